@@ -5,66 +5,132 @@ Receives telemetry from WX-Level and WX-Flow IoT devices.
 Stores readings in the database and provides query endpoints.
 """
 
-from datetime import datetime, timedelta
+import csv
+import io
+import logging
+import struct
+import time
+from collections import deque
+from datetime import datetime, timedelta, timezone
 from typing import Optional
 
-from fastapi import APIRouter, HTTPException, Query
-from pydantic import BaseModel, Field
+from fastapi import APIRouter, HTTPException, Query, Request, Response
+from pydantic import BaseModel, Field, ValidationError
 
+from api.reading_schema import FROM_AIR, FROM_COLUMNS, WXFlowPayload, WXLevelPayload
+from services.stages.s3_gsp_compliance import _load_monitoring_sites, _load_thresholds
+
+logger = logging.getLogger(__name__)
 router = APIRouter()
 
 
 # ── Request Models ───────────────────────────────────────────
 
-class WXLevelReading(BaseModel):
+class LoraLink(BaseModel):
+    """Radio metadata the gateway bridge attaches to LoRa uplinks."""
+    rssi: float
+    snr: float
+    gateway: str = ""                  # EUI of the gateway with the best copy
+    gateways: int = 1                  # gateways that heard the packet
+    freq_mhz: Optional[float] = None
+    datr: str = ""
+    # When the gateway heard it. Differs from "timestamp" (ingest time)
+    # for readings the bridge held through a backhaul outage.
+    received_at: Optional[datetime] = None
+
+
+# Payload fields come from hardware/schema/readings.py (reading_schema.py
+# is generated); these add what the backend attaches on the way in.
+
+class WXLevelReading(WXLevelPayload):
+    measured_at: Optional[datetime] = None   # backlog readings (POST /data/packed)
+    lora: Optional[LoraLink] = None
+
+
+class WXFlowReading(WXFlowPayload):
+    lora: Optional[LoraLink] = None
+
+
+class FlowCheck(BaseModel):
     device_id: str
-    device_type: str = "wx-level"
-    fw_version: str = ""
-    boot_count: int = 0
-    water_level_ft: float
-    pressure_psi: float
-    water_temp_c: Optional[float] = None
-    baro_pressure_hpa: Optional[float] = None
-    baro_temp_c: Optional[float] = None
-    humidity_pct: Optional[float] = None
-    battery_v: float = 0
-    solar_v: float = 0
-
-
-class FlowData(BaseModel):
-    velocity_cm_day: float = 0
-    direction_deg: float = -1
-    valid: bool = False
-    peak_temps: list[float] = Field(default_factory=list)
-    peak_times: list[float] = Field(default_factory=list)
-
-
-class WXFlowReading(BaseModel):
+    distance_km: float
+    direction_deg: float
+    velocity_cm_day: float
+    angle_diff_deg: float
+    agree: bool
+
+
+class GradientCenter(BaseModel):
     device_id: str
-    device_type: str = "wx-flow"
-    fw_version: str = ""
-    boot_count: int = 0
-    flow: FlowData = Field(default_factory=FlowData)
-    conductivity_us: float = 0
-    tds_ppm: float = 0
-    water_temp_c: float = 0
-    water_level_ft: float = 0
-    pressure_psi: float = 0
-    battery_v: float = 0
-    solar_v: float = 0
+    well_id: str = ""
+
+
+class WXGradientRecord(BaseModel):
+    """Planar hydraulic gradient the gateway bridge fits across neighbouring
+    WX-Level wells (hardware/wx-gateway/bridge/gradient.h)."""
+    device_id: str                     # WXG-<centre unit>-<well>
+    device_type: str = "wx-gradient"
+    center: GradientCenter
+    aquifer: str = ""
+    wells: int
+    span_s: float = 0                  # age of the oldest head in the fit
+    computed_at: datetime
+    head_ft: float                     # fitted head at the centre well
+    gradient: float                    # ft/ft
+    azimuth_deg: float                 # down-gradient (flow) direction, 0 = N
+    rmse_ft: float = 0
+    darcy_flux_ft_day: float
+    seepage_cm_day: float
+    flow_check: Optional[FlowCheck] = None
 
 
 # ── In-Memory Storage (swap for SQLAlchemy in production) ────
 
-_readings: list[dict] = []
 MAX_STORED = 50000
+_readings: deque[dict] = deque(maxlen=MAX_STORED)   # oldest evicted on append
+_latest: dict[str, dict] = {}                       # device_id → most recent reading
 
 
 def _store(reading: dict):
     reading["timestamp"] = datetime.utcnow().isoformat()
     _readings.append(reading)
-    if len(_readings) > MAX_STORED:
-        _readings.pop(0)
+    # A backlog upload follows the live reading on the same session; its
+    # older records must not replace it as the latest
+    device_id = reading.get("device_id", "unknown")
+    latest = _latest.get(device_id)
+    if latest is None or _measured_time(reading) >= _measured_time(latest):
+        _latest[device_id] = reading
+    _tag_campaign(reading)
+    _log_alarms(reading)
+    _fulfil_read_requests(reading)
+
+
+def _measured_time(record: dict) -> datetime:
+    """When a record was measured, naive UTC: measured_at for backlog
+    readings (a datetime once parsed, or the decoder's ISO string),
+    otherwise the time it was stored."""
+    measured = record.get("measured_at") or record["timestamp"]
+    if isinstance(measured, str):
+        measured = datetime.fromisoformat(measured)
+    return _utc(measured)
+
+
+def _ingest_reply(record: dict, **extra) -> dict:
+    device_id = record.get("device_id", "unknown")
+    reply = {"status": "ok", "device_id": device_id, "timestamp": record["timestamp"],
+             "utc_ms": int(time.time() * 1000), **extra}
+    # Devices read this reply back and set their clock from utc_ms; the
+    # next campaign, a pending trace request and thresholds the unit does
+    # not have yet ride along
+    campaign = _campaign_push(device_id)
+    if campaign:
+        reply["campaign"] = campaign
+    if device_id in _trace_requests:
+        reply["upload_trace"] = _trace_requests[device_id]
+    thresholds = _threshold_push(record)
+    if thresholds:
+        reply["thresholds"] = thresholds
+    return reply
 
 
 # ── Ingest Endpoints ─────────────────────────────────────────
@@ -73,10 +139,13 @@ def _store(reading: dict):
 async def ingest_data(payload: dict):
     """
     Universal ingest — accepts both wx-level and wx-flow payloads.
-    The device_type field determines how the data is parsed.
+    The device_type field determines how the data is parsed; LoRa frames
+    (short keys, via the gateway) are expanded to the full payload first.
     """
     device_type = payload.get("device_type", "")
     device_id = payload.get("device_id", "unknown")
+    if device_type in FROM_AIR:
+        payload = FROM_AIR[device_type](payload)
 
     if device_type == "wx-level":
         reading = WXLevelReading(**payload)
@@ -84,6 +153,8 @@ async def ingest_data(payload: dict):
     elif device_type == "wx-flow":
         reading = WXFlowReading(**payload)
         record = reading.dict()
+    elif device_type == "wx-gradient":
+        record = WXGradientRecord(**payload).dict()
     else:
         record = payload.copy()
 
@@ -91,12 +162,157 @@ async def ingest_data(payload: dict):
     record["device_type"] = device_type
     _store(record)
 
-    return {
-        "status": "ok",
-        "device_id": device_id,
-        "timestamp": record["timestamp"],
-        "readings_stored": len(_readings),
-    }
+    return _ingest_reply(record, readings_stored=len(_readings))
+
+
+@router.post("/data/batch")
+async def ingest_batch(payloads: list[dict]):
+    """
+    Batched ingest for the LoRa gateway bridge (hardware/wx-gateway/bridge).
+    Each payload is handled as by POST /data; a malformed one gets an error
+    entry instead of failing the batch, since the bridge cannot resend
+    part of it.
+    """
+    replies = []
+    for payload in payloads:
+        try:
+            replies.append(await ingest_data(payload))
+        except ValidationError as e:
+            replies.append({"status": "error", "device_id": payload.get("device_id"),
+                            "detail": e.errors()})
+    return {"status": "ok", "count": len(replies), "replies": replies}
+
+
+# ── Packed Backlog (hardware/common/firmware/ts_codec.h) ─────
+# Readings a unit could not send, uploaded later as one bit-packed batch:
+# per-field columns coded as delta-of-delta (TS_DOD), zig-zag delta
+# (TS_DELTA) or float XOR (TS_XOR), Gorilla-style.
+
+TS_MAGIC = 0xD7
+TS_VERSION = 1
+TS_DOD, TS_DELTA, TS_XOR = 0, 1, 2
+TS_MISSING = -0x80000000
+_TS_BUCKET_BITS = (0, 4, 8, 16, 32)     # after 0, 10, 110, 1110, 1111
+
+
+class _BitReader:
+    def __init__(self, data: bytes, pos: int):
+        self.value = int.from_bytes(data, "big")
+        self.left = len(data) * 8 - pos
+
+    def take(self, n: int) -> int:
+        if n < 0 or n > self.left:
+            raise ValueError("packed batch truncated")
+        self.left -= n
+        return (self.value >> self.left) & ((1 << n) - 1)
+
+    def varbits(self) -> int:
+        ones = 0
+        while ones < 4 and self.take(1):
+            ones += 1
+        z = self.take(_TS_BUCKET_BITS[ones]) if ones else 0
+        return (z >> 1) ^ -(z & 1)
+
+
+def _u32_to_i32(v: int) -> int:
+    v &= 0xFFFFFFFF
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+def decode_packed(data: bytes, received_at: datetime) -> list[dict]:
+    """
+    Decodes a ts_codec batch into reading payloads as POST /data takes
+    them. Field 0 is the unit's clock in seconds; records are dated
+    against `received_at` through the header's t_ref; the rest map back
+    to payload fields through the device type's generated decoder.
+    """
+    if len(data) < 9 or data[0] != TS_MAGIC or data[1] != TS_VERSION:
+        raise ValueError("not a packed batch")
+    count, t_ref = struct.unpack_from("<HI", data, 2)
+    pos = 8
+
+    def cstr() -> str:
+        nonlocal pos
+        end = data.index(b"\0", pos)
+        text = data[pos:end].decode(errors="replace")
+        pos = end + 1
+        return text
+
+    device_id, device_type = cstr(), cstr()
+    from_columns = FROM_COLUMNS.get(device_type)
+    if not from_columns:
+        raise ValueError(f"no packed layout for {device_type!r}")
+    if pos >= len(data):
+        raise ValueError("packed batch truncated")
+    n_fields = data[pos]
+    pos += 1
+    fields = []
+    for _ in range(n_fields):
+        if pos >= len(data):
+            raise ValueError("packed batch truncated")
+        desc = data[pos]
+        pos += 1
+        fields.append((desc & 3, desc >> 2, cstr()))
+    if not fields or fields[0][2] != "t":
+        raise ValueError("packed batch has no time column")
+
+    bits = _BitReader(data, pos * 8)
+    prev = [0] * len(fields)
+    prev_delta = [0] * len(fields)
+    window = [(0, 0)] * len(fields)
+    readings = []
+    for index in range(count):
+        values = []
+        for i, (kind, decimals, _) in enumerate(fields):
+            if kind == TS_XOR:
+                if index == 0:
+                    v = bits.take(32)
+                elif not bits.take(1):
+                    v = prev[i]
+                else:
+                    if bits.take(1):
+                        lead, n = bits.take(5), bits.take(5) + 1
+                        if lead + n > 32:
+                            raise ValueError("packed batch corrupt")
+                        window[i] = (lead, 32 - lead - n)
+                    lead, trail = window[i]
+                    v = prev[i] ^ (bits.take(32 - lead - trail) << trail)
+                prev[i] = v
+                values.append(struct.unpack("<f", struct.pack("<I", v))[0])
+                continue
+            if index == 0:
+                z = bits.take(32)
+                prev[i] = (z >> 1) ^ -(z & 1)
+            else:
+                d = bits.varbits()
+                if kind == TS_DOD and index > 1:
+                    d = _u32_to_i32(prev_delta[i] + d)
+                prev_delta[i] = d
+                prev[i] = _u32_to_i32(prev[i] + d)
+            values.append(None if prev[i] == TS_MISSING else round(prev[i] / 10 ** decimals, decimals))
+
+        columns = {name: v for (_, _, name), v in zip(fields, values)}
+        reading = from_columns(columns)
+        reading["device_id"] = device_id
+        try:
+            reading["measured_at"] = (received_at - timedelta(seconds=t_ref - columns["t"])).isoformat()
+        except (TypeError, OverflowError):
+            raise ValueError("packed batch has a bad time column") from None
+        readings.append(reading)
+    return readings
+
+
+@router.post("/data/packed")
+async def ingest_packed(request: Request):
+    """
+    A unit's backlog of unsent readings as one ts_codec batch
+    (application/octet-stream), ingested as by POST /data/batch.
+    """
+    try:
+        payloads = decode_packed(await request.body(), datetime.utcnow())
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return await ingest_batch(payloads)
 
 
 @router.post("/data/level")
@@ -104,7 +320,7 @@ async def ingest_level(reading: WXLevelReading):
     """Typed endpoint specifically for WX-Level devices."""
     record = reading.dict()
     _store(record)
-    return {"status": "ok", "device_id": reading.device_id, "timestamp": record["timestamp"]}
+    return _ingest_reply(record)
 
 
 @router.post("/data/flow")
@@ -112,7 +328,7 @@ async def ingest_flow(reading: WXFlowReading):
     """Typed endpoint specifically for WX-Flow devices."""
     record = reading.dict()
     _store(record)
-    return {"status": "ok", "device_id": reading.device_id, "timestamp": record["timestamp"]}
+    return _ingest_reply(record)
 
 
 # ── Query Endpoints ──────────────────────────────────────────
@@ -128,39 +344,558 @@ async def get_readings(
     cutoff = datetime.utcnow() - timedelta(hours=hours)
     cutoff_str = cutoff.isoformat()
 
-    results = _readings
-    if device_id:
-        results = [r for r in results if r.get("device_id") == device_id]
-    if device_type:
-        results = [r for r in results if r.get("device_type") == device_type]
-    results = [r for r in results if r.get("timestamp", "") >= cutoff_str]
+    # Newest first; storage is in arrival order, so stop at the cutoff
+    results = []
+    for r in reversed(_readings):
+        if r.get("timestamp", "") < cutoff_str or len(results) >= limit:
+            break
+        if device_id and r.get("device_id") != device_id:
+            continue
+        if device_type and r.get("device_type") != device_type:
+            continue
+        results.append(r)
+    results.reverse()
 
     return {
-        "count": len(results[-limit:]),
-        "readings": results[-limit:],
+        "count": len(results),
+        "readings": results,
     }
 
 
 @router.get("/devices")
 async def list_devices():
     """List all known devices and their last reading time."""
-    devices = {}
-    for r in _readings:
-        did = r.get("device_id", "unknown")
-        devices[did] = {
+    devices = [
+        {
             "device_id": did,
             "device_type": r.get("device_type", ""),
             "last_seen": r.get("timestamp", ""),
             "battery_v": r.get("battery_v", 0),
+            "batt_r_ohm": r.get("batt_r_ohm"),
             "fw_version": r.get("fw_version", ""),
         }
-    return {"devices": list(devices.values())}
+        for did, r in _latest.items()
+    ]
+    return {"devices": devices}
 
 
 @router.get("/data/{device_id}/latest")
 async def get_latest(device_id: str):
     """Get the most recent reading for a specific device."""
-    for r in reversed(_readings):
-        if r.get("device_id") == device_id:
-            return r
+    if device_id in _latest:
+        return _latest[device_id]
     raise HTTPException(status_code=404, detail=f"No readings for device {device_id}")
+
+
+# ── ADC Traces ───────────────────────────────────────────────
+#
+# Devices log every raw ADC conversion of a cycle to flash (firmware
+# adc_trace.h). Requesting a trace flags the device; its next cellular
+# ingest reply carries "upload_trace" and the device POSTs the stored file
+# in chunks. Completed traces replay on a host with hardware/tools/replay,
+# and GET /traces bundles them into one archive for hardware/tools/reanalyze.
+
+ADC_TRACE_MAGIC = 0x54415857
+ADC_TRACE_HEADER = struct.Struct("<IHH12s16sIII4f")   # AdcTraceHeader, 64 bytes
+MAX_TRACES_PER_DEVICE = 20
+
+_trace_requests: dict[str, int] = {}          # device_id → boot (0 = next cycle)
+_trace_uploads: dict[tuple[str, int], dict] = {}
+_traces: dict[str, list[dict]] = {}
+
+
+def _parse_trace_header(data: bytes) -> dict:
+    if len(data) < ADC_TRACE_HEADER.size:
+        raise HTTPException(status_code=400, detail="Trace shorter than its header")
+    (magic, version, sample_size, device_type, device_id, boot_count,
+     count, dropped, *aux) = ADC_TRACE_HEADER.unpack_from(data)
+    if magic != ADC_TRACE_MAGIC:
+        raise HTTPException(status_code=400, detail="Not an ADC trace")
+    if len(data) != ADC_TRACE_HEADER.size + count * sample_size:
+        raise HTTPException(status_code=400, detail="Trace length does not match sample count")
+    return {
+        "version": version,
+        "device_type": device_type.rstrip(b"\0").decode(errors="replace"),
+        "boot_count": boot_count,
+        "samples": count,
+        "dropped": dropped,
+        "aux": aux,
+    }
+
+
+@router.post("/traces/{device_id}/request")
+async def request_trace(device_id: str, boot: int = Query(0, ge=0)):
+    """Ask a device to upload the ADC trace of cycle `boot` (0 = its next cycle)."""
+    _trace_requests[device_id] = boot
+    return {"status": "pending", "device_id": device_id, "boot": boot}
+
+
+@router.post("/traces/{device_id}")
+async def upload_trace_chunk(
+    device_id: str,
+    request: Request,
+    boot: int = Query(..., ge=0),
+    offset: int = Query(..., ge=0),
+    total: int = Query(..., ge=1, le=1 << 20),
+):
+    """Receive one chunk of a raw ADC trace file from a device."""
+    chunk = await request.body()
+    if offset + len(chunk) > total:
+        raise HTTPException(status_code=400, detail="Chunk past end of trace")
+
+    key = (device_id, boot)
+    upload = _trace_uploads.get(key)
+    if upload is None or offset == 0 or len(upload["data"]) != total:
+        upload = {"data": bytearray(total), "received": set()}
+        _trace_uploads[key] = upload
+    upload["data"][offset:offset + len(chunk)] = chunk
+    upload["received"].add((offset, len(chunk)))
+
+    if sum(n for _, n in upload["received"]) < total:
+        return {"status": "partial", "received": offset + len(chunk), "total": total}
+
+    data = bytes(upload.pop("data"))
+    del _trace_uploads[key]
+    meta = _parse_trace_header(data)
+    traces = _traces.setdefault(device_id, [])
+    traces[:] = [t for t in traces if t["boot_count"] != meta["boot_count"]]
+    traces.append({**meta, "received_at": datetime.utcnow().isoformat(), "data": data})
+    del traces[:-MAX_TRACES_PER_DEVICE]
+    if device_id in _trace_requests and _trace_requests[device_id] in (0, meta["boot_count"]):
+        del _trace_requests[device_id]
+    return {"status": "complete", "boot_count": meta["boot_count"], "samples": meta["samples"]}
+
+
+@router.get("/traces/{device_id}")
+async def list_traces(device_id: str):
+    """List the ADC traces received from a device."""
+    traces = _traces.get(device_id, [])
+    return {
+        "device_id": device_id,
+        "pending_request": _trace_requests.get(device_id),
+        "traces": [{k: v for k, v in t.items() if k != "data"} for t in traces],
+    }
+
+
+@router.get("/traces/{device_id}/{boot}")
+async def download_trace(device_id: str, boot: int):
+    """Download a raw trace file for hardware/tools/replay."""
+    for t in _traces.get(device_id, []):
+        if t["boot_count"] == boot:
+            return Response(
+                content=t["data"],
+                media_type="application/octet-stream",
+                headers={"Content-Disposition": f'attachment; filename="{device_id}-{boot}.bin"'},
+            )
+    raise HTTPException(status_code=404, detail=f"No trace for {device_id} boot {boot}")
+
+
+@router.get("/traces")
+async def download_trace_archive(device_type: Optional[str] = None):
+    """All stored traces back to back, optionally of one device type."""
+    data = b"".join(
+        t["data"]
+        for device_id in sorted(_traces)
+        for t in _traces[device_id]
+        if device_type is None or t["device_type"] == device_type
+    )
+    name = f"traces-{device_type}.bin" if device_type else "traces.bin"
+    return Response(
+        content=data,
+        media_type="application/octet-stream",
+        headers={"Content-Disposition": f'attachment; filename="{name}"'},
+    )
+
+
+# ── Flow Re-analysis ─────────────────────────────────────────
+#
+# hardware/tools/reanalyze runs archived WX-Flow traces through revised
+# flow estimators offline and writes one CSV row per trace and estimator.
+# Rows are kept per device under (boot, estimator, version), so results of
+# different estimator revisions stand side by side; a re-import of the same
+# revision replaces its rows.
+
+REANALYSIS_FIELDS = {
+    "velocity_cm_day": float, "direction_deg": float, "cal_k": float,
+    "peak_dt_n": float, "peak_dt_e": float, "peak_dt_s": float, "peak_dt_w": float,
+    "peak_t_n": float, "peak_t_e": float, "peak_t_s": float, "peak_t_w": float,
+    "valid": lambda v: v == "1", "desync": lambda v: v == "1", "dropped": int,
+}
+
+_reanalysis: dict[str, dict[tuple[int, str, int], dict]] = {}
+
+
+@router.post("/reanalysis")
+async def import_reanalysis(request: Request):
+    """Import a results CSV from hardware/tools/reanalyze."""
+    text = (await request.body()).decode(errors="replace")
+    rows = csv.DictReader(io.StringIO(text))
+    missing = {"device_id", "boot_count", "estimator", "version", *REANALYSIS_FIELDS} - set(
+        rows.fieldnames or [])
+    if missing:
+        raise HTTPException(status_code=400, detail=f"Missing columns: {', '.join(sorted(missing))}")
+    imported = 0
+    for n, row in enumerate(rows, start=2):
+        try:
+            key = (int(row["boot_count"]), row["estimator"], int(row["version"]))
+            result = {k: conv(row[k]) for k, conv in REANALYSIS_FIELDS.items()}
+        except (TypeError, ValueError):
+            raise HTTPException(status_code=400, detail=f"Bad value on line {n}")
+        _reanalysis.setdefault(row["device_id"], {})[key] = {
+            "boot_count": key[0], "estimator": key[1], "version": key[2], **result}
+        imported += 1
+    return {"status": "ok", "imported": imported}
+
+
+@router.get("/reanalysis/{device_id}")
+async def get_reanalysis(device_id: str, estimator: Optional[str] = None,
+                         version: Optional[int] = None):
+    """Re-analysed flow results of a device, by boot count."""
+    results = [
+        r for key, r in sorted(_reanalysis.get(device_id, {}).items())
+        if (estimator is None or key[1] == estimator) and (version is None or key[2] == version)
+    ]
+    if not results:
+        raise HTTPException(status_code=404, detail=f"No re-analysis for device {device_id}")
+    return {"device_id": device_id, "count": len(results), "results": results}
+
+
+# ── SGMA Threshold Alarms ────────────────────────────────────
+#
+# WX-Level units check each well against its GSP minimum threshold (MT),
+# measurable objective (MO) and a rate-of-change limit on every sample
+# (firmware alarm.h) and send a breach at once instead of waiting for the
+# transport policy. Limits are configured here per device; the next
+# cellular ingest reply from a unit whose thr_version is stale carries the
+# set, converted to the unit's own frame: ft of water over the transducer.
+
+class WellThresholdConfig(BaseModel):
+    well_id: str
+    ewm_id: Optional[str] = None              # DWR monitoring site for MT / MO
+    transducer_depth_ft: float = Field(..., gt=0)   # below ground surface
+    gs_elevation_ft: Optional[float] = None   # overrides the site's GS_ELEVATION
+    min_level_ft: Optional[float] = None      # overrides, already in device frame
+    warn_level_ft: Optional[float] = None
+    max_rate_ft_per_hr: Optional[float] = Field(None, gt=0)
+
+
+_thresholds: dict[str, dict] = {}             # device_id → {"version", "wells": {well_id: {...}}}
+_alarms: deque[dict] = deque(maxlen=1000)
+_ALARM_BITS = ((1, "mt"), (2, "mo"), (4, "rate"))
+
+
+def _device_level_ft(value: Optional[float], depth_ft: float, gs_elev: Optional[float]) -> Optional[float]:
+    # Same frame heuristic as the GSP compliance stage: positive values are
+    # water surface elevation (ft MSL), negative ones depth (ft BGS)
+    if value is None:
+        return None
+    if value > 0:
+        if not gs_elev or gs_elev <= 0:
+            return None
+        return value - gs_elev + depth_ft
+    return depth_ft + value
+
+
+def _resolve_threshold(cfg: WellThresholdConfig, sites: dict, smc: dict) -> dict:
+    site = sites.get(cfg.ewm_id, {}) if cfg.ewm_id else {}
+    limits = smc.get(cfg.ewm_id, {}) if cfg.ewm_id else {}
+    gs_elev = cfg.gs_elevation_ft if cfg.gs_elevation_ft is not None else site.get("gs_elevation_ft")
+    mt = limits.get("minimum_threshold")
+    mo = limits.get("measurable_objective")
+    min_ft = cfg.min_level_ft
+    if min_ft is None:
+        min_ft = _device_level_ft(mt, cfg.transducer_depth_ft, gs_elev)
+    warn_ft = cfg.warn_level_ft
+    if warn_ft is None:
+        warn_ft = _device_level_ft(mo, cfg.transducer_depth_ft, gs_elev)
+    return {
+        **cfg.dict(),
+        "minimum_threshold": mt,
+        "measurable_objective": mo,
+        "min_ft": min_ft,
+        "warn_ft": warn_ft,
+        "rate_ft_h": cfg.max_rate_ft_per_hr,
+    }
+
+
+def _threshold_push(record: dict) -> Optional[dict]:
+    entry = _thresholds.get(record.get("device_id"))
+    if entry is None or record.get("thr_version") == entry["version"]:
+        return None
+    wells = []
+    for w in record.get("wells") or []:
+        t = entry["wells"].get(w.get("well_id"), {})
+        wells.append([
+            round(t[k], 2) if t.get(k) is not None else None
+            for k in ("min_ft", "warn_ft", "rate_ft_h")
+        ])
+    return {"version": entry["version"], "wells": wells}
+
+
+def _log_alarms(record: dict):
+    for w in record.get("wells") or []:
+        mask = w.get("alarm") or 0
+        if not mask:
+            continue
+        names = [name for bit, name in _ALARM_BITS if mask & bit]
+        _alarms.append({
+            "device_id": record.get("device_id", "unknown"),
+            "well_id": w.get("well_id", ""),
+            "alarm": names,
+            "water_level_ft": w.get("water_level_ft"),
+            "thr_version": record.get("thr_version"),
+            "timestamp": record["timestamp"],
+        })
+        logger.warning("Threshold alarm %s on %s/%s at %s ft",
+                       "+".join(names), record.get("device_id"), w.get("well_id"),
+                       w.get("water_level_ft"))
+
+
+@router.put("/devices/{device_id}/thresholds")
+async def set_thresholds(device_id: str, wells: list[WellThresholdConfig]):
+    """Set a device's per-well alarm limits; sent down on its next cellular ingest."""
+    sites, smc = _load_monitoring_sites(), _load_thresholds()
+    resolved = {cfg.well_id: _resolve_threshold(cfg, sites, smc) for cfg in wells}
+    version = _thresholds.get(device_id, {}).get("version", 0) + 1
+    _thresholds[device_id] = {"version": version, "wells": resolved}
+    return {"device_id": device_id, "version": version, "wells": list(resolved.values())}
+
+
+@router.get("/devices/{device_id}/thresholds")
+async def get_thresholds(device_id: str):
+    """Configured limits, and the version the device last reported checking against."""
+    entry = _thresholds.get(device_id)
+    if entry is None:
+        raise HTTPException(status_code=404, detail=f"No thresholds for device {device_id}")
+    return {
+        "device_id": device_id,
+        "version": entry["version"],
+        "device_version": _latest.get(device_id, {}).get("thr_version"),
+        "wells": list(entry["wells"].values()),
+    }
+
+
+@router.get("/alarms")
+async def list_alarms(
+    device_id: Optional[str] = None,
+    limit: int = Query(100, ge=1, le=1000),
+):
+    """Most recent threshold alarms reported by devices."""
+    alarms = [a for a in _alarms if device_id is None or a["device_id"] == device_id]
+    return {"count": len(alarms[-limit:]), "alarms": alarms[-limit:][::-1]}
+
+
+# ── On-Demand Reads ──────────────────────────────────────────
+#
+# A read request asks a unit for a reading now rather than at its next
+# report. The LoRa gateway bridge polls pending requests and sends a
+# wake-on-radio command to units listening between reports (firmware
+# wake_radio.h); the command carries the request id and the reading
+# answers with it as read_req. A unit woken by a modem ring cannot know
+# the id, so a reading from the device measured after the request fulfils
+# it; backlog readings from before do not.
+
+READ_REQUEST_TTL = timedelta(minutes=10)
+READ_REQUEST_KEEP = timedelta(hours=1)      # closed requests stay readable this long
+
+_read_requests: dict[int, dict] = {}
+_next_read_request = 1
+
+
+def request_read(device_id: str, reason: str = "") -> dict:
+    """Queue an on-demand read; also the entry point for backend services."""
+    global _next_read_request
+    req = {
+        "id": _next_read_request,
+        "device_id": device_id,
+        "reason": reason,
+        "status": "pending",
+        "requested_at": datetime.utcnow().isoformat(),
+    }
+    _next_read_request += 1
+    _read_requests[req["id"]] = req
+    return req
+
+
+def _expire_read_requests():
+    """
+    Expires pending requests older than READ_REQUEST_TTL and forgets
+    closed ones READ_REQUEST_KEEP later. Requests are kept in the order
+    they were made, so only the old end is walked.
+    """
+    now = datetime.utcnow()
+    expire = (now - READ_REQUEST_TTL).isoformat()
+    forget = (now - READ_REQUEST_TTL - READ_REQUEST_KEEP).isoformat()
+    stale = []
+    for req_id, req in _read_requests.items():
+        if req["requested_at"] >= expire:
+            break
+        if req["status"] == "pending":
+            req["status"] = "expired"
+        elif req["requested_at"] < forget:
+            stale.append(req_id)
+    for req_id in stale:
+        del _read_requests[req_id]
+
+
+def _fulfil_read_requests(record: dict):
+    _expire_read_requests()
+    device_id = record.get("device_id")
+    measured = _measured_time(record)
+    for req in _read_requests.values():
+        if req["status"] != "pending" or req["device_id"] != device_id:
+            continue
+        requested = datetime.fromisoformat(req["requested_at"])
+        if record.get("read_req") != req["id"] and measured <= requested:
+            continue
+        req.update({
+            "status": "fulfilled",
+            "fulfilled_at": record["timestamp"],
+            "latency_s": round((datetime.fromisoformat(record["timestamp"]) - requested).total_seconds(), 1),
+            "via": "lora" if record.get("lora") else "cellular",
+            "answered": record.get("read_req") == req["id"],
+        })
+
+
+class ReadRequestBody(BaseModel):
+    reason: str = ""
+
+
+@router.post("/devices/{device_id}/read")
+async def create_read_request(device_id: str, body: Optional[ReadRequestBody] = None):
+    """Ask a device for a reading now; delivered by the gateway bridge."""
+    return request_read(device_id, body.reason if body else "")
+
+
+@router.get("/read-requests")
+async def list_read_requests(
+    status: Optional[str] = None,
+    device_id: Optional[str] = None,
+):
+    """Read requests, newest first; the bridge polls ?status=pending."""
+    _expire_read_requests()
+    reqs = [
+        r for r in _read_requests.values()
+        if (status is None or r["status"] == status)
+        and (device_id is None or r["device_id"] == device_id)
+    ]
+    return {"count": len(reqs), "requests": reqs[::-1]}
+
+
+@router.get("/read-requests/{request_id}")
+async def get_read_request(request_id: int):
+    _expire_read_requests()
+    req = _read_requests.get(request_id)
+    if req is None:
+        raise HTTPException(status_code=404, detail=f"No read request {request_id}")
+    return req
+
+
+# ── Synoptic Campaigns ───────────────────────────────────────
+#
+# A campaign is one instant at which every targeted unit measures, for
+# contour maps and gradients from a single snapshot. Until the instant,
+# every cellular ingest reply announces it; units convert it to their own
+# clock (synced from the replies' utc_ms, firmware campaign.h) and tag the
+# reading with the campaign id, their estimate of how far from the instant
+# they measured (campaign_dt_s) and its error bound (clock_err_s).
+# Readings that came back through the packed backlog lose the tag and are
+# matched on measured_at instead.
+
+class CampaignBody(BaseModel):
+    at: datetime                              # naive = UTC
+    max_err_ms: int = Field(30000, gt=0)      # snapshot tolerance per unit
+    device_ids: Optional[list[str]] = None    # None = the whole fleet
+    note: str = ""
+
+
+_campaigns: dict[int, dict] = {}
+_next_campaign = 1
+
+
+def _utc(dt: datetime) -> datetime:
+    return dt.astimezone(timezone.utc).replace(tzinfo=None) if dt.tzinfo else dt
+
+
+def _targets(campaign: dict, device_id: str) -> bool:
+    return campaign["device_ids"] is None or device_id in campaign["device_ids"]
+
+
+def _campaign_push(device_id: str) -> Optional[dict]:
+    now = datetime.utcnow()
+    upcoming = [c for c in _campaigns.values() if c["at"] > now and _targets(c, device_id)]
+    if not upcoming:
+        return None
+    c = min(upcoming, key=lambda c: c["at"])
+    return {
+        "id": c["id"],
+        "at": int(c["at"].replace(tzinfo=timezone.utc).timestamp()),
+        "max_err_ms": c["max_err_ms"],
+    }
+
+
+def _tag_campaign(record: dict):
+    measured = record.get("measured_at")
+    if record.get("campaign") or not measured:
+        return
+    if isinstance(measured, str):
+        measured = datetime.fromisoformat(measured)
+    measured = _utc(measured)
+    for c in _campaigns.values():
+        dt = (measured - c["at"]).total_seconds()
+        if _targets(c, record.get("device_id")) and abs(dt) * 1000 <= c["max_err_ms"]:
+            record.update({"campaign": c["id"], "campaign_dt_s": round(dt, 3),
+                           "campaign_inferred": True})
+            return
+
+
+def _campaign_view(c: dict) -> dict:
+    return {**c, "at": c["at"].isoformat()}
+
+
+@router.post("/campaigns")
+async def create_campaign(body: CampaignBody):
+    """Schedule a synoptic campaign; announced in every ingest reply until it passes."""
+    global _next_campaign
+    at = _utc(body.at).replace(microsecond=0)     # units get whole Unix seconds
+    if at <= datetime.utcnow():
+        raise HTTPException(status_code=400, detail="Campaign instant is in the past")
+    c = {"id": _next_campaign, **body.dict(), "at": at,
+         "created_at": datetime.utcnow().isoformat()}
+    _next_campaign += 1
+    _campaigns[c["id"]] = c
+    return _campaign_view(c)
+
+
+@router.get("/campaigns")
+async def list_campaigns():
+    campaigns = [_campaign_view(c) for c in _campaigns.values()]
+    return {"count": len(campaigns), "campaigns": campaigns[::-1]}
+
+
+@router.get("/campaigns/{campaign_id}")
+async def get_campaign(campaign_id: int):
+    """
+    The campaign's snapshot: one reading per unit that measured for it,
+    and the targeted units that have not reported one.
+    """
+    c = _campaigns.get(campaign_id)
+    if c is None:
+        raise HTTPException(status_code=404, detail=f"No campaign {campaign_id}")
+    readings: dict[str, dict] = {}
+    for r in _readings:
+        if r.get("campaign") == campaign_id:
+            readings[r.get("device_id", "unknown")] = r
+    expected = c["device_ids"] if c["device_ids"] is not None else list(_latest)
+    offsets = [abs(r["campaign_dt_s"]) for r in readings.values() if r.get("campaign_dt_s") is not None]
+    return {
+        **_campaign_view(c),
+        "reported": len(readings),
+        "missing": sorted(d for d in expected if d not in readings),
+        "max_abs_dt_s": max(offsets) if offsets else None,
+        "within_budget": sum(
+            1 for r in readings.values()
+            if abs(r.get("campaign_dt_s") or 0) + (r.get("clock_err_s") or 0) <= c["max_err_ms"] / 1000
+        ),
+        "readings": list(readings.values()),
+    }
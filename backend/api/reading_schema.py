@@ -0,0 +1,158 @@
+"""
+Generated by hardware/schema/gen_readings.py from readings.py. Do not edit.
+
+Reading payloads as the WX firmware sends them (hardware/schema/readings.py),
+and decoders from LoRa frames and packed backlog columns back to payload dicts.
+"""
+
+from typing import Optional
+
+from pydantic import BaseModel, Field
+
+
+class WellChannelReading(BaseModel):
+    well_id: str = ""
+    channel: Optional[int] = None  # ADS1115 input for analog wells
+    bus: str = "analog"  # "modbus" or "sdi12" for digital sensors
+    water_level_ft: Optional[float] = None  # absent when the sonde did not answer
+    pressure_psi: Optional[float] = None
+    alarm: int = 0  # threshold breach: 1 below MT, 2 below MO, 4 rate of change
+
+
+class TxTelemetry(BaseModel):
+    route: str = ""  # "lora", "cell" or "defer"
+    reason: str = ""
+    queued: int = 0  # readings waiting at decision time
+    p_lora: float = 0  # observed delivery rate
+    p_cell: float = 0
+    cost_j: Optional[float] = None  # weighted cost per reading of the chosen route
+
+
+class WXLevelPayload(BaseModel):
+    device_id: str
+    device_type: str = "wx-level"
+    fw_version: str = ""
+    boot_count: int = 0
+    water_level_ft: Optional[float] = None  # channel 0, for single-well consumers; null when it failed
+    pressure_psi: Optional[float] = None
+    water_temp_c: Optional[float] = None
+    baro_pressure_hpa: Optional[float] = None
+    baro_temp_c: Optional[float] = None
+    humidity_pct: Optional[float] = None
+    battery_v: float = 0
+    solar_v: float = 0
+    wells: list[WellChannelReading] = Field(default_factory=list)
+    thr_version: int = 0  # SGMA threshold set checked on the unit, 0 = none
+    read_req: int = 0  # on-demand read request this reading answers, 0 = scheduled
+    batt_r_ohm: Optional[float] = None  # tracked internal resistance, from loads of known current
+    batt_min_v: Optional[float] = None  # lowest battery voltage under load since the last reading
+    campaign: int = 0  # synoptic campaign this reading was taken for, 0 = none
+    campaign_dt_s: Optional[float] = None  # unit's estimate of measured time minus the campaign instant
+    clock_err_s: Optional[float] = None  # error bound of campaign_dt_s
+    tx: TxTelemetry = Field(default_factory=TxTelemetry)
+
+
+class FlowData(BaseModel):
+    velocity_cm_day: float = 0
+    direction_deg: float = -1
+    valid: bool = False
+    peak_temps: list[float] = Field(default_factory=list)
+    peak_times: list[float] = Field(default_factory=list)
+
+
+class WXFlowPayload(BaseModel):
+    device_id: str
+    device_type: str = "wx-flow"
+    fw_version: str = ""
+    boot_count: int = 0
+    flow: FlowData = Field(default_factory=FlowData)
+    conductivity_us: float = 0
+    tds_ppm: float = 0
+    water_temp_c: float = 0
+    water_level_ft: float = 0
+    pressure_psi: float = 0
+    battery_v: float = 0
+    solar_v: float = 0
+    burst: Optional[str] = None  # "drawdown" or "recovery": an extra pulse of a pressure-triggered burst
+    batt_r_ohm: Optional[float] = None  # tracked internal resistance, from loads of known current
+    batt_min_v: Optional[float] = None  # lowest battery voltage under load since the last reading
+    campaign: int = 0  # synoptic campaign this reading was taken for, 0 = none
+    campaign_dt_s: Optional[float] = None  # unit's estimate of measured time minus the campaign instant
+    clock_err_s: Optional[float] = None  # error bound of campaign_dt_s
+    tx: TxTelemetry = Field(default_factory=TxTelemetry)
+
+
+def wx_level_from_air(frame: dict) -> dict:
+    """A wx-level LoRa frame (build_air) as a payload dict; payloads
+    with the full keys come back unchanged."""
+    reading = dict(frame)
+    for air, key in (("n", "boot_count"), ("wt", "water_temp_c"), ("bp", "baro_pressure_hpa"), ("bt", "baro_temp_c"), ("rh", "humidity_pct"), ("bv", "battery_v"), ("sv", "solar_v"), ("w", "wells"), ("tv", "thr_version"), ("rr", "read_req"), ("br", "batt_r_ohm"), ("bm", "batt_min_v"), ("cp", "campaign"), ("cd", "campaign_dt_s"), ("ce", "clock_err_s")):
+        if air in reading:
+            reading[key] = reading.pop(air)
+    if isinstance(reading.get("wells"), list):
+        reading["wells"] = [
+            {k: v for k, v in zip(("well_id", "water_level_ft", "pressure_psi", "alarm"), e) if v is not None}
+            if isinstance(e, list) else e
+            for e in reading["wells"]
+        ]
+    if "water_level_ft" not in reading and reading.get("wells") and "water_level_ft" in reading["wells"][0]:
+        reading["water_level_ft"] = reading["wells"][0]["water_level_ft"]
+    if "pressure_psi" not in reading and reading.get("wells") and "pressure_psi" in reading["wells"][0]:
+        reading["pressure_psi"] = reading["wells"][0]["pressure_psi"]
+    return reading
+
+
+def wx_flow_from_air(frame: dict) -> dict:
+    """A wx-flow LoRa frame (build_air) as a payload dict; payloads
+    with the full keys come back unchanged."""
+    reading = dict(frame)
+    for air, key in (("n", "boot_count"), ("f", "flow"), ("ec", "conductivity_us"), ("td", "tds_ppm"), ("wt", "water_temp_c"), ("wl", "water_level_ft"), ("p", "pressure_psi"), ("bv", "battery_v"), ("sv", "solar_v"), ("bu", "burst"), ("br", "batt_r_ohm"), ("bm", "batt_min_v"), ("cp", "campaign"), ("cd", "campaign_dt_s"), ("ce", "clock_err_s")):
+        if air in reading:
+            reading[key] = reading.pop(air)
+    if isinstance(reading.get("flow"), dict):
+        group = reading["flow"] = dict(reading["flow"])
+        for air, key in (("v", "velocity_cm_day"), ("d", "direction_deg"), ("ok", "valid"), ("pt", "peak_temps"), ("ps", "peak_times")):
+            if air in group:
+                group[key] = group.pop(air)
+    return reading
+
+
+FROM_AIR = {
+    "wx-level": wx_level_from_air,
+    "wx-flow": wx_flow_from_air,
+}
+
+
+def wx_level_from_columns(columns: dict) -> dict:
+    """One wx-level backlog record, by column name, as a payload dict."""
+    reading = {"device_type": "wx-level"}
+    if columns.get("boot_count") is not None:
+        reading["boot_count"] = int(columns["boot_count"])
+    if columns.get("water_temp_c") is not None:
+        reading["water_temp_c"] = float(columns["water_temp_c"])
+    if columns.get("baro_pressure_hpa") is not None:
+        reading["baro_pressure_hpa"] = float(columns["baro_pressure_hpa"])
+    if columns.get("battery_v") is not None:
+        reading["battery_v"] = float(columns["battery_v"])
+    if columns.get("solar_v") is not None:
+        reading["solar_v"] = float(columns["solar_v"])
+    entries: dict[str, dict] = {}
+    for name, v in columns.items():
+        entry_id, _, key = name.partition(".")
+        if not key:
+            continue
+        entry = entries.setdefault(entry_id, {"well_id": entry_id})
+        if v is not None:
+            entry[key] = v
+    if entries:
+        reading["wells"] = list(entries.values())
+        if "water_level_ft" in reading["wells"][0]:
+            reading["water_level_ft"] = reading["wells"][0]["water_level_ft"]
+        if "pressure_psi" in reading["wells"][0]:
+            reading["pressure_psi"] = reading["wells"][0]["pressure_psi"]
+    return reading
+
+
+FROM_COLUMNS = {
+    "wx-level": wx_level_from_columns,
+}
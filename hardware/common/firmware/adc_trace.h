@@ -0,0 +1,109 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "hal.h"
+
+/*
+ * ADC trace recording
+ *
+ * RecordingAdc sits between the measurement code and a real HalAdc and
+ * logs every conversion result (timestamp, converter, channel, code) into
+ * an AdcTrace. A cycle's trace is saved to flash (adc_trace_store.h) and
+ * uploaded when the backend asks for it. The env:native replay tools then
+ * feed it back through the same measurement and analysis code
+ * (ReplayAdc in hal_native.h).
+ *
+ * File layout: AdcTraceHeader followed by header.count AdcTraceSample
+ * records, little-endian, as written by the ESP32.
+ */
+
+#define ADC_TRACE_MAGIC     0x54415857UL   // "WXAT"
+#define ADC_TRACE_VERSION   1
+
+struct AdcTraceHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t sample_size;      // sizeof(AdcTraceSample)
+    char     device_type[12];
+    char     device_id[16];
+    uint32_t boot_count;
+    uint32_t count;            // samples that follow
+    uint32_t dropped;          // conversions lost to a full buffer
+    float    aux[4];           // non-ADC cycle inputs (WX-Level: baro hPa, baro °C, RH %)
+};
+
+struct AdcTraceSample {
+    uint32_t t_us;             // since AdcTrace::begin()
+    uint8_t  adc;              // converter id, per firmware (see config.h)
+    uint8_t  channel;
+    int16_t  code;
+};
+
+static_assert(sizeof(AdcTraceSample) == 8, "trace samples are stored packed");
+
+class AdcTrace {
+public:
+    AdcTrace(AdcTraceSample *buf, uint32_t capacity) : buf_(buf), capacity_(capacity) {}
+
+    void begin(HalClock &clock, const char *device_type, const char *device_id,
+               uint32_t boot_count) {
+        clock_ = &clock;
+        t0_us_ = clock.now_us();
+        memset(&header, 0, sizeof(header));
+        header.magic       = ADC_TRACE_MAGIC;
+        header.version     = ADC_TRACE_VERSION;
+        header.sample_size = sizeof(AdcTraceSample);
+        strncpy(header.device_type, device_type, sizeof(header.device_type) - 1);
+        strncpy(header.device_id, device_id, sizeof(header.device_id) - 1);
+        header.boot_count  = boot_count;
+    }
+
+    void add(uint8_t adc, uint8_t channel, int16_t code) {
+        if (!clock_) return;
+        if (header.count >= capacity_) {
+            header.dropped++;
+            return;
+        }
+        buf_[header.count++] = { clock_->now_us() - t0_us_, adc, channel, code };
+    }
+
+    const AdcTraceSample *samples() const { return buf_; }
+    size_t bytes() const { return sizeof(header) + header.count * sizeof(AdcTraceSample); }
+
+    AdcTraceHeader header = {};
+
+private:
+    AdcTraceSample *buf_;
+    uint32_t        capacity_;
+    HalClock       *clock_ = nullptr;
+    uint32_t        t0_us_ = 0;
+};
+
+class RecordingAdc : public HalAdc {
+public:
+    RecordingAdc(HalAdc &inner, AdcTrace &trace, uint8_t adc_id)
+        : inner_(inner), trace_(trace), id_(adc_id) {}
+
+    int16_t read_single_ended(uint8_t channel) override {
+        int16_t code = inner_.read_single_ended(channel);
+        trace_.add(id_, channel, code);
+        return code;
+    }
+    void start_single_ended(uint8_t channel) override {
+        channel_ = channel;
+        inner_.start_single_ended(channel);
+    }
+    bool conversion_done() override { return inner_.conversion_done(); }
+    int16_t last_result() override {
+        int16_t code = inner_.last_result();
+        trace_.add(id_, channel_, code);
+        return code;
+    }
+
+private:
+    HalAdc   &inner_;
+    AdcTrace &trace_;
+    uint8_t   id_;
+    uint8_t   channel_ = 0;
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "adc_trace.h"
+#include "sim7000.h"
+
+/*
+ * Flash storage and upload of ADC traces.
+ *
+ * The last `keep` cycles are kept in LittleFS as /trace/<boot % keep>.bin,
+ * so a trace is still there when the backend asks for it a few cycles
+ * after the odd reading came in. Uploads go over an open Sim7000 HTTP
+ * connection in chunks of at most SIM_HTTP_BODYLEN bytes, each POSTed to
+ * <path>?boot=B&offset=O&total=T.
+ */
+
+inline bool trace_store_begin() {
+    return LittleFS.begin(true);    // format on first use
+}
+
+inline void trace_store_path(char *out, size_t cap, uint32_t boot, uint32_t keep) {
+    snprintf(out, cap, "/trace/%u.bin", (unsigned)(boot % keep));
+}
+
+inline bool trace_store_save(const AdcTrace &trace, uint32_t keep) {
+    if (!LittleFS.exists("/trace")) LittleFS.mkdir("/trace");
+    char path[24];
+    trace_store_path(path, sizeof(path), trace.header.boot_count, keep);
+
+    File f = LittleFS.open(path, "w");
+    if (!f) return false;
+    size_t body = trace.header.count * sizeof(AdcTraceSample);
+    bool ok = f.write((const uint8_t *)&trace.header, sizeof(trace.header)) == sizeof(trace.header)
+           && f.write((const uint8_t *)trace.samples(), body) == body;
+    f.close();
+    return ok;
+}
+
+// Upload the stored trace of cycle `boot`; false if it has been overwritten
+inline bool trace_store_upload(Sim7000 &modem, uint32_t boot, uint32_t keep,
+                               const char *path, size_t chunk) {
+    char file_path[24];
+    trace_store_path(file_path, sizeof(file_path), boot, keep);
+    File f = LittleFS.open(file_path, "r");
+    if (!f) return false;
+
+    AdcTraceHeader h;
+    if (f.read((uint8_t *)&h, sizeof(h)) != sizeof(h) || h.magic != ADC_TRACE_MAGIC
+        || h.boot_count != boot) {
+        f.close();
+        return false;
+    }
+    f.seek(0);
+
+    if (chunk > SIM_HTTP_BODYLEN) chunk = SIM_HTTP_BODYLEN;
+    uint8_t *buf = (uint8_t *)malloc(chunk);
+    if (!buf) {
+        f.close();
+        return false;
+    }
+
+    size_t total = f.size(), offset = 0;
+    bool ok = true;
+    while (ok && offset < total) {
+        size_t n = f.read(buf, chunk);
+        if (n == 0) break;
+        char url[96];
+        snprintf(url, sizeof(url), "%s?boot=%u&offset=%u&total=%u",
+                 path, (unsigned)boot, (unsigned)offset, (unsigned)total);
+        ok = modem.http_post(url, "application/octet-stream", buf, n) == 200;
+        offset += n;
+    }
+    free(buf);
+    f.close();
+    return ok && offset == total;
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include "hal.h"
+
+/*
+ * Battery sag and internal resistance.
+ *
+ * One analogRead() of the battery divider says little about an ageing
+ * LiPo: it looks fine at rest and collapses under the heater or a modem
+ * transmit burst, and that sag is what browns the board out. Around each
+ * heavy load the on-chip ADC runs continuously (HalSupplyStream) and every
+ * conversion is reduced on the fly into the phase it fell in, rest before
+ * the load or the load itself. A load with a known current step gives the
+ * internal resistance, R = (V_rest − V_load) / I; every capture gives the
+ * minimum. Both are kept in RTC memory (BatteryHealth), reported with the
+ * next reading, and predict the minimum under a load before it is
+ * switched on.
+ *
+ * A capture whose solar input moved more than solar_steady_v gives no
+ * resistance: the charge current changed under it, so the drop was not
+ * the load's alone.
+ */
+
+enum SagPhase : uint8_t { SAG_REST, SAG_LOAD, SAG_PHASES };
+
+// One capture, reduced as it streams in
+struct SagAccum {
+    uint32_t n[SAG_PHASES];
+    float    sum_v[SAG_PHASES];
+    float    min_v;             // battery, during the load
+    float    solar_min_v;
+    float    solar_max_v;
+};
+
+struct SagParams {
+    float    r_weight;          // of a new resistance estimate in the tracked one
+    float    solar_steady_v;
+    uint16_t min_samples;       // per phase, for a resistance estimate
+    float    brownout_v;        // the board resets below this
+};
+
+struct SagMeasurement {
+    float rest_v;
+    float load_v;
+    float min_v;                // 0 = no load samples
+    float r_ohm;                // 0 = no estimate
+};
+
+// Across wakes; plain data for RTC memory
+struct BatteryHealth {
+    float    r_ohm;             // tracked internal resistance; 0 = none yet
+    uint16_t r_count;           // estimates behind it
+    float    min_v;             // lowest under load since the last report; 0 = none
+};
+
+// What a reading carries; 0 = not measured
+struct SagReport {
+    float r_ohm;
+    float min_v;
+};
+
+inline void sag_reset(SagAccum &a) {
+    for (int k = 0; k < SAG_PHASES; k++) {
+        a.n[k] = 0;
+        a.sum_v[k] = 0;
+    }
+    a.min_v = INFINITY;
+    a.solar_min_v = INFINITY;
+    a.solar_max_v = -INFINITY;
+}
+
+inline void sag_add(SagAccum &a, uint8_t phase, float battery_v, float solar_v) {
+    a.n[phase]++;
+    a.sum_v[phase] += battery_v;
+    if (phase == SAG_LOAD && battery_v < a.min_v) a.min_v = battery_v;
+    if (solar_v < a.solar_min_v) a.solar_min_v = solar_v;
+    if (solar_v > a.solar_max_v) a.solar_max_v = solar_v;
+}
+
+// load_a: current step of the load; 0 when it is not known (minimum only)
+inline SagMeasurement sag_measure(const SagAccum &a, float load_a, const SagParams &p) {
+    SagMeasurement m = {};
+    if (a.n[SAG_REST]) m.rest_v = a.sum_v[SAG_REST] / a.n[SAG_REST];
+    if (!a.n[SAG_LOAD]) return m;
+    m.load_v = a.sum_v[SAG_LOAD] / a.n[SAG_LOAD];
+    m.min_v = a.min_v;
+    if (load_a > 0 && a.n[SAG_REST] >= p.min_samples && a.n[SAG_LOAD] >= p.min_samples &&
+        a.solar_max_v - a.solar_min_v <= p.solar_steady_v && m.rest_v > m.load_v) {
+        m.r_ohm = (m.rest_v - m.load_v) / load_a;
+    }
+    return m;
+}
+
+inline void battery_health_update(BatteryHealth &h, const SagMeasurement &m, const SagParams &p) {
+    if (m.min_v > 0 && (h.min_v == 0 || m.min_v < h.min_v)) h.min_v = m.min_v;
+    if (m.r_ohm <= 0) return;
+    h.r_ohm = h.r_count ? h.r_ohm + p.r_weight * (m.r_ohm - h.r_ohm) : m.r_ohm;
+    if (h.r_count < UINT16_MAX) h.r_count++;
+}
+
+// Expected minimum when a load of load_a is switched on at rest_v; rest_v
+// while the resistance is unknown
+inline float battery_loaded_v(const BatteryHealth &h, float rest_v, float load_a) {
+    return rest_v - h.r_ohm * load_a;
+}
+
+inline bool battery_brownout_risk(const BatteryHealth &h, const SagParams &p, float rest_v,
+                                  float load_a) {
+    return h.r_count && battery_loaded_v(h, rest_v, load_a) < p.brownout_v;
+}
+
+// For the reading; the minimum starts over for the next one
+inline SagReport battery_report(BatteryHealth &h) {
+    SagReport r = { h.r_ohm, h.min_v };
+    h.min_v = 0;
+    return r;
+}
+
+/*
+ * One capture around a load: begin() starts the stream and waits out the
+ * rest phase, load_on() marks the switch-on, load_off() stops the stream.
+ * A capture that did not start (or was never begun) measures nothing.
+ */
+class SagCapture {
+public:
+    SagCapture(HalSupplyStream &stream, HalClock &clock, uint32_t pair_hz, uint32_t preroll_ms)
+        : stream_(stream), clock_(clock), pair_hz_(pair_hz), preroll_ms_(preroll_ms) {
+        sag_reset(acc_);
+    }
+    ~SagCapture() { load_off(); }
+
+    bool begin() {
+        sag_reset(acc_);
+        phase_ = SAG_REST;
+        running_ = stream_.start(pair_hz_, sink, this);
+        if (running_) clock_.delay_ms(preroll_ms_);
+        return running_;
+    }
+    void load_on() { phase_ = SAG_LOAD; }
+    void load_off() {
+        if (running_) stream_.stop();
+        running_ = false;
+    }
+    const SagAccum &result() const { return acc_; }
+
+private:
+    static void sink(void *ctx, float battery_v, float solar_v) {
+        SagCapture *c = (SagCapture *)ctx;
+        sag_add(c->acc_, c->phase_, battery_v, solar_v);
+    }
+
+    HalSupplyStream  &stream_;
+    HalClock         &clock_;
+    uint32_t          pair_hz_, preroll_ms_;
+    SagAccum          acc_;
+    volatile uint8_t  phase_ = SAG_REST;
+    bool              running_ = false;
+};
+
+// Passes GPIO through and marks the capture when the load pin switches:
+// on at its first write high, and the capture ends at the next write low
+class SagGpio : public HalGpio {
+public:
+    SagGpio(HalGpio &gpio, uint8_t load_pin, SagCapture &sag)
+        : gpio_(gpio), pin_(load_pin), sag_(sag) {}
+
+    void set_output(uint8_t pin) override { gpio_.set_output(pin); }
+    void write(uint8_t pin, bool high) override {
+        gpio_.write(pin, high);
+        if (pin == pin_) mark(high);
+    }
+    void write_pwm(uint8_t pin, uint8_t duty) override {
+        gpio_.write_pwm(pin, duty);
+        if (pin == pin_) mark(duty != 0);
+    }
+
+private:
+    void mark(bool on) {
+        if (on) {
+            sag_.load_on();
+            loaded_ = true;
+        } else if (loaded_) {
+            sag_.load_off();
+        }
+    }
+
+    HalGpio    &gpio_;
+    uint8_t     pin_;
+    SagCapture &sag_;
+    bool        loaded_ = false;
+};
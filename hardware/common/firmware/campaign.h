@@ -0,0 +1,111 @@
+#pragma once
+#include <stdint.h>
+#include <sys/time.h>
+
+/*
+ * Synoptic campaigns: the whole fleet measures at one instant, so contour
+ * maps and gradients come from one snapshot instead of readings spread
+ * over a report interval.
+ *
+ * Unit clocks are free-running RTCs started at power-up. Every cellular
+ * ingest reply carries the backend's UTC ("utc_ms") and is a clock sync:
+ * the request's round trip bounds the offset error, and syncs far enough
+ * apart estimate the RTC's skew. A reply may also announce a campaign
+ * ("campaign": {"id", "at", "max_err_ms"}, at in Unix seconds). The unit
+ * converts the instant to its own clock, wakes for it, and tags the
+ * reading with the campaign id, how far from the instant it thinks it
+ * measured, and the error bound of that estimate. When the bound at the
+ * instant would exceed max_err_ms, the reports before it go cellular to
+ * pick up a fresh sync.
+ *
+ * Times are ms. "Unit clock" is gettimeofday(), which on the ESP32 runs
+ * from the RTC through deep sleep.
+ */
+
+#define CAMPAIGN_EARLY_MS   20      // a wake this close before the instant is the snapshot
+
+struct ClockSync {
+    int64_t  offset_ms;     // UTC − unit clock at the last sync
+    int64_t  synced_ms;     // unit clock of the last sync; 0 = never
+    float    skew_ppm;      // unit clock fast (+) or slow (−) against UTC
+    uint32_t err_ms;        // half the round trip of the last sync
+    uint8_t  skew_known;    // estimated from two syncs skew_min_s apart
+};
+
+struct ClockParams {
+    float    drift_ppm;     // RTC drift bound while the skew is unknown…
+    float    residual_ppm;  // …and what is left once it is corrected
+    uint32_t skew_min_s;    // shorter spans are dominated by the sync error
+    uint32_t sync_max_s;    // ask for a sync when the last is older; 0 = never
+};
+
+struct Campaign {
+    uint32_t id;            // 0 = none scheduled
+    int64_t  at_utc_ms;
+    uint32_t max_err_ms;
+};
+
+inline int64_t unit_clock_ms() {
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+inline int64_t clock_to_utc(const ClockSync &c, int64_t unit_ms) {
+    return unit_ms + c.offset_ms - (int64_t)((unit_ms - c.synced_ms) * (double)c.skew_ppm * 1e-6);
+}
+
+// Inverse of clock_to_utc()
+inline int64_t clock_to_unit(const ClockSync &c, int64_t utc_ms) {
+    double k = c.skew_ppm * 1e-6;
+    return (int64_t)((utc_ms - c.offset_ms - c.synced_ms * k) / (1.0 - k));
+}
+
+// Bound on |clock_to_utc(unit_ms) − true UTC|
+inline uint32_t clock_error_ms(const ClockSync &c, const ClockParams &p, int64_t unit_ms) {
+    if (!c.synced_ms) return UINT32_MAX;
+    int64_t span = unit_ms - c.synced_ms;
+    if (span < 0) span = -span;
+    double e = c.err_ms + span * 1e-6 * (c.skew_known ? p.residual_ppm : p.drift_ppm);
+    return e >= UINT32_MAX ? UINT32_MAX : (uint32_t)e;
+}
+
+// One exchange: the request left at sent_ms and the reply, stamped
+// server_utc_ms by the backend, arrived at recv_ms (unit clock)
+inline void clock_sync_update(ClockSync &c, const ClockParams &p, int64_t sent_ms,
+                              int64_t recv_ms, int64_t server_utc_ms) {
+    int64_t mid = sent_ms + (recv_ms - sent_ms) / 2;
+    int64_t offset = server_utc_ms - mid;
+    int64_t span = mid - c.synced_ms;
+    if (c.synced_ms && span >= (int64_t)p.skew_min_s * 1000) {
+        // What the current model got wrong over the span is a skew error
+        double residual = (double)offset - (clock_to_utc(c, mid) - mid);
+        float est = c.skew_ppm - (float)(residual / span * 1e6);
+        c.skew_ppm = c.skew_known ? 0.5f * (c.skew_ppm + est) : est;
+        c.skew_known = 1;
+    }
+    c.offset_ms = offset;
+    c.synced_ms = mid;
+    c.err_ms = (uint32_t)((recv_ms - sent_ms + 1) / 2);
+}
+
+inline int64_t campaign_unit_ms(const ClockSync &c, const Campaign &cp) {
+    return clock_to_unit(c, cp.at_utc_ms);
+}
+
+// A cellular report now would be worth its cost for the clock: the last
+// sync is too old, or too loose to hit the next campaign within its bound
+inline bool clock_wants_sync(const ClockSync &c, const ClockParams &p, const Campaign &cp,
+                             int64_t unit_ms) {
+    if (!c.synced_ms) return true;
+    if (p.sync_max_s && unit_ms - c.synced_ms > (int64_t)p.sync_max_s * 1000) return true;
+    return cp.id && clock_error_ms(c, p, campaign_unit_ms(c, cp)) > cp.max_err_ms;
+}
+
+// Campaign tag for a reading taken at unit_ms: signed distance from the
+// instant, and the error bound of that estimate, both in seconds
+inline void campaign_offset(const ClockSync &c, const ClockParams &p, const Campaign &cp,
+                            int64_t unit_ms, float &dt_s, float &err_s) {
+    dt_s  = (clock_to_utc(c, unit_ms) - cp.at_utc_ms) / 1000.0f;
+    err_s = clock_error_ms(c, p, unit_ms) / 1000.0f;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * Digital Sensor Values
+ *
+ * Common currency between the digital sensor buses (Modbus RTU, SDI-12)
+ * and the firmware reading structs. Each bus driver fills DigitalValue
+ * entries; the firmware decides where a quantity lands (e.g. a pressure on
+ * slot 1 becomes the second digital well on WX-Level, or replaces the
+ * analog transducer on WX-Flow).
+ */
+
+enum SensorQuantity : uint8_t {
+    SQ_PRESSURE_PSI = 0,   // hydrostatic pressure, converted to level like the analog path
+    SQ_LEVEL_FT,           // sensor-computed water level above the sensor
+    SQ_TEMP_C,             // water temperature
+    SQ_EC_US,              // specific conductance, µS/cm
+};
+
+struct DigitalValue {
+    uint8_t quantity;      // SensorQuantity
+    uint8_t slot;          // which well / probe on this logger
+    float   value;
+    bool    ok;
+};
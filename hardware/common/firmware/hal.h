@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Hardware Abstraction Layer
+ *
+ * Thin interfaces over the parts of the board the measurement logic
+ * touches: ADC, clock, GPIO, radio, the modem UART and the supply
+ * monitor. The firmware binds them to the real peripherals
+ * (hal_arduino.h); the env:native build binds them to virtual time and
+ * scripted signals (hal_native.h), so run_heat_pulse(), build_json() and
+ * the level maths run unmodified on a Linux host.
+ */
+
+struct HalClock {
+    virtual ~HalClock() {}
+    virtual uint32_t now_ms() = 0;
+    virtual uint32_t now_us() = 0;
+    virtual void     delay_ms(uint32_t ms) = 0;
+    virtual void     delay_us(uint32_t us) = 0;
+};
+
+// One ADS1115-class converter, single-ended inputs 0–3.
+struct HalAdc {
+    virtual ~HalAdc() {}
+    // Blocking single-shot conversion
+    virtual int16_t read_single_ended(uint8_t channel) = 0;
+    // Non-blocking single-shot conversion, for pipelining across channels
+    virtual void    start_single_ended(uint8_t channel) = 0;
+    virtual bool    conversion_done() = 0;
+    virtual int16_t last_result() = 0;
+};
+
+struct HalGpio {
+    virtual ~HalGpio() {}
+    virtual void set_output(uint8_t pin) = 0;
+    virtual void write(uint8_t pin, bool high) = 0;
+    // Duty 0–255 for resistive loads; full on / off where there is no PWM
+    virtual void write_pwm(uint8_t pin, uint8_t duty) { write(pin, duty != 0); }
+};
+
+struct HalRadio {
+    virtual ~HalRadio() {}
+    virtual bool send(const uint8_t *buf, size_t len) = 0;
+    virtual void sleep() = 0;
+    // Wake-on-radio (wake_radio.h): one channel activity detection, true on
+    // a LoRa preamble; then one frame, its length or -1 on timeout. Radios
+    // that cannot listen never hear anything.
+    virtual bool cad(uint32_t timeout_ms) { (void)timeout_ms; return false; }
+    virtual int  receive(uint8_t *buf, size_t cap, uint32_t timeout_ms) {
+        (void)buf; (void)cap; (void)timeout_ms;
+        return -1;
+    }
+};
+
+// Byte stream to a UART peripheral (the SIM7000G AT port)
+struct HalSerial {
+    virtual ~HalSerial() {}
+    virtual size_t write(const uint8_t *buf, size_t len) = 0;
+    virtual int    read() = 0;     // -1 when no byte is waiting
+};
+
+// The MCU's own ADC run continuously (DMA) on the battery and solar
+// dividers, so the supply can be watched while the CPU is busy with a
+// load. Every battery conversion goes to sink, with the latest solar one,
+// from a background task until stop() returns.
+struct HalSupplyStream {
+    typedef void (*Sink)(void *ctx, float battery_v, float solar_v);
+    virtual ~HalSupplyStream() {}
+    virtual bool start(uint32_t pair_hz, Sink sink, void *ctx) = 0;
+    virtual void stop() = 0;
+};
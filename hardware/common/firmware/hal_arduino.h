@@ -0,0 +1,199 @@
+#pragma once
+#include <Arduino.h>
+#include <Adafruit_ADS1X15.h>
+#include <LoRa.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include "hal.h"
+
+static volatile uint8_t lora_cad_result;    // set from the DIO0 interrupt
+
+/*
+ * HAL bindings to the ESP32-S3 board: Arduino timing and GPIO, the
+ * Adafruit ADS1115 driver, the SX1276 LoRa driver, the modem UART and
+ * ADC1 in continuous (DMA) mode on the supply dividers.
+ */
+
+class ArduinoClock : public HalClock {
+public:
+    uint32_t now_ms() override { return millis(); }
+    uint32_t now_us() override { return micros(); }
+    void delay_ms(uint32_t ms) override { delay(ms); }
+    void delay_us(uint32_t us) override { delayMicroseconds(us); }
+};
+
+class Ads1115Adc : public HalAdc {
+public:
+    explicit Ads1115Adc(Adafruit_ADS1115 &ads) : ads_(ads) {}
+
+    int16_t read_single_ended(uint8_t channel) override {
+        return ads_.readADC_SingleEnded(channel);
+    }
+    void start_single_ended(uint8_t channel) override {
+        static const uint16_t MUX[4] = {
+            ADS1X15_REG_CONFIG_MUX_SINGLE_0, ADS1X15_REG_CONFIG_MUX_SINGLE_1,
+            ADS1X15_REG_CONFIG_MUX_SINGLE_2, ADS1X15_REG_CONFIG_MUX_SINGLE_3,
+        };
+        ads_.startADCReading(MUX[channel & 3], false);
+    }
+    bool conversion_done() override { return ads_.conversionComplete(); }
+    int16_t last_result() override { return ads_.getLastConversionResults(); }
+
+private:
+    Adafruit_ADS1115 &ads_;
+};
+
+class ArduinoGpio : public HalGpio {
+public:
+    void set_output(uint8_t pin) override { pinMode(pin, OUTPUT); }
+    void write(uint8_t pin, bool high) override { digitalWrite(pin, high ? HIGH : LOW); }
+    void write_pwm(uint8_t pin, uint8_t duty) override { analogWrite(pin, duty); }   // LEDC
+};
+
+class LoRaRadio : public HalRadio {
+public:
+    bool send(const uint8_t *buf, size_t len) override {
+        LoRa.beginPacket();
+        LoRa.write(buf, len);
+        return LoRa.endPacket();
+    }
+    void sleep() override { LoRa.sleep(); }
+
+    // CAD result arrives on DIO0 (CadDone); the interrupt is released
+    // again so parsePacket() can poll RxDone itself
+    bool cad(uint32_t timeout_ms) override {
+        lora_cad_result = CAD_PENDING;
+        LoRa.onCadDone(on_cad_done);
+        LoRa.channelActivityDetection();
+        uint32_t start = millis();
+        while (lora_cad_result == CAD_PENDING && millis() - start < timeout_ms) delay(1);
+        LoRa.onCadDone(nullptr);
+        return lora_cad_result == CAD_DETECTED;
+    }
+
+    int receive(uint8_t *buf, size_t cap, uint32_t timeout_ms) override {
+        uint32_t start = millis();
+        while (millis() - start < timeout_ms) {
+            if (LoRa.parsePacket() > 0) {
+                size_t n = 0;
+                while (LoRa.available() && n < cap) buf[n++] = (uint8_t)LoRa.read();
+                return (int)n;
+            }
+            delay(1);
+        }
+        LoRa.idle();
+        return -1;
+    }
+
+private:
+    enum { CAD_PENDING, CAD_CLEAR, CAD_DETECTED };
+    static void on_cad_done(bool detected) { lora_cad_result = detected ? CAD_DETECTED : CAD_CLEAR; }
+};
+
+class ArduinoSerial : public HalSerial {
+public:
+    explicit ArduinoSerial(Stream &s) : s_(s) {}
+    size_t write(const uint8_t *buf, size_t len) override { return s_.write(buf, len); }
+    int read() override { return s_.read(); }
+
+private:
+    Stream &s_;
+};
+
+/*
+ * Battery and solar dividers on ADC1 in continuous mode (ESP-IDF 4.4
+ * adc_digi driver, as in Arduino-ESP32 2.x). The DMA fills frames in the
+ * background; a task on the other core drains them, converts with the
+ * eFuse calibration and feeds the sink. analogRead() must not be used on
+ * these pins between start() and stop().
+ */
+class Esp32SupplyStream : public HalSupplyStream {
+public:
+    Esp32SupplyStream(uint8_t battery_pin, uint8_t solar_pin, float divider)
+        : battery_pin_(battery_pin), solar_pin_(solar_pin), divider_(divider) {}
+
+    bool start(uint32_t pair_hz, Sink sink, void *ctx) override {
+        int8_t ch[2] = { digitalPinToAnalogChannel(battery_pin_),
+                         digitalPinToAnalogChannel(solar_pin_) };
+        for (int i = 0; i < 2; i++) {
+            if (ch[i] < 0 || ch[i] >= SOC_ADC_CHANNEL_NUM(0)) return false;   // ADC1 only
+        }
+        adc_digi_init_config_t init = {};
+        init.max_store_buf_size = 4 * FRAME_BYTES;
+        init.conv_num_each_intr = FRAME_BYTES;
+        init.adc1_chan_mask = BIT(ch[0]) | BIT(ch[1]);
+        if (adc_digi_initialize(&init) != ESP_OK) return false;
+
+        adc_digi_pattern_config_t pattern[2] = {};
+        for (int i = 0; i < 2; i++) {
+            pattern[i].atten = ADC_ATTEN_DB_11;
+            pattern[i].channel = ch[i];
+            pattern[i].unit = 0;
+            pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        }
+        adc_digi_configuration_t cfg = {};
+        cfg.sample_freq_hz = pair_hz * 2;
+        cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+        cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+        cfg.pattern_num = 2;
+        cfg.adc_pattern = pattern;
+        if (adc_digi_controller_configure(&cfg) != ESP_OK) {
+            adc_digi_deinitialize();
+            return false;
+        }
+        esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &cal_);
+
+        battery_ch_ = ch[0];
+        sink_ = sink;
+        ctx_ = ctx;
+        solar_v_ = -1;
+        stopping_ = false;
+        running_ = true;
+        adc_digi_start();
+        if (xTaskCreatePinnedToCore(run, "supply", 3072, this, 5, nullptr, 0) != pdPASS) {
+            running_ = false;
+            stop();
+            return false;
+        }
+        return true;
+    }
+
+    void stop() override {
+        stopping_ = true;
+        while (running_) delay(1);
+        adc_digi_stop();
+        adc_digi_deinitialize();
+    }
+
+private:
+    static const uint32_t FRAME_BYTES = 256;
+
+    static void run(void *arg) {
+        Esp32SupplyStream *s = (Esp32SupplyStream *)arg;
+        uint8_t buf[FRAME_BYTES];
+        while (!s->stopping_) {
+            uint32_t n = 0;
+            if (adc_digi_read_bytes(buf, sizeof(buf), &n, 10) != ESP_OK) continue;
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= n; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                const adc_digi_output_data_t *d = (const adc_digi_output_data_t *)&buf[i];
+                float v = esp_adc_cal_raw_to_voltage(d->type2.data, &s->cal_) / 1000.0f * s->divider_;
+                if (d->type2.channel != s->battery_ch_) {
+                    s->solar_v_ = v;
+                } else if (s->solar_v_ >= 0) {         // pairs start at the first solar one
+                    s->sink_(s->ctx_, v, s->solar_v_);
+                }
+            }
+        }
+        s->running_ = false;
+        vTaskDelete(nullptr);
+    }
+
+    uint8_t  battery_pin_, solar_pin_;
+    float    divider_;
+    int8_t   battery_ch_ = -1;
+    esp_adc_cal_characteristics_t cal_;
+    Sink     sink_ = nullptr;
+    void    *ctx_ = nullptr;
+    float    solar_v_ = -1;
+    volatile bool stopping_ = false, running_ = false;
+};
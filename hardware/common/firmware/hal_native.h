@@ -0,0 +1,153 @@
+#pragma once
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "hal.h"
+#include "adc_trace.h"
+
+/*
+ * Host-side HAL backends for the env:native build.
+ *
+ * Time is virtual: delays advance a counter instead of sleeping, so a
+ * 65-second heat-pulse cycle replays in microseconds of host time. ADC
+ * conversions cost their real duration in virtual time and return codes
+ * from a script (a function of channel and time), and GPIO writes are
+ * logged with timestamps so a simulator can see when the heater was on.
+ */
+
+class VirtualClock : public HalClock {
+public:
+    uint32_t now_ms() override { return (uint32_t)(t_us_ / 1000); }
+    uint32_t now_us() override { return (uint32_t)t_us_; }
+    void delay_ms(uint32_t ms) override { t_us_ += (uint64_t)ms * 1000; }
+    void delay_us(uint32_t us) override { t_us_ += us; }
+
+    uint64_t time_us() const { return t_us_; }
+    void     advance_us(uint64_t us) { t_us_ += us; }
+    void     reset(uint64_t t_us = 0) { t_us_ = t_us; }
+
+private:
+    uint64_t t_us_ = 0;
+};
+
+// Returns the raw ADC code for (channel, virtual time in µs)
+typedef std::function<int16_t(uint8_t, uint64_t)> AdcScript;
+
+class ScriptedAdc : public HalAdc {
+public:
+    // conversion_us: 1/data-rate; the firmware runs the ADS1115 at 128 SPS
+    ScriptedAdc(VirtualClock &clock, AdcScript script, uint32_t conversion_us = 7813)
+        : clock_(clock), script_(script), conversion_us_(conversion_us) {}
+
+    int16_t read_single_ended(uint8_t channel) override {
+        clock_.advance_us(conversion_us_);
+        conversions++;
+        return script_(channel, clock_.time_us());
+    }
+    void start_single_ended(uint8_t channel) override {
+        channel_ = channel;
+        done_at_us_ = clock_.time_us() + conversion_us_;
+    }
+    bool conversion_done() override {
+        // Polling costs time, like an I2C config-register read
+        if (clock_.time_us() < done_at_us_) clock_.advance_us(200);
+        return clock_.time_us() >= done_at_us_;
+    }
+    int16_t last_result() override {
+        conversions++;
+        return script_(channel_, done_at_us_);
+    }
+
+    void set_script(AdcScript script) { script_ = script; }
+
+    uint64_t conversions = 0;
+
+private:
+    VirtualClock &clock_;
+    AdcScript     script_;
+    uint32_t      conversion_us_;
+    uint8_t       channel_ = 0;
+    uint64_t      done_at_us_ = 0;
+};
+
+// Feeds one converter's codes from a recorded AdcTrace back in recorded
+// order, moving virtual time forward to each sample's timestamp so that
+// time-dependent analysis (peak times) sees the field timing.
+class ReplayAdc : public HalAdc {
+public:
+    ReplayAdc(VirtualClock &clock, const std::vector<AdcTraceSample> &samples, uint8_t adc_id)
+        : clock_(clock), samples_(samples), id_(adc_id) {}
+
+    int16_t read_single_ended(uint8_t channel) override { return next(channel); }
+    void start_single_ended(uint8_t channel) override { channel_ = channel; }
+    bool conversion_done() override { return true; }
+    int16_t last_result() override { return next(channel_); }
+
+    // Conversions asked for on a different channel than recorded, and past
+    // the end of the trace; either means the code no longer matches the trace
+    uint32_t mismatches = 0;
+    uint32_t underruns  = 0;
+
+private:
+    int16_t next(uint8_t channel) {
+        while (pos_ < samples_.size() && samples_[pos_].adc != id_) pos_++;
+        if (pos_ >= samples_.size()) {
+            underruns++;
+            return last_code_;
+        }
+        const AdcTraceSample &s = samples_[pos_++];
+        if (s.channel != channel) mismatches++;
+        if (clock_.time_us() < s.t_us) clock_.reset(s.t_us);
+        last_code_ = s.code;
+        return s.code;
+    }
+
+    VirtualClock                       &clock_;
+    const std::vector<AdcTraceSample>  &samples_;
+    uint8_t                             id_;
+    uint8_t                             channel_ = 0;
+    size_t                              pos_ = 0;
+    int16_t                             last_code_ = 0;
+};
+
+struct GpioEvent {
+    uint64_t t_us;
+    uint8_t  pin;
+    bool     high;
+    uint8_t  duty;     // 255 for write(pin, true)
+};
+
+class RecordingGpio : public HalGpio {
+public:
+    explicit RecordingGpio(VirtualClock &clock) : clock_(clock) {}
+
+    void set_output(uint8_t) override {}
+    void write(uint8_t pin, bool high) override {
+        events.push_back({ clock_.time_us(), pin, high, (uint8_t)(high ? 255 : 0) });
+        if (pin < 64) level_[pin] = high;
+    }
+    void write_pwm(uint8_t pin, uint8_t duty) override {
+        events.push_back({ clock_.time_us(), pin, duty != 0, duty });
+        if (pin < 64) level_[pin] = duty != 0;
+    }
+    bool level(uint8_t pin) const { return pin < 64 && level_[pin]; }
+
+    std::vector<GpioEvent> events;
+
+private:
+    VirtualClock &clock_;
+    bool          level_[64] = {};
+};
+
+class CaptureRadio : public HalRadio {
+public:
+    bool send(const uint8_t *buf, size_t len) override {
+        packets.emplace_back((const char *)buf, len);
+        return succeed;
+    }
+    void sleep() override {}
+
+    std::vector<std::string> packets;
+    bool succeed = true;
+};
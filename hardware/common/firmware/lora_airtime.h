@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+/*
+ * LoRa time-on-air (Semtech SX1276 datasheet §4.1.1.7 / AN1200.13).
+ *
+ * cr_denom is the coding-rate denominator: 5..8 for 4/5..4/8. The
+ * sandeepmistry LoRa library defaults are 4/5, 8-symbol preamble, explicit
+ * header and CRC off, which is how the firmware transmits.
+ */
+
+inline uint32_t lora_symbol_us(uint8_t sf, uint32_t bw_hz) {
+    return (uint32_t)((1UL << sf) * 1000000.0 / bw_hz);
+}
+
+inline uint32_t lora_airtime_us(uint8_t sf, uint32_t bw_hz, uint16_t payload_len,
+                                uint8_t cr_denom = 5, uint16_t preamble = 8,
+                                bool crc = false, bool implicit_header = false) {
+    double t_sym = (double)(1UL << sf) * 1e6 / bw_hz;
+    bool   ldro  = t_sym > 16000.0;     // low data-rate optimization above 16 ms symbols
+    double t_preamble = (preamble + 4.25) * t_sym;
+
+    int num = 8 * payload_len - 4 * sf + 28 + (crc ? 16 : 0) - (implicit_header ? 20 : 0);
+    int den = 4 * (sf - (ldro ? 2 : 0));
+    int blocks = num > 0 ? (num + den - 1) / den : 0;
+    double n_payload = 8 + blocks * cr_denom;
+
+    return (uint32_t)(t_preamble + n_payload * t_sym);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+/*
+ * Minimal microbenchmark harness for the env:native build.
+ *
+ * Each case is run in growing batches until it has taken at least
+ * min_ms of wall time, then reported as ns/op. Output is one line per
+ * case, "BENCH <name> <ns/op> <iterations>", easy to diff across commits
+ * or feed to a CI regression check.
+ */
+
+template <typename T>
+inline void bench_keep(T const &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchResult {
+    const char *name;
+    double      ns_per_op;
+    uint64_t    iterations;
+};
+
+template <typename F>
+inline BenchResult bench_run(const char *name, F &&fn, uint32_t min_ms = 200) {
+    using clock = std::chrono::steady_clock;
+    for (int i = 0; i < 16; i++) fn();    // warm caches and branch predictors
+
+    uint64_t batch = 1, total = 0;
+    double   elapsed_ns = 0;
+    while (elapsed_ns < min_ms * 1e6) {
+        auto t0 = clock::now();
+        for (uint64_t i = 0; i < batch; i++) fn();
+        auto t1 = clock::now();
+        elapsed_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        total += batch;
+        if (batch < (1ULL << 30)) batch *= 2;
+    }
+    BenchResult r = { name, elapsed_ns / total, total };
+    printf("BENCH %-32s %12.1f ns/op %12llu\n", r.name, r.ns_per_op,
+           (unsigned long long)r.iterations);
+    fflush(stdout);
+    return r;
+}
+
+// Optional filter from argv: run only cases whose name contains argv[1]
+inline bool bench_selected(int argc, char **argv, const char *name) {
+    return argc < 2 || strstr(name, argv[1]) != nullptr;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <Arduino.h>
+#include <driver/uart.h>
+#include "modbus_rtu.h"
+
+/*
+ * ESP32-S3 RS-485 transport for ModbusMaster.
+ *
+ * Uses the IDF UART driver in RS485 half-duplex mode: the UART peripheral
+ * toggles the transceiver DE pin (wired to RTS) itself, and TX/RX move
+ * through the hardware FIFOs and the driver's interrupt-fed ring buffers,
+ * so the CPU only touches whole frames. The RX timeout interrupt is set to
+ * ~t3.5 so a response is handed over as soon as the slave goes quiet.
+ */
+
+class Esp32ModbusPort : public ModbusPort {
+public:
+    Esp32ModbusPort(uart_port_t uart, int pin_tx, int pin_rx, int pin_de, uint32_t baud)
+        : uart_(uart), pin_tx_(pin_tx), pin_rx_(pin_rx), pin_de_(pin_de),
+          baud_(baud), installed_(false) {}
+
+    ~Esp32ModbusPort() { end(); }
+
+    bool begin() {
+        uart_config_t cfg = {};
+        cfg.baud_rate  = (int)baud_;
+        cfg.data_bits  = UART_DATA_8_BITS;
+        cfg.parity     = UART_PARITY_EVEN;     // Modbus RTU default 8E1
+        cfg.stop_bits  = UART_STOP_BITS_1;
+        cfg.flow_ctrl  = UART_HW_FLOWCTRL_DISABLE;
+        cfg.source_clk = UART_SCLK_DEFAULT;
+
+        if (uart_driver_install(uart_, MODBUS_MAX_FRAME * 2, 0, 0, NULL, 0) != ESP_OK) {
+            return false;
+        }
+        installed_ = true;
+        if (uart_param_config(uart_, &cfg) != ESP_OK) return false;
+        if (uart_set_pin(uart_, pin_tx_, pin_rx_, pin_de_, UART_PIN_NO_CHANGE) != ESP_OK) {
+            return false;
+        }
+        if (uart_set_mode(uart_, UART_MODE_RS485_HALF_DUPLEX) != ESP_OK) return false;
+        // RX timeout in character times; 4 ≥ t3.5
+        uart_set_rx_timeout(uart_, 4);
+        return true;
+    }
+
+    void end() {
+        if (installed_) {
+            uart_driver_delete(uart_);
+            installed_ = false;
+        }
+    }
+
+    size_t write(const uint8_t *buf, size_t len) override {
+        int n = uart_write_bytes(uart_, (const char *)buf, len);
+        return n < 0 ? 0 : (size_t)n;
+    }
+
+    size_t read(uint8_t *buf, size_t len, uint32_t timeout_ms) override {
+        int n = uart_read_bytes(uart_, buf, len, pdMS_TO_TICKS(timeout_ms) + 1);
+        return n < 0 ? 0 : (size_t)n;
+    }
+
+    void discard_input() override { uart_flush_input(uart_); }
+
+    uint32_t micros_now() override { return micros(); }
+
+    void delay_us(uint32_t us) override {
+        if (us >= 2000) delay(us / 1000);
+        delayMicroseconds(us % 1000);
+    }
+
+private:
+    uart_port_t uart_;
+    int         pin_tx_;
+    int         pin_rx_;
+    int         pin_de_;
+    uint32_t    baud_;
+    bool        installed_;
+};
@@ -0,0 +1,285 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "digital_sensors.h"
+
+/*
+ * Modbus RTU Master
+ *
+ * Polls holding/input registers from several slaves on one RS-485 bus.
+ * Fields from the per-sensor register maps in config.h are coalesced into
+ * block reads (one request per register span per slave), and each block is
+ * decoded while the next request is on the wire, so bus time goes to
+ * transfers instead of parsing. Modbus is strictly one request in flight,
+ * so this is as far as pipelining can go on a single bus.
+ *
+ * Frame timing follows the spec: a t3.5 silent interval before every
+ * request, derived from the baud rate (fixed 1750µs above 19200 baud).
+ * Responses are read by expected length instead of waiting for the idle gap.
+ *
+ * The transport sits behind ModbusPort, so the same master runs on the
+ * ESP32-S3 UART (modbus_port_esp32.h) and against the simulated slave on a
+ * host pseudo-terminal (hardware/tools/modbus).
+ */
+
+enum ModbusFunc : uint8_t {
+    MB_READ_HOLDING = 0x03,
+    MB_READ_INPUT   = 0x04,
+};
+
+enum ModbusType : uint8_t {
+    MB_U16 = 0,
+    MB_S16,
+    MB_U32,            // high word first (ABCD)
+    MB_S32,
+    MB_F32,            // IEEE-754, high word first (ABCD)
+    MB_F32_SWAP,       // IEEE-754, low word first (CDAB) — common on sondes
+};
+
+// One register-mapped value. value = raw × scale + offset, in the units
+// of the target quantity (PSI, ft, °C, µS/cm).
+struct ModbusField {
+    uint8_t  slave;
+    uint8_t  func;       // ModbusFunc
+    uint16_t reg;        // zero-based register address
+    uint8_t  type;       // ModbusType
+    float    scale;
+    float    offset;
+    uint8_t  quantity;   // SensorQuantity
+    uint8_t  slot;
+};
+
+// A contiguous register span read in one transaction. Fields of one slave
+// should be listed together in config so they fall into the same block.
+struct ModbusBlock {
+    uint8_t  slave;
+    uint8_t  func;
+    uint16_t start;
+    uint16_t count;
+    uint8_t  first_field;
+    uint8_t  n_fields;
+};
+
+#define MODBUS_MAX_FRAME       256
+#define MODBUS_MAX_BLOCK_REGS  32   // keep frames short; sondes often cap reads
+
+struct ModbusPort {
+    virtual ~ModbusPort() {}
+    virtual size_t   write(const uint8_t *buf, size_t len) = 0;
+    // Read up to len bytes, returning early once len arrive; 0 on timeout.
+    virtual size_t   read(uint8_t *buf, size_t len, uint32_t timeout_ms) = 0;
+    virtual void     discard_input() = 0;
+    virtual uint32_t micros_now() = 0;
+    virtual void     delay_us(uint32_t us) = 0;
+};
+
+// ── Timing ──────────────────────────────────────────────────
+// 11 bits per character (start + 8 data + parity/stop + stop)
+inline uint32_t modbus_char_us(uint32_t baud) {
+    return (11UL * 1000000UL + baud - 1) / baud;
+}
+
+inline uint32_t modbus_t35_us(uint32_t baud) {
+    return baud > 19200 ? 1750 : (modbus_char_us(baud) * 7 + 1) / 2;
+}
+
+// ── CRC-16/MODBUS (nibble table: 32 bytes of flash, 2 lookups/byte) ──
+inline uint16_t modbus_crc16(const uint8_t *buf, size_t len) {
+    static const uint16_t T[16] = {
+        0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+        0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400,
+    };
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 4) ^ T[(crc ^ buf[i]) & 0x0F];
+        crc = (crc >> 4) ^ T[(crc ^ (buf[i] >> 4)) & 0x0F];
+    }
+    return crc;
+}
+
+inline uint8_t modbus_type_regs(uint8_t type) {
+    return (type == MB_U16 || type == MB_S16) ? 1 : 2;
+}
+
+/*
+ * Coalesce consecutive fields of the same slave/function into blocks.
+ * Returns the number of blocks written to out (≤ cap).
+ */
+inline size_t modbus_plan_blocks(const ModbusField *fields, size_t n,
+                                 ModbusBlock *out, size_t cap) {
+    size_t nb = 0;
+    for (size_t i = 0; i < n; i++) {
+        const ModbusField &f = fields[i];
+        uint16_t end = f.reg + modbus_type_regs(f.type);
+        if (nb > 0) {
+            ModbusBlock &b = out[nb - 1];
+            uint16_t lo = f.reg < b.start ? f.reg : b.start;
+            uint16_t hi = end > b.start + b.count ? end : b.start + b.count;
+            if (b.slave == f.slave && b.func == f.func &&
+                hi - lo <= MODBUS_MAX_BLOCK_REGS) {
+                b.start = lo;
+                b.count = hi - lo;
+                b.n_fields++;
+                continue;
+            }
+        }
+        if (nb == cap) break;
+        out[nb].slave       = f.slave;
+        out[nb].func        = f.func;
+        out[nb].start       = f.reg;
+        out[nb].count       = end - f.reg;
+        out[nb].first_field = (uint8_t)i;
+        out[nb].n_fields    = 1;
+        nb++;
+    }
+    return nb;
+}
+
+struct ModbusStats {
+    uint32_t requests;
+    uint32_t timeouts;
+    uint32_t crc_errors;
+    uint32_t exceptions;
+    uint8_t  last_exception;
+};
+
+class ModbusMaster {
+public:
+    ModbusMaster(ModbusPort &port, uint32_t baud, uint32_t timeout_ms)
+        : port_(port), t35_us_(modbus_t35_us(baud)),
+          char_us_(modbus_char_us(baud)), timeout_ms_(timeout_ms),
+          last_activity_us_(0) {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    /*
+     * Read every block and fill one DigitalValue per field (same order as
+     * fields). Returns the number of fields read successfully.
+     */
+    size_t poll(const ModbusField *fields, const ModbusBlock *blocks,
+                size_t nb, DigitalValue *out) {
+        uint8_t rx[2][MODBUS_MAX_FRAME];
+        size_t ok_count = 0;
+        int  pending = -1;
+        bool pending_ok = false;
+
+        for (size_t b = 0; b < nb; b++) {
+            send_request(blocks[b]);
+            // Decode the previous block during the slave's turnaround
+            if (pending >= 0) {
+                ok_count += decode_block(fields, blocks[pending],
+                                         pending_ok ? rx[pending & 1] : nullptr, out);
+            }
+            pending_ok = receive_response(blocks[b], rx[b & 1]);
+            pending = (int)b;
+        }
+        if (pending >= 0) {
+            ok_count += decode_block(fields, blocks[pending],
+                                     pending_ok ? rx[pending & 1] : nullptr, out);
+        }
+        return ok_count;
+    }
+
+    ModbusStats stats;
+
+private:
+    void wait_silent_interval() {
+        uint32_t since = port_.micros_now() - last_activity_us_;
+        if (since < t35_us_) port_.delay_us(t35_us_ - since);
+    }
+
+    void send_request(const ModbusBlock &b) {
+        uint8_t req[8];
+        req[0] = b.slave;
+        req[1] = b.func;
+        req[2] = b.start >> 8;
+        req[3] = b.start & 0xFF;
+        req[4] = b.count >> 8;
+        req[5] = b.count & 0xFF;
+        uint16_t crc = modbus_crc16(req, 6);
+        req[6] = crc & 0xFF;
+        req[7] = crc >> 8;
+
+        wait_silent_interval();
+        port_.discard_input();
+        port_.write(req, sizeof(req));
+        // Response cannot start before our frame has left the wire
+        last_activity_us_ = port_.micros_now() + sizeof(req) * char_us_;
+        stats.requests++;
+    }
+
+    bool receive_response(const ModbusBlock &b, uint8_t *rx) {
+        // Header first: addr, func, byte count (or exception code)
+        size_t n = port_.read(rx, 3, timeout_ms_);
+        if (n < 3) {
+            last_activity_us_ = port_.micros_now();
+            stats.timeouts++;
+            return false;
+        }
+        size_t total = (rx[1] & 0x80) ? 5 : 5 + (size_t)b.count * 2;
+        uint32_t tail_ms = (uint32_t)((total - 3) * char_us_ / 1000) + 1
+                         + t35_us_ / 1000 + 1;
+        n += port_.read(rx + 3, total - 3, tail_ms);
+        last_activity_us_ = port_.micros_now();
+        if (n < total) {
+            stats.timeouts++;
+            return false;
+        }
+
+        uint16_t crc = modbus_crc16(rx, total - 2);
+        if (rx[total - 2] != (crc & 0xFF) || rx[total - 1] != (crc >> 8)) {
+            stats.crc_errors++;
+            return false;
+        }
+        if (rx[0] != b.slave) return false;
+        if (rx[1] & 0x80) {
+            stats.exceptions++;
+            stats.last_exception = rx[2];
+            return false;
+        }
+        return rx[1] == b.func && rx[2] == b.count * 2;
+    }
+
+    static size_t decode_block(const ModbusField *fields, const ModbusBlock &b,
+                               const uint8_t *rx, DigitalValue *out) {
+        size_t ok_count = 0;
+        for (uint8_t k = 0; k < b.n_fields; k++) {
+            size_t idx = b.first_field + k;
+            const ModbusField &f = fields[idx];
+            DigitalValue &v = out[idx];
+            v.quantity = f.quantity;
+            v.slot     = f.slot;
+            v.ok       = rx != nullptr;
+            v.value    = 0;
+            if (!v.ok) continue;
+
+            const uint8_t *p = rx + 3 + (f.reg - b.start) * 2;
+            uint16_t w0 = (uint16_t)(p[0] << 8 | p[1]);
+            uint16_t w1 = modbus_type_regs(f.type) > 1 ? (uint16_t)(p[2] << 8 | p[3]) : 0;
+            float raw;
+            switch (f.type) {
+                case MB_U16: raw = (float)w0; break;
+                case MB_S16: raw = (float)(int16_t)w0; break;
+                case MB_U32: raw = (float)((uint32_t)w0 << 16 | w1); break;
+                case MB_S32: raw = (float)(int32_t)((uint32_t)w0 << 16 | w1); break;
+                case MB_F32_SWAP: { uint16_t t = w0; w0 = w1; w1 = t; }
+                    // fall through
+                default: {
+                    uint32_t bits = (uint32_t)w0 << 16 | w1;
+                    memcpy(&raw, &bits, sizeof(raw));
+                    break;
+                }
+            }
+            v.value = raw * f.scale + f.offset;
+            ok_count++;
+        }
+        return ok_count;
+    }
+
+    ModbusPort &port_;
+    uint32_t    t35_us_;
+    uint32_t    char_us_;
+    uint32_t    timeout_ms_;
+    uint32_t    last_activity_us_;
+};
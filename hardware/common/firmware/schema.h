@@ -0,0 +1,119 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Runtime half of the generated reading codecs (hardware/schema/). The
+ * generated build_json() is straight-line calls into JsonOut with every
+ * key a string literal and every precision a template argument, so a
+ * payload is written in one pass with no document tree, no heap and no
+ * float formatting.
+ *
+ * Numbers are rounded half away from zero to the field's decimals and
+ * printed without trailing zeros (18.50 → 18.5, 7.00 → 7). Non-finite
+ * values print as null.
+ */
+
+template <int D> struct SchemaPow10 { static constexpr float value = 10.0f * SchemaPow10<D - 1>::value; };
+template <> struct SchemaPow10<0> { static constexpr float value = 1.0f; };
+
+template <int D> inline int64_t schema_fixed(float v) {
+    float s = v * SchemaPow10<D>::value;
+    return (int64_t)(s < 0 ? s - 0.5f : s + 0.5f);
+}
+
+// v rounded to D decimals, as the payload carries it
+template <int D> inline float round_dp(float v) {
+    return schema_fixed<D>(v) / SchemaPow10<D>::value;
+}
+
+struct JsonOut {
+    char  *out;
+    size_t cap;
+    size_t len;
+    bool   overflow;
+
+    JsonOut(char *buf, size_t n) : out(buf), cap(n), len(0), overflow(n == 0) {}
+
+    void raw(const char *s, size_t n) {
+        if (overflow || len + n >= cap) {
+            overflow = true;
+            return;
+        }
+        memcpy(out + len, s, n);
+        len += n;
+    }
+
+    // Literal JSON text (keys with their punctuation); length at compile time
+    template <size_t N> void lit(const char (&s)[N]) { raw(s, N - 1); }
+
+    void str(const char *s) {
+        raw("\"", 1);
+        for (const char *p = s; *p; p++) {
+            if (*p == '"' || *p == '\\') raw("\\", 1);
+            raw(p, 1);
+        }
+        raw("\"", 1);
+    }
+
+    void boolean(bool b) {
+        if (b) lit("true");
+        else   lit("false");
+    }
+
+    void uint(uint64_t v) {
+        char tmp[20];
+        size_t n = 0;
+        do {
+            tmp[sizeof(tmp) - ++n] = '0' + v % 10;
+            v /= 10;
+        } while (v);
+        raw(tmp + sizeof(tmp) - n, n);
+    }
+
+    template <int D> void fixed(float v) {
+        if (!isfinite(v)) {
+            lit("null");
+            return;
+        }
+        int64_t q = schema_fixed<D>(v);
+        if (q < 0) {
+            raw("-", 1);
+            q = -q;
+        }
+        const uint64_t scale = (uint64_t)SchemaPow10<D>::value;
+        uint(q / scale);
+        uint64_t frac = q % scale;
+        if (!frac) return;
+        char tmp[8];
+        int n = D;
+        while (frac % 10 == 0) {
+            frac /= 10;
+            n--;
+        }
+        for (int k = n - 1; k >= 0; k--, frac /= 10) tmp[k] = '0' + frac % 10;
+        raw(".", 1);
+        raw(tmp, n);
+    }
+
+    template <int D> void fixed_array(const float *v, int n) {
+        raw("[", 1);
+        for (int i = 0; i < n; i++) {
+            if (i) raw(",", 1);
+            fixed<D>(v[i]);
+        }
+        raw("]", 1);
+    }
+
+    // NUL-terminates; 0 when the payload did not fit in cap
+    size_t finish() {
+        if (overflow) {
+            if (cap) out[0] = 0;
+            return 0;
+        }
+        out[len] = 0;
+        return len;
+    }
+};
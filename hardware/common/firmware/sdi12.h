@@ -0,0 +1,191 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "digital_sensors.h"
+
+/*
+ * SDI-12 Master — concurrent measurements
+ *
+ * Every sensor on the bus is started with aC! before any data is
+ * collected, so all of them measure in parallel. Each answers atttnn
+ * (ready in ttt seconds, nn values). Data is then read with aD0!, aD1!…
+ * in order of readiness. A string of five sensors takes about as long as
+ * its slowest member instead of the sum of all aM! waits.
+ *
+ * Break/marking timing lives in the Sdi12Port implementation
+ * (sdi12_port_esp32.h); this file only deals in command and response lines.
+ */
+
+#define SDI12_MAX_SENSORS    10
+#define SDI12_MAX_VALUES     20
+#define SDI12_LINE_MAX       82    // 75-char data response + address + CRLF
+#define SDI12_RESPONSE_MS    20    // first char within 15ms, plus margin
+#define SDI12_RETRIES        3
+
+// One value from one sensor. value = reading[index] × scale + offset.
+struct Sdi12Field {
+    char    addr;        // '0'–'9', 'a'–'z', 'A'–'Z'
+    uint8_t index;       // position in the concatenated aD0!…aD9! values
+    float   scale;
+    float   offset;
+    uint8_t quantity;    // SensorQuantity
+    uint8_t slot;
+};
+
+struct Sdi12Port {
+    virtual ~Sdi12Port() {}
+    // Wake the bus if needed (break + marking), send cmd, release the line.
+    virtual void     send_command(const char *cmd) = 0;
+    // Read one CRLF-terminated line without the CRLF; 0 on timeout.
+    virtual size_t   read_line(char *buf, size_t cap, uint32_t timeout_ms) = 0;
+    virtual uint32_t millis_now() = 0;
+    virtual void     delay_ms(uint32_t ms) = 0;
+};
+
+struct Sdi12Stats {
+    uint32_t commands;
+    uint32_t retries;
+    uint32_t no_response;
+    uint32_t bad_response;
+};
+
+/*
+ * Parse "a+1.23-4.5+6" into values. Returns the number appended, or -1 if
+ * the address does not match.
+ */
+inline int sdi12_parse_values(const char *line, char addr, float *out, int cap) {
+    if (line[0] != addr) return -1;
+    const char *p = line + 1;
+    int n = 0;
+    while (*p && n < cap) {
+        if (*p != '+' && *p != '-') break;
+        char *end;
+        float v = strtof(p, &end);
+        if (end == p) break;
+        out[n++] = v;
+        p = end;
+    }
+    return n;
+}
+
+class Sdi12Master {
+public:
+    explicit Sdi12Master(Sdi12Port &port) : port_(port) {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    /*
+     * Concurrent measurement of every sensor referenced by fields. Fills one
+     * DigitalValue per field (same order). Returns the number read.
+     */
+    size_t measure(const Sdi12Field *fields, size_t n, DigitalValue *out) {
+        Pending sensors[SDI12_MAX_SENSORS];
+        size_t ns = 0;
+        for (size_t i = 0; i < n; i++) {
+            out[i].quantity = fields[i].quantity;
+            out[i].slot     = fields[i].slot;
+            out[i].value    = 0;
+            out[i].ok       = false;
+            bool seen = false;
+            for (size_t s = 0; s < ns; s++) seen |= sensors[s].addr == fields[i].addr;
+            if (!seen && ns < SDI12_MAX_SENSORS) {
+                sensors[ns].addr = fields[i].addr;
+                sensors[ns].started = false;
+                sensors[ns].n_values = 0;
+                ns++;
+            }
+        }
+
+        // Start everyone: aC! → atttnn
+        uint32_t t_start = port_.millis_now();
+        for (size_t s = 0; s < ns; s++) {
+            char cmd[4] = { sensors[s].addr, 'C', '!', 0 };
+            char line[SDI12_LINE_MAX];
+            if (!transact(cmd, line, sizeof(line))) continue;
+            if (line[0] != sensors[s].addr || strlen(line) < 6) {
+                stats.bad_response++;
+                continue;
+            }
+            char ttt[4] = { line[1], line[2], line[3], 0 };
+            char nn[3]  = { line[4], line[5], 0 };
+            sensors[s].ready_ms = port_.millis_now() + (uint32_t)atoi(ttt) * 1000UL;
+            sensors[s].expected = atoi(nn);
+            sensors[s].started  = true;
+        }
+
+        // Collect in order of readiness
+        for (;;) {
+            int next = -1;
+            for (size_t s = 0; s < ns; s++) {
+                if (!sensors[s].started) continue;
+                if (next < 0 || (int32_t)(sensors[s].ready_ms - sensors[next].ready_ms) < 0) {
+                    next = (int)s;
+                }
+            }
+            if (next < 0) break;
+            Pending &p = sensors[next];
+            int32_t wait = (int32_t)(p.ready_ms - port_.millis_now());
+            if (wait > 0) port_.delay_ms((uint32_t)wait);
+            collect(p);
+            p.started = false;
+        }
+        elapsed_ms = port_.millis_now() - t_start;
+
+        size_t n_ok = 0;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t s = 0; s < ns; s++) {
+                if (sensors[s].addr != fields[i].addr) continue;
+                if (fields[i].index < sensors[s].n_values) {
+                    out[i].value = sensors[s].values[fields[i].index] * fields[i].scale
+                                 + fields[i].offset;
+                    out[i].ok = true;
+                    n_ok++;
+                }
+            }
+        }
+        return n_ok;
+    }
+
+    Sdi12Stats stats;
+    uint32_t   elapsed_ms = 0;
+
+private:
+    struct Pending {
+        char     addr;
+        bool     started;
+        uint32_t ready_ms;
+        int      expected;
+        int      n_values;
+        float    values[SDI12_MAX_VALUES];
+    };
+
+    bool transact(const char *cmd, char *line, size_t cap) {
+        for (int attempt = 0; attempt <= SDI12_RETRIES; attempt++) {
+            if (attempt > 0) stats.retries++;
+            stats.commands++;
+            port_.send_command(cmd);
+            if (port_.read_line(line, cap, SDI12_RESPONSE_MS + 80) > 0) return true;
+        }
+        stats.no_response++;
+        return false;
+    }
+
+    void collect(Pending &p) {
+        for (int d = 0; d <= 9 && p.n_values < p.expected; d++) {
+            char cmd[5] = { p.addr, 'D', (char)('0' + d), '!', 0 };
+            char line[SDI12_LINE_MAX];
+            if (!transact(cmd, line, sizeof(line))) return;
+            int got = sdi12_parse_values(line, p.addr, p.values + p.n_values,
+                                         SDI12_MAX_VALUES - p.n_values);
+            if (got <= 0) {
+                if (got < 0) stats.bad_response++;
+                return;    // sensor has no more data
+            }
+            p.n_values += got;
+        }
+    }
+
+    Sdi12Port &port_;
+};
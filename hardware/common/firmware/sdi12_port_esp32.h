@@ -0,0 +1,113 @@
+#pragma once
+#include <Arduino.h>
+#include <driver/uart.h>
+#include "sdi12.h"
+
+/*
+ * ESP32-S3 SDI-12 transport.
+ *
+ * SDI-12 is 1200 baud 7E1 with inverted logic on a single data line, so
+ * the UART runs with TX/RX inversion and a tri-state buffer (DIR pin)
+ * joins TX and RX to the bus. A break is ≥12ms of spacing followed by
+ * ≥8.33ms of marking; it is generated by taking the TX pin away from the
+ * UART briefly. Sensors drop back to sleep after 87ms of marking, so the
+ * break is only sent when the line has been idle that long.
+ */
+
+#define SDI12_BREAK_MS      13
+#define SDI12_MARKING_MS    9
+#define SDI12_IDLE_WAKE_MS  87
+
+class Esp32Sdi12Port : public Sdi12Port {
+public:
+    Esp32Sdi12Port(uart_port_t uart, int pin_tx, int pin_rx, int pin_dir)
+        : uart_(uart), pin_tx_(pin_tx), pin_rx_(pin_rx), pin_dir_(pin_dir),
+          installed_(false), last_activity_ms_(0), awake_(false) {}
+
+    ~Esp32Sdi12Port() { end(); }
+
+    bool begin() {
+        uart_config_t cfg = {};
+        cfg.baud_rate  = 1200;
+        cfg.data_bits  = UART_DATA_7_BITS;
+        cfg.parity     = UART_PARITY_EVEN;
+        cfg.stop_bits  = UART_STOP_BITS_1;
+        cfg.flow_ctrl  = UART_HW_FLOWCTRL_DISABLE;
+        cfg.source_clk = UART_SCLK_DEFAULT;
+
+        if (uart_driver_install(uart_, 256, 0, 0, NULL, 0) != ESP_OK) return false;
+        installed_ = true;
+        if (uart_param_config(uart_, &cfg) != ESP_OK) return false;
+        if (uart_set_pin(uart_, pin_tx_, pin_rx_, UART_PIN_NO_CHANGE,
+                         UART_PIN_NO_CHANGE) != ESP_OK) {
+            return false;
+        }
+        uart_set_line_inverse(uart_, UART_SIGNAL_TXD_INV | UART_SIGNAL_RXD_INV);
+        pinMode(pin_dir_, OUTPUT);
+        digitalWrite(pin_dir_, LOW);    // listen
+        return true;
+    }
+
+    void end() {
+        if (installed_) {
+            uart_driver_delete(uart_);
+            installed_ = false;
+        }
+    }
+
+    void send_command(const char *cmd) override {
+        digitalWrite(pin_dir_, HIGH);
+        if (!awake_ || millis() - last_activity_ms_ >= SDI12_IDLE_WAKE_MS) {
+            send_break();
+        }
+        size_t len = strlen(cmd);
+        uart_write_bytes(uart_, cmd, len);
+        // 7E1 = 10 bits/char at 1200 baud ≈ 8.33ms per char
+        uart_wait_tx_done(uart_, pdMS_TO_TICKS(len * 9 + 5));
+        digitalWrite(pin_dir_, LOW);    // release within 7.5ms of the stop bit
+        uart_flush_input(uart_);        // drop our own echo
+        last_activity_ms_ = millis();
+        awake_ = true;
+    }
+
+    size_t read_line(char *buf, size_t cap, uint32_t timeout_ms) override {
+        size_t n = 0;
+        uint32_t start = millis();
+        // Allow a full 75-char line to arrive once the first char is in
+        uint32_t limit = timeout_ms;
+        while (millis() - start < limit && n + 1 < cap) {
+            uint8_t c;
+            if (uart_read_bytes(uart_, &c, 1, pdMS_TO_TICKS(10)) != 1) continue;
+            if (n == 0) limit = timeout_ms + SDI12_LINE_MAX * 9;
+            c &= 0x7F;
+            if (c == '\n') break;
+            if (c != '\r') buf[n++] = (char)c;
+        }
+        buf[n] = 0;
+        last_activity_ms_ = millis();
+        return n;
+    }
+
+    uint32_t millis_now() override { return millis(); }
+    void delay_ms(uint32_t ms) override { delay(ms); }
+
+private:
+    void send_break() {
+        // Detach TX from the UART and drive the bus directly. The buffer is
+        // non-inverting, so HIGH on the pin is spacing on the line.
+        pinMode(pin_tx_, OUTPUT);
+        digitalWrite(pin_tx_, HIGH);
+        delay(SDI12_BREAK_MS);
+        digitalWrite(pin_tx_, LOW);
+        delay(SDI12_MARKING_MS);
+        uart_set_pin(uart_, pin_tx_, pin_rx_, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    }
+
+    uart_port_t uart_;
+    int         pin_tx_;
+    int         pin_rx_;
+    int         pin_dir_;
+    bool        installed_;
+    uint32_t    last_activity_ms_;
+    bool        awake_;
+};
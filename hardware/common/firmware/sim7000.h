@@ -0,0 +1,179 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal.h"
+
+/*
+ * SIM7000G AT client: PDP context and the SH* HTTP(S) stack.
+ *
+ * Each command waits for its final result code instead of a fixed delay,
+ * and HTTP responses are read back with AT+SHREAD so the backend can
+ * answer a reading with instructions (e.g. "upload the ADC trace for boot
+ * N"). Runs over HalSerial and HalClock, so it builds for the host too.
+ */
+
+#define SIM_LINE_MAX        160
+#define SIM_HTTP_BODYLEN    4096    // SH* stack limit per request body
+
+class Sim7000 {
+public:
+    Sim7000(HalSerial &io, HalClock &clock) : io_(io), clock_(clock) {}
+
+    // Send `cmd` and wait for a line containing `expect`. False on ERROR or
+    // timeout; the last line received is left in line().
+    bool command(const char *cmd, const char *expect = "OK", uint32_t timeout_ms = 1000) {
+        drain();
+        send_line(cmd);
+        return wait_for(expect, timeout_ms);
+    }
+
+    bool wait_for(const char *expect, uint32_t timeout_ms) {
+        uint32_t start = clock_.now_ms();
+        while (read_line(start, timeout_ms)) {
+            if (strstr(line_, expect)) return true;
+            if (strstr(line_, "ERROR")) return false;
+        }
+        return false;
+    }
+
+    // Wait for the module to answer AT after power-on, then open the PDP context
+    bool attach(const char *apn) {
+        bool alive = false;
+        for (int i = 0; i < 20 && !alive; i++) alive = command("AT", "OK", 500);
+        if (!alive) return false;
+        command("ATE0");
+
+        char cmd[96];
+        snprintf(cmd, sizeof(cmd), "AT+CNACT=1,\"%s\"", apn);
+        // Not just "ACTIVE": a failed activation reports "+APP PDP: DEACTIVE"
+        return command(cmd, "PDP: ACTIVE", 15000);
+    }
+
+    bool http_open(const char *base_url, uint16_t body_len = SIM_HTTP_BODYLEN) {
+        char cmd[128];
+        snprintf(cmd, sizeof(cmd), "AT+SHCONF=\"URL\",\"%s\"", base_url);
+        if (!command(cmd)) return false;
+        snprintf(cmd, sizeof(cmd), "AT+SHCONF=\"BODYLEN\",%u", body_len);
+        if (!command(cmd)) return false;
+        if (!command("AT+SHCONF=\"HEADERLEN\",350")) return false;
+        return command("AT+SHCONN", "OK", 15000);
+    }
+
+    /*
+     * POST `len` bytes to `path` on the open connection. Returns the HTTP
+     * status, or -1 if the modem failed. Up to resp_cap-1 bytes of the
+     * response body are copied to resp (NUL-terminated) when given.
+     */
+    int http_post(const char *path, const char *content_type, const uint8_t *body, size_t len,
+                  char *resp = nullptr, size_t resp_cap = 0) {
+        char cmd[160];
+        if (resp && resp_cap) resp[0] = '\0';
+        if (!command("AT+SHCHEAD")) return -1;
+        snprintf(cmd, sizeof(cmd), "AT+SHAHEAD=\"Content-Type\",\"%s\"", content_type);
+        if (!command(cmd)) return -1;
+
+        snprintf(cmd, sizeof(cmd), "AT+SHBOD=%u,10000", (unsigned)len);
+        drain();
+        send_line(cmd);
+        if (!wait_prompt(2000)) return -1;
+        io_.write(body, len);
+        if (!wait_for("OK", 10000)) return -1;
+
+        snprintf(cmd, sizeof(cmd), "AT+SHREQ=\"%s\",3", path);
+        if (!command(cmd)) return -1;
+        if (!wait_for("+SHREQ:", 30000)) return -1;
+
+        // +SHREQ: "POST",<status>,<body length>
+        const char *p = strchr(line_, ',');
+        if (!p) return -1;
+        int status = atoi(p + 1);
+        const char *q = strchr(p + 1, ',');
+        size_t body_len = q ? strtoul(q + 1, nullptr, 10) : 0;
+
+        if (resp && resp_cap > 1 && body_len > 0) read_body(resp, resp_cap, body_len);
+        return status;
+    }
+
+    void http_close()  { command("AT+SHDISC"); }
+    void detach()      { command("AT+CNACT=0", "OK", 5000); }
+    void power_off()   { command("AT+CPOWD=1", "POWER DOWN", 5000); }
+
+    // Instead of power_off(): stay registered with eDRX paging, and pulse RI
+    // on an incoming SMS so it can wake the MCU. Stored messages are deleted
+    // so the SIM never fills. False if the module refused any step.
+    bool ring_on_sms(const char *edrx_cycle) {
+        char cmd[48];
+        snprintf(cmd, sizeof(cmd), "AT+CEDRXS=1,4,\"%s\"", edrx_cycle);
+        return command("AT+CMGF=1") && command("AT+CMGD=1,4", "OK", 5000) &&
+               command("AT+CNMI=2,1") && command("AT+CFGRI=1") && command(cmd);
+    }
+
+    const char *line() const { return line_; }
+
+private:
+    void send_line(const char *cmd) {
+        io_.write((const uint8_t *)cmd, strlen(cmd));
+        io_.write((const uint8_t *)"\r\n", 2);
+    }
+
+    void drain() {
+        while (io_.read() >= 0) {}
+    }
+
+    // Next non-empty line into line_; false once the window has elapsed
+    bool read_line(uint32_t start, uint32_t timeout_ms) {
+        size_t n = 0;
+        while (clock_.now_ms() - start < timeout_ms) {
+            int c = io_.read();
+            if (c < 0) {
+                clock_.delay_ms(1);
+                continue;
+            }
+            if (c == '\r') continue;
+            if (c == '\n') {
+                if (n == 0) continue;
+                line_[n] = '\0';
+                return true;
+            }
+            if (n < SIM_LINE_MAX - 1) line_[n++] = (char)c;
+        }
+        line_[n] = '\0';
+        return false;
+    }
+
+    // AT+SHBOD answers with a bare '>' before it accepts the body
+    bool wait_prompt(uint32_t timeout_ms) {
+        uint32_t start = clock_.now_ms();
+        while (clock_.now_ms() - start < timeout_ms) {
+            int c = io_.read();
+            if (c == '>') return true;
+            if (c < 0) clock_.delay_ms(1);
+        }
+        return false;
+    }
+
+    void read_body(char *resp, size_t cap, size_t body_len) {
+        size_t want = body_len < cap - 1 ? body_len : cap - 1;
+        char cmd[32];
+        snprintf(cmd, sizeof(cmd), "AT+SHREAD=0,%u", (unsigned)want);
+        if (!command(cmd, "+SHREAD:", 5000)) return;
+
+        size_t got = 0;
+        uint32_t start = clock_.now_ms();
+        while (got < want && clock_.now_ms() - start < 5000) {
+            int c = io_.read();
+            if (c < 0) {
+                clock_.delay_ms(1);
+                continue;
+            }
+            resp[got++] = (char)c;
+        }
+        resp[got] = '\0';
+    }
+
+    HalSerial &io_;
+    HalClock  &clock_;
+    char       line_[SIM_LINE_MAX] = {};
+};
@@ -0,0 +1,337 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Packed time series for batched / backfilled readings (Gorilla-style).
+ *
+ * A batch of readings from one unit is a row of near-identical JSON
+ * objects. Here each field becomes a column, coded against its own
+ * previous value:
+ *
+ *   TS_DOD    fixed point, delta-of-delta: timestamps, boot_count
+ *   TS_DELTA  fixed point, delta: levels to 0.01 ft, battery to 0.01 V
+ *   TS_XOR    float32 XORed with the previous value (unrounded floats)
+ *
+ * Deltas are zig-zag coded into variable-width buckets, so an unchanged
+ * value costs one bit and a slowly varying one a handful.
+ *
+ * Layout (little-endian header, then an MSB-first bit stream):
+ *   u8 magic 0xD7, u8 version, u16 count, u32 t_ref,
+ *   device_id\0, device_type\0, u8 n_fields,
+ *   per field: u8 kind | decimals << 2, name\0
+ *   per record, per field in order:
+ *     first record: 32 raw bits (zig-zag fixed point, or float bits)
+ *     DOD second record: the delta; later records: delta-of-delta
+ *
+ * Field 0 is the record time in seconds on the unit's own clock. t_ref
+ * is that clock at upload, so the receiver dates record i at
+ * (arrival - (t_ref - t_i)) without the unit ever knowing wall time.
+ * Fixed-point fields read as TS_MISSING (0x80000000) when absent.
+ *
+ * The encoder state is plain data with no pointers into the buffer, so
+ * an RTC_DATA_ATTR TsEncoder and its buffer keep building one batch
+ * across deep-sleep cycles. add() either writes a whole record or
+ * nothing, so the buffer always holds a valid batch.
+ */
+
+#define TS_MAGIC        0xD7
+#define TS_VERSION      1
+#define TS_MAX_FIELDS   16
+#define TS_MISSING      ((int32_t)0x80000000)
+
+enum TsKind : uint8_t { TS_DOD = 0, TS_DELTA = 1, TS_XOR = 2 };
+
+struct TsField {
+    const char *name;
+    uint8_t     kind;
+    uint8_t     decimals;       // fixed point: value * 10^decimals
+};
+
+struct TsFieldState {
+    uint32_t prev;              // fixed-point value or float bits
+    int32_t  prev_delta;        // TS_DOD
+    uint8_t  lead, trail;       // TS_XOR window; lead = 0xFF before the first
+};
+
+// ── Bit stream ───────────────────────────────────────────────
+inline bool ts_put_bits(uint8_t *buf, size_t cap, uint32_t &bitpos, uint32_t v, uint8_t n) {
+    if (bitpos + n > cap * 8) return false;
+    for (int i = n - 1; i >= 0; i--) {
+        uint32_t byte = bitpos >> 3;
+        uint8_t mask = 0x80 >> (bitpos & 7);
+        if ((v >> i) & 1) buf[byte] |= mask;
+        else buf[byte] &= ~mask;
+        bitpos++;
+    }
+    return true;
+}
+
+inline bool ts_get_bits(const uint8_t *buf, size_t len, uint32_t &bitpos, uint8_t n, uint32_t &v) {
+    if (bitpos + n > len * 8) return false;
+    v = 0;
+    for (uint8_t i = 0; i < n; i++, bitpos++) {
+        v = v << 1 | ((buf[bitpos >> 3] >> (7 - (bitpos & 7))) & 1);
+    }
+    return true;
+}
+
+inline uint32_t ts_zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+inline int32_t ts_unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Zig-zag bucket: 0 | 10+4 | 110+8 | 1110+16 | 1111+32 bits
+inline bool ts_put_varbits(uint8_t *buf, size_t cap, uint32_t &bitpos, int32_t v) {
+    uint32_t z = ts_zigzag(v);
+    if (z == 0) return ts_put_bits(buf, cap, bitpos, 0, 1);
+    if (z < (1u << 4)) return ts_put_bits(buf, cap, bitpos, 0x2, 2) && ts_put_bits(buf, cap, bitpos, z, 4);
+    if (z < (1u << 8)) return ts_put_bits(buf, cap, bitpos, 0x6, 3) && ts_put_bits(buf, cap, bitpos, z, 8);
+    if (z < (1u << 16)) return ts_put_bits(buf, cap, bitpos, 0xE, 4) && ts_put_bits(buf, cap, bitpos, z, 16);
+    return ts_put_bits(buf, cap, bitpos, 0xF, 4) && ts_put_bits(buf, cap, bitpos, z, 32);
+}
+
+inline bool ts_get_varbits(const uint8_t *buf, size_t len, uint32_t &bitpos, int32_t &v) {
+    static const uint8_t width[5] = { 0, 4, 8, 16, 32 };
+    uint32_t bit, z = 0;
+    int ones = 0;
+    while (ones < 4) {
+        if (!ts_get_bits(buf, len, bitpos, 1, bit)) return false;
+        if (!bit) break;
+        ones++;
+    }
+    if (ones && !ts_get_bits(buf, len, bitpos, width[ones], z)) return false;
+    v = ts_unzigzag(z);
+    return true;
+}
+
+inline int32_t ts_to_fixed(double v, uint8_t decimals) {
+    if (isnan(v)) return TS_MISSING;
+    double s = v;
+    for (uint8_t i = 0; i < decimals; i++) s *= 10;
+    return (int32_t)lround(s);
+}
+
+inline double ts_from_fixed(int32_t v, uint8_t decimals) {
+    if (v == TS_MISSING) return NAN;
+    double s = v;
+    for (uint8_t i = 0; i < decimals; i++) s /= 10;
+    return s;
+}
+
+// ── Encoder ──────────────────────────────────────────────────
+struct TsEncoder {
+    uint16_t     count;
+    uint16_t     header_len;
+    uint32_t     bitpos;        // absolute, from the start of the buffer
+    uint32_t     cap;
+    uint8_t      n_fields;
+    TsField      fields[TS_MAX_FIELDS];
+    TsFieldState state[TS_MAX_FIELDS];
+
+    // Starts an empty batch in `buf`; false if the header does not fit
+    bool begin(uint8_t *buf, size_t buf_cap, const char *device_id, const char *device_type,
+               const TsField *f, uint8_t n) {
+        count = 0;
+        cap = (uint32_t)buf_cap;
+        n_fields = n > TS_MAX_FIELDS ? TS_MAX_FIELDS : n;
+        size_t len = 8;
+        size_t id_len = strlen(device_id) + 1, type_len = strlen(device_type) + 1;
+        if (len + id_len + type_len + 1 > buf_cap) return false;
+        buf[0] = TS_MAGIC;
+        buf[1] = TS_VERSION;
+        memset(buf + 2, 0, 6);
+        memcpy(buf + len, device_id, id_len);
+        len += id_len;
+        memcpy(buf + len, device_type, type_len);
+        len += type_len;
+        buf[len++] = n_fields;
+        for (uint8_t i = 0; i < n_fields; i++) {
+            size_t name_len = strlen(f[i].name) + 1;
+            if (len + 1 + name_len > buf_cap) return false;
+            fields[i] = f[i];
+            state[i] = { 0, 0, 0xFF, 0 };
+            buf[len++] = (uint8_t)(f[i].kind | f[i].decimals << 2);
+            memcpy(buf + len, f[i].name, name_len);
+            len += name_len;
+        }
+        header_len = (uint16_t)len;
+        bitpos = (uint32_t)len * 8;
+        return true;
+    }
+
+    // Appends one record (values[i] for fields[i]); false, with nothing
+    // written, when it does not fit
+    bool add(uint8_t *buf, const double *values) {
+        uint32_t pos = bitpos;
+        TsFieldState saved[TS_MAX_FIELDS];
+        memcpy(saved, state, sizeof(TsFieldState) * n_fields);
+        bool ok = true;
+        for (uint8_t i = 0; i < n_fields && ok; i++) ok = put_field(buf, i, values[i], pos);
+        if (!ok) {
+            memcpy(state, saved, sizeof(TsFieldState) * n_fields);
+            return false;
+        }
+        bitpos = pos;
+        count++;
+        buf[2] = count & 0xFF;
+        buf[3] = count >> 8;
+        return true;
+    }
+
+    // Stamps the unit's clock at upload; returns the batch length
+    size_t finish(uint8_t *buf, uint32_t t_ref) const {
+        memcpy(buf + 4, &t_ref, 4);
+        return (bitpos + 7) / 8;
+    }
+
+    size_t bytes() const { return (bitpos + 7) / 8; }
+
+private:
+    bool put_field(uint8_t *buf, uint8_t i, double value, uint32_t &pos) {
+        const TsField &f = fields[i];
+        TsFieldState &s = state[i];
+        if (f.kind == TS_XOR) {
+            float fv = (float)value;
+            uint32_t bits;
+            memcpy(&bits, &fv, 4);
+            if (!count) {
+                s.prev = bits;
+                return ts_put_bits(buf, cap, pos, bits, 32);
+            }
+            uint32_t x = bits ^ s.prev;
+            s.prev = bits;
+            if (!x) return ts_put_bits(buf, cap, pos, 0, 1);
+            uint8_t lead = (uint8_t)__builtin_clz(x), trail = (uint8_t)__builtin_ctz(x);
+            if (lead > 31) lead = 31;
+            if (s.lead != 0xFF && lead >= s.lead && trail >= s.trail) {
+                uint8_t n = 32 - s.lead - s.trail;
+                return ts_put_bits(buf, cap, pos, 0x2, 2) && ts_put_bits(buf, cap, pos, x >> s.trail, n);
+            }
+            s.lead = lead;
+            s.trail = trail;
+            uint8_t n = 32 - lead - trail;
+            return ts_put_bits(buf, cap, pos, 0x3, 2) && ts_put_bits(buf, cap, pos, lead, 5) &&
+                   ts_put_bits(buf, cap, pos, n - 1, 5) && ts_put_bits(buf, cap, pos, x >> trail, n);
+        }
+        int32_t v = ts_to_fixed(value, f.decimals);
+        if (!count) {
+            s.prev = (uint32_t)v;
+            return ts_put_bits(buf, cap, pos, ts_zigzag(v), 32);
+        }
+        int32_t delta = (int32_t)((uint32_t)v - s.prev);     // wraps; undone the same way
+        s.prev = (uint32_t)v;
+        if (f.kind == TS_DELTA || count == 1) {
+            s.prev_delta = delta;
+            return ts_put_varbits(buf, cap, pos, delta);
+        }
+        int32_t dod = (int32_t)((uint32_t)delta - (uint32_t)s.prev_delta);
+        s.prev_delta = delta;
+        return ts_put_varbits(buf, cap, pos, dod);
+    }
+};
+
+// ── Decoder ──────────────────────────────────────────────────
+// For host tools; the backend has its own (hardware.py decode_packed)
+struct TsDecoder {
+    const uint8_t *buf;
+    size_t         len;
+    uint16_t       count;
+    uint32_t       t_ref;
+    const char    *device_id, *device_type;
+    uint8_t        n_fields;
+    TsField        fields[TS_MAX_FIELDS];
+    TsFieldState   state[TS_MAX_FIELDS];
+    uint32_t       bitpos;
+    uint16_t       index;
+
+    bool begin(const uint8_t *data, size_t n) {
+        buf = data;
+        len = n;
+        if (n < 9 || data[0] != TS_MAGIC || data[1] != TS_VERSION) return false;
+        count = data[2] | data[3] << 8;
+        memcpy(&t_ref, data + 4, 4);
+        size_t p = 8;
+        auto str = [&](const char *&out) {
+            const void *z = memchr(data + p, 0, n - p);
+            if (!z) return false;
+            out = (const char *)data + p;
+            p = (const uint8_t *)z - data + 1;
+            return true;
+        };
+        if (!str(device_id) || !str(device_type) || p >= n) return false;
+        n_fields = data[p++];
+        if (n_fields > TS_MAX_FIELDS) return false;
+        for (uint8_t i = 0; i < n_fields; i++) {
+            if (p >= n) return false;
+            fields[i].kind = data[p] & 3;
+            fields[i].decimals = data[p] >> 2;
+            p++;
+            if (!str(fields[i].name)) return false;
+            state[i] = { 0, 0, 0xFF, 0 };
+        }
+        bitpos = (uint32_t)p * 8;
+        index = 0;
+        return true;
+    }
+
+    // Next record into values[n_fields]; false at the end or on corruption
+    bool next(double *values) {
+        if (index >= count) return false;
+        for (uint8_t i = 0; i < n_fields; i++) {
+            if (!get_field(i, values[i])) return false;
+        }
+        index++;
+        return true;
+    }
+
+private:
+    bool get_field(uint8_t i, double &out) {
+        const TsField &f = fields[i];
+        TsFieldState &s = state[i];
+        uint32_t v;
+        if (f.kind == TS_XOR) {
+            if (!index) {
+                if (!ts_get_bits(buf, len, bitpos, 32, v)) return false;
+            } else {
+                uint32_t ctl;
+                if (!ts_get_bits(buf, len, bitpos, 1, ctl)) return false;
+                if (!ctl) {
+                    v = s.prev;
+                } else {
+                    if (!ts_get_bits(buf, len, bitpos, 1, ctl)) return false;
+                    if (ctl) {
+                        uint32_t lead, n;
+                        if (!ts_get_bits(buf, len, bitpos, 5, lead) || !ts_get_bits(buf, len, bitpos, 5, n)) return false;
+                        s.lead = (uint8_t)lead;
+                        s.trail = (uint8_t)(32 - lead - (n + 1));
+                    }
+                    uint32_t x;
+                    if (!ts_get_bits(buf, len, bitpos, 32 - s.lead - s.trail, x)) return false;
+                    v = s.prev ^ (x << s.trail);
+                }
+            }
+            s.prev = v;
+            float fv;
+            memcpy(&fv, &v, 4);
+            out = fv;
+            return true;
+        }
+        if (!index) {
+            if (!ts_get_bits(buf, len, bitpos, 32, v)) return false;
+            s.prev = (uint32_t)ts_unzigzag(v);
+        } else {
+            int32_t d;
+            if (!ts_get_varbits(buf, len, bitpos, d)) return false;
+            if (f.kind == TS_DOD && index > 1) d = (int32_t)((uint32_t)s.prev_delta + (uint32_t)d);
+            s.prev_delta = d;
+            s.prev += (uint32_t)d;
+        }
+        out = ts_from_fixed((int32_t)s.prev, f.decimals);
+        return true;
+    }
+};
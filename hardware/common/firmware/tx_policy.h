@@ -0,0 +1,198 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Transport policy: per reading, send now over LoRa, send now over
+ * cellular, or queue it for a later cellular batch.
+ *
+ * Each transport is costed in joules per delivered reading:
+ *
+ *     cost = (attempt_j + byte_j × bytes + price_j × bytes) / p / readings
+ *
+ * bytes is what the link carries: the compact frame (build_air) on LoRa,
+ * the full payload plus the queue on cellular.
+ * p is the observed delivery rate (TxLinkStats, kept in RTC memory). A
+ * cellular session also carries whatever is queued, so its fixed cost is
+ * split over the batch. The energy part is weighted up as the battery
+ * runs down; the price part is the data plan cost, expressed in joules.
+ *
+ * Routine readings take the cheapest transport if it is within
+ * routine_budget_j, and otherwise wait in the queue until a batch makes
+ * cellular cheap enough or the queue is full. A routine LoRa send that
+ * fails is queued, not retried over cellular. Urgent readings take the
+ * transport with the shortest expected delivery time (latency_s / p) and
+ * fall back to the other one. Below batt_crit_v only urgent readings and
+ * full queues are sent, and a cellular session that would sag the cell
+ * below brownout (battery_sag.h) is left to urgent readings.
+ *
+ * Nothing here touches hardware; the firmware supplies the inputs, does
+ * the sending and reports each attempt back through tx_record().
+ */
+
+enum TxRoute : uint8_t { TX_LORA, TX_CELL, TX_DEFER };
+enum TxUrgency : uint8_t { TX_ROUTINE, TX_URGENT };
+enum TxReason : uint8_t {
+    TX_WHY_CHEAP,       // routine, cheapest transport within budget
+    TX_WHY_BATCH,       // routine, queued batch makes cellular worth a session
+    TX_WHY_QUEUE_FULL,  // routine, queue cannot take another reading
+    TX_WHY_WAIT,        // routine, queued until a batch is worth sending
+    TX_WHY_LOW_BATT,    // routine, queued: battery below batt_crit_v or too weak for a session
+    TX_WHY_URGENT,      // fastest expected delivery
+    TX_WHY_NO_LINK,     // nothing can carry it now
+    TX_WHY_SYNC,        // cellular for the ingest reply's clock sync (campaign.h)
+};
+
+inline const char *tx_route_name(uint8_t route) {
+    static const char *const NAMES[] = { "lora", "cell", "defer" };
+    return route <= TX_DEFER ? NAMES[route] : "?";
+}
+
+inline const char *tx_reason_name(uint8_t reason) {
+    static const char *const NAMES[] = {
+        "cheap", "batch", "queue_full", "wait", "low_batt", "urgent", "no_link", "sync",
+    };
+    return reason <= TX_WHY_SYNC ? NAMES[reason] : "?";
+}
+
+// One transport's costs; the firmware fills these from config.h
+struct TxLinkCost {
+    float    attempt_j;     // fixed energy of one attempt (wake, attach, TLS, …)
+    float    byte_j;        // energy per payload byte
+    float    price_j;       // data price per byte, in joules (0 = flat rate)
+    float    latency_s;     // send to server, when it works
+    uint16_t max_bytes;     // largest payload it can carry, 0 = any
+};
+
+struct TxPolicyParams {
+    TxLinkCost link[2];          // [TX_LORA], [TX_CELL]
+    float      routine_budget_j; // most a routine reading may cost to send now
+    uint8_t    queue_max;        // readings the firmware can hold
+    float      batt_ok_v;        // energy weight 1 at or above this
+    float      batt_low_v;       // … rising to batt_weight_max here
+    float      batt_crit_v;      // routine readings only queue below this
+    float      batt_weight_max;
+    float      stats_decay;      // weight kept by past attempts, per attempt
+    float      stats_recover;    // … and per cycle, so an unused link is retried
+};
+
+/*
+ * Delivery history of one transport. Plain data, zero = untried, for RTC
+ * memory. Attempts are counted with exponential forgetting; the rate
+ * starts optimistic, (ok + 1) / (n + 1), so an untried or long-unused
+ * link gets another chance.
+ */
+struct TxLinkStats {
+    float ok;
+    float n;
+
+    float p() const { return (ok + 1.0f) / (n + 1.0f); }
+};
+
+struct TxDecision {
+    uint8_t route;          // TxRoute
+    uint8_t reason;         // TxReason
+    uint8_t queued;         // readings waiting when the decision was made
+    float   p[2];           // delivery rate per transport
+    float   cost_j[2];      // weighted cost per reading, < 0 = unavailable
+};
+
+struct TxRequest {
+    uint16_t bytes;         // this reading's payload
+    uint16_t air_bytes;     // the same reading as a LoRa frame (build_air), 0 = does not fit
+    uint16_t queue_bytes;   // queued payload a cellular session would carry
+    uint8_t  queued;        // readings in the queue
+    uint8_t  urgency;       // TxUrgency
+    float    battery_v;
+    bool     lora_up;       // radio initialised
+    bool     cell_brownout; // a cellular session would brown the board out
+};
+
+inline float tx_energy_weight(const TxPolicyParams &pp, float battery_v) {
+    if (battery_v >= pp.batt_ok_v) return 1.0f;
+    if (battery_v <= pp.batt_low_v) return pp.batt_weight_max;
+    float f = (pp.batt_ok_v - battery_v) / (pp.batt_ok_v - pp.batt_low_v);
+    return 1.0f + f * (pp.batt_weight_max - 1.0f);
+}
+
+// Ages every link's history by one cycle; call once per wake
+inline void tx_stats_tick(const TxPolicyParams &pp, TxLinkStats stats[2]) {
+    for (int k = 0; k < 2; k++) {
+        stats[k].ok *= pp.stats_recover;
+        stats[k].n  *= pp.stats_recover;
+    }
+}
+
+inline void tx_record(const TxPolicyParams &pp, TxLinkStats &s, bool delivered) {
+    s.ok = s.ok * pp.stats_decay + (delivered ? 1.0f : 0.0f);
+    s.n  = s.n * pp.stats_decay + 1.0f;
+}
+
+inline TxDecision tx_decide(const TxPolicyParams &pp, const TxLinkStats stats[2],
+                            const TxRequest &rq) {
+    TxDecision d;
+    d.queued = rq.queued;
+    float w = tx_energy_weight(pp, rq.battery_v);
+    bool  up[2] = { rq.lora_up, !rq.cell_brownout || rq.urgency == TX_URGENT };
+    int   readings[2] = { 1, rq.queued + 1 };
+    uint32_t frame[2] = { rq.air_bytes, rq.bytes };      // this reading on each link
+    uint32_t bytes[2] = { rq.air_bytes, (uint32_t)rq.bytes + rq.queue_bytes };
+    for (int k = 0; k < 2; k++) {
+        const TxLinkCost &c = pp.link[k];
+        d.p[k] = stats[k].p();
+        d.cost_j[k] = -1;
+        if (!up[k] || !frame[k] || (c.max_bytes && frame[k] > c.max_bytes)) continue;
+        float j = (c.attempt_j + c.byte_j * bytes[k]) * w + c.price_j * bytes[k];
+        d.cost_j[k] = j / d.p[k] / readings[k];
+    }
+    bool lora = d.cost_j[TX_LORA] >= 0, cell = d.cost_j[TX_CELL] >= 0;
+
+    if (rq.urgency == TX_URGENT) {
+        d.reason = TX_WHY_URGENT;
+        if (lora && (!cell || pp.link[TX_LORA].latency_s / d.p[TX_LORA]
+                              <= pp.link[TX_CELL].latency_s / d.p[TX_CELL])) {
+            d.route = TX_LORA;
+        } else {
+            d.route = cell ? TX_CELL : TX_DEFER;
+            if (!cell) d.reason = TX_WHY_NO_LINK;
+        }
+        return d;
+    }
+
+    bool full = rq.queued >= pp.queue_max;
+    int best = lora && (!cell || d.cost_j[TX_LORA] <= d.cost_j[TX_CELL]) ? TX_LORA
+             : cell ? TX_CELL : -1;
+    if (best < 0) {
+        d.route  = TX_DEFER;
+        d.reason = rq.cell_brownout ? TX_WHY_LOW_BATT : TX_WHY_NO_LINK;
+    } else if (full) {
+        // The queue only drains over cellular
+        d.route  = cell ? TX_CELL : TX_LORA;
+        d.reason = TX_WHY_QUEUE_FULL;
+    } else if (rq.battery_v < pp.batt_crit_v) {
+        d.route  = TX_DEFER;
+        d.reason = TX_WHY_LOW_BATT;
+    } else if (d.cost_j[best] <= pp.routine_budget_j) {
+        d.route  = best;
+        d.reason = best == TX_CELL && rq.queued ? TX_WHY_BATCH : TX_WHY_CHEAP;
+    } else {
+        d.route  = TX_DEFER;
+        d.reason = TX_WHY_WAIT;
+    }
+    return d;
+}
+
+// After a routine LoRa send went out: whether a cellular session for the
+// queue alone is now worth it (the queue is full, or the batch brings the
+// cost per reading within budget) and safe to run
+inline bool tx_flush_queue(const TxPolicyParams &pp, const TxLinkStats stats[2],
+                           uint8_t queued, uint16_t queue_bytes, float battery_v,
+                           bool cell_brownout = false) {
+    if (!queued || cell_brownout) return false;
+    if (queued >= pp.queue_max) return true;
+    if (battery_v < pp.batt_crit_v) return false;
+    const TxLinkCost &c = pp.link[TX_CELL];
+    float j = (c.attempt_j + c.byte_j * queue_bytes) * tx_energy_weight(pp, battery_v)
+            + c.price_j * queue_bytes;
+    return j / stats[TX_CELL].p() / queued <= pp.routine_budget_j;
+}
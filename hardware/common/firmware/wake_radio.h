@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal.h"
+#include "lora_airtime.h"
+
+/*
+ * Wake-on-radio: on-demand reads between scheduled reports.
+ *
+ * A listening unit samples the channel every few seconds with the SX1276's
+ * channel activity detection (CAD, about two symbols of receiver time) and
+ * sleeps in between. To reach it, the gateway bridge sends a read command
+ * behind a preamble longer than the unit's sampling period, so one sample
+ * always lands in it. The unit then receives the frame and, if it is
+ * addressed to it, takes a reading and reports at once.
+ *
+ * The command is a short JSON object, built and parsed here for both ends:
+ *
+ *     {"wx":"read","to":"WXL-001","req":17}
+ *
+ * req is the backend's read-request id; the reading carries it back as
+ * read_req.
+ */
+
+#define WOR_FRAME_MAX   64
+
+struct WorCommand {
+    uint32_t req;
+};
+
+inline size_t wor_frame(char *out, size_t cap, const char *device_id, uint32_t req) {
+    int n = snprintf(out, cap, "{\"wx\":\"read\",\"to\":\"%s\",\"req\":%u}", device_id,
+                     (unsigned)req);
+    return n > 0 && (size_t)n < cap ? (size_t)n : 0;
+}
+
+// True when buf is a read command for device_id
+inline bool wor_parse(const uint8_t *buf, size_t len, const char *device_id, WorCommand &cmd) {
+    static const char HEAD[] = "{\"wx\":\"read\",\"to\":\"";
+    static const char REQ[]  = "\",\"req\":";
+    size_t hl = sizeof(HEAD) - 1, il = strlen(device_id), rl = sizeof(REQ) - 1;
+    if (len < hl + il + rl + 2) return false;
+    const char *p = (const char *)buf, *end = p + len;
+    if (memcmp(p, HEAD, hl) || memcmp(p + hl, device_id, il) || memcmp(p + hl + il, REQ, rl)) {
+        return false;
+    }
+    p += hl + il + rl;
+    uint32_t req = 0;
+    const char *digits = p;
+    while (p < end && *p >= '0' && *p <= '9' && p - digits < 10) req = req * 10 + (*p++ - '0');
+    if (p == digits || p >= end || *p != '}' || !req) return false;   // 0 means no request
+    cmd.req = req;
+    return true;
+}
+
+// Preamble, in symbols, that a unit sampling every period_ms cannot miss:
+// the period, plus the CAD itself and the receiver locking on
+inline uint16_t wor_preamble_symbols(uint32_t period_ms, uint8_t sf, uint32_t bw_hz) {
+    uint32_t n = (uint32_t)((uint64_t)period_ms * 1000 / lora_symbol_us(sf, bw_hz)) + 8;
+    return n > 65535 ? 65535 : (uint16_t)n;
+}
+
+/*
+ * One listen slot: a CAD, and on activity a receive long enough for the
+ * rest of the preamble and the frame. True with cmd filled when the frame
+ * was a read command for this unit; anyone else's traffic costs one
+ * receive window.
+ */
+inline bool wor_listen_once(HalRadio &radio, const char *device_id, uint32_t cad_timeout_ms,
+                            uint32_t rx_timeout_ms, WorCommand &cmd) {
+    if (!radio.cad(cad_timeout_ms)) return false;
+    uint8_t buf[WOR_FRAME_MAX];
+    int n = radio.receive(buf, sizeof(buf), rx_timeout_ms);
+    return n > 0 && wor_parse(buf, (size_t)n, device_id, cmd);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/*
+ * Well positions for host tools and the gateway bridge: lat / lon, a
+ * local flat projection, DWR site-code parsing and a CSV field splitter
+ * for the monitoring-network exports in data/monitoring and
+ * backend/data.
+ */
+
+struct GeoPoint {
+    double lat, lon;
+};
+
+// Local flat projection (km) around a reference latitude; good to well
+// under 1% over the distances a gateway covers
+struct Projection {
+    double lat0 = 0, kx = 111.32, ky = 110.574;
+
+    void center(const std::vector<GeoPoint> &pts) {
+        double s = 0;
+        for (const GeoPoint &p : pts) s += p.lat;
+        lat0 = pts.empty() ? 0 : s / pts.size();
+        kx = 111.32 * cos(lat0 * M_PI / 180.0);
+    }
+    double dist_km(const GeoPoint &a, const GeoPoint &b) const {
+        double dx = (a.lon - b.lon) * kx, dy = (a.lat - b.lat) * ky;
+        return sqrt(dx * dx + dy * dy);
+    }
+    // East / north offsets of `p` from `origin`
+    void offset_km(const GeoPoint &origin, const GeoPoint &p, double &east, double &north) const {
+        east = (p.lon - origin.lon) * kx;
+        north = (p.lat - origin.lat) * ky;
+    }
+};
+
+// DWR site codes carry the position: 333250N1163678W002 is 33.3250 N,
+// 116.3678 W, well 002
+inline bool parse_site_code(const char *code, GeoPoint &p) {
+    char ns, ew;
+    unsigned lat, lon;
+    if (sscanf(code, "%6u%c%7u%c", &lat, &ns, &lon, &ew) != 4) return false;
+    if (ns != 'N' || ew != 'W') return false;
+    p.lat = lat / 10000.0;
+    p.lon = -(lon / 10000.0);
+    return true;
+}
+
+// Splits one CSV line (RFC 4180 quoting, no embedded newlines)
+inline std::vector<std::string> csv_fields(const char *line) {
+    std::vector<std::string> out(1);
+    bool quoted = false;
+    if (!strncmp(line, "\xEF\xBB\xBF", 3)) line += 3;   // BOM
+    for (const char *c = line; *c && *c != '\n' && *c != '\r'; c++) {
+        if (quoted) {
+            if (*c == '"' && c[1] == '"') out.back() += *c++;
+            else if (*c == '"') quoted = false;
+            else out.back() += *c;
+        } else if (*c == '"') {
+            quoted = true;
+        } else if (*c == ',') {
+            out.emplace_back();
+        } else {
+            out.back() += *c;
+        }
+    }
+    return out;
+}
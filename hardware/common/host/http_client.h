@@ -0,0 +1,189 @@
+#pragma once
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <string>
+
+/*
+ * Minimal blocking HTTP/1.1 client for the host-side programs (loadgen,
+ * the gateway bridge): one keep-alive connection per thread,
+ * Content-Length or chunked responses, reconnect on error. Plain http
+ * only; TLS to a remote backend goes through a local reverse proxy.
+ */
+
+struct HttpUrl {
+    std::string host = "127.0.0.1";
+    std::string port = "8000";
+    std::string prefix;             // path prefix, e.g. "/hardware"
+};
+
+// http://host[:port][/prefix]
+inline bool parse_http_url(const char *url, HttpUrl &out) {
+    if (strncmp(url, "http://", 7)) return false;
+    const char *h = url + 7;
+    const char *slash = strchr(h, '/');
+    std::string hostport = slash ? std::string(h, slash) : std::string(h);
+    out.prefix = slash ? std::string(slash) : std::string();
+    while (!out.prefix.empty() && out.prefix.back() == '/') out.prefix.pop_back();
+    size_t colon = hostport.find(':');
+    out.host = hostport.substr(0, colon);
+    if (colon != std::string::npos) out.port = hostport.substr(colon + 1);
+    return !out.host.empty();
+}
+
+class HttpConnection {
+public:
+    explicit HttpConnection(const HttpUrl &url) : url_(url) {}
+    ~HttpConnection() { disconnect(); }
+
+    // Send / receive timeout per socket operation; 0 blocks indefinitely
+    void set_timeout_ms(uint32_t ms) { timeout_ms_ = ms; }
+
+    // Returns the status code, or -1 on a transport error. The response
+    // body is left in body().
+    int request(const char *method, const std::string &path, const char *body = nullptr,
+                size_t body_len = 0) {
+        for (;;) {
+            bool reused = fd_ >= 0;
+            if (!reused && !connect_server()) return -1;
+            if (send_request(method, path, body, body_len)) {
+                int status = read_response();
+                if (status > 0) return status;
+            }
+            disconnect();
+            // A reused connection may have been closed by the server while
+            // idle: retry once on a fresh one
+            if (!reused) return -1;
+        }
+    }
+
+    const std::string &body() const { return body_; }
+
+private:
+    bool connect_server() {
+        addrinfo hints = {}, *res = nullptr;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(url_.host.c_str(), url_.port.c_str(), &hints, &res) != 0) return false;
+        for (addrinfo *a = res; a; a = a->ai_next) {
+            fd_ = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd_ < 0) continue;
+            if (connect(fd_, a->ai_addr, a->ai_addrlen) == 0) break;
+            close(fd_);
+            fd_ = -1;
+        }
+        freeaddrinfo(res);
+        if (fd_ < 0) return false;
+        int one = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (timeout_ms_) {
+            timeval tv = { (time_t)(timeout_ms_ / 1000), (suseconds_t)(timeout_ms_ % 1000) * 1000 };
+            setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        }
+        buf_.clear();
+        return true;
+    }
+
+    void disconnect() {
+        if (fd_ >= 0) close(fd_);
+        fd_ = -1;
+    }
+
+    bool send_all(const char *p, size_t n) {
+        while (n) {
+            ssize_t w = send(fd_, p, n, MSG_NOSIGNAL);
+            if (w <= 0) return false;
+            p += w;
+            n -= (size_t)w;
+        }
+        return true;
+    }
+
+    bool send_request(const char *method, const std::string &path, const char *body, size_t len) {
+        char head[512];
+        int n = snprintf(head, sizeof(head),
+                         "%s %s%s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n"
+                         "Content-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
+                         method, url_.prefix.c_str(), path.c_str(), url_.host.c_str(), len);
+        if (n <= 0 || n >= (int)sizeof(head)) return false;
+        return send_all(head, n) && (!len || send_all(body, len));
+    }
+
+    bool fill() {
+        char tmp[16384];
+        ssize_t r = recv(fd_, tmp, sizeof(tmp), 0);
+        if (r <= 0) return false;
+        buf_.append(tmp, (size_t)r);
+        return true;
+    }
+
+    bool read_line(std::string &line) {
+        size_t eol;
+        while ((eol = buf_.find("\r\n")) == std::string::npos) {
+            if (!fill()) return false;
+        }
+        line.assign(buf_, 0, eol);
+        buf_.erase(0, eol + 2);
+        return true;
+    }
+
+    bool read_bytes(size_t n, std::string &out) {
+        while (buf_.size() < n) {
+            if (!fill()) return false;
+        }
+        out.append(buf_, 0, n);
+        buf_.erase(0, n);
+        return true;
+    }
+
+    int read_response() {
+        std::string line;
+        if (!read_line(line) || line.compare(0, 5, "HTTP/")) return -1;
+        int status = atoi(line.c_str() + 9);
+        long content_length = -1;
+        bool chunked = false, close_after = false;
+        while (read_line(line) && !line.empty()) {
+            if (!strncasecmp(line.c_str(), "content-length:", 15)) content_length = atol(line.c_str() + 15);
+            else if (!strncasecmp(line.c_str(), "transfer-encoding:", 18))
+                chunked = strstr(line.c_str(), "chunked") != nullptr;
+            else if (!strncasecmp(line.c_str(), "connection:", 11))
+                close_after = strstr(line.c_str(), "close") != nullptr;
+        }
+        body_.clear();
+        if (chunked) {
+            for (;;) {
+                if (!read_line(line)) return -1;
+                size_t n = strtoul(line.c_str(), nullptr, 16);
+                if (n == 0) {
+                    read_line(line);
+                    break;
+                }
+                if (!read_bytes(n, body_) || !read_line(line)) return -1;
+            }
+        } else if (content_length >= 0) {
+            if (!read_bytes((size_t)content_length, body_)) return -1;
+        } else {
+            while (fill()) {}
+            body_.swap(buf_);
+            close_after = true;
+        }
+        if (close_after) disconnect();
+        return status;
+    }
+
+    HttpUrl     url_;
+    uint32_t    timeout_ms_ = 0;
+    int         fd_ = -1;
+    std::string buf_;
+    std::string body_;
+};
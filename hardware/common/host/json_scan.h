@@ -0,0 +1,163 @@
+#pragma once
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+/*
+ * Zero-copy JSON scanning for the host daemons: walk the members of an
+ * object or the elements of an array in place and pull out the few
+ * fields a hot path needs, without building a document. Values are
+ * returned as spans of the original text.
+ */
+
+struct JsonSpan {
+    const char *p = nullptr;
+    size_t      n = 0;
+
+    bool is_object() const { return n >= 2 && p[0] == '{'; }
+    bool is_array() const  { return n >= 2 && p[0] == '['; }
+    bool is_string() const { return n >= 2 && p[0] == '"'; }
+};
+
+inline const char *json_ws(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    return p;
+}
+
+// Pointer past the value starting at p, or nullptr if malformed
+inline const char *json_skip(const char *p, const char *end) {
+    p = json_ws(p, end);
+    if (p >= end) return nullptr;
+    if (*p == '"') {
+        for (p++; p < end; p++) {
+            if (*p == '\\') p++;
+            else if (*p == '"') return p + 1;
+        }
+        return nullptr;
+    }
+    if (*p == '{' || *p == '[') {
+        int depth = 0;
+        for (; p < end; p++) {
+            if (*p == '"') {
+                p = json_skip(p, end);
+                if (!p) return nullptr;
+                p--;
+            } else if (*p == '{' || *p == '[') {
+                depth++;
+            } else if (*p == '}' || *p == ']') {
+                if (--depth == 0) return p + 1;
+            }
+        }
+        return nullptr;
+    }
+    const char *s = p;
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n'
+           && *p != '\r' && *p != '\t') p++;
+    return p > s ? p : nullptr;
+}
+
+inline JsonSpan json_value(const char *text, size_t len) {
+    JsonSpan v;
+    const char *end = text + len;
+    const char *s = json_ws(text, end);
+    const char *e = json_skip(s, end);
+    if (e) {
+        v.p = s;
+        v.n = (size_t)(e - s);
+    }
+    return v;
+}
+
+// Calls fn(key, value) for each member; key excludes the quotes. Stops
+// early when fn returns false. Returns false on malformed input.
+template <typename F>
+inline bool json_each_member(JsonSpan obj, F fn) {
+    if (!obj.is_object()) return false;
+    const char *p = obj.p + 1, *end = obj.p + obj.n - 1;
+    for (;;) {
+        p = json_ws(p, end);
+        if (p >= end) return true;
+        if (*p != '"') return false;
+        const char *ke = json_skip(p, end);
+        if (!ke) return false;
+        JsonSpan key = { p + 1, (size_t)(ke - p - 2) };
+        p = json_ws(ke, end);
+        if (p >= end || *p != ':') return false;
+        p = json_ws(p + 1, end);
+        const char *ve = json_skip(p, end);
+        if (!ve) return false;
+        if (!fn(key, JsonSpan{ p, (size_t)(ve - p) })) return true;
+        p = json_ws(ve, end);
+        if (p < end && *p == ',') p++;
+        else if (p < end) return false;
+    }
+}
+
+template <typename F>
+inline bool json_each_element(JsonSpan arr, F fn) {
+    if (!arr.is_array()) return false;
+    const char *p = arr.p + 1, *end = arr.p + arr.n - 1;
+    for (;;) {
+        p = json_ws(p, end);
+        if (p >= end) return true;
+        const char *ve = json_skip(p, end);
+        if (!ve) return false;
+        if (!fn(JsonSpan{ p, (size_t)(ve - p) })) return true;
+        p = json_ws(ve, end);
+        if (p < end && *p == ',') p++;
+        else if (p < end) return false;
+    }
+}
+
+// Element i of an array; false when there is none
+inline bool json_element(JsonSpan arr, size_t i, JsonSpan &out) {
+    bool found = false;
+    json_each_element(arr, [&](JsonSpan v) {
+        if (i--) return true;
+        out = v;
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+inline bool json_get(JsonSpan obj, const char *key, JsonSpan &out) {
+    size_t kl = strlen(key);
+    bool found = false;
+    json_each_member(obj, [&](JsonSpan k, JsonSpan v) {
+        if (k.n == kl && !memcmp(k.p, key, kl)) {
+            out = v;
+            found = true;
+            return false;
+        }
+        return true;
+    });
+    return found;
+}
+
+inline double json_number(JsonSpan v, double dflt = 0) {
+    if (!v.n || v.p[0] == '"' || v.p[0] == '{' || v.p[0] == '[') return dflt;
+    char tmp[48];
+    size_t n = v.n < sizeof(tmp) - 1 ? v.n : sizeof(tmp) - 1;
+    memcpy(tmp, v.p, n);
+    tmp[n] = 0;
+    char *e;
+    double d = strtod(tmp, &e);
+    return e == tmp ? dflt : d;
+}
+
+// String contents with the common escapes undone (\uXXXX kept as is)
+inline std::string json_string(JsonSpan v) {
+    std::string out;
+    if (!v.is_string()) return out;
+    for (size_t i = 1; i + 1 < v.n; i++) {
+        char c = v.p[i];
+        if (c == '\\' && i + 2 < v.n) {
+            char e = v.p[++i];
+            c = e == 'n' ? '\n' : e == 't' ? '\t' : e == 'r' ? '\r' : e;
+        }
+        out += c;
+    }
+    return out;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+/*
+ * Semtech packet-forwarder UDP protocol (lora_gateway / packet_forwarder
+ * PROTOCOL.TXT, version 2). Every datagram starts with
+ *
+ *   [0] protocol version  [1..2] random token  [3] identifier
+ *
+ * followed, for gateway-originated messages, by the 8-byte gateway EUI
+ * and a JSON object. Uplinks arrive as PUSH_DATA {"rxpk":[...]} and are
+ * acknowledged with PUSH_ACK; PULL_DATA keepalives open the downlink path
+ * and are answered with PULL_ACK.
+ */
+
+#define SEMTECH_VERSION      2
+#define SEMTECH_PUSH_DATA    0x00
+#define SEMTECH_PUSH_ACK     0x01
+#define SEMTECH_PULL_DATA    0x02
+#define SEMTECH_PULL_RESP    0x03
+#define SEMTECH_PULL_ACK     0x04
+#define SEMTECH_TX_ACK       0x05
+#define SEMTECH_HEADER_LEN   12       // with gateway EUI
+
+struct SemtechHeader {
+    uint8_t  version;
+    uint16_t token;
+    uint8_t  id;
+    uint64_t gateway_eui;            // 0 for server-originated messages
+};
+
+// Parses the fixed header; `json` / `json_len` point at the payload
+inline bool semtech_parse(const uint8_t *buf, size_t len, SemtechHeader &h,
+                          const char *&json, size_t &json_len) {
+    if (len < 4 || buf[0] < 1 || buf[0] > 2) return false;
+    h.version = buf[0];
+    h.token = (uint16_t)(buf[1] << 8 | buf[2]);
+    h.id = buf[3];
+    h.gateway_eui = 0;
+    json = nullptr;
+    json_len = 0;
+    bool has_eui = h.id == SEMTECH_PUSH_DATA || h.id == SEMTECH_PULL_DATA || h.id == SEMTECH_TX_ACK;
+    if (!has_eui) return true;
+    if (len < SEMTECH_HEADER_LEN) return false;
+    for (int i = 0; i < 8; i++) h.gateway_eui = h.gateway_eui << 8 | buf[4 + i];
+    json = (const char *)buf + SEMTECH_HEADER_LEN;
+    json_len = len - SEMTECH_HEADER_LEN;
+    return true;
+}
+
+// Header for a message with EUI (PUSH_DATA / PULL_DATA / TX_ACK); returns its length
+inline size_t semtech_header(uint8_t *buf, uint8_t id, uint16_t token, uint64_t eui) {
+    buf[0] = SEMTECH_VERSION;
+    buf[1] = token >> 8;
+    buf[2] = token & 0xFF;
+    buf[3] = id;
+    for (int i = 0; i < 8; i++) buf[4 + i] = (uint8_t)(eui >> (56 - 8 * i));
+    return SEMTECH_HEADER_LEN;
+}
+
+// PUSH_ACK / PULL_ACK echo the version and token of the message they answer
+inline size_t semtech_ack(uint8_t *buf, const SemtechHeader &h, uint8_t ack_id) {
+    buf[0] = h.version;
+    buf[1] = h.token >> 8;
+    buf[2] = h.token & 0xFF;
+    buf[3] = ack_id;
+    return 4;
+}
+
+// PULL_RESP: header without EUI, then {"txpk":{...}}; returns its length,
+// 0 if it does not fit
+inline size_t semtech_pull_resp(uint8_t *buf, size_t cap, uint16_t token, const std::string &json) {
+    if (4 + json.size() > cap) return 0;
+    buf[0] = SEMTECH_VERSION;
+    buf[1] = token >> 8;
+    buf[2] = token & 0xFF;
+    buf[3] = SEMTECH_PULL_RESP;
+    memcpy(buf + 4, json.data(), json.size());
+    return 4 + json.size();
+}
+
+inline void semtech_eui_str(uint64_t eui, char out[17]) {
+    static const char HEX[] = "0123456789abcdef";
+    for (int i = 0; i < 16; i++) out[i] = HEX[(eui >> (60 - 4 * i)) & 0xF];
+    out[16] = 0;
+}
+
+// ── Base64 (rxpk / txpk "data") ─────────────────────────────
+inline size_t base64_decode(const char *in, size_t len, uint8_t *out, size_t cap) {
+    static int8_t T[256];
+    static bool init = false;
+    if (!init) {
+        memset(T, -1, sizeof(T));
+        const char *A = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (int i = 0; i < 64; i++) T[(uint8_t)A[i]] = (int8_t)i;
+        init = true;
+    }
+    uint32_t acc = 0;
+    int bits = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        int8_t v = T[(uint8_t)in[i]];
+        if (v < 0) {
+            if (in[i] == '=') break;
+            continue;
+        }
+        acc = acc << 6 | (uint32_t)v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (n >= cap) return 0;
+            out[n++] = (uint8_t)(acc >> bits);
+        }
+    }
+    return n;
+}
+
+inline std::string base64_encode(const uint8_t *in, size_t len) {
+    static const char A[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < len) v |= in[i + 2];
+        out += A[v >> 18 & 63];
+        out += A[v >> 12 & 63];
+        out += i + 1 < len ? A[v >> 6 & 63] : '=';
+        out += i + 2 < len ? A[v & 63] : '=';
+    }
+    return out;
+}
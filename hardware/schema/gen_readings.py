@@ -0,0 +1,440 @@
+"""
+Compiles readings.py into the firmware codecs and backend models.
+
+Usage:
+    python3 hardware/schema/gen_readings.py            # rewrite the outputs
+    python3 hardware/schema/gen_readings.py --check    # exit 1 if any is stale
+
+Outputs are committed; run this after any change to readings.py.
+"""
+
+import argparse
+import re
+import sys
+from pathlib import Path
+
+from readings import DEVICES, REQUIRED, F, Group
+
+ROOT = Path(__file__).resolve().parents[2]
+BACKEND = "backend/api/reading_schema.py"
+BANNER = "Generated by hardware/schema/gen_readings.py from readings.py. Do not edit."
+
+PY_TYPES = {"f32": "float", "u32": "int", "u8": "int", "bool": "bool", "str": "str"}
+
+
+# ── C++ ──────────────────────────────────────────────────────
+
+def _cstr(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def _key(key, lead=","):
+    """Literal for a key with the text before it: "," or "{", then "key":"""
+    return _cstr(lead + '"' + key + '":')
+
+
+def _value(f):
+    if f.count:
+        return f"out.fixed_array<{f.decimals}>({f.src}, {f.count});"
+    if f.type == "f32":
+        return f"out.fixed<{f.decimals}>({f.src});"
+    if f.type == "str":
+        return f"out.str({f.src});"
+    if f.type == "bool":
+        return f"out.boolean({f.src});"
+    return f"out.uint({f.src});"
+
+
+def _uses(decl, exprs):
+    name = decl.replace("&", " ").replace("*", " ").split()[-3]
+    return any(re.search(rf"\b{name}\b", e) for e in exprs)
+
+
+def _on_air(fields, air):
+    return [f for f in fields if not air or f.air is not None]
+
+
+def _air_key(f, air):
+    return (f.air or f.key) if air else f.key
+
+
+def _json_object(fields, indent, lead="", air=False):
+    """Statements writing {...}; `lead` is literal text before the brace."""
+    pad = " " * indent
+    fields = _on_air(fields, air)
+    if not isinstance(fields[0], F) or fields[0].when:
+        raise SystemExit("the first field of an object must be unconditional")
+    lines, open_when = [], ""
+    for n, f in enumerate(fields):
+        when = f.when if isinstance(f, F) else ""
+        if when != open_when:
+            if open_when:
+                lines.append(pad + "}")
+            if when:
+                lines.append(pad + f"if ({when}) {{")
+            open_when = when
+        p = pad + ("    " if when else "")
+        if isinstance(f, Group):
+            lines += _json_group(f, indent, air)
+            continue
+        lines.append(p + f"out.lit({_key(_air_key(f, air), lead + '{' if n == 0 else ',')});")
+        lines.append(p + _value(f))
+    if open_when:
+        lines.append(pad + "}")
+    return lines
+
+
+def _air_value(f):
+    """A field as one value of an air array entry: conditions become null / 0."""
+    if not f.when:
+        return _value(f)
+    if f.type == "f32" and not f.count:
+        return f"out.fixed<{f.decimals}>(({f.when}) ? {f.src} : NAN);"
+    if f.type in ("u8", "u32"):
+        if f.when == f.src:
+            return _value(f)
+        return f"out.uint(({f.when}) ? {f.src} : 0);"
+    raise SystemExit(f"{f.key}: only numbers can be conditional in an air array")
+
+
+def _json_group(g, indent, air=False):
+    pad = " " * indent
+    key = _air_key(g, air)
+    if not g.count:
+        lines = _json_object(g.fields, indent, f',"{key}":', air)
+        return lines + [pad + 'out.lit("}");']
+    fields = _on_air(g.fields, air)
+    exprs = [f.src + " " + f.when for f in fields]
+    start = _cstr(f',"{key}":[')
+    lines = [pad + f"out.lit({start});",
+             pad + f"for (int i = 0; i < {g.count}; i++) {{"]
+    lines += [pad + f"    {d};" for d in g.locals if _uses(d, exprs)]
+    lines.append(pad + '    if (i) out.lit(",");')
+    if air:
+        for n, f in enumerate(fields):
+            lines.append(pad + "    " + ('out.lit("[");' if n == 0 else 'out.lit(",");'))
+            lines.append(pad + "    " + _air_value(f))
+        lines.append(pad + '    out.lit("]");')
+    else:
+        lines += _json_object(fields, indent + 4)
+        lines.append(pad + '    out.lit("}");')
+    lines += [pad + "}", pad + 'out.lit("]");']
+    return lines
+
+
+def _check_air(fields, where):
+    """Air keys must not collide with each other or with another field's key."""
+    keys = [f.key for f in fields]
+    air = [_air_key(f, True) for f in _on_air(fields, True)]
+    for f in _on_air(fields, True):
+        k = _air_key(f, True)
+        if air.count(k) > 1 or (k != f.key and k in keys):
+            raise SystemExit(f"{where}: air key {k!r} is ambiguous")
+        if isinstance(f, Group):
+            if f.count and k == f.key:
+                raise SystemExit(f"{where}.{f.key}: an air array needs its own key")
+            if not f.count:
+                _check_air(f.fields, f"{where}.{f.key}")
+
+
+# Widest value of each type in the LoRa frame when a field gives no span;
+# f32 allows a sign and four integer digits, the point and decimals on top
+AIR_WIDTH = {"f32": 5, "u32": 10, "u8": 3, "bool": 5}
+
+
+def _air_width(f):
+    """(bytes, C++ terms) of the longest value field f can put on air."""
+    if f.type == "str":
+        if re.fullmatch(r"[A-Z_]+", f.src):
+            return 2, [f"(sizeof({f.src}) - 1)"]      # a string macro
+        if not f.width:
+            raise SystemExit(f"{f.key}: a str on air needs a width")
+        return f.width + 2, []
+    if f.span:
+        n = max(len(f"{v:.{f.decimals}f}") for v in f.span)
+        n = max(n, 4) if f.type == "f32" else n        # null
+    else:
+        n = AIR_WIDTH[f.type] + (f.decimals + 1 if f.decimals else 0)
+    return (f.count * (n + 1) + 1, []) if f.count else (n, [])
+
+
+def _air_bound(fields):
+    """(bytes, C++ terms) of the longest air object: {...} over fields."""
+    size, terms = 1, []
+    for f in _on_air(fields, True):
+        size += len(_air_key(f, True)) + 4        # ,"key": or {"key":
+        if isinstance(f, Group) and not f.count:
+            n, t = _air_bound(f.fields)
+        elif isinstance(f, Group):
+            entry, t = 1, []                      # [v,v,...]
+            for g in _on_air(f.fields, True):
+                w, wt = _air_width(g)
+                entry, t = entry + w + 1, t + wt
+            n, t = 1, [f"({f.count}) * ({' + '.join([str(entry + 1)] + t)})"]
+        else:
+            n, t = _air_width(f)
+        size, terms = size + n, terms + t
+    return size, terms
+
+
+def _merge_literals(lines):
+    """Joins consecutive out.lit() calls at the same depth into one."""
+    merged = []
+    for line in lines:
+        prev = merged[-1] if merged else ""
+        if (line.strip().startswith('out.lit("') and prev.strip().startswith('out.lit("')
+                and len(line) - len(line.lstrip()) == len(prev) - len(prev.lstrip())):
+            merged[-1] = prev[:-3] + line.strip()[len('out.lit("'):]
+            continue
+        merged.append(line)
+    return merged
+
+
+def _packed(dev):
+    """(columns, group) for the backlog: top-level packed fields, one array group."""
+    cols = [f for f in dev.fields if isinstance(f, F) and f.pack]
+    groups = [g for g in dev.fields if isinstance(g, Group) and any(f.pack for f in g.fields)]
+    if len(groups) > 1 or (groups and not groups[0].count):
+        raise SystemExit("the packed backlog supports one array group")
+    return cols, groups[0] if groups else None
+
+
+def gen_cpp(dev):
+    out = [f"// {BANNER}", "#pragma once"]
+    if dev.backlog:
+        out += ["#include <stdio.h>", '#include "schema.h"', '#include "ts_codec.h"']
+    else:
+        out.append('#include "schema.h"')
+    out += ["",
+            f"// {dev.device_type} payload, keys and precision as in hardware/schema/readings.py.",
+            "// Serializes into buf (NUL-terminated); returns the payload length, 0 if",
+            "// it did not fit.",
+            f"inline size_t build_json(const {dev.reading} &r, char *buf, size_t cap) {{",
+            "    JsonOut out(buf, cap);"]
+    out += _merge_literals(_json_object(dev.fields, 4) + ['    out.lit("}");'])
+    out += ["    return out.finish();", "}"]
+    _check_air(dev.fields, dev.device_type)
+    out += ["",
+            "// The same reading as a LoRa frame: short keys, arrays of objects as",
+            "// value arrays, cellular-only fields left out (readings.py `air`).",
+            f"inline size_t build_air(const {dev.reading} &r, char *buf, size_t cap) {{",
+            "    JsonOut out(buf, cap);"]
+    out += _merge_literals(_json_object(dev.fields, 4, air=True) + ['    out.lit("}");'])
+    out += ["    return out.finish();", "}"]
+    size, terms = _air_bound(dev.fields)
+    out += ["",
+            "// Longest frame build_air() writes: every conditional field present,",
+            "// numbers and strings at their readings.py span / width.",
+            "static constexpr size_t AIR_MAX_BYTES = " + " + ".join([str(size)] + terms) + ";"]
+    if dev.backlog:
+        out += gen_cpp_pack(dev)
+    return "\n".join(out) + "\n"
+
+
+def gen_cpp_pack(dev):
+    cols, g = _packed(dev)
+    gcols = [f for f in g.fields if f.pack] if g else []
+    n = len(gcols)
+    out = ["",
+           "// Packed backlog columns: unit clock (s), then every packed field at its",
+           f"// payload precision; {g.key} columns repeat per entry as \"<{g.id_key}>.<key>\"." if g else "",
+           "static constexpr TsField PACK_COLUMNS[] = {",
+           '    { "t", TS_DOD, 0 },']
+    out += [f'    {{ "{f.key}", {f.pack}, {f.decimals} }},' for f in cols]
+    out.append("};")
+    if g:
+        out.append(f"static constexpr TsField PACK_{g.key.upper()}_COLUMNS[] = {{")
+        out += [f'    {{ "{f.key}", {f.pack}, {f.decimals} }},' for f in gcols]
+        out.append("};")
+    out += ["",
+            f"#define PACK_BASE_FIELDS    {len(cols) + 1}",
+            f"#define PACK_FIELD_COUNT    (PACK_BASE_FIELDS + {n} * {g.count})" if g
+            else "#define PACK_FIELD_COUNT    PACK_BASE_FIELDS",
+            'static_assert(PACK_FIELD_COUNT <= TS_MAX_FIELDS, "too many columns for one packed record");',
+            "",
+            "// Starts a batch in buf",
+            "inline bool pack_begin(TsEncoder &enc, uint8_t *buf, size_t cap) {",
+            "    TsField f[PACK_FIELD_COUNT];",
+            "    for (int k = 0; k < PACK_BASE_FIELDS; k++) f[k] = PACK_COLUMNS[k];"]
+    if g:
+        id_src = next(f.src for f in g.fields if f.key == g.id_key)
+        out += [f"    static char names[{g.count}][{n}][32];",
+                f"    for (int i = 0; i < {g.count}; i++) {{",
+                f"        for (int k = 0; k < {n}; k++) {{",
+                f"            const TsField &c = PACK_{g.key.upper()}_COLUMNS[k];",
+                f'            snprintf(names[i][k], sizeof(names[i][k]), "%s.%s", {id_src}, c.name);',
+                f"            f[PACK_BASE_FIELDS + {n} * i + k] = {{ names[i][k], c.kind, c.decimals }};",
+                "        }",
+                "    }"]
+    out += ["    return enc.begin(buf, cap, DEVICE_ID, DEVICE_TYPE, f, PACK_FIELD_COUNT);",
+            "}",
+            "",
+            "// Appends r, taken at unit-clock second t; false when the batch is full",
+            f"inline bool pack_add(TsEncoder &enc, uint8_t *buf, const {dev.reading} &r, uint32_t t) {{",
+            "    double v[PACK_FIELD_COUNT];",
+            "    v[0] = t;"]
+    for k, f in enumerate(cols):
+        expr = f"{f.when} ? {f.src} : NAN" if f.when else f.src
+        out.append(f"    v[{k + 1}] = {expr};")
+    if g:
+        exprs = [f.src + " " + f.when for f in gcols]
+        out.append(f"    for (int i = 0; i < {g.count}; i++) {{")
+        out += [f"        {d};" for d in g.locals if _uses(d, exprs)]
+        for k, f in enumerate(gcols):
+            expr = f"{f.when} ? {f.src} : NAN" if f.when else f.src
+            slot = f"PACK_BASE_FIELDS + {n} * i" + (f" + {k}" if k else "")
+            out.append(f"        v[{slot}] = {expr};")
+        out.append("    }")
+    out += ["    return enc.add(buf, v);", "}"]
+    return out
+
+
+# ── Python ───────────────────────────────────────────────────
+
+def _py_field(f):
+    if isinstance(f, Group):
+        if f.count:
+            return f"{f.key}: list[{f.model}] = Field(default_factory=list)"
+        return f"{f.key}: {f.model} = Field(default_factory={f.model})"
+    t = PY_TYPES[f.type]
+    if f.count:
+        line = f"{f.key}: list[{t}] = Field(default_factory=list)"
+    elif f.default is REQUIRED:
+        line = f"{f.key}: {t}"
+    elif f.default is None:
+        line = f"{f.key}: Optional[{t}] = None"
+    else:
+        d = f.default
+        line = f"{f.key}: {t} = " + (f'"{d}"' if isinstance(d, str) else repr(d))
+    return line + (f"  # {f.doc}" if f.doc else "")
+
+
+def _py_models(fields, name, seen, out):
+    for g in fields:
+        if isinstance(g, Group) and g.model not in seen:
+            seen.add(g.model)
+            _py_models(g.fields, g.model, seen, out)
+    out += [f"class {name}(BaseModel):"] + ["    " + _py_field(f) for f in fields] + ["", ""]
+
+
+def _py_decoder(dev):
+    cols, g = _packed(dev)
+    fn = dev.device_type.replace("-", "_") + "_from_columns"
+    out = [f"def {fn}(columns: dict) -> dict:",
+           f'    """One {dev.device_type} backlog record, by column name, as a payload dict."""',
+           f'    reading = {{"device_type": "{dev.device_type}"}}']
+    for f in cols:
+        conv = PY_TYPES[f.type]
+        out += [f'    if columns.get("{f.key}") is not None:',
+                f'        reading["{f.key}"] = {conv}(columns["{f.key}"])']
+    if g:
+        out += ["    entries: dict[str, dict] = {}",
+                "    for name, v in columns.items():",
+                '        entry_id, _, key = name.partition(".")',
+                "        if not key:",
+                "            continue",
+                f'        entry = entries.setdefault(entry_id, {{"{g.id_key}": entry_id}})',
+                "        if v is not None:",
+                "            entry[key] = v",
+                "    if entries:",
+                f'        reading["{g.key}"] = list(entries.values())']
+        for f in dev.fields:
+            if isinstance(f, F) and f.first_of:
+                gk, key = f.first_of.split(".")
+                out += [f'        if "{key}" in reading["{gk}"][0]:',
+                        f'            reading["{f.key}"] = reading["{gk}"][0]["{key}"]']
+    out += ["    return reading", "", ""]
+    return fn, out
+
+
+def _py_from_air(dev):
+    fn = dev.device_type.replace("-", "_") + "_from_air"
+    top = [f for f in _on_air(dev.fields, True) if _air_key(f, True) != f.key]
+    out = [f"def {fn}(frame: dict) -> dict:",
+           f'    """A {dev.device_type} LoRa frame (build_air) as a payload dict; payloads',
+           '    with the full keys come back unchanged."""',
+           "    reading = dict(frame)"]
+    if top:
+        pairs = ", ".join(f'("{_air_key(f, True)}", "{f.key}")' for f in top)
+        out += [f"    for air, key in ({pairs}):",
+                "        if air in reading:",
+                "            reading[key] = reading.pop(air)"]
+    for g in _on_air(dev.fields, True):
+        if not isinstance(g, Group):
+            continue
+        if g.count:
+            fields = _on_air(g.fields, True)
+            keys = ", ".join(f'"{f.key}"' for f in fields) + ("," if len(fields) == 1 else "")
+            out += [f'    if isinstance(reading.get("{g.key}"), list):',
+                    f'        reading["{g.key}"] = [',
+                    f"            {{k: v for k, v in zip(({keys}), e) if v is not None}}",
+                    "            if isinstance(e, list) else e",
+                    f'            for e in reading["{g.key}"]',
+                    "        ]"]
+        else:
+            inner = [f for f in _on_air(g.fields, True) if _air_key(f, True) != f.key]
+            if inner:
+                pairs = ", ".join(f'("{_air_key(f, True)}", "{f.key}")' for f in inner)
+                out += [f'    if isinstance(reading.get("{g.key}"), dict):',
+                        f'        group = reading["{g.key}"] = dict(reading["{g.key}"])',
+                        f"        for air, key in ({pairs}):",
+                        "            if air in group:",
+                        "                group[key] = group.pop(air)"]
+    for f in dev.fields:
+        if isinstance(f, F) and f.first_of and f.air is None:
+            gk, key = f.first_of.split(".")
+            out += [f'    if "{f.key}" not in reading and reading.get("{gk}") '
+                    f'and "{key}" in reading["{gk}"][0]:',
+                    f'        reading["{f.key}"] = reading["{gk}"][0]["{key}"]']
+    out += ["    return reading", "", ""]
+    return fn, out
+
+
+def gen_py():
+    out = ['"""', BANNER, "", "Reading payloads as the WX firmware sends them (hardware/schema/readings.py),",
+           "and decoders from LoRa frames and packed backlog columns back to payload dicts.",
+           '"""', "",
+           "from typing import Optional", "", "from pydantic import BaseModel, Field", "", ""]
+    seen = set()
+    for dev in DEVICES:
+        _py_models(dev.fields, dev.model, seen, out)
+    for dev in DEVICES:
+        out += _py_from_air(dev)[1]
+    out.append("FROM_AIR = {")
+    out += [f'    "{dev.device_type}": {_py_from_air(dev)[0]},' for dev in DEVICES]
+    out += ["}", "", ""]
+    decoders = []
+    for dev in DEVICES:
+        if dev.backlog:
+            fn, lines = _py_decoder(dev)
+            decoders.append((dev.device_type, fn))
+            out += lines
+    out.append("FROM_COLUMNS = {")
+    out += [f'    "{t}": {fn},' for t, fn in decoders]
+    out.append("}")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    ap.add_argument("--check", action="store_true", help="exit 1 if an output is stale")
+    args = ap.parse_args()
+
+    outputs = {dev.header: gen_cpp(dev) for dev in DEVICES}
+    outputs[BACKEND] = gen_py()
+    stale = 0
+    for rel, text in outputs.items():
+        path = ROOT / rel
+        if path.exists() and path.read_text() == text:
+            continue
+        stale += 1
+        if args.check:
+            print(f"stale: {rel}", file=sys.stderr)
+        else:
+            path.write_text(text)
+            print(f"wrote {rel}")
+    return 1 if args.check and stale else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
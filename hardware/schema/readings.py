@@ -0,0 +1,212 @@
+"""
+WX reading schema — the one definition of what a unit reports.
+
+Each field carries its JSON key, wire type, precision (decimal places,
+used both for JSON rounding and as the fixed-point scale of the packed
+backlog), where the firmware reads it from, and how the backend models
+it. gen_readings.py compiles this into:
+
+    hardware/wx-level/firmware/reading_schema.h   build_json(), build_air(), pack_begin(), pack_add()
+    hardware/wx-flow/firmware/reading_schema.h    build_json(), build_air()
+    backend/api/reading_schema.py                 pydantic models, LoRa frame and packed-column decoders
+
+build_air() is the LoRa frame: still JSON, so the gateway bridge can read
+it, but under each field's short `air` key, with arrays of objects sent as
+arrays of values in field order, and with the fields that have no air key
+left for cellular. It has to fit LORA_MAX_PAYLOAD; AIR_MAX_BYTES is its
+longest form: every conditional field present, numbers within their
+`span` (four integer digits without one), strings at their `width`.
+
+The firmware structs (SensorReading, FullReading) stay hand-written: they
+hold measurement state, and a field here that names a member they lack
+fails to compile. After editing, regenerate and commit the outputs:
+
+    python3 hardware/schema/gen_readings.py
+"""
+
+from dataclasses import dataclass, field
+from typing import Any, Optional
+
+REQUIRED = object()     # backend: no default, the payload must carry it
+
+# Packed backlog column codings (common/firmware/ts_codec.h)
+DOD = "TS_DOD"          # delta-of-delta: counters, clocks
+DELTA = "TS_DELTA"      # delta: slowly varying sensor values
+XOR = "TS_XOR"          # float XOR: unrounded floats
+
+
+@dataclass
+class F:
+    """A scalar (or fixed-length array, count > 0) field."""
+    key: str
+    type: str                     # f32 | u32 | u8 | bool | str
+    decimals: int = 0             # f32 only
+    src: str = ""                 # C++ expression; `r` is the reading
+    when: str = ""                # C++ condition; the key is omitted when false
+    default: Any = 0              # backend default, None → Optional, REQUIRED
+    count: int = 0                # > 0: JSON array of this many values
+    pack: Optional[str] = None    # column coding in the packed backlog
+    first_of: str = ""            # "group.key": backlog decode fills it from entry 0
+    air: Optional[str] = ""       # LoRa frame key: "" = same as key, None = not sent
+    width: int = 0                # str from an expression: longest value (AIR_MAX_BYTES)
+    span: tuple = ()              # (lowest, highest) value on air (AIR_MAX_BYTES)
+    doc: str = ""
+
+
+@dataclass
+class Group:
+    """
+    A nested object (count == "") or an array of objects, one per index
+    `i` below count. locals are C++ declarations visible to the fields.
+    In the packed backlog an array's columns are named "<id>.<key>",
+    id being the entry's `id_key` field. In the LoRa frame an array's
+    entries are value arrays; a field's air key then only says whether
+    it is sent (None = not), and a conditional one goes as null (0 for
+    integers) when its condition is false.
+    """
+    key: str
+    model: str
+    fields: list
+    count: str = ""
+    locals: list = field(default_factory=list)
+    id_key: str = ""
+    air: Optional[str] = ""
+    doc: str = ""
+
+
+@dataclass
+class Device:
+    device_type: str
+    reading: str                  # firmware reading struct
+    header: str                   # generated C++ header, from the repo root
+    model: str                    # backend pydantic model
+    fields: list
+    backlog: bool = False         # emit pack_begin() / pack_add()
+
+
+def _identity(device_type):
+    return [
+        F("device_id", "str", src="DEVICE_ID", default=REQUIRED),
+        F("device_type", "str", src="DEVICE_TYPE", default=device_type),
+        F("fw_version", "str", src="FIRMWARE_VERSION", default="", air=None),
+        F("boot_count", "u32", src="r.boot_count", pack=DOD, air="n", span=(0, 9999999)),
+    ]
+
+
+def _tx():
+    """Transport policy decision for this reading (common/firmware/tx_policy.h);
+    cellular only, LoRa frames leave it out."""
+    return Group("tx", "TxTelemetry", fields=[
+        F("route", "str", src="tx_route_name(r.tx.route)", default="",
+          doc='"lora", "cell" or "defer"'),
+        F("reason", "str", src="tx_reason_name(r.tx.reason)", default=""),
+        F("queued", "u8", src="r.tx.queued", doc="readings waiting at decision time"),
+        F("p_lora", "f32", 2, "r.tx.p[TX_LORA]", doc="observed delivery rate"),
+        F("p_cell", "f32", 2, "r.tx.p[TX_CELL]"),
+        F("cost_j", "f32", 1, "r.tx.cost_j[r.tx.route]", when="r.tx.route != TX_DEFER",
+          default=None, doc="weighted cost per reading of the chosen route"),
+    ], air=None)
+
+
+def _campaign():
+    """Synoptic campaign tag (common/firmware/campaign.h)."""
+    return [
+        F("campaign", "u32", src="r.campaign", when="r.campaign", air="cp", span=(0, 999999),
+          doc="synoptic campaign this reading was taken for, 0 = none"),
+        F("campaign_dt_s", "f32", 3, "r.campaign_dt_s", when="r.campaign", default=None,
+          air="cd", span=(-999, 999),
+          doc="unit's estimate of measured time minus the campaign instant"),
+        F("clock_err_s", "f32", 3, "r.clock_err_s", when="r.campaign", default=None,
+          air="ce", span=(0, 999), doc="error bound of campaign_dt_s"),
+    ]
+
+
+def _battery():
+    """Battery sag tracking (common/firmware/battery_sag.h)."""
+    return [
+        F("batt_r_ohm", "f32", 3, "r.batt.r_ohm", when="r.batt.r_ohm > 0", default=None,
+          air="br", span=(0, 10),
+          doc="tracked internal resistance, from loads of known current"),
+        F("batt_min_v", "f32", 2, "r.batt.min_v", when="r.batt.min_v > 0", default=None,
+          air="bm", span=(0, 10),
+          doc="lowest battery voltage under load since the last reading"),
+    ]
+
+
+WX_LEVEL = Device(
+    device_type="wx-level",
+    reading="SensorReading",
+    header="hardware/wx-level/firmware/reading_schema.h",
+    model="WXLevelPayload",
+    backlog=True,
+    fields=_identity("wx-level") + [
+        F("water_level_ft", "f32", 2, "r.water_level_ft", default=None,
+          first_of="wells.water_level_ft", air=None,
+          doc="channel 0, for single-well consumers; null when it failed"),
+        F("pressure_psi", "f32", 3, "r.pressure_psi", default=None,
+          first_of="wells.pressure_psi", air=None),
+        F("water_temp_c", "f32", 1, "r.water_temp_c", default=None, pack=DELTA, air="wt",
+          span=(-40, 85)),
+        F("baro_pressure_hpa", "f32", 1, "r.baro_pressure_hpa", default=None, pack=DELTA,
+          air="bp", span=(300, 1100)),
+        F("baro_temp_c", "f32", 1, "r.baro_temp_c", default=None, air="bt", span=(-40, 85)),
+        F("humidity_pct", "f32", 1, "r.humidity_pct", default=None, air="rh", span=(0, 100)),
+        F("battery_v", "f32", 2, "r.battery_v", pack=DELTA, air="bv", span=(0, 9)),
+        F("solar_v", "f32", 2, "r.solar_v", pack=DELTA, air="sv", span=(0, 25)),
+        Group("wells", "WellChannelReading", count="WELL_COUNT", id_key="well_id", air="w",
+              locals=["const WellReading &w = r.wells[i]",
+                      "const DigitalWell *dw = digital_well(i)"],
+              fields=[
+                  F("well_id", "str", src="well_id(i)", default="", width=4),
+                  F("channel", "u8", src="WELL_CFG[i].ads_channel", when="!dw", default=None,
+                    air=None, doc="ADS1115 input for analog wells"),
+                  F("bus", "str", src="dw->bus", when="dw", default="analog", air=None,
+                    doc='"modbus" or "sdi12" for digital sensors'),
+                  F("water_level_ft", "f32", 2, "w.water_level_ft", when="w.ok", default=None,
+                    pack=DELTA, span=(-999, 9999), doc="absent when the sonde did not answer"),
+                  F("pressure_psi", "f32", 3, "w.pressure_psi", when="w.ok", default=None,
+                    pack=DELTA, span=(0, 300)),
+                  F("alarm", "u8", src="w.alarm", when="w.alarm", span=(0, 7),
+                    doc="threshold breach: 1 below MT, 2 below MO, 4 rate of change"),
+              ]),
+        F("thr_version", "u32", src="r.thr_version", when="r.thr_version", air="tv",
+          span=(0, 999999),
+          doc="SGMA threshold set checked on the unit, 0 = none"),
+        F("read_req", "u32", src="r.read_req", when="r.read_req", air="rr", span=(0, 999999),
+          doc="on-demand read request this reading answers, 0 = scheduled"),
+    ] + _battery() + _campaign() + [
+        _tx(),
+    ],
+)
+
+WX_FLOW = Device(
+    device_type="wx-flow",
+    reading="FullReading",
+    header="hardware/wx-flow/firmware/reading_schema.h",
+    model="WXFlowPayload",
+    fields=_identity("wx-flow") + [
+        Group("flow", "FlowData", air="f", fields=[
+            F("velocity_cm_day", "f32", 1, "r.flow.velocity_cm_day", air="v",
+              span=(-9999, 9999)),
+            F("direction_deg", "f32", 0, "r.flow.direction_deg", default=-1, air="d",
+              span=(-1, 360)),
+            F("valid", "bool", src="r.flow.valid", default=False, air="ok"),
+            F("peak_temps", "f32", 2, "r.flow.peak_temps", count=4, air="pt", span=(0, 99)),
+            F("peak_times", "f32", 1, "r.flow.peak_times", count=4, air="ps", span=(0, 999)),
+        ]),
+        F("conductivity_us", "f32", 0, "r.conductivity_us", air="ec", span=(0, 99999)),
+        F("tds_ppm", "f32", 0, "r.tds_ppm", air="td", span=(0, 99999)),
+        F("water_temp_c", "f32", 1, "r.water_temp_c", air="wt", span=(-40, 85)),
+        F("water_level_ft", "f32", 2, "r.water_level_ft", air="wl", span=(-999, 9999)),
+        F("pressure_psi", "f32", 3, "r.pressure_psi", air="p", span=(0, 300)),
+        F("battery_v", "f32", 2, "r.battery_v", air="bv", span=(0, 9)),
+        F("solar_v", "f32", 2, "r.solar_v", air="sv", span=(0, 25)),
+        F("burst", "str", src="pressure_event_name(r.burst)", when="r.burst", default=None,
+          air="bu", width=8,
+          doc='"drawdown" or "recovery": an extra pulse of a pressure-triggered burst'),
+    ] + _battery() + _campaign() + [
+        _tx(),
+    ],
+)
+
+DEVICES = [WX_LEVEL, WX_FLOW]
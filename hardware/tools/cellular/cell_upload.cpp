@@ -0,0 +1,104 @@
+/*
+ * Cellular upload driver — runs the firmware's send_cellular() sequence
+ * (common/firmware/sim7000.h) against a tty.
+ *
+ * Point it at the pty printed by modem-sim, or a SIM7000G on a USB-UART
+ * adapter, to time whole upload sessions: PWRKEY, attach, HTTPS POST of a
+ * build_json() payload, reply read-back, detach and power-down. Payloads
+ * come from the firmware via fleet/; APN, host and endpoint from WX-Level's
+ * config.h (WX-Flow's are the same).
+ *
+ * With --park the modem is left registered in eDRX between uploads
+ * (sim_release() with SIM_RI_WAKE) instead of powered down, so the cost of
+ * staying reachable can be set against a power cycle per upload.
+ *
+ * Usage:
+ *   cell-upload /dev/pts/N [--uploads 10] [--unit level|flow] [--gap-s 1] [--park]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include "config.h"
+#include "sim7000.h"
+#include "posix_serial.h"
+#include "../fleet/fleet_units.h"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s TTY [--uploads N] [--unit level|flow] [--gap-s S] [--park]\n",
+                argv[0]);
+        return 2;
+    }
+    uint32_t uploads = 10;
+    double gap_s = 1;
+    bool park = false;
+    const UnitType *unit = &wx_level_unit();
+    for (int i = 2; i < argc; i++) {
+        bool more = i + 1 < argc;
+        const char *a = argv[i];
+        if (!strcmp(a, "--uploads") && more)        uploads = atoi(argv[++i]);
+        else if (!strcmp(a, "--gap-s") && more)     gap_s = atof(argv[++i]);
+        else if (!strcmp(a, "--park"))              park = true;
+        else if (!strcmp(a, "--unit") && more) {
+            const char *v = argv[++i];
+            if (!strcmp(v, "level"))     unit = &wx_level_unit();
+            else if (!strcmp(v, "flow")) unit = &wx_flow_unit();
+            else {
+                fprintf(stderr, "unknown unit: %s\n", v);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return 2;
+        }
+    }
+
+    PosixSerial io;
+    if (!io.open_tty(argv[1])) {
+        perror(argv[1]);
+        return 1;
+    }
+    HostClock clock;
+    std::mt19937 rng(1);
+
+    printf("upload,status,session_s,bytes,reply\n");
+    uint32_t delivered = 0;
+    double total_s = 0;
+    bool parked = false;
+    for (uint32_t u = 0; u < uploads; u++) {
+        if (u) host_sleep_us((uint64_t)(gap_s * 1e6));
+        char json[2048];
+        size_t len = unit->payload(0, u + 1, rng, json, sizeof(json));
+        if (!len) {
+            fprintf(stderr, "build_json() produced no payload\n");
+            return 2;
+        }
+
+        // As send_cellular(): sim_power_on() holds PWRKEY for a second,
+        // unless the modem was left parked
+        uint64_t t0 = host_now_us();
+        if (!parked) clock.delay_ms(1000);
+        Sim7000 modem(io, clock);
+        int status = -1;
+        char reply[512] = "";
+        if (modem.attach(APN) && modem.http_open("https://" SERVER_HOST)) {
+            status = modem.http_post(API_ENDPOINT, "application/json",
+                                     (const uint8_t *)json, len, reply, sizeof(reply));
+            modem.http_close();
+        }
+        modem.detach();
+        parked = park && modem.ring_on_sms(SIM_EDRX_CYCLE);
+        if (!parked) modem.power_off();
+        double s = (host_now_us() - t0) / 1e6;
+
+        total_s += s;
+        if (status == 200) delivered++;
+        printf("%u,%d,%.2f,%zu,%s\n", u + 1, status, s, len, reply);
+        fflush(stdout);
+    }
+    fprintf(stderr, "%u of %u uploads delivered, %.2f s per session\n", delivered, uploads,
+            uploads ? total_s / uploads : 0.0);
+    return delivered ? 0 : 1;
+}
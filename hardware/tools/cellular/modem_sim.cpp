@@ -0,0 +1,557 @@
+/*
+ * Simulated SIM7000G on a pseudo-terminal.
+ *
+ * Opens a pty, prints the path for the firmware side, and answers the AT
+ * subset the firmware's Sim7000 client uses: PDP context (AT+CNACT), the
+ * SH* HTTP(S) stack and power-down. Requests are forwarded to a local
+ * backend (uvicorn, see backend/) or answered by a built-in stand-in.
+ *
+ * Network timing — boot, attach, TLS connect, request round-trip — is
+ * injected in real time, along with ERROR replies, failed attaches, dropped
+ * connections and unsolicited result codes. The modem is metered like a
+ * bench supply on its rail: each power cycle (first byte after power-down
+ * to AT+CPOWD) is one session, and its on-time and energy come from the
+ * time spent in each state and that state's current. One CSV row is
+ * printed per session. A modem parked in eDRX after detach (AT+CEDRXS, as
+ * the firmware's ring_on_sms() leaves it) also ends a session; the next
+ * one starts without a boot, and the idle time in between is billed to it
+ * at the eDRX current.
+ *
+ *   modem-sim --sessions 10 --baseline cell_baseline.csv &
+ *   cell-upload /dev/pts/N --uploads 10
+ *
+ * With --sessions N the simulator exits after N sessions with a summary,
+ * and --baseline FILE fails it when mean on-time or energy per upload is
+ * more than --slower times the baseline (--update rewrites it).
+ *
+ * Commands not implemented answer ERROR and are logged, so firmware that
+ * starts using a new command (UDP sockets, PSM) shows up here first; add
+ * it to COMMANDS below.
+ */
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <random>
+#include <string>
+#include "http_client.h"
+#include "posix_serial.h"
+#include "../replay/trace_file.h"
+
+enum ModemState { M_OFF, M_BOOT, M_READY, M_ATTACH, M_ONLINE, M_CONNECTED, M_EDRX, M_STATE_COUNT };
+static const char *STATE_NAMES[M_STATE_COUNT] = {
+    "off", "boot", "ready", "attach", "online", "connected", "edrx",
+};
+
+struct SimOptions {
+    const char *backend     = nullptr;   // http://host:port; null = built-in stand-in
+    const char *reply       = "{\"status\":\"ok\"}";
+    int         status      = 200;       // stand-in HTTP status
+    // Latencies, ms; defaults approximate a ~25 s Cat-M1 session in the field
+    double pwrkey_ms  = 1000;            // PWRKEY pulse before the first AT (sim_power_on)
+    double boot_ms    = 3000;
+    double cmd_ms     = 20;
+    double attach_ms  = 15000;           // registration + PDP activation
+    double conn_ms    = 3000;            // TCP + TLS handshake
+    double rtt_ms     = 800;             // per HTTP request, on top of the backend's time
+    double jitter     = 0.2;             // each latency × U(1 - j, 1 + j)
+    // Faults, as probabilities
+    double error       = 0;              // any command answers ERROR
+    double attach_fail = 0;
+    double conn_fail   = 0;
+    double http_fail   = 0;              // connection drops during a request
+    double urc_rate    = 0;              // noise URCs per second while powered
+    // Rail
+    double ma[M_STATE_COUNT] = { 0, 60, 30, 100, 40, 140, 1 };   // eDRX: average over paging cycles
+    double vbat      = 3.8;
+    uint32_t sessions = 0;               // exit after this many; 0 = run forever
+    uint32_t seed     = 1;
+    bool     trace    = false;
+};
+
+struct SessionStats {
+    double   state_s[M_STATE_COUNT] = {};
+    uint32_t commands = 0, errors = 0, posts = 0, delivered = 0;
+    uint64_t bytes_up = 0, bytes_down = 0;
+
+    double on_s() const {
+        double s = 0;
+        for (int i = M_BOOT; i < M_STATE_COUNT; i++) s += state_s[i];
+        return s;
+    }
+};
+
+class SimModem;
+typedef void (SimModem::*AtHandler)(const char *args);
+struct AtCommand {
+    const char *name;       // up to '=' or '?'
+    AtHandler   fn;
+};
+
+class SimModem {
+public:
+    SimModem(int fd, const SimOptions &opt)
+        : fd_(fd), opt_(opt), rng_(opt.seed), u01_(0.0, 1.0) {
+        if (opt.backend) parse_http_url(opt.backend, url_);
+    }
+
+    bool powered() const { return state_ != M_OFF; }
+    uint32_t sessions() const { return sessions_; }
+    const std::vector<SessionStats> &history() const { return history_; }
+
+    // Bytes from the firmware side
+    void feed(const uint8_t *buf, size_t n) {
+        if (!powered()) {
+            power_on();     // the first AT wakes it; nothing is answered until booted
+            return;
+        }
+        if (state_ == M_EDRX) enter(M_READY);   // registered and listening: answers at once
+        for (size_t i = 0; i < n; i++) {
+            uint8_t c = buf[i];
+            if (skip_lf_) {
+                skip_lf_ = false;
+                if (c == '\n') continue;
+            }
+            if (body_left_) {
+                body_.push_back((char)c);
+                if (--body_left_ == 0) {
+                    stats_.bytes_up += body_.size();
+                    ok();
+                }
+                continue;
+            }
+            if (c == '\r' || c == '\n') {
+                skip_lf_ = c == '\r';
+                std::string cmd;
+                cmd.swap(line_);
+                if (!cmd.empty()) run(cmd);
+            } else {
+                line_.push_back((char)c);
+            }
+        }
+    }
+
+    // Between commands: unsolicited result codes
+    void idle(double dt_s) {
+        if (!powered() || opt_.urc_rate <= 0) return;
+        if (u01_(rng_) < opt_.urc_rate * dt_s) {
+            static const char *const NOISE[] = {
+                "+CPSI: LTE CAT-M1,Online,310-410,0x2C1F,27447553,340,EUTRAN-BAND12,5110,3,3,-11,-91,-61,15",
+                "+CGREG: 1",
+                "+CTZV: -28,0",
+            };
+            urc(NOISE[(size_t)(u01_(rng_) * 3) % 3]);
+        }
+    }
+
+    static const AtCommand COMMANDS[];
+
+    // ── AT handlers ──
+    void at(const char *)     { ok(); }
+    void echo_off(const char *) { echo_ = false; ok(); }
+    void echo_on(const char *)  { echo_ = true; ok(); }
+
+    void cnact(const char *args) {
+        if (args[0] == '0') {
+            if (state_ >= M_ONLINE) enter(M_READY);
+            ok();
+            urc("+APP PDP: DEACTIVE");
+            return;
+        }
+        if (state_ >= M_ONLINE) return ok();
+        ok();
+        enter(M_ATTACH);
+        wait(opt_.attach_ms);
+        if (fault(opt_.attach_fail)) {
+            enter(M_READY);
+            urc("+APP PDP: DEACTIVE");
+        } else {
+            enter(M_ONLINE);
+            urc("+APP PDP: ACTIVE");
+        }
+    }
+
+    void shconf(const char *args) {
+        unsigned n;
+        if (sscanf(args, "\"BODYLEN\",%u", &n) == 1) bodylen_ = n;
+        ok();
+    }
+
+    void shconn(const char *) {
+        if (state_ < M_ONLINE) return error();
+        wait(opt_.conn_ms);
+        if (fault(opt_.conn_fail)) return error();
+        enter(M_CONNECTED);
+        ok();
+    }
+
+    void shstate(const char *) {
+        urc(state_ == M_CONNECTED ? "+SHSTATE: 1" : "+SHSTATE: 0");
+        ok();
+    }
+
+    void shchead(const char *) { ok(); }
+    void shahead(const char *) { ok(); }
+
+    void shbod(const char *args) {
+        unsigned len = (unsigned)atoi(args);
+        if (state_ != M_CONNECTED || len == 0 || len > bodylen_) return error();
+        body_.clear();
+        body_left_ = len;
+        write_raw(">", 1);
+    }
+
+    void shreq(const char *args) {
+        if (state_ != M_CONNECTED) return error();
+        std::string path = args[0] == '"' ? args + 1 : args;
+        size_t q = path.find('"');
+        int type = q != std::string::npos && path[q + 1] == ',' ? atoi(path.c_str() + q + 2) : 1;
+        if (q != std::string::npos) path.resize(q);
+        ok();
+
+        const char *method = type == 3 ? "POST" : "GET";
+        int status;
+        uint64_t t0 = host_now_us();
+        if (opt_.backend) {
+            HttpConnection conn(url_);
+            conn.set_timeout_ms(30000);
+            status = conn.request(method, path, type == 3 ? body_.data() : nullptr,
+                                  type == 3 ? body_.size() : 0);
+            resp_ = status > 0 ? conn.body() : std::string();
+        } else {
+            status = opt_.status;
+            resp_ = opt_.reply;
+        }
+        wait(opt_.rtt_ms - (host_now_us() - t0) / 1000.0);
+        if (type == 3) stats_.posts++;
+        if (status < 0 || fault(opt_.http_fail)) {
+            enter(M_ONLINE);
+            urc("+SHSTATE: 0");
+            return;
+        }
+        if (type == 3 && status >= 200 && status < 300) stats_.delivered++;
+        char buf[64];
+        snprintf(buf, sizeof(buf), "+SHREQ: \"%s\",%d,%zu", method, status, resp_.size());
+        urc(buf);
+    }
+
+    void shread(const char *args) {
+        unsigned pos = 0, len = 0;
+        if (sscanf(args, "%u,%u", &pos, &len) != 2 || pos > resp_.size()) return error();
+        if (pos + len > resp_.size()) len = (unsigned)(resp_.size() - pos);
+        ok();
+        char buf[32];
+        snprintf(buf, sizeof(buf), "+SHREAD: %u", len);
+        urc(buf);
+        write_raw(resp_.data() + pos, len);
+        stats_.bytes_down += len;
+    }
+
+    void shdisc(const char *) {
+        if (state_ == M_CONNECTED) enter(M_ONLINE);
+        ok();
+    }
+
+    void cpowd(const char *) {
+        urc("NORMAL POWER DOWN");
+        end_session(M_OFF);
+    }
+
+    // SMS ring wake (Sim7000::ring_on_sms): text mode, delete stored
+    // messages, new-message indication and RI pulses need no state here
+    void cmgf(const char *)  { ok(); }
+    void cmgd(const char *)  { ok(); }
+    void cnmi(const char *)  { ok(); }
+    void cfgri(const char *) { ok(); }
+
+    // eDRX on while detached parks the modem instead of powering it down
+    void cedrxs(const char *args) {
+        ok();
+        if (atoi(args) == 1 && state_ == M_READY) end_session(M_EDRX);
+    }
+
+private:
+    void run(const std::string &cmd) {
+        stats_.commands++;
+        if (opt_.trace) fprintf(stderr, "[%s] %s\n", STATE_NAMES[state_], cmd.c_str());
+        if (echo_) {
+            write_raw(cmd.data(), cmd.size());
+            write_raw("\r\n", 2);
+        }
+        size_t end = cmd.find_first_of("=?");
+        std::string name = cmd.substr(0, end);
+        const char *args = end == std::string::npos ? "" : cmd.c_str() + end + (cmd[end] == '=');
+        for (const AtCommand *c = COMMANDS; c->name; c++) {
+            if (strcasecmp(name.c_str(), c->name)) continue;
+            wait(opt_.cmd_ms);
+            // Power-down and parking always work, so a session is never left open
+            if (c->fn != &SimModem::cpowd && c->fn != &SimModem::cedrxs && fault(opt_.error)) {
+                return error();
+            }
+            (this->*c->fn)(args);
+            return;
+        }
+        fprintf(stderr, "modem-sim: unsupported command %s\n", cmd.c_str());
+        error();
+    }
+
+    void power_on() {
+        stats_ = SessionStats();
+        stats_.state_s[M_BOOT] += opt_.pwrkey_ms / 1000.0;
+        echo_ = true;
+        enter(M_BOOT);
+        wait(opt_.boot_ms);
+        tcflush(fd_, TCIFLUSH);        // what arrived during boot was never seen
+        line_.clear();
+        enter(M_READY);
+        for (const char *u : { "RDY", "+CFUN: 1", "+CPIN: READY", "SMS Ready" }) urc(u);
+    }
+
+    // Closes the session's books; a parked modem's idle time goes to the next
+    void end_session(ModemState next) {
+        enter(next);
+        body_left_ = 0;
+        resp_.clear();
+        history_.push_back(stats_);
+        sessions_++;
+        const SessionStats &s = stats_;
+        double j = energy_j(s);
+        printf("%u,%.2f,%.2f,%.2f", sessions_, s.on_s(), j, s.delivered ? j / s.delivered : 0.0);
+        for (int i = M_BOOT; i < M_STATE_COUNT; i++) printf(",%.2f", s.state_s[i]);
+        printf(",%u,%u,%u,%u,%llu,%llu\n", s.commands, s.errors, s.posts, s.delivered,
+               (unsigned long long)s.bytes_up, (unsigned long long)s.bytes_down);
+        fflush(stdout);
+        stats_ = SessionStats();
+    }
+
+    void enter(ModemState s) {
+        uint64_t now = host_now_us();
+        if (state_ != M_OFF) stats_.state_s[state_] += (now - since_us_) / 1e6;
+        state_ = s;
+        since_us_ = now;
+    }
+
+    void wait(double ms) {
+        if (ms <= 0) return;
+        double f = 1.0 + opt_.jitter * (2.0 * u01_(rng_) - 1.0);
+        host_sleep_us((uint64_t)(ms * f * 1000.0));
+    }
+
+    bool fault(double p) { return p > 0 && u01_(rng_) < p; }
+
+    void write_raw(const char *p, size_t n) {
+        while (n) {
+            ssize_t w = write(fd_, p, n);
+            if (w <= 0) return;
+            p += w;
+            n -= (size_t)w;
+        }
+    }
+
+    void urc(const char *line) {
+        write_raw("\r\n", 2);
+        write_raw(line, strlen(line));
+        write_raw("\r\n", 2);
+    }
+
+    void ok()    { urc("OK"); }
+    void error() { stats_.errors++; urc("ERROR"); }
+
+public:
+    double energy_j(const SessionStats &s) const {
+        double mas = 0;
+        for (int i = M_BOOT; i < M_STATE_COUNT; i++) mas += s.state_s[i] * opt_.ma[i];
+        return mas / 1000.0 * opt_.vbat;
+    }
+
+private:
+    int                 fd_;
+    const SimOptions   &opt_;
+    HttpUrl             url_;
+    std::mt19937        rng_;
+    std::uniform_real_distribution<double> u01_;
+
+    ModemState  state_ = M_OFF;
+    uint64_t    since_us_ = 0;
+    bool        echo_ = true;
+    bool        skip_lf_ = false;
+    std::string line_;
+    std::string body_;
+    size_t      body_left_ = 0;
+    unsigned    bodylen_ = 4096;
+    std::string resp_;
+
+    SessionStats              stats_;
+    std::vector<SessionStats> history_;
+    uint32_t                  sessions_ = 0;
+};
+
+const AtCommand SimModem::COMMANDS[] = {
+    { "AT",         &SimModem::at },
+    { "ATE0",       &SimModem::echo_off },
+    { "ATE1",       &SimModem::echo_on },
+    { "AT+CNACT",   &SimModem::cnact },
+    { "AT+SHCONF",  &SimModem::shconf },
+    { "AT+SHCONN",  &SimModem::shconn },
+    { "AT+SHSTATE", &SimModem::shstate },
+    { "AT+SHCHEAD", &SimModem::shchead },
+    { "AT+SHAHEAD", &SimModem::shahead },
+    { "AT+SHBOD",   &SimModem::shbod },
+    { "AT+SHREQ",   &SimModem::shreq },
+    { "AT+SHREAD",  &SimModem::shread },
+    { "AT+SHDISC",  &SimModem::shdisc },
+    { "AT+CPOWD",   &SimModem::cpowd },
+    { "AT+CMGF",    &SimModem::cmgf },
+    { "AT+CMGD",    &SimModem::cmgd },
+    { "AT+CNMI",    &SimModem::cnmi },
+    { "AT+CFGRI",   &SimModem::cfgri },
+    { "AT+CEDRXS",  &SimModem::cedrxs },
+    { nullptr,      nullptr },
+};
+
+/*
+ * modem-sim [--backend http://127.0.0.1:8000] [--status 200] [--reply JSON]
+ *           [--pwrkey-ms 1000] [--boot-ms 3000] [--cmd-ms 20] [--attach-ms 15000]
+ *           [--conn-ms 3000] [--rtt-ms 800] [--jitter 0.2]
+ *           [--error P] [--attach-fail P] [--conn-fail P] [--http-fail P] [--urc-rate R]
+ *           [--ma STATE=mA]... [--vbat 3.8] [--sessions N] [--seed 1] [--trace]
+ *           [--baseline FILE] [--update] [--slower 1.2]
+ */
+int main(int argc, char **argv) {
+    SimOptions opt;
+    const char *baseline_path = nullptr;
+    bool update = false;
+    double slower = 1.2;
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        const char *a = argv[i];
+        if (!strcmp(a, "--backend") && more)            opt.backend = argv[++i];
+        else if (!strcmp(a, "--status") && more)        opt.status = atoi(argv[++i]);
+        else if (!strcmp(a, "--reply") && more)         opt.reply = argv[++i];
+        else if (!strcmp(a, "--pwrkey-ms") && more)     opt.pwrkey_ms = atof(argv[++i]);
+        else if (!strcmp(a, "--boot-ms") && more)       opt.boot_ms = atof(argv[++i]);
+        else if (!strcmp(a, "--cmd-ms") && more)        opt.cmd_ms = atof(argv[++i]);
+        else if (!strcmp(a, "--attach-ms") && more)     opt.attach_ms = atof(argv[++i]);
+        else if (!strcmp(a, "--conn-ms") && more)       opt.conn_ms = atof(argv[++i]);
+        else if (!strcmp(a, "--rtt-ms") && more)        opt.rtt_ms = atof(argv[++i]);
+        else if (!strcmp(a, "--jitter") && more)        opt.jitter = atof(argv[++i]);
+        else if (!strcmp(a, "--error") && more)         opt.error = atof(argv[++i]);
+        else if (!strcmp(a, "--attach-fail") && more)   opt.attach_fail = atof(argv[++i]);
+        else if (!strcmp(a, "--conn-fail") && more)     opt.conn_fail = atof(argv[++i]);
+        else if (!strcmp(a, "--http-fail") && more)     opt.http_fail = atof(argv[++i]);
+        else if (!strcmp(a, "--urc-rate") && more)      opt.urc_rate = atof(argv[++i]);
+        else if (!strcmp(a, "--vbat") && more)          opt.vbat = atof(argv[++i]);
+        else if (!strcmp(a, "--sessions") && more)      opt.sessions = atoi(argv[++i]);
+        else if (!strcmp(a, "--seed") && more)          opt.seed = atoi(argv[++i]);
+        else if (!strcmp(a, "--trace"))                 opt.trace = true;
+        else if (!strcmp(a, "--baseline") && more)      baseline_path = argv[++i];
+        else if (!strcmp(a, "--update"))                update = true;
+        else if (!strcmp(a, "--slower") && more)        slower = atof(argv[++i]);
+        else if (!strcmp(a, "--ma") && more) {
+            const char *v = argv[++i];
+            const char *eq = strchr(v, '=');
+            int s = M_BOOT;
+            while (eq && s < M_STATE_COUNT && strncmp(v, STATE_NAMES[s], eq - v)) s++;
+            if (!eq || s == M_STATE_COUNT) {
+                fprintf(stderr, "--ma wants boot|ready|attach|online|connected=mA, got %s\n", v);
+                return 2;
+            }
+            opt.ma[s] = atof(eq + 1);
+        } else {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return 2;
+        }
+    }
+    HttpUrl check;
+    if (opt.backend && !parse_http_url(opt.backend, check)) {
+        fprintf(stderr, "need an http://host[:port] backend URL, got %s\n", opt.backend);
+        return 2;
+    }
+
+    std::vector<std::string> cols = { "on_s", "energy_j", "j_per_upload" };
+    BaselineRows baseline;
+    if (baseline_path && !update && !load_baseline(baseline_path, cols.size(), baseline)) {
+        fprintf(stderr, "cannot read baseline %s\n", baseline_path);
+        return 2;
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("pty");
+        return 1;
+    }
+    termios tio;
+    tcgetattr(master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(master, TCSANOW, &tio);
+
+    printf("%s\n", ptsname(master));
+    printf("session,on_s,energy_j,j_per_upload");
+    for (int i = M_BOOT; i < M_STATE_COUNT; i++) printf(",%s_s", STATE_NAMES[i]);
+    printf(",commands,errors,posts,delivered,bytes_up,bytes_down\n");
+    fflush(stdout);
+
+    SimModem modem(master, opt);
+    uint64_t last = host_now_us();
+    while (!opt.sessions || modem.sessions() < opt.sessions) {
+        pollfd pfd = { master, POLLIN, 0 };
+        int r = poll(&pfd, 1, 100);
+        if (r > 0) {
+            uint8_t buf[512];
+            ssize_t n = read(master, buf, sizeof(buf));
+            if (n > 0) modem.feed(buf, (size_t)n);
+            else if (n < 0) host_sleep_us(100000);   // no client attached yet
+        }
+        uint64_t now = host_now_us();
+        modem.idle((now - last) / 1e6);
+        last = now;
+    }
+
+    // Closing the master hangs up the slave and discards what it has not
+    // read yet: give the client time to see the power-down reply
+    host_sleep_us(500000);
+
+    // ── Summary ──
+    const std::vector<SessionStats> &h = modem.history();
+    double on_s = 0, energy = 0;
+    uint32_t delivered = 0, posts = 0;
+    for (const SessionStats &s : h) {
+        on_s += s.on_s();
+        energy += modem.energy_j(s);
+        delivered += s.delivered;
+        posts += s.posts;
+    }
+    double per_upload = delivered ? energy / delivered : 0;
+    fprintf(stderr, "%zu sessions: %.2f s on, %.2f J per session; %u of %u posts delivered, "
+            "%.2f J per upload\n", h.size(), on_s / h.size(), energy / h.size(), delivered, posts,
+            per_upload);
+
+    BaselineRows fresh;
+    fresh["session"] = { on_s / h.size(), energy / h.size(), per_upload };
+    if (update && baseline_path) {
+        if (!write_baseline(baseline_path, cols, fresh, "run")) {
+            perror(baseline_path);
+            return 1;
+        }
+        fprintf(stderr, "baseline written: %s\n", baseline_path);
+        return 0;
+    }
+    int failures = 0;
+    auto it = baseline.find("session");
+    if (it != baseline.end()) {
+        const std::vector<double> &now = fresh["session"];
+        for (size_t c = 0; c < cols.size(); c++) {
+            double ratio = it->second[c] > 0 ? now[c] / it->second[c] : 1.0;
+            if (ratio > slower) {
+                fprintf(stderr, "SLOWER %s: %.2f vs %.2f baseline (%.2fx)\n", cols[c].c_str(),
+                        now[c], it->second[c], ratio);
+                failures++;
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdint.h>
+#include "hal.h"
+
+/*
+ * HalSerial and HalClock on a POSIX host in real time, so the firmware's
+ * Sim7000 client can talk to a tty — the pseudo-terminal of modem-sim, or
+ * a SIM7000G on a USB-UART adapter.
+ */
+
+inline uint64_t host_now_us() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+inline void host_sleep_us(uint64_t us) {
+    timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000L };
+    nanosleep(&ts, nullptr);
+}
+
+class HostClock : public HalClock {
+public:
+    uint32_t now_ms() override { return (uint32_t)(host_now_us() / 1000); }
+    uint32_t now_us() override { return (uint32_t)host_now_us(); }
+    void delay_ms(uint32_t ms) override { host_sleep_us((uint64_t)ms * 1000); }
+    void delay_us(uint32_t us) override { host_sleep_us(us); }
+};
+
+class PosixSerial : public HalSerial {
+public:
+    PosixSerial() : fd_(-1) {}
+    ~PosixSerial() { if (fd_ >= 0) close(fd_); }
+
+    // 8N1 at 115200, as the firmware opens Serial1 for the modem
+    bool open_tty(const char *path) {
+        fd_ = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd_ < 0) return false;
+        termios tio;
+        if (tcgetattr(fd_, &tio) == 0) {
+            cfmakeraw(&tio);
+            tio.c_cflag |= CLOCAL | CREAD;
+            cfsetispeed(&tio, B115200);
+            cfsetospeed(&tio, B115200);
+            tcsetattr(fd_, TCSANOW, &tio);
+        }
+        return true;
+    }
+
+    size_t write(const uint8_t *buf, size_t len) override {
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = ::write(fd_, buf + done, len - done);
+            if (n > 0) done += (size_t)n;
+            else if (n < 0 && errno == EAGAIN) host_sleep_us(1000);   // pty buffer full
+            else break;
+        }
+        return done;
+    }
+
+    int read() override {
+        uint8_t c;
+        return ::read(fd_, &c, 1) == 1 ? c : -1;
+    }
+
+private:
+    int fd_;
+};
@@ -0,0 +1,178 @@
+/*
+ * Packed-backlog bench for WX-Level (ts_codec.h). Builds a synthetic
+ * outage's worth of readings with groundwater-like behaviour:
+ *   - levels random-walking at the sensor's resolution, plus an optional
+ *     pumping drawdown
+ *   - diurnal barometric pressure and water temperature
+ *   - a solar-charged battery
+ * Then compares:
+ *   - bytes as one JSON payload per reading (build_json())
+ *   - bytes as packed batches of the firmware's BACKLOG_BYTES
+ *   - LoRa frames needed either way
+ * Every batch is decoded again and checked against the payload's
+ * precision. All of it uses the firmware's own pack_begin() / pack_add().
+ *
+ *   codec-level --readings 96,672,2880 --noise-ft 0.01 --drawdown-ft 3
+ *   codec-level --readings 200 --out backlog.bin    # sample for the backend
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "reading.h"
+
+struct Series {
+    std::vector<SensorReading> r;
+    std::vector<uint32_t>      t;
+};
+
+static Series make_series(size_t n, double noise_ft, double drawdown_ft, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> nrm(0.0, 1.0);
+    Series s;
+    double level[WELL_COUNT];
+    for (int w = 0; w < WELL_COUNT; w++) level[w] = 18.0 + 7.5 * w;
+    double battery = 3.95;
+    for (size_t i = 0; i < n; i++) {
+        double hours = i * (TX_INTERVAL_MS / 3.6e6);
+        double day = fmod(hours, 24.0) / 24.0;
+        SensorReading r = {};
+        r.boot_count = 1000 + (uint32_t)i;
+        r.baro_pressure_hpa = round_dp<1>(1012.0 + 1.6 * sin(2 * M_PI * (day * 2 - 0.1)) + 0.1 * nrm(rng));
+        r.water_temp_c = round_dp<1>(17.8 + 0.2 * sin(2 * M_PI * day));
+        r.baro_temp_c = r.water_temp_c;
+        double sun = std::max(0.0, sin(2 * M_PI * (day - 0.25)));
+        r.solar_v = round_dp<2>(sun * 6.1);
+        battery = std::min(4.15, battery + (sun > 0.2 ? 0.004 : -0.0015));
+        r.battery_v = round_dp<2>(battery + 0.005 * nrm(rng));
+        // Pumping draws the first well down over the first day, then it recovers
+        double pump = drawdown_ft * (hours < 24 ? hours / 24 : std::max(0.0, 1 - (hours - 24) / 48));
+        for (int w = 0; w < WELL_COUNT; w++) {
+            level[w] += noise_ft * 0.3 * nrm(rng);
+            double wl = level[w] - (w == 0 ? pump : 0) + noise_ft * nrm(rng);
+            r.wells[w].water_level_ft = round_dp<2>((float)wl);
+            r.wells[w].pressure_psi = round_dp<3>((float)(wl / PSI_TO_FT_WATER));
+            r.wells[w].ok = true;
+        }
+        r.water_level_ft = r.wells[0].water_level_ft;
+        r.pressure_psi = r.wells[0].pressure_psi;
+        s.r.push_back(r);
+        s.t.push_back(3600 + (uint32_t)(i * TX_INTERVAL_MS / 1000) + (uint32_t)(rng() % 3));   // wake jitter
+    }
+    return s;
+}
+
+// Decodes one batch and checks it against the readings it was built from
+static bool verify(const uint8_t *buf, size_t len, const Series &s, size_t first, size_t n) {
+    TsDecoder d;
+    if (!d.begin(buf, len) || d.count != n || d.n_fields != PACK_FIELD_COUNT) return false;
+    double v[TS_MAX_FIELDS];
+    for (size_t i = 0; i < n; i++) {
+        if (!d.next(v)) return false;
+        const SensorReading &r = s.r[first + i];
+        // Base columns by name: their order follows hardware/schema/readings.py
+        double want[PACK_FIELD_COUNT] = { (double)s.t[first + i] };
+        for (int f = 1; f < PACK_BASE_FIELDS; f++) {
+            const char *name = PACK_COLUMNS[f].name;
+            want[f] = !strcmp(name, "boot_count")        ? (double)r.boot_count
+                    : !strcmp(name, "battery_v")         ? r.battery_v
+                    : !strcmp(name, "solar_v")           ? r.solar_v
+                    : !strcmp(name, "baro_pressure_hpa") ? r.baro_pressure_hpa
+                    : !strcmp(name, "water_temp_c")      ? r.water_temp_c
+                    : NAN;
+        }
+        for (int w = 0; w < WELL_COUNT; w++) {
+            want[PACK_BASE_FIELDS + 2 * w] = r.wells[w].water_level_ft;
+            want[PACK_BASE_FIELDS + 2 * w + 1] = r.wells[w].pressure_psi;
+        }
+        for (int f = 0; f < PACK_FIELD_COUNT; f++) {
+            if (fabs(v[f] - want[f]) > 0.51 * pow(10.0, -d.fields[f].decimals)) {
+                fprintf(stderr, "record %zu field %s: %.4f != %.4f\n", first + i, d.fields[f].name, v[f],
+                        want[f]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * codec-level [--readings 96,672,2880] [--noise-ft 0.01] [--drawdown-ft 0]
+ *             [--seed 1] [--out FILE]
+ */
+int main(int argc, char **argv) {
+    std::vector<size_t> counts = { 96, 672, 2880 };
+    double noise_ft = 0.01, drawdown_ft = 0;
+    uint32_t seed = 1;
+    const char *out_path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        const char *a = argv[i];
+        if (!strcmp(a, "--readings") && more) {
+            counts.clear();
+            for (char *p = argv[++i]; *p; p += *p == ',') counts.push_back(strtoul(p, &p, 10));
+        }
+        else if (!strcmp(a, "--noise-ft") && more)     noise_ft = atof(argv[++i]);
+        else if (!strcmp(a, "--drawdown-ft") && more)  drawdown_ft = atof(argv[++i]);
+        else if (!strcmp(a, "--seed") && more)         seed = atoi(argv[++i]);
+        else if (!strcmp(a, "--out") && more)          out_path = argv[++i];
+        else {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return 2;
+        }
+    }
+
+    printf("readings,json_bytes,packed_bytes,batches,ratio,packed_bytes_per_reading,"
+           "json_lora_frames,packed_lora_frames,verified\n");
+    bool all_ok = true;
+    for (size_t n : counts) {
+        Series s = make_series(n, noise_ft, drawdown_ft, seed);
+        size_t json_bytes = 0, json_frames = 0;
+        char json[1024];
+        for (const SensorReading &r : s.r) {
+            size_t len = build_json(r, json, sizeof(json));
+            json_bytes += len;
+            json_frames += len <= LORA_MAX_PAYLOAD ? 1 : 0;   // too long: goes cellular
+        }
+
+        // Batches as the firmware fills them: a new one when BACKLOG_BYTES is full
+        static uint8_t buf[BACKLOG_BYTES];
+        TsEncoder enc = {};
+        size_t packed = 0, batches = 0, frames = 0, first = 0;
+        bool ok = true;
+        auto close = [&](size_t upto) {
+            size_t len = enc.finish(buf, s.t[upto - 1]);
+            ok &= verify(buf, len, s, first, upto - first);
+            if (out_path && !batches) {
+                FILE *f = fopen(out_path, "wb");
+                if (f) {
+                    fwrite(buf, 1, len, f);
+                    fclose(f);
+                }
+            }
+            packed += len;
+            frames += (len + LORA_MAX_PAYLOAD - 1) / LORA_MAX_PAYLOAD;
+            batches++;
+            first = upto;
+        };
+        pack_begin(enc, buf, sizeof(buf));
+        for (size_t i = 0; i < n; i++) {
+            if (pack_add(enc, buf, s.r[i], s.t[i])) continue;
+            close(i);
+            pack_begin(enc, buf, sizeof(buf));
+            if (!pack_add(enc, buf, s.r[i], s.t[i])) {
+                fprintf(stderr, "one record does not fit in %u bytes\n", BACKLOG_BYTES);
+                return 1;
+            }
+        }
+        if (enc.count) close(n);
+        all_ok &= ok;
+        printf("%zu,%zu,%zu,%zu,%.1f,%.1f,%zu,%zu,%s\n", n, json_bytes, packed, batches,
+               packed ? (double)json_bytes / packed : 0.0, (double)packed / n, json_frames, frames,
+               ok ? "yes" : "NO");
+    }
+    return all_ok ? 0 : 1;
+}
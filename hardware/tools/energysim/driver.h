@@ -0,0 +1,203 @@
+#pragma once
+#include <functional>
+#include "energy_model.h"
+#include "lora_airtime.h"
+
+/*
+ * Command-line driver shared by energysim-level and energysim-flow. Each
+ * tool supplies a function that turns its config.h (plus the knobs being
+ * swept) into a CycleProfile; the driver runs every site × configuration
+ * over `runs` weather years and prints one CSV row each.
+ */
+
+// Board-level current draws; estimates until replaced by wx-bench figures
+struct PowerParams {
+    double boot_s         = 0.35;    // ROM + Arduino init after deep-sleep wake
+    double mcu_ma         = 45;      // S3 active, radios off
+    double sleep_ma       = 0.25;    // deep sleep + regulators + sensor quiescent
+    double lora_tx_ma     = 120;     // SX1276 at 17 dBm
+    double cell_session_s = 30;      // attach + TLS + POST + detach
+    double cell_ma        = 110;     // SIM7000G Cat-M1 session average
+    double heater_ma      = 800;     // nichrome element
+    double sonde_ma       = 60;      // RS-485 / SDI-12 sonde supply
+    double flash_write_s  = 0.05;    // ADC trace save
+    double flash_ma       = 50;
+};
+
+struct Knobs {
+    double   tx_interval_s;
+    uint32_t heater_ms;       // WX-Flow only
+    uint32_t payload_bytes;
+};
+
+typedef std::function<CycleProfile(const Knobs &, const PowerParams &, const Site &)> ProfileFn;
+
+inline std::vector<double> parse_doubles(const char *s) {
+    std::vector<double> out;
+    while (*s) {
+        char *end;
+        double v = strtod(s, &end);
+        if (end == s) break;
+        out.push_back(v);
+        if (*end != ',') break;
+        s = end + 1;
+    }
+    return out;
+}
+
+// LoRa or cellular per cycle. Oversized payloads go straight to cellular
+// when the firmware has a LoRa size guard (max_payload > 0).
+inline void add_transport(CycleProfile &p, const Knobs &k, const PowerParams &pw,
+                          const Site &site, uint8_t sf, uint32_t bw_hz, uint32_t max_payload) {
+    double cell = site.cell_share;
+    if (max_payload && k.payload_bytes > max_payload) cell = 1.0;
+    uint16_t frame = k.payload_bytes > 255 ? 255 : (uint16_t)k.payload_bytes;
+    if (cell < 1.0) {
+        p.phases.push_back({ "lora_tx", lora_airtime_us(sf, bw_hz, frame) / 1e6,
+                             pw.lora_tx_ma + pw.mcu_ma, 1.0 - cell });
+    }
+    if (cell > 0.0) {
+        p.phases.push_back({ "cellular", pw.cell_session_s, pw.cell_ma + pw.mcu_ma, cell });
+    }
+}
+
+inline std::vector<Site> default_sites() {
+    std::vector<Site> s(3);
+    s[0].name = "valley-floor";
+    s[1].name = "orchard-edge";
+    s[1].shade = 0.6;
+    s[2].name = "no-gateway";
+    s[2].cell_share = 1.0;
+    return s;
+}
+
+// CSV "name,panel_w,derate,shade,cell_share"
+inline bool load_sites(const char *path, std::vector<Site> &sites) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    sites.clear();
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        Site s;
+        char name[64];
+        if (sscanf(line, "%63[^,],%lf,%lf,%lf,%lf", name, &s.panel_w, &s.derate, &s.shade,
+                   &s.cell_share) == 5) {
+            s.name = name;
+            sites.push_back(s);
+        }
+    }
+    fclose(f);
+    return !sites.empty();
+}
+
+/*
+ * energysim-<device> [--tx-min 5,15,30] [--heater-ms 2000,4000] [--payload-bytes N]
+ *                    [--battery-mah 6800] [--runs 20] [--seed 1]
+ *                    [--sites FILE] [--irradiance FILE] [--phases FILE]
+ *                    [--sleep-ma X] [--mcu-ma X] [--lora-ma X] [--cell-ma X]
+ *                    [--cell-s X] [--heater-ma X]
+ */
+inline int energysim_main(int argc, char **argv, const char *device, Knobs base,
+                          ProfileFn build_profile) {
+    PowerParams   pw;
+    BatteryParams bat;
+    std::vector<Site> sites = default_sites();
+    std::vector<double> tx_min = { base.tx_interval_s / 60.0 };
+    std::vector<double> heater = { (double)base.heater_ms };
+    const char *irradiance_path = nullptr, *phases_path = nullptr;
+    int runs = 20;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        const char *a = argv[i];
+        if (!strcmp(a, "--tx-min") && more)               tx_min = parse_doubles(argv[++i]);
+        else if (!strcmp(a, "--heater-ms") && more)       heater = parse_doubles(argv[++i]);
+        else if (!strcmp(a, "--payload-bytes") && more)   base.payload_bytes = atoi(argv[++i]);
+        else if (!strcmp(a, "--battery-mah") && more)     bat.capacity_mah = atof(argv[++i]);
+        else if (!strcmp(a, "--runs") && more)            runs = atoi(argv[++i]);
+        else if (!strcmp(a, "--seed") && more)            seed = atoi(argv[++i]);
+        else if (!strcmp(a, "--irradiance") && more)      irradiance_path = argv[++i];
+        else if (!strcmp(a, "--phases") && more)          phases_path = argv[++i];
+        else if (!strcmp(a, "--sleep-ma") && more)        pw.sleep_ma = atof(argv[++i]);
+        else if (!strcmp(a, "--mcu-ma") && more)          pw.mcu_ma = atof(argv[++i]);
+        else if (!strcmp(a, "--lora-ma") && more)         pw.lora_tx_ma = atof(argv[++i]);
+        else if (!strcmp(a, "--cell-ma") && more)         pw.cell_ma = atof(argv[++i]);
+        else if (!strcmp(a, "--cell-s") && more)          pw.cell_session_s = atof(argv[++i]);
+        else if (!strcmp(a, "--heater-ma") && more)       pw.heater_ma = atof(argv[++i]);
+        else if (!strcmp(a, "--sites") && more) {
+            if (!load_sites(argv[++i], sites)) {
+                fprintf(stderr, "cannot read sites from %s\n", argv[i]);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return 2;
+        }
+    }
+    if (tx_min.empty() || heater.empty() || runs <= 0) {
+        fprintf(stderr, "empty sweep\n");
+        return 2;
+    }
+
+    Irradiance measured;
+    if (irradiance_path && !measured.load_csv(irradiance_path)) {
+        fprintf(stderr, "need 8760 hourly W/m² values in %s\n", irradiance_path);
+        return 2;
+    }
+
+    printf("device,site,tx_interval_min,heater_ms,payload_bytes,awake_s,cycle_mah,daily_mah,"
+           "solar_offered_daily_mah,runs,brownout_h_med,brownout_h_max,data_loss_med_pct,"
+           "data_loss_max_pct,min_soc_med_pct,min_soc_worst_pct\n");
+
+    bool printed_phases = false;
+    for (const Site &site : sites) {
+        for (double tm : tx_min) {
+            for (double hm : heater) {
+                Knobs k = base;
+                k.tx_interval_s = tm * 60.0;
+                k.heater_ms = (uint32_t)hm;
+                CycleProfile prof = build_profile(k, pw, site);
+                if (phases_path && !apply_phase_csv(phases_path, prof)) {
+                    fprintf(stderr, "cannot read phases from %s\n", phases_path);
+                    return 2;
+                }
+                if (!printed_phases) {
+                    fprintf(stderr, "%s cycle (%s, %.0f min):\n", device, site.name.c_str(), tm);
+                    for (const Phase &p : prof.phases) {
+                        fprintf(stderr, "  %-16s %8.2f s %8.1f mA  p=%.2f\n", p.name.c_str(),
+                                p.duration_s, p.current_ma, p.probability);
+                    }
+                    fprintf(stderr, "  %-16s %8.2f s %8.2f mA\n", "sleep",
+                            prof.interval_s - prof.awake_s(), prof.sleep_ma);
+                    printed_phases = true;
+                }
+
+                std::vector<double> brown, loss, min_soc;
+                double harvest = 0;
+                for (int r = 0; r < runs; r++) {
+                    Irradiance synth;
+                    if (!irradiance_path) synth.synthesize(seed + r);
+                    YearResult y = simulate_year(prof, bat, site,
+                                                 irradiance_path ? measured : synth);
+                    brown.push_back(y.brownout_h);
+                    loss.push_back(y.data_loss_pct);
+                    min_soc.push_back(y.min_soc * 100.0);
+                    harvest += y.harvest_mah / 365.0 / runs;
+                    if (irradiance_path) break;   // measured year is deterministic
+                }
+                std::sort(brown.begin(), brown.end());
+                std::sort(loss.begin(), loss.end());
+                std::sort(min_soc.begin(), min_soc.end());
+                size_t n = brown.size();
+
+                printf("%s,%s,%.1f,%u,%u,%.2f,%.4f,%.1f,%.1f,%zu,%.1f,%.1f,%.2f,%.2f,%.1f,%.1f\n",
+                       device, site.name.c_str(), tm, k.heater_ms, k.payload_bytes,
+                       prof.awake_s(), prof.cycle_mah(), prof.cycle_mah() * 86400.0 / k.tx_interval_s,
+                       harvest, n, brown[n / 2], brown[n - 1], loss[n / 2], loss[n - 1],
+                       min_soc[n / 2], min_soc[0]);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+#pragma once
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Energy model shared by the energysim tools.
+ *
+ * A unit's duty cycle is a list of phases (duration × current) that run
+ * every TX interval, followed by deep sleep. It runs on a battery charged
+ * by a solar panel under an hourly Central Valley irradiance model, or a
+ * 8760-hour profile loaded from CSV (e.g. an NSRDB TMY export). The
+ * simulation steps one cycle at a time for a year and tracks state of
+ * charge, brownout time and cycles lost.
+ */
+
+struct Phase {
+    std::string name;
+    double      duration_s;
+    double      current_ma;
+    double      probability = 1.0;   // fraction of cycles that run this phase
+};
+
+struct CycleProfile {
+    std::vector<Phase> phases;
+    double interval_s;
+    double sleep_ma;
+
+    double awake_s() const {
+        double s = 0;
+        for (const Phase &p : phases) s += p.duration_s * p.probability;
+        return s;
+    }
+    // Expected charge per cycle (mAh), sleep included
+    double cycle_mah() const {
+        double mas = 0;
+        for (const Phase &p : phases) mas += p.duration_s * p.current_ma * p.probability;
+        double sleep_s = interval_s - awake_s();
+        if (sleep_s > 0) mas += sleep_s * sleep_ma;
+        return mas / 3600.0;
+    }
+};
+
+struct BatteryParams {
+    double capacity_mah      = 6800;   // 2 × 18650 in parallel
+    double charge_eff        = 0.85;
+    double max_charge_ma     = 500;    // charger limit
+    double self_discharge_pm = 0.02;   // per month
+    double brownout_soc      = 0.03;   // BOD trips below this
+    double restart_soc       = 0.10;   // unit resumes above this
+    double nominal_v         = 3.7;
+};
+
+struct Site {
+    std::string name;
+    double panel_w    = 2.0;   // panel peak power
+    double derate     = 0.7;   // angle, soiling, MPPT and wiring losses
+    double shade      = 1.0;   // fraction of irradiance reaching the panel
+    double cell_share = 0.0;   // extra fraction of cycles falling back to cellular
+};
+
+// ── Irradiance ──────────────────────────────────────────────
+// Fresno-area monthly mean GHI, kWh/m²/day (NSRDB long-term averages, rounded)
+static const double CV_GHI_KWH[12]   = { 2.3, 3.4, 4.9, 6.4, 7.5, 8.1, 7.9, 7.1, 5.9, 4.4, 2.9, 2.1 };
+// Probability a day is clear; winter tule fog and storms come in runs of days
+static const double CV_P_CLEAR[12]   = { 0.45, 0.6, 0.7, 0.8, 0.9, 0.97, 0.97, 0.95, 0.92, 0.85, 0.6, 0.45 };
+static const double CV_LATITUDE_DEG  = 36.7;
+static const double CLOUDY_FACTOR    = 0.3;    // mean cloudy-day fraction of clear-sky
+static const double CLOUDY_PERSIST   = 0.65;   // P(cloudy tomorrow | cloudy today)
+
+class Irradiance {
+public:
+    // Synthetic year: clear-sky diurnal curve scaled to the monthly mean,
+    // with a Markov clear/cloudy day sequence
+    void synthesize(uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        hourly_.assign(8760, 0.0);
+        bool cloudy = false;
+        for (int day = 0; day < 365; day++) {
+            int m = month_of(day);
+            double p_clear = CV_P_CLEAR[m];
+            // Chain tuned so the stationary clear fraction is p_clear
+            double p_become_cloudy = (1.0 - p_clear) * (1.0 - CLOUDY_PERSIST) / p_clear;
+            cloudy = cloudy ? u(rng) < CLOUDY_PERSIST : u(rng) < p_become_cloudy;
+            double mean_factor = p_clear + (1.0 - p_clear) * CLOUDY_FACTOR;
+            double factor = cloudy ? CLOUDY_FACTOR * (0.5 + u(rng)) : 1.0;
+            double day_wh = CV_GHI_KWH[m] * 1000.0 / mean_factor * factor;
+            fill_day(day, day_wh);
+        }
+    }
+
+    // One value per line (W/m²), 8760 lines; a header line is skipped
+    bool load_csv(const char *path) {
+        FILE *f = fopen(path, "r");
+        if (!f) return false;
+        hourly_.clear();
+        char line[128];
+        while (fgets(line, sizeof(line), f)) {
+            char *end;
+            double v = strtod(line, &end);
+            if (end != line) hourly_.push_back(v);
+        }
+        fclose(f);
+        return hourly_.size() >= 8760;
+    }
+
+    // W/m² at hour-of-year h (wraps)
+    double at_hour(double h) const {
+        size_t i = (size_t)h % hourly_.size();
+        return hourly_[i];
+    }
+
+private:
+    static int month_of(int day) {
+        static const int END[12] = { 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 };
+        int m = 0;
+        while (day >= END[m]) m++;
+        return m;
+    }
+
+    void fill_day(int day, double day_wh) {
+        double decl = 23.44 * sin(2.0 * M_PI * (284 + day + 1) / 365.0) * M_PI / 180.0;
+        double lat  = CV_LATITUDE_DEG * M_PI / 180.0;
+        double ws   = acos(std::max(-1.0, std::min(1.0, -tan(lat) * tan(decl))));
+        double daylen = 2.0 * ws * 12.0 / M_PI;    // hours
+        double sunrise = 12.0 - daylen / 2.0;
+        // ∫ sin(π(t - sunrise)/daylen) dt over the day = 2·daylen/π
+        double peak = day_wh * M_PI / (2.0 * daylen);
+        for (int h = 0; h < 24; h++) {
+            double t = h + 0.5 - sunrise;
+            hourly_[day * 24 + h] = (t > 0 && t < daylen) ? peak * sin(M_PI * t / daylen) : 0.0;
+        }
+    }
+
+    std::vector<double> hourly_;
+};
+
+// ── Simulation ──────────────────────────────────────────────
+struct YearResult {
+    double brownout_h = 0;
+    double data_loss_pct = 0;
+    double min_soc = 1.0;
+    double harvest_mah = 0;
+    double load_mah = 0;
+};
+
+inline YearResult simulate_year(const CycleProfile &profile, const BatteryParams &bat,
+                                const Site &site, const Irradiance &sun) {
+    YearResult r;
+    double soc_mah = bat.capacity_mah;
+    bool   browned_out = false;
+    double year_s = 365.0 * 86400.0;
+    double dt = profile.interval_s;
+    double cycle_mah = profile.cycle_mah();
+    double sleep_mah = profile.sleep_ma * dt / 3600.0;
+    double self_mah  = bat.capacity_mah * bat.self_discharge_pm / (30.0 * 86400.0) * dt;
+    uint64_t cycles = 0, lost = 0;
+
+    for (double t = 0; t < year_s; t += dt) {
+        double ghi = sun.at_hour((t + dt / 2) / 3600.0) * site.shade;
+        double charge_ma = site.panel_w * site.derate * ghi / 1000.0 / bat.nominal_v * 1000.0;
+        charge_ma = std::min(charge_ma, bat.max_charge_ma);
+        double in_mah = charge_ma * bat.charge_eff * dt / 3600.0;
+        r.harvest_mah += in_mah;
+
+        cycles++;
+        double out_mah;
+        if (browned_out) {
+            out_mah = sleep_mah;    // supervisor keeps the board off
+            lost++;
+            r.brownout_h += dt / 3600.0;
+        } else {
+            out_mah = cycle_mah;
+        }
+        out_mah += self_mah;
+        r.load_mah += out_mah;
+
+        soc_mah = std::min(bat.capacity_mah, soc_mah + in_mah - out_mah);
+        if (soc_mah < 0) soc_mah = 0;
+        double soc = soc_mah / bat.capacity_mah;
+        r.min_soc = std::min(r.min_soc, soc);
+        if (!browned_out && soc < bat.brownout_soc) browned_out = true;
+        else if (browned_out && soc > bat.restart_soc) browned_out = false;
+    }
+    r.data_loss_pct = cycles ? 100.0 * lost / cycles : 0;
+    return r;
+}
+
+// ── Phase Overrides ─────────────────────────────────────────
+// CSV "name,duration_ms,current_ma" (e.g. from wx-bench medians); matching
+// phases take the measured figures, unknown names are appended
+inline bool apply_phase_csv(const char *path, CycleProfile &profile) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || !strchr(line, ',')) continue;
+        char name[64];
+        double ms, ma;
+        if (sscanf(line, "%63[^,],%lf,%lf", name, &ms, &ma) != 3) continue;
+        bool found = false;
+        for (Phase &p : profile.phases) {
+            if (p.name == name) {
+                p.duration_s = ms / 1000.0;
+                p.current_ma = ma;
+                found = true;
+            }
+        }
+        if (!found) profile.phases.push_back({ name, ms / 1000.0, ma });
+    }
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,68 @@
+/*
+ * WX-Flow energy / lifetime simulator. The duty cycle is built from the
+ * WX-Flow config.h (heat-pulse timing, digital sondes, trace recording,
+ * LoRa settings, TX interval), and the payload size from the firmware's
+ * own build_json(). --heater-ms sweeps the pulse length.
+ *
+ * Usage: see energysim/driver.h
+ *   energysim-flow --tx-min 15,30,60 --heater-ms 2000,4000,8000
+ */
+
+#include "driver.h"
+#include "reading.h"
+
+static uint32_t payload_bytes() {
+    FullReading r = {};
+    const float peaks[4] = { 0.14f, 0.88f, 0.09f, 0.31f };
+    const float times[4] = { 13.1f, 11.9f, 14.0f, 12.6f };
+    r.flow = analyze_heat_pulse(peaks, times);
+    r.conductivity_us = 842.0f;
+    r.tds_ppm = 463.0f;
+    r.water_temp_c = 17.9f;
+    r.water_level_ft = 12.41f;
+    r.pressure_psi = 5.372f;
+    r.battery_v = 3.88f;
+    r.solar_v = 5.12f;
+    char buf[2048];
+    return (uint32_t)build_json(r, buf, sizeof(buf));
+}
+
+static CycleProfile flow_profile(const Knobs &k, const PowerParams &pw, const Site &site) {
+    CycleProfile p;
+    p.interval_s = k.tx_interval_s;
+    p.sleep_ma   = pw.sleep_ma;
+    p.phases.push_back({ "boot", pw.boot_s, pw.mcu_ma });
+    // run_heat_pulse(): 10 baseline scans, pulse, settle + monitoring window
+    p.phases.push_back({ "baseline", 10 * (4 / 128.0 + 0.05), pw.mcu_ma });
+#if HEAT_MODE == HEAT_MODE_CODED
+    // run_coded_heat_pulse(): half the chips on at CODED_DUTY, every period
+    const double chips = (1 << CODED_ORDER) - 1;
+    p.phases.push_back({ "coded", CODED_PERIODS * chips * CODED_CHIP_MS / 1000.0,
+                         pw.mcu_ma + pw.heater_ma * (CODED_DUTY / 255.0) * (chips + 1) / (2 * chips) });
+#else
+    p.phases.push_back({ "heater", k.heater_ms / 1000.0, pw.mcu_ma + pw.heater_ma });
+    p.phases.push_back({ "monitor", (HEATER_SETTLE_MS + FLOW_MONITOR_MS) / 1000.0, pw.mcu_ma });
+#endif
+    p.phases.push_back({ "adc_sensors", 3 / 128.0, pw.mcu_ma });
+#if MODBUS_FIELD_COUNT > 0
+    p.phases.push_back({ "modbus", MODBUS_WARMUP_MS / 1000.0 + 0.1, pw.mcu_ma + pw.sonde_ma });
+#endif
+#if SDI12_FIELD_COUNT > 0
+    p.phases.push_back({ "sdi12", 3.0, pw.mcu_ma + pw.sonde_ma });
+#endif
+#if TRACE_RECORD
+    p.phases.push_back({ "trace_save", pw.flash_write_s, pw.mcu_ma + pw.flash_ma });
+#endif
+#ifdef LORA_MAX_PAYLOAD
+    const uint32_t max_payload = LORA_MAX_PAYLOAD;
+#else
+    const uint32_t max_payload = 0;     // no size guard: always tries LoRa
+#endif
+    add_transport(p, k, pw, site, LORA_SPREAD_FACTOR, (uint32_t)LORA_BANDWIDTH, max_payload);
+    return p;
+}
+
+int main(int argc, char **argv) {
+    Knobs base = { TX_INTERVAL_MS / 1000.0, HEATER_POWER_MS, payload_bytes() };
+    return energysim_main(argc, argv, "wx-flow", base, flow_profile);
+}
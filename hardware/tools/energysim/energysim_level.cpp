@@ -0,0 +1,51 @@
+/*
+ * WX-Level energy / lifetime simulator. The duty cycle is built from the
+ * WX-Level config.h (well channels, digital sondes, trace recording, LoRa
+ * settings, TX interval), and the payload size from the firmware's own
+ * build_json(), so it follows the firmware as it changes.
+ *
+ * Usage: see energysim/driver.h
+ *   energysim-level --tx-min 5,15,30,60 --runs 20
+ */
+
+#include "driver.h"
+#include "reading.h"
+
+static uint32_t payload_bytes() {
+    SensorReading r = {};
+    r.baro_pressure_hpa = 1009.7f;
+    r.baro_temp_c = r.water_temp_c = 24.3f;
+    r.humidity_pct = 41.8f;
+    r.battery_v = 3.92f;
+    r.solar_v = 5.61f;
+    float psi[WELL_CHANNEL_COUNT];
+    for (int i = 0; i < WELL_CHANNEL_COUNT; i++) psi[i] = 4.2f + i * 1.7f;
+    fill_well_levels(r, psi);
+    char buf[1024];
+    return (uint32_t)build_json(r, buf, sizeof(buf));
+}
+
+static CycleProfile level_profile(const Knobs &k, const PowerParams &pw, const Site &site) {
+    CycleProfile p;
+    p.interval_s = k.tx_interval_s;
+    p.sleep_ma   = pw.sleep_ma;
+    p.phases.push_back({ "boot", pw.boot_s, pw.mcu_ma });
+    // Pipelined conversions at 128 SPS; the BME280 runs in their shadow
+    p.phases.push_back({ "adc_wells", WELL_CHANNEL_COUNT / 128.0 + 0.01, pw.mcu_ma });
+#if MODBUS_FIELD_COUNT > 0
+    p.phases.push_back({ "modbus", MODBUS_WARMUP_MS / 1000.0 + 0.1, pw.mcu_ma + pw.sonde_ma });
+#endif
+#if SDI12_FIELD_COUNT > 0
+    p.phases.push_back({ "sdi12", 3.0, pw.mcu_ma + pw.sonde_ma });   // typical aC! wait
+#endif
+#if TRACE_RECORD
+    p.phases.push_back({ "trace_save", pw.flash_write_s, pw.mcu_ma + pw.flash_ma });
+#endif
+    add_transport(p, k, pw, site, LORA_SPREAD_FACTOR, (uint32_t)LORA_BANDWIDTH, LORA_MAX_PAYLOAD);
+    return p;
+}
+
+int main(int argc, char **argv) {
+    Knobs base = { TX_INTERVAL_MS / 1000.0, 0, payload_bytes() };
+    return energysim_main(argc, argv, "wx-level", base, level_profile);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <random>
+
+/*
+ * The WX unit types as the host tools see them: radio settings and timing
+ * from each firmware's config.h, and payloads from its own build_json()
+ * (cellular) and build_air() (LoRa frame).
+ *
+ * Both firmwares define the same config macros, so each type lives in its
+ * own translation unit (unit_level.cpp, unit_flow.cpp) that includes that
+ * firmware's reading.h by relative path. Tools that model a mixed fleet
+ * add +<fleet/> to their build_src_filter and use only this header.
+ */
+
+struct UnitType {
+    const char *device_type;        // DEVICE_TYPE
+    const char *id_prefix;          // virtual units are <prefix>NNN
+    double      tx_interval_s;      // TX_INTERVAL_MS
+    double      awake_s;            // wake to LoRa TX, estimated from the config timing
+    uint8_t     lora_sf;
+    uint32_t    lora_bw_hz;
+    int         lora_tx_dbm;
+    uint32_t    lora_max_payload;   // 0: firmware has no size guard
+
+    // JSON the firmware would send as virtual unit `unit` on boot `boot`,
+    // with sensor values drawn around a typical reading. Returns the
+    // length, 0 if it does not fit in `cap`.
+    size_t (*payload)(uint32_t unit, uint32_t boot, std::mt19937 &rng, char *out, size_t cap);
+    // The same reading as the LoRa frame the firmware sends
+    size_t (*air_payload)(uint32_t unit, uint32_t boot, std::mt19937 &rng, char *out, size_t cap);
+};
+
+const UnitType &wx_level_unit();
+const UnitType &wx_flow_unit();
+
+inline void fleet_device_id(const UnitType &t, uint32_t unit, char *out, size_t cap) {
+    snprintf(out, cap, "%s%03u", t.id_prefix, (unsigned)unit + 1);
+}
+
+// Swap the compiled-in DEVICE_ID for a virtual unit's ID in a serialized
+// payload, so the bytes match what that unit's build would send.
+inline size_t fleet_replace_id(char *buf, size_t len, size_t cap, const char *from, const char *to) {
+    char *p = strstr(buf, from);
+    if (!p) return len;
+    size_t fl = strlen(from), tl = strlen(to);
+    if (len - fl + tl + 1 > cap) return 0;
+    memmove(p + tl, p + fl, len - (p - buf) - fl + 1);
+    memcpy(p, to, tl);
+    return len - fl + tl;
+}
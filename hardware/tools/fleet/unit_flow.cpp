@@ -0,0 +1,66 @@
+/*
+ * WX-Flow as a fleet unit type (see fleet_units.h).
+ */
+
+#include "fleet_units.h"
+#include "../../wx-flow/firmware/reading.h"
+
+static FullReading flow_reading(uint32_t boot, std::mt19937 &rng) {
+    std::normal_distribution<float> n(0.0f, 1.0f);
+    FullReading r = {};
+    float peaks[4], times[4];
+    for (int i = 0; i < 4; i++) {
+        peaks[i] = 0.1f + 0.4f * fabsf(n(rng));
+        times[i] = 12.5f + 1.0f * n(rng);
+    }
+    r.flow            = analyze_heat_pulse(peaks, times);
+    r.boot_count      = boot;
+    r.conductivity_us = 842.0f + 60.0f * n(rng);
+    r.tds_ppm         = r.conductivity_us * 0.55f;
+    r.water_temp_c    = 17.9f + 0.5f * n(rng);
+    r.water_level_ft  = 12.41f + 0.5f * n(rng);
+    r.pressure_psi    = r.water_level_ft / PSI_TO_FT_WATER;
+    r.battery_v       = 3.88f + 0.1f * n(rng);
+    r.solar_v         = 5.12f + 0.5f * n(rng);
+    return r;
+}
+
+// A built payload under the virtual unit's ID; 0 if it did not fit
+static size_t flow_serialized(uint32_t unit, size_t len, char *out, size_t cap) {
+    if (!len || len >= cap) return 0;
+    char id[24];
+    fleet_device_id(wx_flow_unit(), unit, id, sizeof(id));
+    return fleet_replace_id(out, len, cap, DEVICE_ID, id);
+}
+
+static size_t flow_payload(uint32_t unit, uint32_t boot, std::mt19937 &rng, char *out, size_t cap) {
+    return flow_serialized(unit, build_json(flow_reading(boot, rng), out, cap), out, cap);
+}
+
+static size_t flow_air(uint32_t unit, uint32_t boot, std::mt19937 &rng, char *out, size_t cap) {
+    return flow_serialized(unit, build_air(flow_reading(boot, rng), out, cap), out, cap);
+}
+
+const UnitType &wx_flow_unit() {
+    static const UnitType t = {
+        DEVICE_TYPE, "WXF-",
+        TX_INTERVAL_MS / 1000.0,
+        // boot, 10 baseline scans, pulse, settle + monitoring window
+        0.35 + 10 * (4 / 128.0 + 0.05) + (HEATER_POWER_MS + HEATER_SETTLE_MS + FLOW_MONITOR_MS) / 1000.0
+#if MODBUS_FIELD_COUNT > 0
+            + MODBUS_WARMUP_MS / 1000.0
+#endif
+#if SDI12_FIELD_COUNT > 0
+            + 3.0
+#endif
+        ,
+        LORA_SPREAD_FACTOR, (uint32_t)LORA_BANDWIDTH, LORA_TX_POWER,
+#ifdef LORA_MAX_PAYLOAD
+        LORA_MAX_PAYLOAD,
+#else
+        0,
+#endif
+        flow_payload, flow_air,
+    };
+    return t;
+}
@@ -0,0 +1,59 @@
+/*
+ * WX-Level as a fleet unit type (see fleet_units.h).
+ */
+
+#include "fleet_units.h"
+#include "../../wx-level/firmware/reading.h"
+
+static SensorReading level_reading(uint32_t boot, std::mt19937 &rng) {
+    std::normal_distribution<float> n(0.0f, 1.0f);
+    SensorReading r = {};
+    r.boot_count        = boot;
+    r.baro_pressure_hpa = 1009.7f + 4.0f * n(rng);
+    r.baro_temp_c       = 24.3f + 5.0f * n(rng);
+    r.water_temp_c      = 18.5f + 1.0f * n(rng);
+    r.humidity_pct      = 41.8f + 10.0f * n(rng);
+    r.battery_v         = 3.92f + 0.1f * n(rng);
+    r.solar_v           = 5.61f + 0.5f * n(rng);
+    float psi[WELL_CHANNEL_COUNT];
+    for (int i = 0; i < WELL_CHANNEL_COUNT; i++) psi[i] = 4.2f + i * 1.7f + 0.3f * n(rng);
+    fill_well_levels(r, psi);
+    r.pressure_psi   = r.wells[0].pressure_psi;
+    r.water_level_ft = r.wells[0].water_level_ft;
+    return r;
+}
+
+// A built payload under the virtual unit's ID; 0 if it did not fit
+static size_t level_serialized(uint32_t unit, size_t len, char *out, size_t cap) {
+    if (!len || len >= cap) return 0;
+    char id[24];
+    fleet_device_id(wx_level_unit(), unit, id, sizeof(id));
+    return fleet_replace_id(out, len, cap, DEVICE_ID, id);
+}
+
+static size_t level_payload(uint32_t unit, uint32_t boot, std::mt19937 &rng, char *out, size_t cap) {
+    return level_serialized(unit, build_json(level_reading(boot, rng), out, cap), out, cap);
+}
+
+static size_t level_air(uint32_t unit, uint32_t boot, std::mt19937 &rng, char *out, size_t cap) {
+    return level_serialized(unit, build_air(level_reading(boot, rng), out, cap), out, cap);
+}
+
+const UnitType &wx_level_unit() {
+    static const UnitType t = {
+        DEVICE_TYPE, "WXL-",
+        TX_INTERVAL_MS / 1000.0,
+        // boot, pipelined well conversions, sondes
+        0.35 + WELL_CHANNEL_COUNT / 128.0 + 0.01
+#if MODBUS_FIELD_COUNT > 0
+            + MODBUS_WARMUP_MS / 1000.0
+#endif
+#if SDI12_FIELD_COUNT > 0
+            + 3.0
+#endif
+        ,
+        LORA_SPREAD_FACTOR, (uint32_t)LORA_BANDWIDTH, LORA_TX_POWER, LORA_MAX_PAYLOAD,
+        level_payload, level_air,
+    };
+    return t;
+}
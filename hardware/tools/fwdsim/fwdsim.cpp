@@ -0,0 +1,225 @@
+/*
+ * Simulated Semtech UDP packet forwarders for testing the gateway bridge
+ * (wx-gateway/bridge) without radios.
+ *
+ * Each of --gateways forwarders has its own EUI and UDP socket. Virtual
+ * WX units (fleet/, firmware build_air() LoRa frames) transmit at the
+ * aggregate --rate; each transmission is heard by 1..--max-heard
+ * gateways with their own RSSI / SNR, and lands in those forwarders' next
+ * PUSH_DATA (sent every --push-ms with the rxpk gathered since, as the
+ * stock forwarder does). Bad-CRC and foreign (non-WX) frames are mixed in;
+ * payloads over 255 bytes go out cut off at the FIFO size, as the radio
+ * would send them, and the bridge should drop them.
+ * PULL_DATA keepalives go out every 10 s.
+ *
+ *   wx-bridge --listen 1700 &
+ *   fwdsim --bridge 127.0.0.1:1700 --devices 5000 --rate 500 --duration-s 60
+ *
+ * Reports sends, PUSH_ACK round-trips and how many unique readings the
+ * bridge should forward.
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+#include "semtech_udp.h"
+#include "../fleet/fleet_units.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct Forwarder {
+    int fd;
+    uint64_t eui;
+    std::string rxpk;          // pending rxpk objects, comma-separated
+    uint32_t pending = 0;
+    uint16_t token = 0;
+};
+
+static double ms_since(Clock::time_point t) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+/*
+ * fwdsim [--bridge HOST:PORT] [--gateways 4] [--max-heard 3] [--devices 1000]
+ *        [--flow-share 0.25] [--rate 100] [--duration-s 30] [--push-ms 100]
+ *        [--bad-crc 0.01] [--foreign 0.02] [--seed 1]
+ */
+int main(int argc, char **argv) {
+    const char *bridge = "127.0.0.1:1700";
+    int n_gw = 4, max_heard = 3;
+    uint32_t devices = 1000, seed = 1, push_ms = 100;
+    double flow_share = 0.25, rate = 100, duration_s = 30, bad_crc = 0.01, foreign = 0.02;
+
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        const char *a = argv[i];
+        if (!strcmp(a, "--bridge") && more)            bridge = argv[++i];
+        else if (!strcmp(a, "--gateways") && more)     n_gw = atoi(argv[++i]);
+        else if (!strcmp(a, "--max-heard") && more)    max_heard = atoi(argv[++i]);
+        else if (!strcmp(a, "--devices") && more)      devices = atoi(argv[++i]);
+        else if (!strcmp(a, "--flow-share") && more)   flow_share = atof(argv[++i]);
+        else if (!strcmp(a, "--rate") && more)         rate = atof(argv[++i]);
+        else if (!strcmp(a, "--duration-s") && more)   duration_s = atof(argv[++i]);
+        else if (!strcmp(a, "--push-ms") && more)      push_ms = atoi(argv[++i]);
+        else if (!strcmp(a, "--bad-crc") && more)      bad_crc = atof(argv[++i]);
+        else if (!strcmp(a, "--foreign") && more)      foreign = atof(argv[++i]);
+        else if (!strcmp(a, "--seed") && more)         seed = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return 2;
+        }
+    }
+    if (n_gw < 1 || max_heard < 1 || !devices || rate <= 0) {
+        fprintf(stderr, "nothing to send\n");
+        return 2;
+    }
+    max_heard = std::min(max_heard, n_gw);
+
+    std::string host(bridge), port = "1700";
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos) {
+        port = host.substr(colon + 1);
+        host.resize(colon);
+    }
+    addrinfo hints = {}, *dest = nullptr;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &dest) != 0) {
+        fprintf(stderr, "cannot resolve %s\n", bridge);
+        return 2;
+    }
+
+    std::vector<Forwarder> gws(n_gw);
+    for (int g = 0; g < n_gw; g++) {
+        gws[g].fd = socket(dest->ai_family, SOCK_DGRAM, 0);
+        connect(gws[g].fd, dest->ai_addr, dest->ai_addrlen);
+        gws[g].eui = 0x0016C001FF100000ULL + g;
+    }
+    freeaddrinfo(dest);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> u01(0.0, 1.0);
+    std::normal_distribution<double> nrm(0.0, 1.0);
+    std::vector<const UnitType *> units(devices);
+    std::vector<uint32_t> boots(devices, 0);
+    for (auto &t : units) t = u01(rng) < flow_share ? &wx_flow_unit() : &wx_level_unit();
+
+    std::map<uint64_t, Clock::time_point> sent_at;     // (gw << 16 | token) → send time
+    std::vector<double> rtt;
+    uint64_t tx = 0, copies = 0, datagrams = 0, acks = 0, pull_acks = 0;
+    uint64_t unique = 0, bad = 0, other = 0, truncated = 0;
+
+    auto push = [&](Forwarder &f, uint8_t id, const std::string &json) {
+        uint8_t buf[65536];
+        size_t n = semtech_header(buf, id, ++f.token, f.eui);
+        if (n + json.size() > sizeof(buf)) return;
+        memcpy(buf + n, json.data(), json.size());
+        send(f.fd, buf, n + json.size(), 0);
+        sent_at[(uint64_t)(&f - &gws[0]) << 16 | f.token] = Clock::now();
+        datagrams++;
+    };
+    auto poll_acks = [&](int timeout_ms) {
+        std::vector<pollfd> pfds(n_gw);
+        for (int g = 0; g < n_gw; g++) pfds[g] = { gws[g].fd, POLLIN, 0 };
+        if (poll(pfds.data(), n_gw, timeout_ms) <= 0) return;
+        for (int g = 0; g < n_gw; g++) {
+            uint8_t buf[64];
+            ssize_t r;
+            while ((r = recv(gws[g].fd, buf, sizeof(buf), MSG_DONTWAIT)) >= 4) {
+                uint16_t token = (uint16_t)(buf[1] << 8 | buf[2]);
+                auto it = sent_at.find((uint64_t)g << 16 | token);
+                if (it == sent_at.end()) continue;
+                rtt.push_back(ms_since(it->second));
+                sent_at.erase(it);
+                if (buf[3] == SEMTECH_PUSH_ACK) acks++;
+                else if (buf[3] == SEMTECH_PULL_ACK) pull_acks++;
+            }
+        }
+    };
+
+    Clock::time_point start = Clock::now(), next_push = start, next_pull = start;
+    double next_tx_s = 0;
+    char payload[2048];
+    while (ms_since(start) < duration_s * 1000.0) {
+        double now_s = ms_since(start) / 1000.0;
+        // Poisson arrivals at the aggregate rate
+        while (next_tx_s <= now_s) {
+            next_tx_s += -log(1.0 - u01(rng)) / rate;
+            uint32_t unit = std::uniform_int_distribution<uint32_t>(0, devices - 1)(rng);
+            size_t len;
+            double kind = u01(rng);
+            if (kind < foreign) {
+                len = 12 + rng() % 40;            // e.g. a neighbour's LoRaWAN frame
+                for (size_t i = 0; i < len; i++) payload[i] = (char)rng();
+                other++;
+            } else {
+                len = units[unit]->air_payload(unit, ++boots[unit], rng, payload, sizeof(payload));
+                if (!len) continue;
+                if (len > 255) {
+                    len = 255;                    // SX1276 FIFO: the unit sends a cut-off frame
+                    truncated++;
+                } else {
+                    kind < foreign + bad_crc ? bad++ : unique++;
+                }
+            }
+            std::string data = base64_encode((const uint8_t *)payload, len);
+            int heard = 1 + (int)(u01(rng) * max_heard);
+            std::vector<int> order(n_gw);
+            for (int g = 0; g < n_gw; g++) order[g] = g;
+            std::shuffle(order.begin(), order.end(), rng);
+            for (int k = 0; k < heard; k++) {
+                Forwarder &f = gws[order[k]];
+                char pk[640];
+                int stat = kind >= foreign && kind < foreign + bad_crc ? -1 : 0;
+                snprintf(pk, sizeof(pk),
+                         "{\"tmst\":%u,\"chan\":0,\"rfch\":0,\"freq\":915.000000,\"stat\":%d,"
+                         "\"modu\":\"LORA\",\"datr\":\"SF7BW125\",\"codr\":\"4/5\",\"lsnr\":%.1f,"
+                         "\"rssi\":%d,\"size\":%zu,\"data\":\"",
+                         (uint32_t)(now_s * 1e6), stat, 7.0 + 3.0 * nrm(rng),
+                         (int)(-100 + 8 * nrm(rng)), len);
+                if (f.pending) f.rxpk += ',';
+                f.rxpk += pk;
+                f.rxpk += data;
+                f.rxpk += "\"}";
+                f.pending++;
+                copies++;
+            }
+            tx++;
+        }
+        if (Clock::now() >= next_push) {
+            next_push += std::chrono::milliseconds(push_ms);
+            for (Forwarder &f : gws) {
+                if (!f.pending) continue;
+                push(f, SEMTECH_PUSH_DATA, "{\"rxpk\":[" + f.rxpk + "]}");
+                f.rxpk.clear();
+                f.pending = 0;
+            }
+        }
+        if (Clock::now() >= next_pull) {
+            next_pull += std::chrono::seconds(10);
+            for (Forwarder &f : gws) push(f, SEMTECH_PULL_DATA, "");
+        }
+        poll_acks(1);
+    }
+    for (Forwarder &f : gws) {
+        if (f.pending) push(f, SEMTECH_PUSH_DATA, "{\"rxpk\":[" + f.rxpk + "]}");
+    }
+    for (int i = 0; i < 50 && !sent_at.empty(); i++) poll_acks(10);
+
+    std::sort(rtt.begin(), rtt.end());
+    auto pct = [&](double p) { return rtt.empty() ? 0.0 : rtt[(size_t)(p * (rtt.size() - 1))]; };
+    printf("transmissions,rxpk_copies,datagrams,push_acks,pull_acks,unacked,"
+           "ack_p50_ms,ack_p99_ms,expected_readings,bad_crc,foreign,truncated\n");
+    printf("%llu,%llu,%llu,%llu,%llu,%zu,%.2f,%.2f,%llu,%llu,%llu,%llu\n", (unsigned long long)tx,
+           (unsigned long long)copies, (unsigned long long)datagrams, (unsigned long long)acks,
+           (unsigned long long)pull_acks, sent_at.size(), pct(0.5), pct(0.99),
+           (unsigned long long)unique, (unsigned long long)bad, (unsigned long long)other,
+           (unsigned long long)truncated);
+    return sent_at.empty() ? 0 : 1;
+}
@@ -0,0 +1,397 @@
+/*
+ * Heat-pulse simulator — runs the firmware's run_heat_pulse() against
+ * synthetic thermistor traces from the line-source model.
+ *
+ * Each trial draws a flow velocity (log-uniform), direction and ambient
+ * temperature, then runs run_heat_pulse() on virtual time. The ADC script
+ * converts the modelled temperature plus noise and baseline drift into the
+ * ADS1115 code the probe would read. The heater history comes from the
+ * GPIO writes that the firmware actually makes. For every heater duration ×
+ * window length in the sweep it prints one CSV row: pulse energy against
+ * velocity and direction error. Errors are given both with FLOW_CAL_K from
+ * config.h and with K refit to that configuration, the way
+ * flow_calibration.py would fit it from lab data.
+ *
+ * --coded runs run_coded_heat_pulse() instead, sweeping chip length ×
+ * PWM duty at the given code order, so coded and single-pulse rows can
+ * be compared on heater energy, peak heater power and error.
+ *
+ * --pulses N repeats each cycle N times on one clock, --gap-s apart (start
+ * to start), and scores the last one: closer than the decay time, the
+ * earlier pulses' heat is still there. --history 0,1 runs it without and
+ * with the firmware's ThermalHistory taking that residual out.
+ *
+ * Usage:
+ *   heatsim [--heater-ms 1000,2000,4000,8000] [--monitor-ms 30000,60000,120000]
+ *           [--sample-ms 100] [--trials 100] [--seed 1]
+ *           [--v-min 5] [--v-max 500] [--noise-c 0.003] [--drift-c-min 0.002]
+ *           [--heater-w 3] [--heater-len-m 0.04] [--mcu-w 0.15]
+ *           [--lambda 2.0] [--rho-c 2.6e6]
+ *   heatsim --coded [--order 6] [--chip-ms 500,1000,2000] [--duty 32,64,128]
+ *           [--periods 2] [--coded-sample-ms 250] [options]
+ *   heatsim --pulses 4 --gap-s 120,300,900 [--history 0,1] [options]
+ *   heatsim --trace FILE --velocity 100 --direction 45 [options]
+ *   heatsim --adc-trace FILE.bin --velocity 100 --direction 45 [options]
+ *
+ * --adc-trace writes the cycle in the firmware's AdcTrace format (with a
+ * fixed analog sensor block), to seed the replay corpus in tools/replay.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "hal_native.h"
+#include "heat_pulse.h"
+#include "line_source.h"
+#include "../replay/trace_file.h"
+
+struct SimConfig {
+    MediumParams medium;
+    HeaterParams heater;
+    double noise_c        = 0.003;   // thermistor + ADC noise, 1σ
+    double drift_c_per_min = 0.002;  // ambient baseline drift
+    double mcu_w          = 0.15;    // board power while awake
+    double v_min = 5, v_max = 500;   // cm/day
+};
+
+// One measurement cycle: a single pulse or a coded sequence
+struct Cycle {
+    bool             coded = false;
+    HeatPulseParams  hp;
+    CodedPulseParams cp;
+    int              pulses = 1;       // repeats, gap_ms start to start
+    uint32_t         gap_ms = 0;
+    bool             history = false;  // run_heat_pulse() with a ThermalHistory
+};
+
+struct Trial {
+    double v_cm_day;
+    double dir_deg;
+    double ambient_c;
+};
+
+// Thermistor positions (m) indexed by ADC channel
+static void therm_positions(double x[4], double y[4]) {
+    double r = THERM_DISTANCE_MM / 1000.0;
+    x[CH_THERM_N] = 0;  y[CH_THERM_N] = r;
+    x[CH_THERM_E] = r;  y[CH_THERM_E] = 0;
+    x[CH_THERM_S] = 0;  y[CH_THERM_S] = -r;
+    x[CH_THERM_W] = -r; y[CH_THERM_W] = 0;
+}
+
+// Heater on-intervals up to time t, with their PWM duty, from the
+// firmware's GPIO writes
+static void heater_intervals(const RecordingGpio &gpio, double t, std::vector<HeaterInterval> &out) {
+    out.clear();
+    double on_at = 0;
+    uint8_t duty = 0;
+    for (const GpioEvent &e : gpio.events) {
+        if (e.pin != PIN_HEATER || e.duty == duty) continue;
+        double ts = e.t_us / 1e6;
+        if (ts > t) break;
+        if (duty) out.push_back({ on_at, ts, duty / 255.0 });
+        on_at = ts;
+        duty = e.duty;
+    }
+    if (duty) out.push_back({ on_at, t, duty / 255.0 });
+}
+
+static double heater_energy_j(const SimConfig &cfg, const RecordingGpio &gpio, double t) {
+    std::vector<HeaterInterval> on;
+    heater_intervals(gpio, t, on);
+    double j = 0;
+    for (const HeaterInterval &iv : on) j += cfg.heater.power_w * iv.duty * (iv.off_s - iv.on_s);
+    return j;
+}
+
+static FlowResult run_cycle(const Cycle &c, HalAdc &adc, HalClock &clock, HalGpio &gpio,
+                            ThermalHistory *history = nullptr) {
+    return c.coded ? run_coded_heat_pulse(adc, clock, gpio, c.cp)
+                   : run_heat_pulse(adc, clock, gpio, c.hp, history);
+}
+
+static FlowResult simulate(const SimConfig &cfg, const Cycle &cycle, const Trial &trial,
+                           std::mt19937 &rng, FILE *trace, double *awake_s, double *heater_j,
+                           AdcTrace *adc_trace = nullptr) {
+    LineSourceModel model(cfg.medium, cfg.heater);
+    model.set_flow(trial.v_cm_day, trial.dir_deg);
+
+    double px[4], py[4];
+    therm_positions(px, py);
+    std::normal_distribution<double> noise(0.0, cfg.noise_c);
+    std::vector<HeaterInterval> on;
+
+    VirtualClock  clock;
+    RecordingGpio gpio(clock);
+    ScriptedAdc   adc(clock, [&](uint8_t ch, uint64_t t_us) {
+        double t = t_us / 1e6;
+        heater_intervals(gpio, t, on);
+        double temp = trial.ambient_c + cfg.drift_c_per_min * t / 60.0
+                    + model.rise(px[ch & 3], py[ch & 3], t, on) + noise(rng);
+        int16_t code = therm_temp_to_code((float)temp);
+        if (trace) fprintf(trace, "%.4f,%u,%d,%.5f\n", t, ch, code, therm_code_to_temp(code));
+        return code;
+    });
+
+    if (heater_j) *heater_j = 0;
+    if (!adc_trace) {
+        // Energy and awake time are per cycle; the gaps are spent asleep
+        ThermalHistory history = {};
+        FlowResult fr = {};
+        uint64_t awake_us = 0;
+        for (int k = 0; k < cycle.pulses; k++) {
+            if (k) {
+                uint64_t due = (uint64_t)k * cycle.gap_ms * 1000;
+                if (due > clock.time_us()) clock.advance_us(due - clock.time_us());
+            }
+            uint64_t t0 = clock.time_us();
+            history.sync(clock.now_ms(), clock.now_ms());
+            fr = run_cycle(cycle, adc, clock, gpio, cycle.history ? &history : nullptr);
+            awake_us += clock.time_us() - t0;
+        }
+        if (awake_s) *awake_s = awake_us / 1e6 / cycle.pulses;
+        if (heater_j) *heater_j = heater_energy_j(cfg, gpio, clock.time_us() / 1e6) / cycle.pulses;
+        return fr;
+    }
+
+    // Recorded the way the firmware records a cycle: heat pulse, then the
+    // ADS1115 #1 block (fixed codes here) in read_analog_sensors() order
+    adc_trace->begin(clock, "wx-flow", "SIM", 0);
+    RecordingAdc therm_rec(adc, *adc_trace, TRACE_ADC_THERM);
+    FlowResult fr = run_cycle(cycle, therm_rec, clock, gpio);
+
+    ScriptedAdc  sensors(clock, [](uint8_t ch, uint64_t) {
+        return (int16_t)(ch == CH_PRESSURE ? 12000 : ch == CH_CONDUCTIVITY ? 6400 : 800);
+    });
+    RecordingAdc sensors_rec(sensors, *adc_trace, TRACE_ADC_SENSORS);
+    sensors_rec.read_single_ended(CH_PRESSURE);
+    sensors_rec.read_single_ended(CH_CONDUCTIVITY);
+    sensors_rec.read_single_ended(CH_PT1000);
+    if (awake_s) *awake_s = clock.time_us() / 1e6;
+    return fr;
+}
+
+static double angle_diff(double a, double b) {
+    double d = fabs(fmod(a - b, 360.0));
+    return d > 180.0 ? 360.0 - d : d;
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return NAN;
+    size_t k = (size_t)(p * (v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+// Time-to-peak of the dominant thermistor, clamped as in analyze_heat_pulse()
+static double dominant_peak_time(const FlowResult &fr) {
+    int m = 0;
+    for (int j = 1; j < 4; j++) if (fr.peak_temps[j] > fr.peak_temps[m]) m = j;
+    return fr.peak_times[m] > 0.5f ? fr.peak_times[m] : 0.5;
+}
+
+static std::vector<uint32_t> parse_list(const char *s) {
+    std::vector<uint32_t> out;
+    while (*s) {
+        out.push_back((uint32_t)strtoul(s, (char **)&s, 10));
+        if (*s == ',') s++;
+        else break;
+    }
+    return out;
+}
+
+static void run_sweep(const SimConfig &cfg, const std::vector<Cycle> &cycles, int trials, uint32_t seed) {
+    printf("mode,heater_ms,monitor_ms,sample_ms,chip_ms,duty,pulses,gap_s,history,"
+           "peak_heater_w,heater_j,total_j,cycle_s,"
+           "trials,detected_pct,vel_err_med_pct,vel_err_p90_pct,dir_err_med_deg,dir_err_p90_deg,"
+           "k_fit,vel_err_fit_med_pct,vel_err_fit_p90_pct,host_ms_per_run\n");
+
+    for (const Cycle &cycle : cycles) {
+        // Same draws for every configuration, so rows are comparable
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+
+        std::vector<double> v_true, t_peak, vel_err, dir_err;
+        int detected = 0;
+        double awake_s = 0, heater_j = 0, host_ms = 0;
+        for (int i = 0; i < trials; i++) {
+            Trial tr;
+            tr.v_cm_day  = cfg.v_min * pow(cfg.v_max / cfg.v_min, u(rng));
+            tr.dir_deg   = 360.0 * u(rng);
+            tr.ambient_c = 12.0 + 10.0 * u(rng);
+
+            auto t0 = std::chrono::steady_clock::now();
+            FlowResult fr = simulate(cfg, cycle, tr, rng, nullptr, &awake_s, &heater_j);
+            host_ms += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - t0).count();
+
+            v_true.push_back(tr.v_cm_day);
+            t_peak.push_back(dominant_peak_time(fr));
+            vel_err.push_back(100.0 * fabs(fr.velocity_cm_day - tr.v_cm_day) / tr.v_cm_day);
+            if (fr.valid && fr.direction_deg >= 0) {
+                detected++;
+                dir_err.push_back(angle_diff(fr.direction_deg, tr.dir_deg));
+            }
+        }
+
+        // Least-squares K for v = K / t_peak over this configuration
+        double num = 0, den = 0;
+        for (size_t i = 0; i < v_true.size(); i++) {
+            num += v_true[i] / t_peak[i];
+            den += 1.0 / (t_peak[i] * t_peak[i]);
+        }
+        double k_fit = den > 0 ? num / den : NAN;
+        std::vector<double> fit_err;
+        for (size_t i = 0; i < v_true.size(); i++) {
+            fit_err.push_back(100.0 * fabs(k_fit / t_peak[i] - v_true[i]) / v_true[i]);
+        }
+
+        const HeatPulseParams &hp = cycle.hp;
+        const CodedPulseParams &cp = cycle.cp;
+        uint8_t duty = cycle.coded ? cp.duty : 255;
+        printf("%s,%u,%u,%u,%u,%u,%d,%u,%d,%.2f,%.2f,%.2f,%.1f,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.2f\n",
+               cycle.coded ? "coded" : "pulse",
+               cycle.coded ? 0 : hp.heater_ms, cycle.coded ? 0 : hp.monitor_ms,
+               cycle.coded ? cp.sample_ms : hp.sample_ms, cycle.coded ? cp.chip_ms : 0, duty,
+               cycle.pulses, cycle.gap_ms / 1000, cycle.history ? 1 : 0,
+               cfg.heater.power_w * duty / 255.0, heater_j, heater_j + cfg.mcu_w * awake_s,
+               awake_s, trials,
+               100.0 * detected / trials,
+               percentile(vel_err, 0.5), percentile(vel_err, 0.9),
+               percentile(dir_err, 0.5), percentile(dir_err, 0.9),
+               k_fit, percentile(fit_err, 0.5), percentile(fit_err, 0.9),
+               host_ms / trials);
+        fflush(stdout);
+    }
+}
+
+int main(int argc, char **argv) {
+    SimConfig cfg;
+    std::vector<uint32_t> heater_ms  = { 1000, 2000, 4000, 8000 };
+    std::vector<uint32_t> monitor_ms = { 30000, 60000, 120000 };
+    uint32_t sample_ms = FLOW_SAMPLE_MS, seed = 1;
+    int trials = 100;
+    const char *trace_path = nullptr, *adc_trace_path = nullptr;
+    double velocity = 100, direction = 45;
+    bool coded = false;
+    CodedPulseParams cp;
+    std::vector<uint32_t> chip_ms = { 500, 1000, 2000 };
+    std::vector<uint32_t> duty    = { 32, 64, 128 };
+    int pulses = 1;
+    std::vector<uint32_t> gap_s   = { 300 };
+    std::vector<uint32_t> history = { 1 };
+
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        if (!strcmp(argv[i], "--heater-ms") && more)          heater_ms = parse_list(argv[++i]);
+        else if (!strcmp(argv[i], "--monitor-ms") && more)    monitor_ms = parse_list(argv[++i]);
+        else if (!strcmp(argv[i], "--sample-ms") && more)     sample_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--trials") && more)        trials = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && more)          seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--v-min") && more)         cfg.v_min = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--v-max") && more)         cfg.v_max = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--noise-c") && more)       cfg.noise_c = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--drift-c-min") && more)   cfg.drift_c_per_min = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--heater-w") && more)      cfg.heater.power_w = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--heater-len-m") && more)  cfg.heater.length_m = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--mcu-w") && more)         cfg.mcu_w = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--lambda") && more)        cfg.medium.conductivity_w_mk = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--rho-c") && more)         cfg.medium.heat_capacity_j_m3k = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--trace") && more)         trace_path = argv[++i];
+        else if (!strcmp(argv[i], "--adc-trace") && more)     adc_trace_path = argv[++i];
+        else if (!strcmp(argv[i], "--velocity") && more)      velocity = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--direction") && more)     direction = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--coded"))                 coded = true;
+        else if (!strcmp(argv[i], "--order") && more)         cp.order = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--chip-ms") && more)       chip_ms = parse_list(argv[++i]);
+        else if (!strcmp(argv[i], "--duty") && more)          duty = parse_list(argv[++i]);
+        else if (!strcmp(argv[i], "--periods") && more)       cp.periods = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--coded-sample-ms") && more) cp.sample_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--pulses") && more)        pulses = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--gap-s") && more)         gap_s = parse_list(argv[++i]);
+        else if (!strcmp(argv[i], "--history") && more)       history = parse_list(argv[++i]);
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (heater_ms.empty() || monitor_ms.empty() || chip_ms.empty() || duty.empty() || trials <= 0
+        || pulses < 1 || gap_s.empty() || history.empty()) {
+        fprintf(stderr, "empty sweep\n");
+        return 2;
+    }
+
+    std::vector<Cycle> cycles;
+    if (coded) {
+        for (uint32_t c_ms : chip_ms) {
+            for (uint32_t d : duty) {
+                Cycle c;
+                c.coded = true;
+                c.cp = cp;
+                c.cp.chip_ms = c_ms;
+                c.cp.duty = (uint8_t)std::min<uint32_t>(d, 255);
+                cycles.push_back(c);
+            }
+        }
+    } else {
+        for (uint32_t h_ms : heater_ms) {
+            for (uint32_t m_ms : monitor_ms) {
+                Cycle c;
+                c.hp.heater_ms  = h_ms;
+                c.hp.monitor_ms = m_ms;
+                c.hp.sample_ms  = sample_ms;
+                cycles.push_back(c);
+            }
+        }
+    }
+
+    if (pulses > 1) {
+        std::vector<Cycle> repeated;
+        for (const Cycle &c : cycles) {
+            for (uint32_t g : gap_s) {
+                for (uint32_t h : history) {
+                    Cycle r = c;
+                    r.pulses  = pulses;
+                    r.gap_ms  = g * 1000;
+                    r.history = h && !c.coded;
+                    repeated.push_back(r);
+                }
+            }
+        }
+        cycles.swap(repeated);
+    }
+
+    if (trace_path || adc_trace_path) {
+        FILE *f = nullptr;
+        if (trace_path && !(f = fopen(trace_path, "w"))) {
+            perror(trace_path);
+            return 1;
+        }
+        std::mt19937 rng(seed);
+        static AdcTraceSample samples[8192];
+        AdcTrace adc_trace(samples, 8192);
+        if (f) fprintf(f, "t_s,channel,code,temp_c\n");
+        FlowResult fr = simulate(cfg, cycles[0], { velocity, direction, 18.0 }, rng, f, nullptr,
+                                 nullptr, adc_trace_path ? &adc_trace : nullptr);
+        if (f) fclose(f);
+        if (adc_trace_path) {
+            adc_trace.header.boot_count = seed;
+            if (!save_trace(adc_trace_path, adc_trace)) {
+                perror(adc_trace_path);
+                return 1;
+            }
+        }
+        printf("true v=%.1f cm/day dir=%.0f | firmware v=%.1f cm/day dir=%.0f | "
+               "peak dT N/E/S/W %.3f %.3f %.3f %.3f\n",
+               velocity, direction, fr.velocity_cm_day, fr.direction_deg,
+               fr.peak_temps[0], fr.peak_temps[1], fr.peak_temps[2], fr.peak_temps[3]);
+        return 0;
+    }
+
+    run_sweep(cfg, cycles, trials, seed);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+/*
+ * Analytic line-source model of a heat pulse in a moving, saturated medium.
+ *
+ * An infinite line heater dissipating q' W/m, switched on over one or more
+ * intervals, in a medium with bulk conductivity λ and volumetric heat
+ * capacity ρc, through which the heat front moves at V = v·(ρc)_w/(ρc)
+ * (v = Darcy flux). The temperature rise at (x, y) is the superposition of
+ * instantaneous line sources released during each on-interval:
+ *
+ *   ΔT(x, y, t) = ∫ q' / (4πλτ) · exp(-((x - Vx·τ)² + (y - Vy·τ)²) / (4κτ)) ds,
+ *   τ = t - s, κ = λ/ρc
+ *
+ * integrated over the heater-on times s < t with Simpson's rule, each
+ * interval scaled by its PWM duty (the element's thermal mass smooths
+ * the PWM carrier). Positions
+ * are in metres with +y = north and +x = east, matching the firmware's
+ * N/E/S/W thermistor order and compass-degree flow direction.
+ */
+
+struct MediumParams {
+    double conductivity_w_mk   = 2.0;      // λ, saturated sand
+    double heat_capacity_j_m3k = 2.6e6;    // (ρc) bulk
+    double water_capacity_j_m3k = 4.18e6;  // (ρc) water
+};
+
+struct HeaterParams {
+    double power_w  = 3.0;     // electrical power into the element
+    double length_m = 0.04;    // element length (heater post height)
+};
+
+struct HeaterInterval {
+    double on_s;
+    double off_s;
+    double duty;       // fraction of power_w
+};
+
+class LineSourceModel {
+public:
+    LineSourceModel(const MediumParams &m, const HeaterParams &h)
+        : lambda_(m.conductivity_w_mk),
+          kappa_(m.conductivity_w_mk / m.heat_capacity_j_m3k),
+          front_ratio_(m.water_capacity_j_m3k / m.heat_capacity_j_m3k),
+          q_per_m_(h.power_w / h.length_m) {}
+
+    // Darcy flux in cm/day, direction in compass degrees (flow heads toward)
+    void set_flow(double v_cm_day, double dir_deg) {
+        double v = v_cm_day / 100.0 / 86400.0 * front_ratio_;
+        double rad = dir_deg * M_PI / 180.0;
+        vx_ = v * sin(rad);
+        vy_ = v * cos(rad);
+    }
+
+    // Temperature rise (°C) at (x, y) metres, t seconds
+    double rise(double x, double y, double t, const std::vector<HeaterInterval> &on) const {
+        double sum = 0;
+        for (const HeaterInterval &iv : on) {
+            double b = iv.off_s < t ? iv.off_s : t;
+            if (b <= iv.on_s) continue;
+            sum += iv.duty * integrate(x, y, t, iv.on_s, b);
+        }
+        return sum;
+    }
+
+private:
+    static const int STEPS = 64;   // even, for Simpson's rule
+
+    double kernel(double x, double y, double tau) const {
+        if (tau <= 0) return 0;
+        double dx = x - vx_ * tau, dy = y - vy_ * tau;
+        return q_per_m_ / (4.0 * M_PI * lambda_ * tau) * exp(-(dx * dx + dy * dy) / (4.0 * kappa_ * tau));
+    }
+
+    double integrate(double x, double y, double t, double a, double b) const {
+        double h = (b - a) / STEPS;
+        double acc = kernel(x, y, t - a) + kernel(x, y, t - b);
+        for (int i = 1; i < STEPS; i++) {
+            acc += (i & 1 ? 4.0 : 2.0) * kernel(x, y, t - (a + i * h));
+        }
+        return acc * h / 3.0;
+    }
+
+    double lambda_, kappa_, front_ratio_, q_per_m_;
+    double vx_ = 0, vy_ = 0;
+};
@@ -0,0 +1,300 @@
+/*
+ * Fleet telemetry load generator for the backend ingest path
+ * (POST /hardware/data) and the device queries next to it.
+ *
+ * N virtual WX-Level / WX-Flow units send the exact bytes their firmware's
+ * build_json() produces (via fleet/), each on its TX interval with
+ * per-cycle jitter. Time is compressed by --speedup, or to hit a target
+ * --rate. The schedule is open-loop: latency counts from when a request
+ * was due, so a server that falls behind shows it in the tail rather than
+ * slowing the generator down. A --query-ratio share of sends is followed
+ * by a device query (/devices, /data/{id}/latest, /data?device_id=).
+ *
+ *   uvicorn main:app --port 8000 &        (from backend/)
+ *   loadgen --devices 5000 --rate 200 --duration-s 30 --prefill 50000
+ *
+ * As a regression benchmark, --baseline FILE compares p99 per endpoint
+ * and fails on errors or a p99 more than --slower times the baseline;
+ * --update rewrites it. --dump N prints N payloads and exits.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "http_client.h"
+#include "../fleet/fleet_units.h"
+#include "../replay/trace_file.h"
+
+typedef std::chrono::steady_clock Clock;
+
+enum Endpoint { EP_INGEST, EP_DEVICES, EP_LATEST, EP_QUERY, EP_COUNT };
+static const char *EP_NAMES[EP_COUNT] = { "ingest", "devices", "latest", "query" };
+
+struct VirtualUnit {
+    const UnitType *type;
+    double interval_s;
+    double phase_s;
+};
+
+struct Send {
+    double   t;          // scheduled wall offset from start (s)
+    uint32_t unit;
+    uint32_t boot;
+    bool operator>(const Send &o) const { return t > o.t; }
+};
+
+// Hands out sends in time order to the workers
+class Schedule {
+public:
+    Schedule(const std::vector<VirtualUnit> &units, double speedup, double jitter_s, uint32_t seed)
+        : units_(units), speedup_(speedup), jitter_(0.0, jitter_s), rng_(seed) {
+        for (uint32_t i = 0; i < units.size(); i++) push(i, 1);
+    }
+
+    Send next() {
+        std::lock_guard<std::mutex> lock(mu_);
+        Send s = q_.top();
+        q_.pop();
+        push(s.unit, s.boot + 1);
+        return s;
+    }
+
+private:
+    void push(uint32_t unit, uint32_t boot) {
+        const VirtualUnit &u = units_[unit];
+        double sim_t = u.phase_s + (boot - 1) * u.interval_s + (jitter_.stddev() > 0 ? jitter_(rng_) : 0);
+        q_.push({ std::max(0.0, sim_t) / speedup_, unit, boot });
+    }
+
+    const std::vector<VirtualUnit> &units_;
+    double speedup_;
+    std::normal_distribution<double> jitter_;
+    std::mt19937 rng_;
+    std::mutex mu_;
+    std::priority_queue<Send, std::vector<Send>, std::greater<Send>> q_;
+};
+
+struct WorkerStats {
+    std::vector<double> ms[EP_COUNT];
+    uint64_t errors[EP_COUNT] = {};
+    uint64_t late = 0;          // sends that left more than 1 ms after they were due
+};
+
+static size_t make_payload(const std::vector<VirtualUnit> &units, uint32_t unit, uint32_t boot,
+                           std::mt19937 &rng, char *buf, size_t cap) {
+    return units[unit].type->payload(unit, boot, rng, buf, cap);
+}
+
+static double percentile(std::vector<double> &v, double p) {
+    if (v.empty()) return 0;
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[std::min(i, v.size() - 1)];
+}
+
+/*
+ * loadgen [--url http://127.0.0.1:8000/hardware] [--devices 1000] [--flow-share 0.25]
+ *         [--interval-s S] [--jitter-s 5] [--speedup X | --rate R]
+ *         [--duration-s 30] [--warmup-s 3] [--connections 8]
+ *         [--query-ratio 0.05] [--prefill N] [--seed 1] [--dump N]
+ *         [--baseline FILE] [--update] [--slower 1.5]
+ */
+int main(int argc, char **argv) {
+    const char *url_str = "http://127.0.0.1:8000/hardware";
+    const char *baseline_path = nullptr;
+    uint32_t devices = 1000, seed = 1, prefill = 0, dump = 0;
+    int connections = 8;
+    double flow_share = 0.25, interval_s = 0, jitter_s = 5, speedup = 0, rate = 0;
+    double duration_s = 30, warmup_s = 3, query_ratio = 0.05, slower = 1.5;
+    bool update = false;
+
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        const char *a = argv[i];
+        if (!strcmp(a, "--url") && more)                url_str = argv[++i];
+        else if (!strcmp(a, "--devices") && more)       devices = atoi(argv[++i]);
+        else if (!strcmp(a, "--flow-share") && more)    flow_share = atof(argv[++i]);
+        else if (!strcmp(a, "--interval-s") && more)    interval_s = atof(argv[++i]);
+        else if (!strcmp(a, "--jitter-s") && more)      jitter_s = atof(argv[++i]);
+        else if (!strcmp(a, "--speedup") && more)       speedup = atof(argv[++i]);
+        else if (!strcmp(a, "--rate") && more)          rate = atof(argv[++i]);
+        else if (!strcmp(a, "--duration-s") && more)    duration_s = atof(argv[++i]);
+        else if (!strcmp(a, "--warmup-s") && more)      warmup_s = atof(argv[++i]);
+        else if (!strcmp(a, "--connections") && more)   connections = atoi(argv[++i]);
+        else if (!strcmp(a, "--query-ratio") && more)   query_ratio = atof(argv[++i]);
+        else if (!strcmp(a, "--prefill") && more)       prefill = atoi(argv[++i]);
+        else if (!strcmp(a, "--seed") && more)          seed = atoi(argv[++i]);
+        else if (!strcmp(a, "--dump") && more)          dump = atoi(argv[++i]);
+        else if (!strcmp(a, "--baseline") && more)      baseline_path = argv[++i];
+        else if (!strcmp(a, "--update"))                update = true;
+        else if (!strcmp(a, "--slower") && more)        slower = atof(argv[++i]);
+        else {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return 2;
+        }
+    }
+    HttpUrl url;
+    if (!parse_http_url(url_str, url)) {
+        fprintf(stderr, "need an http://host[:port][/prefix] URL, got %s\n", url_str);
+        return 2;
+    }
+    if (!devices || connections <= 0 || duration_s <= 0) {
+        fprintf(stderr, "nothing to run\n");
+        return 2;
+    }
+
+    // ── Fleet ──
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> u01(0.0, 1.0);
+    std::vector<VirtualUnit> units(devices);
+    double natural_rps = 0;
+    for (VirtualUnit &u : units) {
+        u.type = u01(rng) < flow_share ? &wx_flow_unit() : &wx_level_unit();
+        u.interval_s = interval_s > 0 ? interval_s : u.type->tx_interval_s;
+        u.phase_s = u01(rng) * u.interval_s;
+        natural_rps += 1.0 / u.interval_s;
+    }
+    if (rate > 0) speedup = rate / natural_rps;
+    if (speedup <= 0) speedup = 1;
+
+    char buf[2048];
+    if (dump) {
+        for (uint32_t i = 0; i < dump; i++) {
+            size_t n = make_payload(units, i % devices, 1 + i / devices, rng, buf, sizeof(buf));
+            printf("%.*s\n", (int)n, buf);
+        }
+        return 0;
+    }
+    if (!make_payload(units, 0, 1, rng, buf, sizeof(buf))) {
+        fprintf(stderr, "build_json() produced no payload\n");
+        return 2;
+    }
+    fprintf(stderr, "%u units, %.2f req/s at field cadence, x%.1f -> %.1f req/s for %.0f s, "
+            "%d connections\n", devices, natural_rps, speedup, natural_rps * speedup, duration_s,
+            connections);
+
+    // ── Prefill: bring the store to size before measuring ──
+    if (prefill) {
+        std::atomic<uint32_t> next(0);
+        std::atomic<uint64_t> failed(0);
+        std::vector<std::thread> threads;
+        for (int c = 0; c < connections; c++) {
+            threads.emplace_back([&, c] {
+                HttpConnection conn(url);
+                std::mt19937 r(seed + 1000 + c);
+                char b[2048];
+                for (uint32_t i; (i = next++) < prefill;) {
+                    size_t n = make_payload(units, i % devices, 1 + i / devices, r, b, sizeof(b));
+                    if (conn.request("POST", "/data", b, n) != 200) failed++;
+                }
+            });
+        }
+        for (std::thread &t : threads) t.join();
+        fprintf(stderr, "prefilled %u readings (%llu failed)\n", prefill,
+                (unsigned long long)failed.load());
+        if (failed == prefill) {
+            fprintf(stderr, "server at %s:%s not answering\n", url.host.c_str(), url.port.c_str());
+            return 1;
+        }
+    }
+
+    // ── Timed run ──
+    Schedule sched(units, speedup, jitter_s, seed);
+    std::vector<WorkerStats> stats(connections);
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < connections; c++) {
+        threads.emplace_back([&, c] {
+            HttpConnection conn(url);
+            WorkerStats &st = stats[c];
+            std::mt19937 r(seed + 2000 + c);
+            std::uniform_real_distribution<double> coin(0.0, 1.0);
+            char b[2048];
+            uint32_t queries = 0;
+            for (;;) {
+                Send s = sched.next();
+                if (s.t >= duration_s) break;
+                Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(
+                                                    std::chrono::duration<double>(s.t));
+                std::this_thread::sleep_until(due);
+                size_t n = make_payload(units, s.unit, s.boot, r, b, sizeof(b));
+                Clock::time_point sent = Clock::now();
+                int status = conn.request("POST", "/data", b, n);
+                Clock::time_point done = Clock::now();
+                if (s.t < warmup_s) continue;
+                if (sent - due > std::chrono::milliseconds(1)) st.late++;
+                st.ms[EP_INGEST].push_back(std::chrono::duration<double, std::milli>(done - due).count());
+                if (status != 200) st.errors[EP_INGEST]++;
+
+                if (coin(r) >= query_ratio) continue;
+                char id[24];
+                fleet_device_id(*units[s.unit].type, s.unit, id, sizeof(id));
+                Endpoint ep = (Endpoint)(EP_DEVICES + queries++ % 3);
+                std::string path = ep == EP_DEVICES ? std::string("/devices")
+                                 : ep == EP_LATEST  ? "/data/" + std::string(id) + "/latest"
+                                 : "/data?device_id=" + std::string(id) + "&limit=100";
+                Clock::time_point q0 = Clock::now();
+                status = conn.request("GET", path);
+                st.ms[ep].push_back(std::chrono::duration<double, std::milli>(Clock::now() - q0).count());
+                if (status != 200) st.errors[ep]++;
+            }
+        });
+    }
+    for (std::thread &t : threads) t.join();
+    double measured_s = std::max(1e-9, duration_s - warmup_s);
+
+    // ── Report ──
+    std::vector<std::string> cols = { "p50_ms", "p99_ms", "errors" };
+    BaselineRows baseline, fresh;
+    if (baseline_path && !update && !load_baseline(baseline_path, cols.size(), baseline)) {
+        fprintf(stderr, "cannot read baseline %s\n", baseline_path);
+        return 2;
+    }
+    uint64_t late = 0, sends = 0;
+    for (const WorkerStats &st : stats) {
+        late += st.late;
+        sends += st.ms[EP_INGEST].size();
+    }
+    printf("endpoint,count,errors,achieved_rps,p50_ms,p90_ms,p99_ms,p999_ms,max_ms\n");
+    int failures = 0;
+    for (int ep = 0; ep < EP_COUNT; ep++) {
+        std::vector<double> all;
+        uint64_t errors = 0;
+        for (WorkerStats &st : stats) {
+            all.insert(all.end(), st.ms[ep].begin(), st.ms[ep].end());
+            errors += st.errors[ep];
+        }
+        if (all.empty()) continue;
+        std::sort(all.begin(), all.end());
+        double p50 = percentile(all, 0.5), p99 = percentile(all, 0.99);
+        printf("%s,%zu,%llu,%.1f,%.2f,%.2f,%.2f,%.2f,%.2f\n", EP_NAMES[ep], all.size(),
+               (unsigned long long)errors, all.size() / measured_s, p50, percentile(all, 0.9), p99,
+               percentile(all, 0.999), all.back());
+        fresh[EP_NAMES[ep]] = { p50, p99, (double)errors };
+
+        if (errors) failures++;
+        auto it = baseline.find(EP_NAMES[ep]);
+        if (it == baseline.end()) continue;
+        double ratio = it->second[1] > 0 ? p99 / it->second[1] : 1.0;
+        if (ratio > slower) {
+            fprintf(stderr, "SLOWER %s: p99 %.2f ms vs %.2f ms baseline (%.2fx)\n", EP_NAMES[ep],
+                    p99, it->second[1], ratio);
+            failures++;
+        }
+    }
+    fprintf(stderr, "%llu of %llu sends left late (generator or connections saturated)\n",
+            (unsigned long long)late, (unsigned long long)sends);
+
+    if (update && baseline_path) {
+        if (!write_baseline(baseline_path, cols, fresh, "endpoint")) {
+            perror(baseline_path);
+            return 1;
+        }
+        fprintf(stderr, "baseline written: %s\n", baseline_path);
+        return 0;
+    }
+    return failures ? 1 : 0;
+}
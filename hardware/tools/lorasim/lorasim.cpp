@@ -0,0 +1,552 @@
+/*
+ * LoRa uplink capacity simulator: how many WX units a gateway carries
+ * before collisions dominate.
+ *
+ * Discrete-event model of every uplink in a fleet placed at the DWR
+ * monitoring wells (data/monitoring/enterprise_wells.csv) with k-means
+ * gateways, or gateways given on the command line. Units wake on their
+ * deep-sleep timer (TX_INTERVAL_MS after the previous cycle ends, with
+ * per-unit RTC drift) and transmit the LoRa frame their firmware's
+ * build_air() produces, at the SF / bandwidth / power in config.h.
+ * Units whose frame exceeds the firmware's LORA_MAX_PAYLOAD cannot use
+ * LoRa at all; they are reported on stderr and left out.
+ *
+ * A packet is received by a gateway when it is above sensitivity, a
+ * demodulator was free when it arrived, the gateway was not transmitting,
+ * and it beat every overlapping same-SF packet by the capture threshold.
+ * Different SFs are treated as orthogonal. Units out of reach of every
+ * gateway are reported as coverage and left out of the delivery figures.
+ * Schemes vary payload, SF (fixed or per-unit ADR), ACK + retries and
+ * channel count; one CSV row per scheme × fleet size × gateway count.
+ *
+ *   lorasim --devices 500,1000,2000,5000 --gateways 8
+ *   lorasim --basin KERN --devices 200,1000 --gateways 1,2 --flow-share 0.5
+ *   lorasim --scheme current --scheme tight:payload=24,sf=adr,channels=8
+ *
+ * Built-in schemes: current (firmware as configured), compact (24-byte
+ * binary frame), adr (lowest SF with 10 dB margin), ack3 (confirmed, up
+ * to 3 retries) and hop8 (8 uplink channels).
+ */
+
+#include <chrono>
+#include <queue>
+#include "lora_airtime.h"
+#include "radio_model.h"
+#include "../fleet/fleet_units.h"
+
+// ── Schemes ─────────────────────────────────────────────────
+struct Scheme {
+    std::string name;
+    uint32_t payload     = 0;       // 0: firmware build_air()
+    int      sf          = 0;       // 0: firmware, -1: ADR
+    bool     ack         = false;
+    int      retries     = 0;
+    int      channels    = 1;
+    double   interval_min = 0;      // 0: firmware TX_INTERVAL_MS
+    double   backoff_s   = 3.0;     // retry jitter after the RX2 window
+};
+
+static bool parse_scheme(const char *spec, Scheme &s) {
+    static const char *BUILTIN[] = { "current", "compact", "adr", "ack3", "hop8" };
+    const char *colon = strchr(spec, ':');
+    s = Scheme();
+    s.name = colon ? std::string(spec, colon) : std::string(spec);
+    if (s.name == "compact") s.payload = 24;
+    else if (s.name == "adr") s.sf = -1;
+    else if (s.name == "ack3") { s.ack = true; s.retries = 3; }
+    else if (s.name == "hop8") s.channels = 8;
+    else if (!colon) {
+        bool known = false;
+        for (const char *b : BUILTIN) known |= s.name == b;
+        if (!known) return false;
+    }
+    if (!colon) return true;
+
+    std::string rest(colon + 1);
+    size_t pos = 0;
+    while (pos < rest.size()) {
+        size_t end = rest.find(',', pos);
+        if (end == std::string::npos) end = rest.size();
+        std::string kv = rest.substr(pos, end - pos);
+        size_t eq = kv.find('=');
+        if (eq == std::string::npos) return false;
+        std::string k = kv.substr(0, eq);
+        const char *v = kv.c_str() + eq + 1;
+        if (k == "payload")            s.payload = atoi(v);
+        else if (k == "sf")            s.sf = !strcmp(v, "adr") ? -1 : atoi(v);
+        else if (k == "ack")           s.ack = atoi(v) != 0;
+        else if (k == "retries")       s.retries = atoi(v);
+        else if (k == "channels")      s.channels = std::max(1, atoi(v));
+        else if (k == "interval_min")  s.interval_min = atof(v);
+        else if (k == "backoff_s")     s.backoff_s = atof(v);
+        else return false;
+        pos = end + 1;
+    }
+    if (s.retries > 0) s.ack = true;
+    return s.sf == -1 || s.sf == 0 || (s.sf >= 7 && s.sf <= 12);
+}
+
+// ── Scenario ────────────────────────────────────────────────
+struct SimParams {
+    LinkParams link;
+    double hours        = 24;
+    double align_s      = -1;       // < 0: random phase; else all units boot within align_s
+    double drift_ppm    = 2000;     // σ of the deep-sleep RTC rate error across units
+    double wake_jitter_s = 0.05;    // σ of boot-to-TX time per cycle
+    double adr_margin_db = 10;
+    int    demods       = 8;        // SX1301/SX1302 concurrent demodulators
+    double duty_cycle   = 1.0;      // per-unit airtime limit (0.01 for EU868)
+    double max_dwell_ms = 400;      // FCC 15.247 dwell per channel hop
+    double supply_v     = 3.7;
+    double tx_ma        = 120;      // SX1276 at 17 dBm
+    double rx_ma        = 11.5;
+    double mcu_ma       = 45;       // awake while waiting for RX windows
+};
+
+struct Unit {
+    const UnitType *type;
+    GeoPoint pos;
+    bool     lora;           // payload fits the LoRa path
+    uint32_t bytes;          // payload as built
+    uint16_t frame;
+    uint8_t  sf;
+    double   period_s;       // sleep interval with this unit's RTC error
+    double   dc_ready;       // duty-cycle: earliest next TX
+    std::vector<float> rssi; // mean per gateway
+    // current reading
+    bool     counted;
+    bool     delivered;
+    int      attempts;
+};
+
+struct Packet {
+    int    unit;
+    double start, end;
+    uint8_t ch, sf;
+    std::vector<float> rx;       // per gateway, with fading
+    std::vector<float> imax;     // strongest overlapping same-SF packet per gateway
+    std::vector<char>  locked;   // demodulator assigned
+    std::vector<char>  blocked;  // above sensitivity, no demodulator free
+};
+
+enum EvKind { EV_END = 0, EV_TX = 1, EV_WAKE = 2 };
+struct Event {
+    double t;
+    int kind, idx;
+    bool operator>(const Event &o) const { return t != o.t ? t > o.t : kind > o.kind; }
+};
+
+struct RunResult {
+    size_t units = 0, lora_units = 0, in_range = 0;
+    uint64_t readings = 0, delivered = 0, attempts = 0;
+    uint64_t lost_range = 0, lost_collision = 0, lost_demod = 0, lost_gw_tx = 0;
+    uint64_t dwell_violations = 0, deferred = 0;
+    double airtime_s = 0, energy_mj = 0;
+};
+
+class Simulation {
+public:
+    Simulation(const SimParams &sp, const Scheme &sc, std::vector<Unit> &units,
+               const std::vector<GeoPoint> &gateways, const Projection &proj, uint32_t seed)
+        : sp_(sp), sc_(sc), units_(units), gws_(gateways.size()), rng_(seed) {
+        std::normal_distribution<double> shadow(0.0, sp.link.shadow_db);
+        for (Unit &u : units_) {
+            u.rssi.resize(gws_);
+            float best = -1e9f;
+            for (size_t g = 0; g < gws_; g++) {
+                double pl = path_loss_db(sp.link, proj.dist_km(u.pos, gateways[g])) + shadow(rng_);
+                u.rssi[g] = (float)(u.type->lora_tx_dbm + sp.link.unit_gain_dbi
+                                    + sp.link.gw_gain_dbi - pl);
+                best = std::max(best, u.rssi[g]);
+            }
+            u.sf = sc.sf > 0 ? sc.sf : u.type->lora_sf;
+            if (sc.sf < 0) {
+                u.sf = 12;
+                for (uint8_t sf = 7; sf <= 12; sf++) {
+                    if (best - sx1276_sensitivity_dbm(sf, u.type->lora_bw_hz) >= sp.adr_margin_db) {
+                        u.sf = sf;
+                        break;
+                    }
+                }
+            }
+            if (u.lora) {
+                res_.lora_units++;
+                // Units no gateway can hear would be set up for cellular;
+                // they show in in_range_pct and are not simulated
+                if (best >= sx1276_sensitivity_dbm(u.sf, u.type->lora_bw_hz)) res_.in_range++;
+                else u.lora = false;
+            }
+        }
+        res_.units = units_.size();
+        busy_.resize(gws_);
+        demods_.assign(gws_, 0);
+        active_.resize(sc.channels);
+    }
+
+    RunResult run() {
+        std::uniform_real_distribution<double> u01(0.0, 1.0);
+        double longest = 0;
+        for (const Unit &u : units_) longest = std::max(longest, u.period_s);
+        t0_ = longest;                           // one full cycle of warm-up
+        t1_ = t0_ + sp_.hours * 3600.0;
+
+        for (size_t i = 0; i < units_.size(); i++) {
+            if (!units_[i].lora) continue;
+            double wake = sp_.align_s >= 0 ? u01(rng_) * sp_.align_s : u01(rng_) * units_[i].period_s;
+            q_.push({ wake, EV_WAKE, (int)i });
+        }
+        while (!q_.empty()) {
+            Event e = q_.top();
+            q_.pop();
+            if (e.t > t1_ + 600.0) break;
+            if (e.kind == EV_WAKE)     wake(e);
+            else if (e.kind == EV_TX)  transmit(e);
+            else                       end(e);
+        }
+        return res_;
+    }
+
+private:
+    void wake(const Event &e) {
+        Unit &u = units_[e.idx];
+        std::normal_distribution<double> jit(0.0, sp_.wake_jitter_s);
+        double t = e.t + std::max(0.0, u.type->awake_s + jit(rng_));
+        u.counted = t >= t0_ && t < t1_;
+        u.delivered = false;
+        u.attempts = 0;
+        if (u.counted) res_.readings++;
+        q_.push({ t, EV_TX, e.idx });
+    }
+
+    void finish_reading(int unit_idx, double t) {
+        Unit &u = units_[unit_idx];
+        q_.push({ t + u.period_s, EV_WAKE, unit_idx });
+    }
+
+    void transmit(const Event &e) {
+        Unit &u = units_[e.idx];
+        if (e.t < u.dc_ready) {
+            if (u.counted) res_.deferred++;
+            q_.push({ u.dc_ready, EV_TX, e.idx });
+            return;
+        }
+        double air = lora_airtime_us(u.sf, u.type->lora_bw_hz, u.frame) / 1e6;
+        if (sp_.duty_cycle < 1.0) u.dc_ready = e.t + air / sp_.duty_cycle;
+        u.attempts++;
+
+        int slot = alloc();
+        Packet &p = pool_[slot];
+        p.unit = e.idx;
+        p.start = e.t;
+        p.end = e.t + air;
+        p.sf = u.sf;
+        p.ch = (uint8_t)std::uniform_int_distribution<int>(0, sc_.channels - 1)(rng_);
+        p.rx.resize(gws_);
+        p.imax.assign(gws_, -1e9f);
+        p.locked.assign(gws_, 0);
+        p.blocked.assign(gws_, 0);
+        std::normal_distribution<double> fade(0.0, sp_.link.fade_db);
+        double sens = sx1276_sensitivity_dbm(u.sf, u.type->lora_bw_hz);
+        for (size_t g = 0; g < gws_; g++) {
+            p.rx[g] = u.rssi[g] + (float)fade(rng_);
+            if (p.rx[g] < sens) continue;
+            if (demods_[g] < sp_.demods) {
+                p.locked[g] = 1;
+                demods_[g]++;
+            } else {
+                p.blocked[g] = 1;
+            }
+        }
+        for (int qi : active_[p.ch]) {
+            Packet &q = pool_[qi];
+            if (q.sf != p.sf) continue;
+            for (size_t g = 0; g < gws_; g++) {
+                p.imax[g] = std::max(p.imax[g], q.rx[g]);
+                q.imax[g] = std::max(q.imax[g], p.rx[g]);
+            }
+        }
+        active_[p.ch].push_back(slot);
+
+        if (u.counted) {
+            res_.attempts++;
+            res_.airtime_s += air;
+            res_.energy_mj += air * (sp_.tx_ma + sp_.mcu_ma) * sp_.supply_v;
+            if (air * 1000.0 > sp_.max_dwell_ms) res_.dwell_violations++;
+        }
+        q_.push({ p.end, EV_END, slot });
+    }
+
+    void end(const Event &e) {
+        Packet &p = pool_[e.idx];
+        Unit &u = units_[p.unit];
+        std::vector<int> &act = active_[p.ch];
+        act.erase(std::find(act.begin(), act.end(), e.idx));
+
+        // Best outcome over all gateways
+        enum { R_RANGE, R_GW_TX, R_DEMOD, R_COLLISION, R_OK } why = R_RANGE;
+        int ack_gw = -1;
+        for (size_t g = 0; g < gws_; g++) {
+            if (p.locked[g]) demods_[g]--;
+            int r;
+            if (p.blocked[g])                                   r = R_DEMOD;
+            else if (!p.locked[g])                              r = R_RANGE;
+            else if (gateway_busy(g, p.start, p.end))           r = R_GW_TX;
+            else if (p.imax[g] > p.rx[g] - sp_.link.capture_db) r = R_COLLISION;
+            else                                                r = R_OK;
+            if (r == R_OK && (ack_gw < 0 || p.rx[g] > p.rx[ack_gw])) ack_gw = (int)g;
+            if (r > why) why = (decltype(why))r;
+        }
+        bool ok = why == R_OK;
+        double done = p.end;
+
+        if (sc_.ack) {
+            double sym = lora_symbol_us(p.sf, u.type->lora_bw_hz) / 1e6;
+            double ack_air = lora_airtime_us(p.sf, u.type->lora_bw_hz, 12) / 1e6;
+            if (ok) {
+                busy_[ack_gw].push_back({ p.end + 1.0, p.end + 1.0 + ack_air });
+                done = p.end + 1.0 + ack_air;
+                if (u.counted) res_.energy_mj += (1.0 * sp_.mcu_ma + ack_air * (sp_.rx_ma + sp_.mcu_ma)) * sp_.supply_v;
+            } else {
+                // RX1 and RX2 both time out after an 8-symbol preamble search
+                done = p.end + 2.0 + 8 * sym;
+                if (u.counted) res_.energy_mj += (2.0 * sp_.mcu_ma + 16 * sym * sp_.rx_ma) * sp_.supply_v;
+            }
+        }
+
+        free_.push_back(e.idx);
+        int unit_idx = p.unit;
+        if (ok && !u.delivered) {
+            u.delivered = true;
+            if (u.counted) res_.delivered++;
+        }
+        if (!ok && sc_.ack && u.attempts <= sc_.retries) {
+            double backoff = std::uniform_real_distribution<double>(0.0, sc_.backoff_s)(rng_);
+            q_.push({ done + backoff, EV_TX, unit_idx });
+            return;
+        }
+        if (!u.delivered && u.counted) {
+            if (why == R_RANGE)          res_.lost_range++;
+            else if (why == R_COLLISION) res_.lost_collision++;
+            else if (why == R_DEMOD)     res_.lost_demod++;
+            else                         res_.lost_gw_tx++;
+        }
+        finish_reading(unit_idx, done);
+    }
+
+    bool gateway_busy(size_t g, double s, double e) {
+        std::vector<std::pair<double, double>> &b = busy_[g];
+        // ACKs older than the longest possible packet cannot overlap anything again
+        while (!b.empty() && b.front().second < s - 10.0) b.erase(b.begin());
+        for (const auto &iv : b) {
+            if (iv.first < e && iv.second > s) return true;
+        }
+        return false;
+    }
+
+    int alloc() {
+        if (!free_.empty()) {
+            int i = free_.back();
+            free_.pop_back();
+            return i;
+        }
+        pool_.emplace_back();
+        return (int)pool_.size() - 1;
+    }
+
+    const SimParams &sp_;
+    const Scheme    &sc_;
+    std::vector<Unit> &units_;
+    size_t gws_;
+    std::mt19937 rng_;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> q_;
+    std::vector<Packet> pool_;
+    std::vector<int> free_;
+    std::vector<std::vector<int>> active_;                       // per channel
+    std::vector<std::vector<std::pair<double, double>>> busy_;   // gateway TX per gateway
+    std::vector<int> demods_;
+    double t0_ = 0, t1_ = 0;
+    RunResult res_;
+};
+
+// ── Fleet ───────────────────────────────────────────────────
+static std::vector<Unit> build_fleet(const std::vector<GeoPoint> &wells, size_t n, double flow_share,
+                                     double spread_km, const Scheme &sc, const SimParams &sp,
+                                     const Projection &proj, std::mt19937 &rng) {
+    std::uniform_real_distribution<double> u01(0.0, 1.0);
+    std::normal_distribution<double> drift(0.0, sp.drift_ppm * 1e-6);
+    std::vector<size_t> order(wells.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<Unit> units(n);
+    char buf[2048];
+    for (size_t i = 0; i < n; i++) {
+        Unit &u = units[i];
+        u.type = u01(rng) < flow_share ? &wx_flow_unit() : &wx_level_unit();
+        if (n <= wells.size()) {
+            u.pos = wells[order[i]];
+        } else {
+            // More units than wells: several units per site, spread over the farm
+            const GeoPoint &w = wells[order[i % wells.size()]];
+            double r = spread_km * sqrt(u01(rng)), a = 2.0 * M_PI * u01(rng);
+            u.pos = { w.lat + r * sin(a) / proj.ky, w.lon + r * cos(a) / proj.kx };
+        }
+        uint32_t bytes = sc.payload ? sc.payload
+                                    : (uint32_t)u.type->air_payload((uint32_t)i, 1000, rng, buf, sizeof(buf));
+        u.bytes = bytes;
+        u.lora  = !(u.type->lora_max_payload && bytes > u.type->lora_max_payload) && bytes > 0;
+        u.frame = bytes > 255 ? 255 : (uint16_t)bytes;     // SX1276 FIFO
+        double interval = sc.interval_min > 0 ? sc.interval_min * 60.0 : u.type->tx_interval_s;
+        u.period_s = interval * (1.0 + drift(rng));
+        u.dc_ready = 0;
+    }
+    return units;
+}
+
+static std::vector<double> parse_list(const char *s) {
+    std::vector<double> out;
+    while (*s) {
+        char *end;
+        double v = strtod(s, &end);
+        if (end == s) break;
+        out.push_back(v);
+        if (*end != ',') break;
+        s = end + 1;
+    }
+    return out;
+}
+
+/*
+ * lorasim [--wells FILE] [--basin NAME] [--devices 500,1000] [--flow-share 0.25]
+ *         [--gateways 4,8] [--gateway LAT,LON ...] [--spread-km 2]
+ *         [--scheme NAME[:key=val,...] ...] [--hours 24] [--seed 1]
+ *         [--align-s S] [--drift-ppm P] [--demods 8] [--duty-cycle 1]
+ *         [--max-dwell-ms 400] [--pl0-db X] [--pl-exp X] [--shadow-db X]
+ *         [--fade-db X] [--capture-db X] [--tx-ma X]
+ *
+ * Scheme keys: payload=N, sf=7..12|adr, ack=0|1, retries=N, channels=N,
+ * interval_min=M, backoff_s=S.
+ */
+int main(int argc, char **argv) {
+    SimParams sp;
+    const char *wells_path = "../../data/monitoring/enterprise_wells.csv";
+    const char *basin = nullptr;
+    std::vector<double> devices = { 250, 500, 1000, 2000, 5000 };
+    std::vector<double> gw_counts = { 8 };
+    std::vector<GeoPoint> fixed_gws;
+    std::vector<Scheme> schemes;
+    double flow_share = 0.25, spread_km = 2.0;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        const char *a = argv[i];
+        if (!strcmp(a, "--wells") && more)              wells_path = argv[++i];
+        else if (!strcmp(a, "--basin") && more)         basin = argv[++i];
+        else if (!strcmp(a, "--devices") && more)       devices = parse_list(argv[++i]);
+        else if (!strcmp(a, "--gateways") && more)      gw_counts = parse_list(argv[++i]);
+        else if (!strcmp(a, "--flow-share") && more)    flow_share = atof(argv[++i]);
+        else if (!strcmp(a, "--spread-km") && more)     spread_km = atof(argv[++i]);
+        else if (!strcmp(a, "--hours") && more)         sp.hours = atof(argv[++i]);
+        else if (!strcmp(a, "--seed") && more)          seed = atoi(argv[++i]);
+        else if (!strcmp(a, "--align-s") && more)       sp.align_s = atof(argv[++i]);
+        else if (!strcmp(a, "--drift-ppm") && more)     sp.drift_ppm = atof(argv[++i]);
+        else if (!strcmp(a, "--demods") && more)        sp.demods = atoi(argv[++i]);
+        else if (!strcmp(a, "--duty-cycle") && more)    sp.duty_cycle = atof(argv[++i]);
+        else if (!strcmp(a, "--max-dwell-ms") && more)  sp.max_dwell_ms = atof(argv[++i]);
+        else if (!strcmp(a, "--pl0-db") && more)        sp.link.pl0_db = atof(argv[++i]);
+        else if (!strcmp(a, "--pl-exp") && more)        sp.link.exponent = atof(argv[++i]);
+        else if (!strcmp(a, "--shadow-db") && more)     sp.link.shadow_db = atof(argv[++i]);
+        else if (!strcmp(a, "--fade-db") && more)       sp.link.fade_db = atof(argv[++i]);
+        else if (!strcmp(a, "--capture-db") && more)    sp.link.capture_db = atof(argv[++i]);
+        else if (!strcmp(a, "--tx-ma") && more)         sp.tx_ma = atof(argv[++i]);
+        else if (!strcmp(a, "--gateway") && more) {
+            GeoPoint g;
+            if (sscanf(argv[++i], "%lf,%lf", &g.lat, &g.lon) != 2) {
+                fprintf(stderr, "--gateway wants LAT,LON\n");
+                return 2;
+            }
+            fixed_gws.push_back(g);
+        } else if (!strcmp(a, "--scheme") && more) {
+            Scheme s;
+            if (!parse_scheme(argv[++i], s)) {
+                fprintf(stderr, "bad scheme: %s\n", argv[i]);
+                return 2;
+            }
+            schemes.push_back(s);
+        } else {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return 2;
+        }
+    }
+    if (schemes.empty()) {
+        for (const char *n : { "current", "compact", "adr", "ack3", "hop8" }) {
+            Scheme s;
+            parse_scheme(n, s);
+            schemes.push_back(s);
+        }
+    }
+    if (!fixed_gws.empty()) gw_counts = { (double)fixed_gws.size() };
+
+    std::vector<GeoPoint> wells;
+    if (!load_wells(wells_path, basin, wells) || wells.empty()) {
+        fprintf(stderr, "no wells in %s%s%s\n", wells_path, basin ? " matching " : "", basin ? basin : "");
+        return 2;
+    }
+    Projection proj;
+    proj.center(wells);
+    fprintf(stderr, "%zu wells, %zu schemes\n", wells.size(), schemes.size());
+
+    printf("scheme,devices,gateways,lora_units_pct,in_range_pct,readings,delivered_pct,"
+           "lost_range_pct,lost_collision_pct,lost_demod_pct,lost_gw_tx_pct,attempts_per_reading,"
+           "dwell_violation_pct,load_erlang_per_channel,energy_mj_per_delivered,host_ms\n");
+
+    for (double nd : devices) {
+        for (double ng : gw_counts) {
+            for (const Scheme &sc : schemes) {
+                auto t_start = std::chrono::steady_clock::now();
+                // Same seed per (devices, gateways): schemes see the same fleet and layout
+                std::mt19937 rng(seed + (uint32_t)nd * 7919u + (uint32_t)ng);
+                std::vector<Unit> units = build_fleet(wells, (size_t)nd, flow_share, spread_km,
+                                                      sc, sp, proj, rng);
+                std::vector<GeoPoint> units_pos;
+                for (const Unit &u : units) units_pos.push_back(u.pos);
+                size_t oversize = 0;
+                uint32_t largest = 0, limit = 0;
+                for (const Unit &u : units) {
+                    if (u.lora) continue;
+                    oversize++;
+                    largest = std::max(largest, u.bytes);
+                    limit = u.type->lora_max_payload;
+                }
+                if (oversize) {
+                    fprintf(stderr, "%s: %zu of %zu units have a frame over LORA_MAX_PAYLOAD "
+                            "(up to %u B > %u B) and cannot use LoRa\n",
+                            sc.name.c_str(), oversize, units.size(), largest, limit);
+                }
+                std::vector<GeoPoint> gws = fixed_gws.empty()
+                    ? place_gateways(units_pos, (int)ng, proj, rng) : fixed_gws;
+
+                Simulation sim(sp, sc, units, gws, proj, seed);
+                RunResult r = sim.run();
+                double ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - t_start).count();
+
+                double rd = r.readings ? (double)r.readings : 1.0;
+                double lu = r.lora_units ? (double)r.lora_units : 1.0;
+                printf("%s,%zu,%zu,%.1f,%.1f,%llu,%.2f,%.2f,%.2f,%.2f,%.2f,%.3f,%.1f,%.4f,%.2f,%.0f\n",
+                       sc.name.c_str(), r.units, gws.size(),
+                       r.units ? 100.0 * r.lora_units / r.units : 0.0, 100.0 * r.in_range / lu,
+                       (unsigned long long)r.readings, 100.0 * r.delivered / rd,
+                       100.0 * r.lost_range / rd, 100.0 * r.lost_collision / rd,
+                       100.0 * r.lost_demod / rd, 100.0 * r.lost_gw_tx / rd,
+                       r.attempts / rd,
+                       r.attempts ? 100.0 * r.dwell_violations / r.attempts : 0.0,
+                       r.airtime_s / (sp.hours * 3600.0 * sc.channels),
+                       r.delivered ? r.energy_mj / r.delivered : 0.0, ms);
+                fflush(stdout);
+            }
+        }
+    }
+    return 0;
+}
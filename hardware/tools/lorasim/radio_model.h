@@ -0,0 +1,114 @@
+#pragma once
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "geo.h"
+
+/*
+ * Geometry and link budget for lorasim: unit / gateway positions (on top
+ * of geo.h), a log-distance path loss model with per-link shadowing, and
+ * SX1276 receiver sensitivity by spreading factor.
+ */
+
+// ── Positions ───────────────────────────────────────────
+// enterprise_wells.csv (site_code first, basin third); `basin` filters on a
+// substring of basin_subbasin_name
+inline bool load_wells(const char *path, const char *basin, std::vector<GeoPoint> &out) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        char *s = line;
+        if (!strncmp(s, "\xEF\xBB\xBF", 3)) s += 3;   // BOM
+        GeoPoint p;
+        if (!parse_site_code(s, p)) continue;
+        if (basin && *basin) {
+            const char *c1 = strchr(s, ',');
+            const char *c2 = c1 ? strchr(c1 + 1, ',') : nullptr;
+            const char *c3 = c2 ? strchr(c2 + 1, ',') : nullptr;
+            if (!c3) continue;
+            std::string name(c2 + 1, c3);
+            if (name.find(basin) == std::string::npos) continue;
+        }
+        out.push_back(p);
+    }
+    fclose(f);
+    return true;
+}
+
+// k-means++ over unit positions: where a planned deployment would put k gateways
+inline std::vector<GeoPoint> place_gateways(const std::vector<GeoPoint> &units, int k,
+                                            const Projection &proj, std::mt19937 &rng) {
+    std::vector<GeoPoint> c;
+    if (units.empty() || k <= 0) return c;
+    std::uniform_int_distribution<size_t> pick(0, units.size() - 1);
+    c.push_back(units[pick(rng)]);
+    std::vector<double> d2(units.size());
+    while ((int)c.size() < k) {
+        double total = 0;
+        for (size_t i = 0; i < units.size(); i++) {
+            double best = 1e30;
+            for (const GeoPoint &g : c) best = std::min(best, proj.dist_km(units[i], g));
+            d2[i] = best * best;
+            total += d2[i];
+        }
+        if (total <= 0) break;
+        double r = std::uniform_real_distribution<double>(0, total)(rng);
+        size_t i = 0;
+        while (i + 1 < units.size() && r > d2[i]) r -= d2[i++];
+        c.push_back(units[i]);
+    }
+    std::vector<int> owner(units.size());
+    for (int iter = 0; iter < 20; iter++) {
+        for (size_t i = 0; i < units.size(); i++) {
+            double best = 1e30;
+            for (size_t g = 0; g < c.size(); g++) {
+                double d = proj.dist_km(units[i], c[g]);
+                if (d < best) { best = d; owner[i] = (int)g; }
+            }
+        }
+        std::vector<GeoPoint> sum(c.size(), GeoPoint{ 0, 0 });
+        std::vector<int> n(c.size(), 0);
+        for (size_t i = 0; i < units.size(); i++) {
+            sum[owner[i]].lat += units[i].lat;
+            sum[owner[i]].lon += units[i].lon;
+            n[owner[i]]++;
+        }
+        for (size_t g = 0; g < c.size(); g++) {
+            if (n[g]) c[g] = { sum[g].lat / n[g], sum[g].lon / n[g] };
+        }
+    }
+    return c;
+}
+
+// ── Link Budget ─────────────────────────────────────────────
+// Rural log-distance defaults for 915 MHz, wellhead antenna ~1 m, gateway
+// on a mast; replace with drive-test fits when we have them
+struct LinkParams {
+    double pl0_db       = 110.0;   // path loss at d0
+    double d0_km        = 1.0;
+    double exponent     = 2.9;
+    double shadow_db    = 6.0;     // per-link log-normal shadowing σ
+    double fade_db      = 2.0;     // per-packet variation σ
+    double gw_gain_dbi  = 3.0;
+    double unit_gain_dbi = 0.0;
+    double capture_db   = 6.0;     // same-SF capture threshold
+};
+
+inline double path_loss_db(const LinkParams &lp, double d_km) {
+    d_km = std::max(d_km, 0.01);
+    return lp.pl0_db + 10.0 * lp.exponent * log10(d_km / lp.d0_km);
+}
+
+// SX1276 sensitivity at 125 kHz (datasheet table 13), scaled for wider bandwidths
+inline double sx1276_sensitivity_dbm(uint8_t sf, uint32_t bw_hz) {
+    static const double SENS_125K[13] = { 0, 0, 0, 0, 0, 0, -121.0,
+                                          -123.0, -126.0, -129.0, -132.0, -134.5, -137.0 };
+    if (sf < 6 || sf > 12) return 0;
+    return SENS_125K[sf] + 10.0 * log10(bw_hz / 125000.0);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdint.h>
+#include "modbus_rtu.h"
+
+/*
+ * ModbusPort over a POSIX tty — a USB RS-485 adapter on the bench, or the
+ * pseudo-terminal of the simulated slave (slave_sim.cpp).
+ */
+
+inline uint32_t host_micros() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+inline void host_delay_us(uint32_t us) {
+    timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000L };
+    nanosleep(&ts, nullptr);
+}
+
+inline speed_t tty_speed(uint32_t baud) {
+    switch (baud) {
+        case 1200:   return B1200;
+        case 2400:   return B2400;
+        case 4800:   return B4800;
+        case 9600:   return B9600;
+        case 19200:  return B19200;
+        case 38400:  return B38400;
+        case 57600:  return B57600;
+        default:     return B115200;
+    }
+}
+
+class PosixModbusPort : public ModbusPort {
+public:
+    PosixModbusPort() : fd_(-1) {}
+    ~PosixModbusPort() { if (fd_ >= 0) close(fd_); }
+
+    bool open_tty(const char *path, uint32_t baud) {
+        fd_ = open(path, O_RDWR | O_NOCTTY);
+        if (fd_ < 0) return false;
+        termios tio;
+        if (tcgetattr(fd_, &tio) == 0) {
+            cfmakeraw(&tio);
+            tio.c_cflag |= PARENB | CLOCAL | CREAD;   // 8E1
+            tio.c_cflag &= ~(PARODD | CSTOPB);
+            cfsetispeed(&tio, tty_speed(baud));
+            cfsetospeed(&tio, tty_speed(baud));
+            tcsetattr(fd_, TCSANOW, &tio);
+        }
+        return true;
+    }
+
+    size_t write(const uint8_t *buf, size_t len) override {
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = ::write(fd_, buf + done, len - done);
+            if (n <= 0) break;
+            done += (size_t)n;
+        }
+        return done;
+    }
+
+    size_t read(uint8_t *buf, size_t len, uint32_t timeout_ms) override {
+        size_t got = 0;
+        uint32_t start = host_micros();
+        while (got < len) {
+            uint32_t elapsed_ms = (host_micros() - start) / 1000;
+            if (elapsed_ms >= timeout_ms) break;
+            pollfd pfd = { fd_, POLLIN, 0 };
+            if (poll(&pfd, 1, (int)(timeout_ms - elapsed_ms)) <= 0) break;
+            ssize_t n = ::read(fd_, buf + got, len - got);
+            if (n <= 0) break;
+            got += (size_t)n;
+        }
+        return got;
+    }
+
+    void discard_input() override { tcflush(fd_, TCIFLUSH); }
+    uint32_t micros_now() override { return host_micros(); }
+    void delay_us(uint32_t us) override { host_delay_us(us); }
+
+private:
+    int fd_;
+};
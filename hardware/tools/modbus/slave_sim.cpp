@@ -0,0 +1,198 @@
+/*
+ * Simulated Modbus RTU slaves on a pseudo-terminal.
+ *
+ * Opens a pty, prints the slave-side path, and answers read requests for
+ * one or more simulated sondes so ModbusMaster can be exercised without
+ * RS-485 hardware. Wire time at the configured baud, slave turnaround,
+ * dropped responses and corrupted CRCs can be injected.
+ *
+ * Usage:
+ *   modbus-sim [--slave ADDR:level|ctd]... [--baud 19200]
+ *              [--turnaround-ms 5] [--drop 0.0] [--crc-error 0.0] [--seed 1]
+ *
+ * Register maps (match the examples in the firmware config.h files):
+ *   level  holding 0-1  F32  pressure, PSI
+ *          holding 2-3  F32  temperature, °C
+ *   ctd    input   0    S16  conductivity, µS/cm
+ *          input   1    S16  temperature, 0.01 °C
+ *          input   2-3  F32 (CDAB)  pressure, PSI
+ */
+
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "modbus_rtu.h"
+#include "posix_port.h"
+
+struct SimSlave {
+    uint8_t     addr;
+    std::string model;
+};
+
+struct SimOptions {
+    std::vector<SimSlave> slaves;
+    uint32_t baud          = 19200;
+    uint32_t turnaround_ms = 5;
+    double   drop          = 0.0;
+    double   crc_error     = 0.0;
+    uint32_t seed          = 1;
+};
+
+static void put_u16(uint16_t *regs, uint16_t v) { regs[0] = v; }
+
+static void put_f32(uint16_t *regs, float v, bool swap) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    uint16_t hi = bits >> 16, lo = bits & 0xFFFF;
+    regs[0] = swap ? lo : hi;
+    regs[1] = swap ? hi : lo;
+}
+
+// Fill the register image of one slave at simulated time t (seconds).
+// Returns the number of valid registers for the function, 0 if unsupported.
+static size_t fill_registers(const SimSlave &s, uint8_t func, double t, uint16_t *regs) {
+    double drift = sin(t / 600.0);
+    if (s.model == "level" && func == MB_READ_HOLDING) {
+        put_f32(regs + 0, (float)(6.5 + 0.2 * drift), false);
+        put_f32(regs + 2, (float)(17.8 + 0.1 * drift), false);
+        return 4;
+    }
+    if (s.model == "ctd" && func == MB_READ_INPUT) {
+        put_u16(regs + 0, (uint16_t)(int16_t)(850 + 25 * drift));
+        put_u16(regs + 1, (uint16_t)(int16_t)(1790 + 10 * drift));
+        put_f32(regs + 2, (float)(12.1 + 0.3 * drift), true);
+        return 4;
+    }
+    return 0;
+}
+
+static size_t build_response(const SimOptions &opt, const uint8_t *req, double t,
+                             uint8_t *out) {
+    const SimSlave *slave = nullptr;
+    for (const SimSlave &s : opt.slaves) {
+        if (s.addr == req[0]) slave = &s;
+    }
+    if (!slave) return 0;    // no such device: stay silent like a real bus
+
+    uint8_t  func  = req[1];
+    uint16_t start = (uint16_t)(req[2] << 8 | req[3]);
+    uint16_t count = (uint16_t)(req[4] << 8 | req[5]);
+    uint16_t regs[64] = {};
+    size_t   nregs = 0;
+    uint8_t  exception = 0;
+
+    if (func != MB_READ_HOLDING && func != MB_READ_INPUT) {
+        exception = 0x01;    // illegal function
+    } else {
+        nregs = fill_registers(*slave, func, t, regs);
+        if (nregs == 0) exception = 0x01;
+        else if (count == 0 || start + count > nregs) exception = 0x02;  // illegal address
+    }
+
+    size_t n = 0;
+    out[n++] = req[0];
+    if (exception) {
+        out[n++] = func | 0x80;
+        out[n++] = exception;
+    } else {
+        out[n++] = func;
+        out[n++] = (uint8_t)(count * 2);
+        for (uint16_t i = 0; i < count; i++) {
+            out[n++] = regs[start + i] >> 8;
+            out[n++] = regs[start + i] & 0xFF;
+        }
+    }
+    uint16_t crc = modbus_crc16(out, n);
+    out[n++] = crc & 0xFF;
+    out[n++] = crc >> 8;
+    return n;
+}
+
+static bool parse_args(int argc, char **argv, SimOptions &opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (a == "--slave" && v) {
+            std::string s = v;
+            size_t colon = s.find(':');
+            if (colon == std::string::npos) return false;
+            opt.slaves.push_back({ (uint8_t)atoi(s.substr(0, colon).c_str()),
+                                   s.substr(colon + 1) });
+            i++;
+        } else if (a == "--baud" && v)          { opt.baud = (uint32_t)atoi(v); i++; }
+        else if (a == "--turnaround-ms" && v)   { opt.turnaround_ms = (uint32_t)atoi(v); i++; }
+        else if (a == "--drop" && v)            { opt.drop = atof(v); i++; }
+        else if (a == "--crc-error" && v)       { opt.crc_error = atof(v); i++; }
+        else if (a == "--seed" && v)            { opt.seed = (uint32_t)atoi(v); i++; }
+        else return false;
+    }
+    if (opt.slaves.empty()) {
+        opt.slaves.push_back({ 1, "level" });
+        opt.slaves.push_back({ 2, "ctd" });
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    SimOptions opt;
+    if (!parse_args(argc, argv, opt)) {
+        fprintf(stderr, "usage: %s [--slave ADDR:level|ctd]... [--baud N] "
+                        "[--turnaround-ms N] [--drop P] [--crc-error P] [--seed N]\n", argv[0]);
+        return 2;
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("pty");
+        return 1;
+    }
+    termios tio;
+    tcgetattr(master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(master, TCSANOW, &tio);
+
+    printf("%s\n", ptsname(master));
+    for (const SimSlave &s : opt.slaves) {
+        printf("  slave %u: %s\n", s.addr, s.model.c_str());
+    }
+    fflush(stdout);
+
+    std::mt19937 rng(opt.seed);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    uint32_t t35_ms = modbus_t35_us(opt.baud) / 1000 + 1;
+    uint32_t char_us = modbus_char_us(opt.baud);
+    uint32_t t0 = host_micros();
+
+    uint8_t  frame[MODBUS_MAX_FRAME];
+    size_t   len = 0;
+    for (;;) {
+        pollfd pfd = { master, POLLIN, 0 };
+        int r = poll(&pfd, 1, len ? (int)t35_ms : -1);
+        if (r > 0) {
+            ssize_t n = read(master, frame + len, sizeof(frame) - len);
+            if (n > 0) len += (size_t)n;
+            else if (n < 0) host_delay_us(100000);   // no client attached yet
+            if (len < sizeof(frame)) continue;
+        }
+        // Silent interval elapsed: one complete request frame in the buffer
+        if (len == 8 && modbus_crc16(frame, 6) == (uint16_t)(frame[6] | frame[7] << 8)) {
+            uint8_t resp[MODBUS_MAX_FRAME + 8];
+            double t = (host_micros() - t0) / 1e6;
+            size_t n = build_response(opt, frame, t, resp);
+            if (n > 0 && uni(rng) >= opt.drop) {
+                if (uni(rng) < opt.crc_error) resp[n - 1] ^= 0x5A;
+                host_delay_us(opt.turnaround_ms * 1000 + (uint32_t)n * char_us);
+                if (write(master, resp, n) != (ssize_t)n) perror("write");
+            }
+        }
+        len = 0;
+    }
+}
@@ -0,0 +1,314 @@
+/*
+ * Batch re-analysis of uploaded WX-Flow heat-pulse traces.
+ *
+ * When the flow estimation changes, every trace the fleet has uploaded can
+ * be run again through it: trace files and archives (GET /hardware/traces,
+ * trace files back to back) are indexed, then each trace is loaded and run
+ * through the selected estimators on a work-stealing pool across all
+ * cores. Results go to a CSV for POST /hardware/reanalysis, one row per
+ * trace and estimator, tagged with the estimator's version so rows from
+ * different revisions can sit side by side.
+ *
+ * Estimators (--estimators, comma separated):
+ *   pulse   run_heat_pulse() on the replayed trace, exactly as the unit
+ *           runs it, less the ThermalHistory correction (its state is not
+ *           in the trace)
+ *   interp  the same scans, smoothed over three and with the peak and its
+ *           time interpolated between scans by a parabola, so time-to-peak
+ *           is not quantised to FLOW_SAMPLE_MS at fast flow
+ * Both report through analyze_heat_pulse(); --cal-k replaces FLOW_CAL_K.
+ *
+ * Usage:
+ *   reanalyze --out reanalysis.csv archive/
+ *   reanalyze --estimators interp --cal-k 870 --threads 16 --out r.csv fleet.bin
+ *   reanalyze --repeat 2000 replay/corpus         (throughput only)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "hal_native.h"
+#include "heat_pulse.h"
+#include "../replay/trace_file.h"
+#include "work_pool.h"
+
+typedef std::chrono::steady_clock Clock;
+
+#define BASELINE_SCANS  10      // read_baseline()
+
+static const uint8_t THERM_CH[4] = { CH_THERM_N, CH_THERM_E, CH_THERM_S, CH_THERM_W };
+
+// Returns false when the trace does not line up with the estimator
+typedef bool (*EstimateFn)(const TraceFile &t, float cal_k, FlowResult &out);
+
+struct Estimator {
+    const char *name;
+    int         version;        // bump when the estimator's output changes
+    EstimateFn  run;
+};
+
+// ── Estimators ──────────────────────────────────────────────
+
+static bool estimate_pulse(const TraceFile &t, float cal_k, FlowResult &out) {
+    VirtualClock  clock;
+    ReplayAdc     therm(clock, t.samples, TRACE_ADC_THERM);
+    RecordingGpio gpio(clock);
+    out = run_heat_pulse(therm, clock, gpio);
+    out.velocity_cm_day *= cal_k / FLOW_CAL_K;          // v = K / t
+    return !therm.mismatches && !therm.underruns;
+}
+
+static bool estimate_interp(const TraceFile &t, float cal_k, FlowResult &out) {
+    static const int MAX_SCANS = BASELINE_SCANS + ThermTimeSeries::MAX_SAMPLES;
+    float    temp[4][MAX_SCANS];
+    uint32_t t_us[MAX_SCANS];
+    int      scans = 0, k = 0;
+    bool     in_sync = true;
+
+    for (const AdcTraceSample &s : t.samples) {
+        if (s.adc != TRACE_ADC_THERM) continue;
+        if (scans == MAX_SCANS) {
+            in_sync = false;
+            break;
+        }
+        if (s.channel != THERM_CH[k]) in_sync = false;
+        if (k == 3) t_us[scans] = s.t_us;        // as run_heat_pulse() times a scan
+        temp[k][scans] = therm_code_to_temp(s.code);
+        if (++k == 4) {
+            k = 0;
+            scans++;
+        }
+    }
+    if (k || scans < BASELINE_SCANS + 3) in_sync = false;
+
+    float peak_dt[4] = {0, 0, 0, 0}, peak_time[4] = {0, 0, 0, 0};
+    int   n = scans - BASELINE_SCANS;
+    if (in_sync) {
+        const uint32_t t0 = t_us[BASELINE_SCANS];
+        for (int j = 0; j < 4; j++) {
+            float base = 0;
+            for (int i = 0; i < BASELINE_SCANS; i++) base += temp[j][i];
+            base /= BASELINE_SCANS;
+
+            const float *y = temp[j] + BASELINE_SCANS;
+            float sm[ThermTimeSeries::MAX_SAMPLES];
+            sm[0] = y[0] - base;
+            sm[n - 1] = y[n - 1] - base;
+            for (int i = 1; i < n - 1; i++) sm[i] = (y[i - 1] + y[i] + y[i + 1]) / 3 - base;
+
+            int m = 0;
+            for (int i = 1; i < n; i++) if (sm[i] > sm[m]) m = i;
+            float dt = sm[m], at = (t_us[BASELINE_SCANS + m] - t0) / 1e6f;
+            if (m > 0 && m < n - 1) {
+                float a = sm[m - 1], b = sm[m], c = sm[m + 1];
+                float den = a - 2 * b + c;
+                if (den < 0) {
+                    float d = 0.5f * (a - c) / den;             // vertex, in scans
+                    float half = (t_us[BASELINE_SCANS + m + 1] - t_us[BASELINE_SCANS + m - 1]) / 2e6f;
+                    dt = b - 0.25f * (a - c) * d;
+                    at += d * half;
+                }
+            }
+            if (dt > 0) {
+                peak_dt[j] = dt;
+                peak_time[j] = at;
+            }
+        }
+    }
+    out = analyze_heat_pulse(peak_dt, peak_time, cal_k);
+    return in_sync;
+}
+
+static const Estimator ESTIMATORS[] = {
+    { "pulse",  1, estimate_pulse },
+    { "interp", 1, estimate_interp },
+};
+
+// ── Batch ───────────────────────────────────────────────────
+
+struct TraceRef {
+    uint32_t file;
+    long     offset;
+};
+
+struct ResultRow {
+    std::string device_id;
+    uint32_t    boot_count;
+    uint8_t     estimator;      // index into ESTIMATORS
+    uint32_t    dropped;
+    bool        desync;
+    FlowResult  flow;
+};
+
+// Per worker; results are merged once the pool is done
+struct WorkerState {
+    FILE                  *f = nullptr;
+    uint32_t               file = UINT32_MAX;
+    TraceFile              trace;
+    std::vector<ResultRow> rows;
+    uint64_t               traces = 0, skipped = 0, failed = 0, desync = 0;
+};
+
+static bool write_results(const char *path, const std::vector<ResultRow> &rows, float cal_k) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "device_id,boot_count,estimator,version,cal_k,velocity_cm_day,direction_deg,"
+               "peak_dt_n,peak_dt_e,peak_dt_s,peak_dt_w,"
+               "peak_t_n,peak_t_e,peak_t_s,peak_t_w,valid,desync,dropped\n");
+    for (const ResultRow &r : rows) {
+        const Estimator &e = ESTIMATORS[r.estimator];
+        fprintf(f, "%s,%u,%s,%d,%g,%.6g,%.6g", r.device_id.c_str(), r.boot_count, e.name,
+                e.version, cal_k, r.flow.velocity_cm_day, r.flow.direction_deg);
+        for (int j = 0; j < 4; j++) fprintf(f, ",%.6g", r.flow.peak_temps[j]);
+        for (int j = 0; j < 4; j++) fprintf(f, ",%.6g", r.flow.peak_times[j]);
+        fprintf(f, ",%d,%d,%u\n", r.flow.valid, r.desync, r.dropped);
+    }
+    return fclose(f) == 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--estimators pulse,interp] [--cal-k K] [--threads N] [--grain N]\n"
+                    "       [--repeat N] [--out FILE] TRACE|ARCHIVE|DIR...\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = nullptr;
+    std::string estimator_list = "pulse,interp";
+    float cal_k = FLOW_CAL_K;
+    unsigned threads = 0, repeat = 1;
+    size_t grain = 64;
+    std::vector<std::string> args;
+
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        const char *a = argv[i];
+        if (!strcmp(a, "--estimators") && more)    estimator_list = argv[++i];
+        else if (!strcmp(a, "--cal-k") && more)    cal_k = atof(argv[++i]);
+        else if (!strcmp(a, "--threads") && more)  threads = atoi(argv[++i]);
+        else if (!strcmp(a, "--grain") && more)    grain = atoi(argv[++i]);
+        else if (!strcmp(a, "--repeat") && more)   repeat = atoi(argv[++i]);
+        else if (!strcmp(a, "--out") && more)      out_path = argv[++i];
+        else if (a[0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            args.push_back(a);
+        }
+    }
+
+    std::vector<uint8_t> selected;
+    for (size_t p = 0; p <= estimator_list.size();) {
+        size_t q = estimator_list.find(',', p);
+        if (q == std::string::npos) q = estimator_list.size();
+        std::string name = estimator_list.substr(p, q - p);
+        size_t k = 0;
+        while (k < sizeof(ESTIMATORS) / sizeof(ESTIMATORS[0]) && name != ESTIMATORS[k].name) k++;
+        if (k == sizeof(ESTIMATORS) / sizeof(ESTIMATORS[0])) {
+            fprintf(stderr, "unknown estimator: %s\n", name.c_str());
+            return 2;
+        }
+        selected.push_back(k);
+        p = q + 1;
+    }
+    if (args.empty() || cal_k <= 0 || !repeat) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // ── Index ──
+    Clock::time_point t0 = Clock::now();
+    std::vector<std::string> files = expand_trace_paths(args);
+    std::vector<TraceRef> refs;
+    uint32_t bad_files = 0;
+    for (uint32_t i = 0; i < files.size(); i++) {
+        std::vector<long> offsets;
+        if (!index_trace_archive(files[i].c_str(), offsets)) {
+            fprintf(stderr, "%s: unreadable or truncated archive\n", files[i].c_str());
+            bad_files++;
+        }
+        for (long off : offsets) refs.push_back({ i, off });
+    }
+    double index_s = std::chrono::duration<double>(Clock::now() - t0).count();
+    if (refs.empty()) {
+        fprintf(stderr, "no traces\n");
+        return 1;
+    }
+
+    // ── Analyze ──
+    WorkPool pool(threads);
+    std::vector<WorkerState> state(pool.threads());
+    Clock::time_point t1 = Clock::now();
+    WorkStats stats = pool.run(refs.size() * repeat, grain, [&](unsigned w, size_t i) {
+        WorkerState &ws = state[w];
+        const TraceRef &ref = refs[i % refs.size()];
+        if (ws.file != ref.file) {
+            if (ws.f) fclose(ws.f);
+            ws.f = fopen(files[ref.file].c_str(), "rb");
+            ws.file = ref.file;
+        }
+        if (!ws.f || fseek(ws.f, ref.offset, SEEK_SET) || !read_trace(ws.f, ws.trace)) {
+            ws.failed++;
+            return;
+        }
+        if (strcmp(ws.trace.header.device_type, "wx-flow")) {
+            ws.skipped++;
+            return;
+        }
+        ws.traces++;
+        bool record = i < refs.size();
+        bool desync = false;
+        for (uint8_t k : selected) {
+            ResultRow r;
+            r.desync = !ESTIMATORS[k].run(ws.trace, cal_k, r.flow);
+            desync |= r.desync;
+            if (!record) continue;
+            r.device_id.assign(ws.trace.header.device_id,
+                               strnlen(ws.trace.header.device_id, sizeof(ws.trace.header.device_id)));
+            r.boot_count = ws.trace.header.boot_count;
+            r.estimator  = k;
+            r.dropped    = ws.trace.header.dropped;
+            ws.rows.push_back(r);
+        }
+        if (desync) ws.desync++;
+    });
+    double run_s = std::chrono::duration<double>(Clock::now() - t1).count();
+
+    uint64_t traces = 0, skipped = 0, failed = 0, desync = 0;
+    std::vector<ResultRow> rows;
+    for (WorkerState &ws : state) {
+        if (ws.f) fclose(ws.f);
+        traces += ws.traces;
+        skipped += ws.skipped;
+        failed += ws.failed;
+        desync += ws.desync;
+        rows.insert(rows.end(), ws.rows.begin(), ws.rows.end());
+    }
+
+    printf("%zu files, %zu traces indexed in %.3f s\n", files.size(), refs.size(), index_s);
+    printf("%llu traces x %zu estimators in %.3f s on %u threads (%llu steals): %.0f traces/s\n",
+           (unsigned long long)traces, selected.size(), run_s, stats.threads,
+           (unsigned long long)stats.steals, run_s > 0 ? traces / run_s : 0.0);
+    if (skipped || failed || desync) {
+        printf("%llu skipped (not wx-flow), %llu failed to load, %llu desynced\n",
+               (unsigned long long)skipped, (unsigned long long)failed,
+               (unsigned long long)desync);
+    }
+
+    if (out_path) {
+        std::sort(rows.begin(), rows.end(), [](const ResultRow &a, const ResultRow &b) {
+            if (a.device_id != b.device_id) return a.device_id < b.device_id;
+            if (a.boot_count != b.boot_count) return a.boot_count < b.boot_count;
+            return a.estimator < b.estimator;
+        });
+        if (!write_results(out_path, rows, cal_k)) {
+            perror(out_path);
+            return 1;
+        }
+        printf("results written: %s (%zu rows)\n", out_path, rows.size());
+    }
+    return failed || bad_files ? 1 : 0;
+}
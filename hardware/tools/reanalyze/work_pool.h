@@ -0,0 +1,115 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Work-stealing parallel loop over [0, n).
+ *
+ * Each worker owns a contiguous share of the index range and takes grain
+ * items at a time from its front, so neighbouring items (traces of one
+ * archive) stay on one thread. A worker that runs dry steals the back half
+ * of the largest share left, so a few slow items do not leave the other
+ * cores idle at the end. No items are added during a run: once every
+ * share is empty the loop is done.
+ */
+
+struct WorkStats {
+    unsigned threads = 0;
+    uint64_t steals  = 0;
+};
+
+class WorkPool {
+public:
+    // fn(worker, i); workers are numbered 0..threads-1
+    typedef std::function<void(unsigned, size_t)> Fn;
+
+    explicit WorkPool(unsigned threads)
+        : threads_(threads ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+    unsigned threads() const { return threads_; }
+
+    WorkStats run(size_t n, size_t grain, const Fn &fn) {
+        if (!grain) grain = 1;
+        std::vector<std::unique_ptr<Share>> shares;
+        for (unsigned w = 0; w < threads_; w++) {
+            shares.emplace_back(new Share);
+            shares[w]->begin = n * w / threads_;
+            shares[w]->end   = n * (w + 1) / threads_;
+        }
+        std::atomic<uint64_t> steals(0);
+        auto worker = [&](unsigned w) {
+            Share &own = *shares[w];
+            for (;;) {
+                size_t b, e;
+                {
+                    std::lock_guard<std::mutex> lock(own.mu);
+                    b = own.begin;
+                    e = std::min(own.end, b + grain);
+                    own.begin = e;
+                }
+                if (b < e) {
+                    for (size_t i = b; i < e; i++) fn(w, i);
+                    continue;
+                }
+                if (!steal(shares, w)) return;
+                steals++;
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned w = 1; w < threads_; w++) pool.emplace_back(worker, w);
+        worker(0);
+        for (std::thread &t : pool) t.join();
+
+        WorkStats s;
+        s.threads = threads_;
+        s.steals  = steals;
+        return s;
+    }
+
+private:
+    struct Share {
+        std::mutex mu;
+        size_t     begin = 0, end = 0;
+    };
+
+    // Moves the back half of the largest other share to worker w's;
+    // false when there is nothing left anywhere
+    static bool steal(std::vector<std::unique_ptr<Share>> &shares, unsigned w) {
+        for (;;) {
+            size_t best = 0, victim = shares.size();
+            for (size_t v = 0; v < shares.size(); v++) {
+                if (v == w) continue;
+                std::lock_guard<std::mutex> lock(shares[v]->mu);
+                size_t left = shares[v]->end - shares[v]->begin;
+                if (left > best) {
+                    best = left;
+                    victim = v;
+                }
+            }
+            if (victim == shares.size()) return false;
+
+            size_t b, e;
+            {
+                std::lock_guard<std::mutex> lock(shares[victim]->mu);
+                Share &s = *shares[victim];
+                if (s.begin >= s.end) continue;       // emptied since the scan
+                e = s.end;
+                b = s.end - (s.end - s.begin + 1) / 2;
+                s.end = b;
+            }
+            std::lock_guard<std::mutex> lock(shares[w]->mu);
+            shares[w]->begin = b;
+            shares[w]->end   = e;
+            return true;
+        }
+    }
+
+    unsigned threads_;
+};
@@ -0,0 +1,37 @@
+/*
+ * WX-Flow trace replay — runs recorded ADC traces back through the
+ * firmware's run_heat_pulse() and analog sensor block on virtual time.
+ *
+ * Usage:
+ *   replay-flow [--baseline replay/corpus/flow_baseline.csv] [--update] replay/corpus
+ */
+
+#include "hal_native.h"
+#include "heat_pulse.h"
+#include "reading.h"
+#include "trace_file.h"
+
+static void replay_flow(const TraceFile &t, std::vector<double> &m, ReplayCheck &check) {
+    VirtualClock  clock;
+    ReplayAdc     therm(clock, t.samples, TRACE_ADC_THERM);
+    ReplayAdc     sensors(clock, t.samples, TRACE_ADC_SENSORS);
+    RecordingGpio gpio(clock);
+
+    FullReading r = {};
+    r.flow = run_heat_pulse(therm, clock, gpio);
+    read_analog_sensors(r, sensors);
+
+    m = { r.flow.velocity_cm_day, r.flow.direction_deg,
+          r.flow.peak_temps[0], r.flow.peak_temps[1], r.flow.peak_temps[2], r.flow.peak_temps[3],
+          r.water_level_ft, r.conductivity_us, r.water_temp_c };
+    check.mismatches = therm.mismatches + sensors.mismatches;
+    check.underruns  = therm.underruns + sensors.underruns;
+}
+
+int main(int argc, char **argv) {
+    return replay_main(argc, argv, "wx-flow",
+                       { "velocity_cm_day", "direction_deg", "peak_dt_n", "peak_dt_e",
+                         "peak_dt_s", "peak_dt_w", "water_level_ft", "conductivity_us",
+                         "water_temp_c" },
+                       replay_flow);
+}
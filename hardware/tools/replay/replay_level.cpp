@@ -0,0 +1,103 @@
+/*
+ * WX-Level trace replay — runs recorded ADC traces back through the
+ * firmware's pipelined well conversions and barometric compensation. The
+ * BME280 inputs come from the trace header (aux[0..2]).
+ *
+ * Usage:
+ *   replay-level [--baseline replay/corpus/level_baseline.csv] [--update] replay/corpus
+ *   replay-level --record FILE.bin --psi 4.2[,...] [--baro 1009.7,24.3,41.8]
+ *
+ * --record runs one cycle whose transducers read the given pressures (one
+ * per analog well) through the firmware's conversions and writes it in
+ * the AdcTrace format, to seed the corpus until field traces arrive.
+ */
+
+#include <string>
+#include "adc_trace.h"
+#include "hal_native.h"
+#include "reading.h"
+#include "trace_file.h"
+
+static void replay_level(const TraceFile &t, std::vector<double> &m, ReplayCheck &check) {
+    VirtualClock clock;
+    ReplayAdc    adc(clock, t.samples, TRACE_ADC_LEVEL);
+
+    SensorReading r = {};
+    float psi[WELL_CHANNEL_COUNT];
+    well_conversions_begin(adc);
+    well_conversions_finish(adc, clock, psi);
+
+    r.baro_pressure_hpa = t.header.aux[0];
+    r.baro_temp_c       = t.header.aux[1];
+    r.humidity_pct      = t.header.aux[2];
+    r.water_temp_c      = r.baro_temp_c;
+    fill_well_levels(r, psi);
+
+    m.clear();
+    for (int i = 0; i < WELL_CHANNEL_COUNT; i++) {
+        m.push_back(r.wells[i].pressure_psi);
+        m.push_back(r.wells[i].water_level_ft);
+    }
+    check.mismatches = adc.mismatches;
+    check.underruns  = adc.underruns;
+}
+
+// ADS1115 code for psi on channel ch (inverse of pressure_psi_from_raw)
+static int16_t code_for_psi(const WellChannel &ch, float psi) {
+    float v = ch.v_min + (psi - ch.psi_min) * (ch.v_max - ch.v_min) / (ch.psi_max - ch.psi_min);
+    return (int16_t)lroundf(v / 0.000125f);
+}
+
+static int record_level(const char *path, const char *psi_list, const char *baro) {
+    int16_t codes[8] = {};
+    const char *p = psi_list;
+    for (int i = 0; i < WELL_CHANNEL_COUNT && p; i++) {
+        codes[WELL_CFG[i].ads_channel] = code_for_psi(WELL_CFG[i], strtof(p, nullptr));
+        p = strchr(p, ',');
+        if (p) p++;
+    }
+
+    VirtualClock clock;
+    ScriptedAdc  adc(clock, [&](uint8_t ch, uint64_t) { return codes[ch & 7]; });
+    static AdcTraceSample samples[64];
+    AdcTrace trace(samples, 64);
+    trace.begin(clock, "wx-level", "SIM", 0);
+    if (sscanf(baro, "%f,%f,%f", &trace.header.aux[0], &trace.header.aux[1],
+               &trace.header.aux[2]) != 3) {
+        fprintf(stderr, "--baro wants hPa,degC,RH\n");
+        return 2;
+    }
+    RecordingAdc rec(adc, trace, TRACE_ADC_LEVEL);
+    float psi[WELL_CHANNEL_COUNT];
+    well_conversions_begin(rec);
+    well_conversions_finish(rec, clock, psi);
+    if (!save_trace(path, trace)) {
+        perror(path);
+        return 1;
+    }
+    printf("%s: %u conversions\n", path, trace.header.count);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 2 && !strcmp(argv[1], "--record")) {
+        const char *psi = nullptr, *baro = "1013.25,20,50";
+        for (int i = 3; i + 1 < argc; i += 2) {
+            if (!strcmp(argv[i], "--psi"))       psi = argv[i + 1];
+            else if (!strcmp(argv[i], "--baro")) baro = argv[i + 1];
+        }
+        if (!psi) {
+            fprintf(stderr, "usage: %s --record FILE.bin --psi P[,...] [--baro hPa,degC,RH]\n",
+                    argv[0]);
+            return 2;
+        }
+        return record_level(argv[2], psi, baro);
+    }
+
+    std::vector<std::string> metrics;
+    for (int i = 0; i < WELL_CHANNEL_COUNT; i++) {
+        metrics.push_back("well" + std::to_string(i) + "_psi");
+        metrics.push_back("well" + std::to_string(i) + "_ft");
+    }
+    return replay_main(argc, argv, "wx-level", metrics, replay_level);
+}
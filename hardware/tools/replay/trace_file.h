@@ -0,0 +1,252 @@
+#pragma once
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "adc_trace.h"
+#include "microbench.h"
+
+/*
+ * Shared corpus driver for the replay tools: loads AdcTrace files,
+ * replays each through a firmware-specific function, and compares the
+ * outputs and host cost against a baseline CSV
+ * (trace,<metric>...,ns_per_replay).
+ */
+
+struct TraceFile {
+    std::string                 name;
+    AdcTraceHeader              header;
+    std::vector<AdcTraceSample> samples;
+};
+
+// Reads the trace at the current position of f into out (name untouched)
+inline bool read_trace(FILE *f, TraceFile &out) {
+    if (fread(&out.header, sizeof(out.header), 1, f) != 1
+        || out.header.magic != ADC_TRACE_MAGIC
+        || out.header.version != ADC_TRACE_VERSION
+        || out.header.sample_size != sizeof(AdcTraceSample)) {
+        return false;
+    }
+    out.samples.resize(out.header.count);
+    return fread(out.samples.data(), sizeof(AdcTraceSample), out.header.count, f)
+           == out.header.count;
+}
+
+inline bool load_trace(const char *path, TraceFile &out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    bool ok = read_trace(f, out);
+    fclose(f);
+    const char *slash = strrchr(path, '/');
+    out.name = slash ? slash + 1 : path;
+    return ok;
+}
+
+/*
+ * A trace archive is trace files back to back (GET /hardware/traces); a
+ * single trace file is an archive of one. Appends the byte offset of each
+ * trace in path to offsets, reading headers only; false if the file does
+ * not open or ends in a partial or foreign record.
+ */
+inline bool index_trace_archive(const char *path, std::vector<long> &offsets) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    AdcTraceHeader h;
+    long off = 0;
+    while (off < size) {
+        if (fseek(f, off, SEEK_SET) || fread(&h, sizeof(h), 1, f) != 1
+            || h.magic != ADC_TRACE_MAGIC || h.sample_size != sizeof(AdcTraceSample)) {
+            break;
+        }
+        offsets.push_back(off);
+        off += sizeof(h) + (long)h.count * sizeof(AdcTraceSample);
+    }
+    fclose(f);
+    if (off > size) offsets.pop_back();     // truncated
+    return off == size;
+}
+
+inline bool save_trace(const char *path, const AdcTrace &trace) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(&trace.header, sizeof(trace.header), 1, f) == 1
+           && fwrite(trace.samples(), sizeof(AdcTraceSample), trace.header.count, f)
+              == trace.header.count;
+    fclose(f);
+    return ok;
+}
+
+// Trace files named on the command line; directories expand to their *.bin
+inline std::vector<std::string> expand_trace_paths(const std::vector<std::string> &args) {
+    std::vector<std::string> out;
+    for (const std::string &a : args) {
+        DIR *d = opendir(a.c_str());
+        if (!d) {
+            out.push_back(a);
+            continue;
+        }
+        std::vector<std::string> found;
+        while (struct dirent *e = readdir(d)) {
+            size_t n = strlen(e->d_name);
+            if (n > 4 && !strcmp(e->d_name + n - 4, ".bin")) found.push_back(a + "/" + e->d_name);
+        }
+        closedir(d);
+        std::sort(found.begin(), found.end());
+        out.insert(out.end(), found.begin(), found.end());
+    }
+    return out;
+}
+
+typedef std::map<std::string, std::vector<double>> BaselineRows;
+
+inline bool load_baseline(const char *path, size_t n_cols, BaselineRows &rows) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[1024];
+    bool header = true;
+    while (fgets(line, sizeof(line), f)) {
+        if (header) {
+            header = false;
+            continue;
+        }
+        char *p = strchr(line, ',');
+        if (!p) continue;
+        std::string name(line, p - line);
+        std::vector<double> v;
+        while (p && v.size() < n_cols) {
+            v.push_back(strtod(p + 1, nullptr));
+            p = strchr(p + 1, ',');
+        }
+        if (v.size() == n_cols) rows[name] = v;
+    }
+    fclose(f);
+    return true;
+}
+
+inline bool write_baseline(const char *path, const std::vector<std::string> &cols,
+                           const BaselineRows &rows, const char *key = "trace") {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "%s", key);
+    for (const std::string &c : cols) fprintf(f, ",%s", c.c_str());
+    fprintf(f, "\n");
+    for (const auto &r : rows) {
+        fprintf(f, "%s", r.first.c_str());
+        for (double v : r.second) fprintf(f, ",%.6g", v);
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return true;
+}
+
+struct ReplayCheck {
+    uint32_t mismatches = 0;    // channel order differs from the recording
+    uint32_t underruns  = 0;    // code asked for more conversions than recorded
+};
+
+// Replays one trace: fills metrics (same order as the metric names)
+typedef std::function<void(const TraceFile &, std::vector<double> &, ReplayCheck &)> ReplayFn;
+
+/*
+ * replay-<device> [--baseline FILE] [--update] [--slower 1.25] TRACE|DIR...
+ *
+ * Prints each trace's outputs and host ns/replay. Outputs that moved from
+ * the baseline, or traces that no longer line up with the code's
+ * conversion sequence, fail the run. Host time is reported against the
+ * baseline and only flagged. --update rewrites the baseline.
+ */
+inline int replay_main(int argc, char **argv, const char *device_type,
+                       const std::vector<std::string> &metrics, ReplayFn replay) {
+    const char *baseline_path = nullptr;
+    bool update = false;
+    double slower = 1.25;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--baseline") && i + 1 < argc)     baseline_path = argv[++i];
+        else if (!strcmp(argv[i], "--update"))                  update = true;
+        else if (!strcmp(argv[i], "--slower") && i + 1 < argc)  slower = atof(argv[++i]);
+        else args.push_back(argv[i]);
+    }
+    if (args.empty()) {
+        fprintf(stderr, "usage: %s [--baseline FILE] [--update] [--slower X] TRACE|DIR...\n",
+                argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> cols = metrics;
+    cols.push_back("ns_per_replay");
+    BaselineRows baseline, fresh;
+    if (baseline_path && !update && !load_baseline(baseline_path, cols.size(), baseline)) {
+        fprintf(stderr, "cannot read baseline %s\n", baseline_path);
+        return 2;
+    }
+
+    int failures = 0;
+    for (const std::string &path : expand_trace_paths(args)) {
+        TraceFile t;
+        if (!load_trace(path.c_str(), t)) {
+            printf("%-28s LOAD FAILED\n", path.c_str());
+            failures++;
+            continue;
+        }
+        if (strcmp(t.header.device_type, device_type)) {
+            printf("%-28s skipped (%s trace)\n", t.name.c_str(), t.header.device_type);
+            continue;
+        }
+
+        std::vector<double> m;
+        ReplayCheck check;
+        replay(t, m, check);
+        BenchResult b = bench_run(t.name.c_str(), [&] {
+            std::vector<double> mm;
+            ReplayCheck c;
+            replay(t, mm, c);
+            bench_keep(mm);
+        }, 100);
+        m.push_back(b.ns_per_op);
+        fresh[t.name] = m;
+
+        printf("%-28s", t.name.c_str());
+        for (size_t i = 0; i < metrics.size(); i++) printf(" %s=%.4g", metrics[i].c_str(), m[i]);
+        printf(" | %u conv, %u dropped\n", t.header.count, t.header.dropped);
+
+        if (check.mismatches || check.underruns) {
+            printf("  DESYNC: %u channel mismatches, %u underruns\n",
+                   check.mismatches, check.underruns);
+            failures++;
+        }
+        auto it = baseline.find(t.name);
+        if (it == baseline.end()) {
+            if (baseline_path && !update) printf("  NEW: not in baseline\n");
+            continue;
+        }
+        const std::vector<double> &old = it->second;
+        for (size_t i = 0; i < metrics.size(); i++) {
+            if (fabs(m[i] - old[i]) > 1e-4 * (1.0 + fabs(old[i]))) {
+                printf("  CHANGED %s: %.6g -> %.6g\n", metrics[i].c_str(), old[i], m[i]);
+                failures++;
+            }
+        }
+        double ratio = old.back() > 0 ? m.back() / old.back() : 1.0;
+        printf("  host %.0f ns/replay (%.2fx baseline)%s\n", m.back(), ratio,
+               ratio > slower ? " SLOWER" : "");
+    }
+
+    if (update && baseline_path) {
+        if (!write_baseline(baseline_path, cols, fresh)) {
+            perror(baseline_path);
+            return 1;
+        }
+        printf("baseline written: %s (%zu traces)\n", baseline_path, fresh.size());
+        return 0;
+    }
+    return failures ? 1 : 0;
+}
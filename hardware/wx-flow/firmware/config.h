@@ -15,6 +15,12 @@
 #define PIN_HEATER          38   // MOSFET gate for nichrome heater
 #define PIN_BATTERY_ADC     4
 #define PIN_SOLAR_ADC       5
+#define PIN_RS485_TX        15
+#define PIN_RS485_RX        16
+#define PIN_RS485_DE        7    // transceiver DE/RE, driven by UART RTS
+#define PIN_SDI12_TX        1    // via tri-state buffer onto the SDI-12 line
+#define PIN_SDI12_RX        2
+#define PIN_SDI12_DIR       6    // buffer enable: HIGH = talk, LOW = listen
 
 // ── ADS1115 Addresses ───────────────────────────────────────
 // Two ADS1115 on I2C: ADDR pin tied differently
@@ -57,6 +63,68 @@
 // v = K / delay_peak  where K is empirical constant
 #define FLOW_CAL_K          900.0f   // calibrate in lab; cm·s/day
 
+// Residual heat: past pulses (timing, and each thermistor's fitted
+// amplitude) are kept in RTC memory and their predicted tail is
+// subtracted from the next baseline and trace, so pulses may come before
+// the formation has relaxed (short TX_INTERVAL_MS during pumping tests).
+// κ = λ/ρc of the formation sets the shape of the predicted decay.
+#define HEAT_HISTORY        1
+#define HEAT_HISTORY_PULSES 8
+#define THERM_DIFFUSIVITY   7.7e-7f  // m²/s, saturated sand
+
+// Coded excitation: instead of one full-power pulse, the heater is keyed
+// with a maximal-length PRBS at reduced PWM duty, and each thermistor's
+// response is correlated against the code to recover its impulse
+// response (see run_coded_heat_pulse()). Lower peak heater power for a
+// longer cycle; tools/heatsim compares the two per joule.
+#define HEAT_MODE_PULSE     0
+#define HEAT_MODE_CODED     1
+#define HEAT_MODE           HEAT_MODE_PULSE
+#define CODED_ORDER         7        // 2^7 - 1 = 127 chips per period
+#define CODED_CHIP_MS       1000
+#define CODED_SAMPLE_MS     250      // divides CODED_CHIP_MS
+#define CODED_DUTY          16       // heater PWM while a chip is on, /255
+#define CODED_PERIODS       2        // the first settles, the rest are averaged
+#define FLOW_CAL_K_CODED    950.0f   // v = K / impulse-response peak time (heatsim fit)
+
+// ── Modbus RTU (RS-485) ─────────────────────────────────────
+// Digital sondes polled after the analog channels. A value read here
+// replaces the analog measurement of the same quantity (pressure, level,
+// temperature, conductivity); slot is unused on WX-Flow.
+#define MODBUS_UART         UART_NUM_2
+#define MODBUS_BAUD         19200
+#define MODBUS_TIMEOUT_MS   200
+#define MODBUS_WARMUP_MS    1000  // sonde power-up, counted from boot
+#define MODBUS_FIELD_COUNT  0
+// { slave, func, reg, type, scale, offset, quantity, slot }
+#define MODBUS_FIELDS       { }
+/* Example — CTD sonde at address 2, S16 conductivity (µS/cm) at input
+   register 0 and S16 temperature (0.01 °C) at input register 1:
+     #define MODBUS_FIELD_COUNT  2
+     #define MODBUS_FIELDS { \
+         { 2, MB_READ_INPUT, 0, MB_S16, 1.0f,  0.0f, SQ_EC_US,  0 }, \
+         { 2, MB_READ_INPUT, 1, MB_S16, 0.01f, 0.0f, SQ_TEMP_C, 0 }, \
+     }
+*/
+
+// ── SDI-12 ──────────────────────────────────────────────────
+// All sensors are started together with aC! and collected with aD0!…, so
+// the bus takes as long as the slowest sensor. Values replace the analog
+// measurement of the same quantity, as for Modbus. Shares the UART with
+// Modbus; the two buses are read one after the other.
+#define SDI12_UART          UART_NUM_2
+#define SDI12_FIELD_COUNT   0
+// { addr, value_index, scale, offset, quantity, slot }
+#define SDI12_FIELDS        { }
+/* Example — CTD probe at address 0 returning +pressure_psi+temp_c+ec_us:
+     #define SDI12_FIELD_COUNT   3
+     #define SDI12_FIELDS { \
+         { '0', 0, 1.0f, 0.0f, SQ_PRESSURE_PSI, 0 }, \
+         { '0', 1, 1.0f, 0.0f, SQ_TEMP_C,       0 }, \
+         { '0', 2, 1.0f, 0.0f, SQ_EC_US,        0 }, \
+     }
+*/
+
 // ── Timing ──────────────────────────────────────────────────
 #define TX_INTERVAL_MS      (15UL * 60UL * 1000UL)
 #define DEEP_SLEEP_US       (TX_INTERVAL_MS * 1000ULL)
@@ -66,12 +134,97 @@
 #define LORA_BANDWIDTH      125E3
 #define LORA_SPREAD_FACTOR  7
 #define LORA_TX_POWER       17
+#define LORA_MAX_PAYLOAD    255  // SX1276 FIFO; longer payloads go cellular
 
 // ── Cellular ────────────────────────────────────────────────
 #define APN                 "iot.1nce.net"
 #define SERVER_HOST         "api.waterxchange.io"
 #define SERVER_PORT         443
 #define API_ENDPOINT        "/hardware/data"
+#define API_BATCH_ENDPOINT  "/hardware/data/batch"
+#define JSON_MAX_PAYLOAD    1024     // build_json() buffer for one reading
+
+// ── Transport Policy ────────────────────────────────────────
+// Each reading goes over LoRa, cellular, or waits in the queue for a
+// cellular batch, by expected joules per delivered reading (see
+// common/firmware/tx_policy.h). Delivery rates are learned per link in
+// RTC memory; a LoRa send counts as delivered when the frame goes out.
+#define TX_LORA_ATTEMPT_J   0.02f    // wake + preamble at 17 dBm
+#define TX_LORA_BYTE_J      0.0009f  // ~1.5 ms airtime per byte at SF7/125 kHz
+#define TX_LORA_LATENCY_S   2.0f
+#define TX_CELL_ATTEMPT_J   17.0f    // ~30 s attach + TLS + POST at ~155 mA
+#define TX_CELL_BYTE_J      0.00005f
+#define TX_CELL_PRICE_J     0.0f     // data price per byte in joules; 0 for flat-rate SIMs
+#define TX_CELL_LATENCY_S   30.0f
+#define TX_ROUTINE_BUDGET_J 3.0f     // routine readings wait rather than cost more
+#define TX_QUEUE_MAX        4        // whole readings in RTC memory, sent as one JSON batch
+#define TX_BATT_OK_V        3.8f     // energy weighs 1× at or above this…
+#define TX_BATT_LOW_V       3.5f     // …rising to TX_BATT_WEIGHT_MAX here
+#define TX_BATT_CRIT_V      3.4f     // below: only urgent readings are sent
+#define TX_BATT_WEIGHT_MAX  4.0f
+#define TX_STATS_DECAY      0.8f     // per attempt: ~5 attempts of memory
+#define TX_STATS_RECOVER    0.97f    // per cycle: an unused link drifts back to untried
+#define TX_URGENT_EC_STEP_US    200.0f  // since the last reading
+#define TX_URGENT_LEVEL_STEP_FT 1.0f
+
+// ── Battery Sag ─────────────────────────────────────────────
+// Around the heater and cellular sessions the on-chip ADC samples the
+// battery and solar dividers continuously (battery_sag.h). The heater is a
+// known current step and gives the cell's internal resistance (not in
+// HEAT_MODE_CODED, where it is PWM keyed); every capture gives its
+// minimum. Routine readings stay off cellular when the predicted sag of a
+// session would reach SAG_BROWNOUT_V, and bursts are judged on the
+// battery under the heater.
+#define SAG_CAPTURE         1
+#define SAG_SAMPLE_HZ       1000     // battery / solar pairs per second
+#define SAG_PREROLL_MS      50       // rest before the load
+#define SAG_DIVIDER         2.0f     // 100 kΩ / 100 kΩ on both inputs
+#define SAG_HEATER_A        0.8f     // heater current step
+#define SAG_CELL_PEAK_A     0.6f     // SIM7000G LTE-M transmit peak
+#define SAG_BROWNOUT_V      3.1f     // LDO dropout above the S3 brownout detector
+#define SAG_MIN_SAMPLES     32       // per phase, for a resistance estimate
+#define SAG_R_WEIGHT        0.2f     // of a new estimate in the tracked one
+#define SAG_SOLAR_STEADY_V  0.2f     // more solar swing voids the estimate
+
+// ── Synoptic Campaigns ──────────────────────────────────────
+// The backend announces campaign instants in the ingest reply and the unit
+// wakes to measure at them (common/firmware/campaign.h). Its clock comes
+// from the same replies: the internal RC RTC drifts ~1000 ppm until two
+// syncs CLOCK_SKEW_MIN_S apart give its skew. A 32 kHz crystal
+// (CONFIG_RTC_CLK_SRC_EXT_CRYS) brings both bounds to ~20 ppm.
+#define CLOCK_DRIFT_PPM     1000.0f
+#define CLOCK_RESIDUAL_PPM  200.0f
+#define CLOCK_SKEW_MIN_S    3600
+#define CLOCK_SYNC_MAX_S    (24UL * 3600UL)  // a cellular report at least daily; 0 = only for campaigns
+
+// ── Pressure-Triggered Bursts ───────────────────────────────
+// Between cycles the probe wakes every PRESSURE_SAMPLE_MS to read the
+// pressure channel alone (one conversion), and a drawdown or recovery of
+// BURST_TRIGGER_FT against the baseline starts a burst of heat pulses
+// every BURST_INTERVAL_MS until the level settles (pressure_watch.h).
+// Closely spaced pulses rely on HEAT_HISTORY for the residual heat.
+#define PRESSURE_SAMPLE_MS  (60UL * 1000UL)  // 0: no sample wakes, no bursts
+#define BURST_TRIGGER_FT    0.3f
+#define BURST_STABLE_FT     0.03f    // per sample…
+#define BURST_STABLE_SAMPLES 5       // …for 5 samples in a row ends the burst
+#define BURST_BASELINE_S    3600
+#define BURST_INTERVAL_MS   (5UL * 60UL * 1000UL)
+#define BURST_MAX_PULSES    8
+#define BURST_PULSE_J       23.0f    // 800 mA heater for HEATER_POWER_MS + ~65 s awake
+#define BURST_BUDGET_J_DAY  250.0f   // ~10 extra pulses a day, on ~2.2 kJ scheduled
+#define BURST_MIN_BATT_V    TX_BATT_LOW_V    // under the heater, with the sag estimate
+
+// ── ADC Trace Recording ─────────────────────────────────────
+// Every ADC conversion of a cycle is logged and the last TRACE_KEEP cycles
+// are kept in flash; the backend can ask for one to be uploaded, and
+// hardware/tools/replay runs it back through the firmware code.
+#define TRACE_RECORD        1
+#define TRACE_MAX_SAMPLES   4096      // 8 bytes each
+#define TRACE_KEEP          8
+#define TRACE_UPLOAD_CHUNK  2048
+#define TRACE_PATH          "/hardware/traces/" DEVICE_ID
+#define TRACE_ADC_SENSORS   0         // converter ids in the trace
+#define TRACE_ADC_THERM     1
 
 // ── Device ──────────────────────────────────────────────────
 #define DEVICE_TYPE         "wx-flow"
@@ -1,7 +1,8 @@
 #pragma once
-#include <Adafruit_ADS1X15.h>
-#include "config.h"
 #include <math.h>
+#include <string.h>
+#include "hal.h"
+#include "config.h"
 
 /*
  * Heat Pulse Flow Measurement
@@ -11,6 +12,17 @@
  * and largest rise. From timing and magnitude we derive:
  *   - Flow direction (which quadrant sees max ΔT first)
  *   - Flow velocity (inversely proportional to peak delay time)
+ *
+ * Coded excitation (HEAT_MODE_CODED) spreads the heat over a PRBS at low
+ * PWM duty and recovers the same peak ΔT / time-to-peak from the
+ * correlated impulse response; see run_coded_heat_pulse().
+ *
+ * With a ThermalHistory, run_heat_pulse() subtracts the predicted tail of
+ * earlier pulses from its baseline and trace, so a pulse can follow the
+ * last one before the formation has relaxed.
+ *
+ * Hardware access goes through the HAL so the same code runs on the probe
+ * and in the env:native build against scripted thermistor signals.
  */
 
 struct FlowResult {
@@ -21,15 +33,34 @@ struct FlowResult {
     bool  valid;
 };
 
+// Timing of one measurement cycle; defaults are the config.h values
+struct HeatPulseParams {
+    uint32_t heater_ms  = HEATER_POWER_MS;
+    uint32_t settle_ms  = HEATER_SETTLE_MS;
+    uint32_t sample_ms  = FLOW_SAMPLE_MS;
+    uint32_t monitor_ms = FLOW_MONITOR_MS;
+};
+
+// Coded cycle; defaults are the config.h values
+struct CodedPulseParams {
+    uint8_t  order     = CODED_ORDER;      // 2^order - 1 chips per period
+    uint32_t chip_ms   = CODED_CHIP_MS;
+    uint32_t sample_ms = CODED_SAMPLE_MS;  // divides chip_ms
+    uint8_t  duty      = CODED_DUTY;       // heater PWM during a 1 chip, /255
+    uint8_t  periods   = CODED_PERIODS;    // >= 2: the first is not sampled
+};
+
+#define CODED_MAX_ORDER     7
+#define CODED_MAX_SAMPLES   1024           // per channel per period
+
 struct ThermTimeSeries {
     static const int MAX_SAMPLES = 600; // 60s at 100ms intervals
     float temps[4][MAX_SAMPLES];
     int   count;
 };
 
-// Convert raw ADC to thermistor temperature using Steinhart-Hart (B-parameter)
-float thermistor_temp(Adafruit_ADS1115 &adc, uint8_t channel) {
-    int16_t raw = adc.readADC_SingleEnded(channel);
+// Convert raw ADC code to thermistor temperature (B-parameter equation)
+inline float therm_code_to_temp(int16_t raw) {
     float voltage = raw * 0.000125f;
 
     // Voltage divider: V = Vref * R_therm / (R_series + R_therm)
@@ -47,8 +78,22 @@ float thermistor_temp(Adafruit_ADS1115 &adc, uint8_t channel) {
     return temp_c;
 }
 
+// Inverse of therm_code_to_temp, for simulators and scripted ADCs
+inline int16_t therm_temp_to_code(float temp_c) {
+    float t_k = temp_c + 273.15f;
+    float r_therm = THERM_NOMINAL_R *
+        expf(THERM_B_COEFF * (1.0f / t_k - 1.0f / (THERM_NOMINAL_T + 273.15f)));
+    float voltage = 3.3f * r_therm / (THERM_SERIES_R + r_therm);
+    float code = roundf(voltage / 0.000125f);
+    return (int16_t)(code > 32767.0f ? 32767.0f : code);
+}
+
+inline float thermistor_temp(HalAdc &adc, uint8_t channel) {
+    return therm_code_to_temp(adc.read_single_ended(channel));
+}
+
 // Read all 4 thermistors at once
-void read_all_thermistors(Adafruit_ADS1115 &adc, float out[4]) {
+inline void read_all_thermistors(HalAdc &adc, float out[4]) {
     out[0] = thermistor_temp(adc, CH_THERM_N);
     out[1] = thermistor_temp(adc, CH_THERM_E);
     out[2] = thermistor_temp(adc, CH_THERM_S);
@@ -56,52 +101,15 @@ void read_all_thermistors(Adafruit_ADS1115 &adc, float out[4]) {
 }
 
 /*
- * Run the full heat pulse measurement cycle:
- * 1. Read baseline temperatures (average of 10 readings)
- * 2. Fire heater for HEATER_POWER_MS
- * 3. Monitor all 4 thermistors for FLOW_MONITOR_MS
- * 4. Find peak ΔT and time-to-peak for each
- * 5. Derive flow direction and velocity
+ * Derive flow direction and velocity from per-thermistor peak ΔT and
+ * time-to-peak (steps 4–5 of run_heat_pulse).
  */
-FlowResult run_heat_pulse(Adafruit_ADS1115 &therm_adc) {
+inline FlowResult analyze_heat_pulse(const float peak_dt[4], const float peak_time[4],
+                                     float cal_k = FLOW_CAL_K) {
     FlowResult result;
-    result.valid = false;
-
-    // Step 1: Baseline — average 10 readings per thermistor
-    float baseline[4] = {0, 0, 0, 0};
-    for (int i = 0; i < 10; i++) {
-        float t[4];
-        read_all_thermistors(therm_adc, t);
-        for (int j = 0; j < 4; j++) baseline[j] += t[j];
-        delay(50);
-    }
-    for (int j = 0; j < 4; j++) baseline[j] /= 10.0f;
-
-    // Step 2: Fire heater
-    pinMode(PIN_HEATER, OUTPUT);
-    digitalWrite(PIN_HEATER, HIGH);
-    delay(HEATER_POWER_MS);
-    digitalWrite(PIN_HEATER, LOW);
-    delay(HEATER_SETTLE_MS);
-
-    // Step 3: Monitor thermistors for FLOW_MONITOR_MS
-    float peak_dt[4] = {0, 0, 0, 0};
-    float peak_time[4] = {0, 0, 0, 0};
-
-    unsigned long start_ms = millis();
-    while (millis() - start_ms < FLOW_MONITOR_MS) {
-        float t[4];
-        read_all_thermistors(therm_adc, t);
-
-        float elapsed_s = (millis() - start_ms) / 1000.0f;
-        for (int j = 0; j < 4; j++) {
-            float dt = t[j] - baseline[j];
-            if (dt > peak_dt[j]) {
-                peak_dt[j] = dt;
-                peak_time[j] = elapsed_s;
-            }
-        }
-        delay(FLOW_SAMPLE_MS);
+    for (int j = 0; j < 4; j++) {
+        result.peak_temps[j] = peak_dt[j];
+        result.peak_times[j] = peak_time[j];
     }
 
     // Step 4: Find the dominant thermistor (highest peak ΔT)
@@ -116,10 +124,6 @@ FlowResult run_heat_pulse(Adafruit_ADS1115 &therm_adc) {
         result.velocity_cm_day = 0;
         result.direction_deg = -1;
         result.valid = true;
-        for (int j = 0; j < 4; j++) {
-            result.peak_temps[j] = peak_dt[j];
-            result.peak_times[j] = peak_time[j];
-        }
         return result;
     }
 
@@ -140,17 +144,273 @@ FlowResult run_heat_pulse(Adafruit_ADS1115 &therm_adc) {
     // v = K / t_peak  (empirical relationship from calibration)
     float velocity = 0;
     if (peak_time[max_idx] > 0.5f) {
-        velocity = FLOW_CAL_K / peak_time[max_idx];
+        velocity = cal_k / peak_time[max_idx];
     } else {
-        velocity = FLOW_CAL_K / 0.5f; // cap at very fast flow
+        velocity = cal_k / 0.5f; // cap at very fast flow
     }
 
     result.velocity_cm_day = velocity;
     result.direction_deg   = direction;
     result.valid           = true;
+    return result;
+}
+
+// ── Residual Heat ───────────────────────────────────────────
+// Conduction-only temperature at THERM_DISTANCE_MM from a line source
+// heating over [on_ms, off_ms], seen at t_ms, per unit of source strength:
+//   ∫ exp(-a/u) / u du  over u = t - off … t - on,  a = r² / 4κ
+// evaluated by Simpson's rule in ln u (the integrand is smooth there).
+inline float residual_shape(int64_t on_ms, int64_t off_ms, int64_t t_ms) {
+    if (t_ms <= on_ms) return 0;
+    const float r = THERM_DISTANCE_MM / 1000.0f;
+    const float a = r * r / (4.0f * THERM_DIFFUSIVITY);
+    float u_hi = (t_ms - on_ms) / 1000.0f;
+    float u_lo = t_ms > off_ms ? (t_ms - off_ms) / 1000.0f : 0;
+    if (u_lo < 0.01f * a) u_lo = 0.01f * a;    // exp(-100): nothing below
+    if (u_lo >= u_hi) return 0;
+    const int N = 16;
+    float v0 = logf(u_lo), h = (logf(u_hi) - v0) / N;
+    float sum = 0;
+    for (int k = 0; k <= N; k++) {
+        float f = expf(-a * expf(-(v0 + k * h)));
+        sum += (k == 0 || k == N) ? f : (k & 1 ? 4 * f : 2 * f);
+    }
+    return sum * h / 3;
+}
+
+struct PastPulse {
+    int64_t on_ms, off_ms;     // unit clock
+    float   c[4];              // fitted amplitude per thermistor, °C
+};
+
+/*
+ * Recent pulses, for predicting what is left of their heat. Plain data,
+ * zero = empty, so it can sit in RTC memory across deep sleep. Times are
+ * on the unit clock (which survives sleep); sync() maps this wake's
+ * HalClock onto it before a cycle.
+ *
+ * Each thermistor's amplitude is fitted to the tail of its own trace, so
+ * advection toward or away from it is folded into c[j] and only the
+ * decay shape comes from the conduction model; late in the decay, when
+ * the next pulse comes, conduction dominates anyway.
+ */
+struct ThermalHistory {
+    PastPulse pulses[HEAT_HISTORY_PULSES];
+    uint8_t   count;
+    int64_t   offset_ms;       // unit clock − HalClock::now_ms(), this wake
+
+    void sync(int64_t unit_ms, uint32_t clock_ms) { offset_ms = unit_ms - clock_ms; }
+    int64_t unit_ms(uint32_t clock_ms) const { return offset_ms + clock_ms; }
+
+    // Predicted temperature left by past pulses at clock_ms, per thermistor
+    void residual(uint32_t clock_ms, float out[4]) const {
+        int64_t t = unit_ms(clock_ms);
+        for (int j = 0; j < 4; j++) out[j] = 0;
+        for (int i = 0; i < count; i++) {
+            float g = residual_shape(pulses[i].on_ms, pulses[i].off_ms, t);
+            for (int j = 0; j < 4; j++) out[j] += pulses[i].c[j] * g;
+        }
+    }
+
+    // Records p, first dropping pulses whose tail is now below 1 mK and,
+    // when still full, the oldest
+    void add(const PastPulse &p) {
+        int n = 0;
+        for (int i = 0; i < count; i++) {
+            float g = residual_shape(pulses[i].on_ms, pulses[i].off_ms, p.on_ms);
+            float c = 0;
+            for (int j = 0; j < 4; j++) c = fmaxf(c, fabsf(pulses[i].c[j]));
+            if (c * g >= 0.001f) pulses[n++] = pulses[i];
+        }
+        if (n == HEAT_HISTORY_PULSES) {
+            memmove(pulses, pulses + 1, (n - 1) * sizeof(PastPulse));
+            n--;
+        }
+        pulses[n++] = p;
+        count = n;
+    }
+};
+
+// Pre-heat temperature of each thermistor: the average of 10 scans, less
+// the predicted residual of earlier pulses when a history is given
+inline void read_baseline(HalAdc &therm_adc, HalClock &clock, float baseline[4],
+                          const ThermalHistory *history = nullptr) {
+    for (int j = 0; j < 4; j++) baseline[j] = 0;
+    for (int i = 0; i < 10; i++) {
+        float t[4], res[4] = {0, 0, 0, 0};
+        read_all_thermistors(therm_adc, t);
+        if (history) history->residual(clock.now_ms(), res);
+        for (int j = 0; j < 4; j++) baseline[j] += t[j] - res[j];
+        clock.delay_ms(50);
+    }
+    for (int j = 0; j < 4; j++) baseline[j] /= 10.0f;
+}
+
+/*
+ * Run the full heat pulse measurement cycle:
+ * 1. Read baseline temperatures (average of 10 readings)
+ * 2. Fire heater for p.heater_ms
+ * 3. Monitor all 4 thermistors for p.monitor_ms
+ * 4. Find peak ΔT and time-to-peak for each
+ * 5. Derive flow direction and velocity
+ * With a history (synced to clock), steps 1 and 3 have the residual of
+ * earlier pulses taken out, and this pulse is added to it afterwards,
+ * its amplitudes fitted over the last third of the monitoring window.
+ */
+inline FlowResult run_heat_pulse(HalAdc &therm_adc, HalClock &clock, HalGpio &gpio,
+                                 const HeatPulseParams &p = HeatPulseParams(),
+                                 ThermalHistory *history = nullptr) {
+    // Step 1: Baseline — average 10 readings per thermistor
+    float baseline[4];
+    read_baseline(therm_adc, clock, baseline, history);
+
+    // Step 2: Fire heater
+    gpio.set_output(PIN_HEATER);
+    uint32_t on_ms = clock.now_ms();
+    gpio.write(PIN_HEATER, true);
+    clock.delay_ms(p.heater_ms);
+    gpio.write(PIN_HEATER, false);
+    uint32_t off_ms = clock.now_ms();
+    clock.delay_ms(p.settle_ms);
+
+    // Step 3: Monitor thermistors for p.monitor_ms
+    float peak_dt[4] = {0, 0, 0, 0};
+    float peak_time[4] = {0, 0, 0, 0};
+    float fit_yg[4] = {0, 0, 0, 0}, fit_gg = 0;
+
+    uint32_t start_ms = clock.now_ms();
+    while (clock.now_ms() - start_ms < p.monitor_ms) {
+        float t[4], res[4] = {0, 0, 0, 0};
+        read_all_thermistors(therm_adc, t);
+        uint32_t now = clock.now_ms();
+        if (history) history->residual(now, res);
+
+        float elapsed_s = (now - start_ms) / 1000.0f;
+        bool tail = history && (now - start_ms) * 3 >= p.monitor_ms * 2;
+        float g = tail ? residual_shape(on_ms, off_ms, now) : 0;
+        fit_gg += g * g;
+        for (int j = 0; j < 4; j++) {
+            float dt = t[j] - baseline[j] - res[j];
+            fit_yg[j] += dt * g;
+            if (dt > peak_dt[j]) {
+                peak_dt[j] = dt;
+                peak_time[j] = elapsed_s;
+            }
+        }
+        clock.delay_ms(p.sample_ms);
+    }
+
+    if (history && fit_gg > 0) {
+        PastPulse past;
+        past.on_ms  = history->unit_ms(on_ms);
+        past.off_ms = history->unit_ms(off_ms);
+        for (int j = 0; j < 4; j++) past.c[j] = fit_yg[j] / fit_gg;
+        history->add(past);
+    }
+
+    // Steps 4–5
+    return analyze_heat_pulse(peak_dt, peak_time);
+}
+
+// ── Coded Excitation ────────────────────────────────────────
+// One period of the maximal-length sequence of a Fibonacci LFSR on
+// x^order + x^tap + 1 (order 3–CODED_MAX_ORDER); returns its length,
+// 2^order - 1, with (length + 1) / 2 ones.
+inline int mseq_generate(uint8_t order, uint8_t *chips) {
+    static const uint8_t TAP[CODED_MAX_ORDER + 1] = { 0, 0, 0, 2, 3, 3, 5, 6 };
+    if (order < 3 || order > CODED_MAX_ORDER) return 0;
+    int n = (1 << order) - 1;
+    uint32_t reg = 1;
+    for (int k = 0; k < n; k++) {
+        chips[k] = reg & 1;
+        uint32_t fb = ((reg >> (order - 1)) ^ (reg >> (TAP[order] - 1))) & 1;
+        reg = ((reg << 1) | fb) & (uint32_t)n;
+    }
+    return n;
+}
+
+/*
+ * Coded heat-pulse cycle:
+ * 1. Baseline, as run_heat_pulse()
+ * 2. Key the heater with the m-sequence, p.periods times over, at PWM
+ *    p.duty during 1 chips. The first period lets the medium settle
+ *    into the periodic response; later ones are sampled every
+ *    p.sample_ms and summed per position within the period.
+ * 3. Correlate each thermistor's period against the bipolar code. For
+ *    an m-sequence the periodic cross-correlation with its 0/1 drive is
+ *    (N + 1) / 2 at lag 0 and exactly 0 elsewhere, so this gives the
+ *    response to one chip, sample by sample after its start, with the
+ *    noise averaged over every chip of every sampled period.
+ * 4. Smooth over one chip, take peak and time-to-peak, and scale the
+ *    peak to the ΔT a HEATER_POWER_MS full-power pulse would give, so
+ *    peak_temps and the stagnant threshold read the same in either mode.
+ * 5. Direction and velocity as analyze_heat_pulse(), with
+ *    FLOW_CAL_K_CODED: time-to-peak here runs from the chip start, not
+ *    from the end of a pulse.
+ * The response must die down within one period (N × chip_ms); any tail
+ * past it wraps around onto early lags.
+ */
+inline FlowResult run_coded_heat_pulse(HalAdc &therm_adc, HalClock &clock, HalGpio &gpio,
+                                       const CodedPulseParams &p = CodedPulseParams()) {
+    static uint8_t chips[(1 << CODED_MAX_ORDER) - 1];
+    static float   acc[4][CODED_MAX_SAMPLES];
+    static float   h[CODED_MAX_SAMPLES];
+
+    FlowResult invalid = {};
+    invalid.direction_deg = -1;
+    int n = mseq_generate(p.order, chips);
+    int spc = p.sample_ms ? (int)(p.chip_ms / p.sample_ms) : 0;
+    int len = n * spc;
+    if (!n || spc < 1 || len > CODED_MAX_SAMPLES || p.periods < 2) return invalid;
+
+    // Step 1: Baseline
+    float baseline[4];
+    read_baseline(therm_adc, clock, baseline);
+    memset(acc, 0, sizeof(acc));
+
+    // Step 2: Drive the code, sample after the first period
+    gpio.set_output(PIN_HEATER);
+    uint32_t start_ms = clock.now_ms();
+    for (int s = 0; s < p.periods * len; s++) {
+        uint32_t due = start_ms + (uint32_t)s * p.sample_ms;
+        uint32_t now = clock.now_ms();
+        if ((int32_t)(due - now) > 0) clock.delay_ms(due - now);
+        if (s % spc == 0) gpio.write_pwm(PIN_HEATER, chips[(s / spc) % n] ? p.duty : 0);
+        if (s < len) continue;
+
+        float t[4];
+        read_all_thermistors(therm_adc, t);
+        for (int j = 0; j < 4; j++) acc[j][s % len] += t[j] - baseline[j];
+    }
+    gpio.write_pwm(PIN_HEATER, 0);
+
+    // Steps 3–4: chip response → equivalent single-pulse ΔT
+    float scale = 2.0f / ((n + 1) * (p.periods - 1))
+                * HEATER_POWER_MS / (p.chip_ms * (p.duty / 255.0f));
+    float peak_dt[4], peak_time[4];
     for (int j = 0; j < 4; j++) {
-        result.peak_temps[j] = peak_dt[j];
-        result.peak_times[j] = peak_time[j];
+        for (int lag = 0; lag < len; lag++) {
+            float r = 0;
+            for (int k = 0; k < n; k++) {
+                float y = acc[j][(k * spc + lag) % len];
+                r += chips[k] ? y : -y;
+            }
+            h[lag] = r * scale;
+        }
+        peak_dt[j] = 0;
+        peak_time[j] = 0;
+        float win = 0;
+        for (int i = 0; i < spc; i++) win += h[i];
+        for (int lag = 0; lag < len; lag++) {
+            float smooth = win / spc;          // h over [lag, lag + spc)
+            if (smooth > peak_dt[j]) {
+                peak_dt[j] = smooth;
+                peak_time[j] = (lag + 0.5f * (spc - 1)) * p.sample_ms / 1000.0f;
+            }
+            win += h[(lag + spc) % len] - h[lag];
+        }
     }
-    return result;
+
+    // Step 5
+    return analyze_heat_pulse(peak_dt, peak_time, FLOW_CAL_K_CODED);
 }
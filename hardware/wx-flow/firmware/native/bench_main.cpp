@@ -0,0 +1,132 @@
+/*
+ * WX-Flow host microbenchmarks (env:native).
+ *
+ * Runs the firmware's thermistor conversion, heat-pulse analysis, full
+ * run_heat_pulse() cycle and JSON serialization against hal_native.h
+ * backends and reports host ns/op. The full cycle runs on virtual time
+ * with a scripted thermistor response, so a 65-second pulse costs only
+ * the compute it really does.
+ * It also checks that a default reading goes out as one LoRa frame and
+ * exits nonzero if not.
+ *
+ *   pio run -e native && .pio/build/native/program [name-filter]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "hal_native.h"
+#include "microbench.h"
+#include "heat_pulse.h"
+#include "reading.h"
+
+// Downstream (east) thermistor peaks ~12 s after the heater switches off
+static int16_t scripted_therm(uint8_t ch, uint64_t t_us) {
+    static const float gain[4] = { 0.15f, 0.9f, 0.1f, 0.3f };
+    double t = t_us / 1e6 - 5.0;    // heater off at ~5 s into the cycle
+    float dt = t > 0 ? (float)(gain[ch] * (t / 12.0) * exp(1.0 - t / 12.0)) : 0.0f;
+    return therm_temp_to_code(18.0f + dt);
+}
+
+static FullReading sample_reading() {
+    FullReading r = {};
+    r.boot_count       = 1234;
+    const float peaks[4] = { 0.14f, 0.88f, 0.09f, 0.31f };
+    const float times[4] = { 13.1f, 11.9f, 14.0f, 12.6f };
+    r.flow             = analyze_heat_pulse(peaks, times);
+    r.conductivity_us  = 842.0f;
+    r.tds_ppm          = 463.0f;
+    r.water_temp_c     = 17.9f;
+    r.water_level_ft   = 12.41f;
+    r.pressure_psi     = 5.372f;
+    r.battery_v        = 3.88f;
+    r.solar_v          = 5.12f;
+    return r;
+}
+
+// A default reading must go out as one LoRa frame: build_air() within
+// LORA_MAX_PAYLOAD, and the transport policy routing it to LoRa
+static bool check_lora_feasible() {
+    FullReading r = sample_reading();
+    char json[JSON_MAX_PAYLOAD], frame[LORA_MAX_PAYLOAD + 1];
+    TxRequest rq = {};
+    rq.bytes     = build_json(r, json, sizeof(json));
+    rq.air_bytes = build_air(r, frame, sizeof(frame));
+    rq.urgency   = TX_ROUTINE;
+    rq.battery_v = r.battery_v;
+    rq.lora_up   = true;
+    TxLinkStats stats[2] = {};
+    TxDecision d = tx_decide(TX_POLICY, stats, rq);
+    bool ok = rq.air_bytes && d.route == TX_LORA;
+    printf("CHECK %-32s %12s (%u B frame, route %s)\n", "flow/lora_feasible",
+           ok ? "ok" : "FAIL", (unsigned)rq.air_bytes, tx_route_name(d.route));
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    bool checks_ok = check_lora_feasible();
+    if (bench_selected(argc, argv, "flow/therm_code_to_temp")) {
+        int16_t code = 12000;
+        bench_run("flow/therm_code_to_temp", [&] {
+            code = (int16_t)(9000 + (code + 13) % 12000);
+            bench_keep(therm_code_to_temp(code));
+        });
+    }
+
+    if (bench_selected(argc, argv, "flow/analyze_heat_pulse")) {
+        float peaks[4] = { 0.14f, 0.88f, 0.09f, 0.31f };
+        float times[4] = { 13.1f, 11.9f, 14.0f, 12.6f };
+        bench_run("flow/analyze_heat_pulse", [&] {
+            peaks[1] += 1e-6f;
+            bench_keep(analyze_heat_pulse(peaks, times));
+        });
+    }
+
+    if (bench_selected(argc, argv, "flow/run_heat_pulse")) {
+        VirtualClock clock;
+        ScriptedAdc adc(clock, [&](uint8_t ch, uint64_t) {
+            return scripted_therm(ch, clock.time_us());
+        });
+        RecordingGpio gpio(clock);
+        FlowResult fr = run_heat_pulse(adc, clock, gpio);
+        printf("SIM   %-32s %12.2f s virtual, %llu conversions, v=%.1f cm/day dir=%.0f\n",
+               "flow/run_heat_pulse", clock.time_us() / 1e6,
+               (unsigned long long)adc.conversions, fr.velocity_cm_day, fr.direction_deg);
+        bench_run("flow/run_heat_pulse", [&] {
+            clock.reset();
+            gpio.events.clear();
+            bench_keep(run_heat_pulse(adc, clock, gpio));
+        });
+    }
+
+    if (bench_selected(argc, argv, "flow/adc_conversions")) {
+        int16_t code = 9000;
+        bench_run("flow/adc_conversions", [&] {
+            code = (int16_t)(8000 + (code + 11) % 30000);
+            bench_keep(pressure_psi_from_raw(code) + conductivity_from_raw(code)
+                       + pt1000_temp_from_raw(code));
+        });
+    }
+
+    if (bench_selected(argc, argv, "flow/build_json")) {
+        FullReading r = sample_reading();
+        char buf[2048];
+        size_t len = build_json(r, buf, sizeof(buf));
+        printf("SIZE  %-32s %12zu bytes\n", "flow/build_json", len);
+        bench_run("flow/build_json", [&] {
+            r.boot_count++;
+            bench_keep(build_json(r, buf, sizeof(buf)));
+        });
+    }
+
+    if (bench_selected(argc, argv, "flow/build_air")) {
+        FullReading r = sample_reading();
+        char buf[LORA_MAX_PAYLOAD + 1];
+        size_t len = build_air(r, buf, sizeof(buf));
+        printf("SIZE  %-32s %12zu bytes\n", "flow/build_air", len);
+        bench_run("flow/build_air", [&] {
+            r.boot_count++;
+            bench_keep(build_air(r, buf, sizeof(buf)));
+        });
+    }
+    return checks_ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include "config.h"
+
+/*
+ * Pressure-triggered heat-pulse bursts.
+ *
+ * Flow velocity changes most when nearby pumps start or stop, and that
+ * shows first as a drawdown or recovery of the level over the probe.
+ * Between scheduled cycles the probe wakes every PRESSURE_SAMPLE_MS,
+ * reads only the pressure channel and compares the level with a slow
+ * baseline. A departure of BURST_TRIGGER_FT starts a burst: heat pulses
+ * every BURST_INTERVAL_MS instead of every TX_INTERVAL_MS, until the
+ * level has held within BURST_STABLE_FT for BURST_STABLE_SAMPLES samples
+ * or BURST_MAX_PULSES extra pulses have run. The extra pulses are paid
+ * from a heater energy budget that refills at BURST_BUDGET_J_DAY, and
+ * none are run below the battery floor.
+ */
+
+enum PressureEvent : uint8_t {
+    PEV_NONE     = 0,
+    PEV_DRAWDOWN = 1,   // level falling: a pump nearby started
+    PEV_RECOVERY = 2,   // level rising: it stopped
+};
+
+inline const char *pressure_event_name(uint8_t e) {
+    return e == PEV_DRAWDOWN ? "drawdown" : e == PEV_RECOVERY ? "recovery" : "";
+}
+
+struct BurstParams {
+    float    trigger_ft;        // departure from the baseline that starts a burst
+    float    stable_ft;         // largest step between samples that counts as stable…
+    uint8_t  stable_samples;    // …for this many samples in a row to end it
+    uint32_t baseline_s;        // time constant of the baseline
+    uint32_t interval_s;        // between burst pulses
+    uint8_t  max_pulses;        // extra pulses per burst
+    float    pulse_j;           // one pulse cycle, heater and MCU
+    float    budget_j_day;      // refill rate and cap of the burst budget
+    float    min_batt_v;
+};
+
+// Across wakes; plain data for RTC memory
+struct PressureWatch {
+    float    base_ft;           // slow baseline of the level
+    float    last_ft;           // last sample
+    uint32_t last_t;            // its unit-clock second; 0 = no sample yet
+    float    budget_j;          // heater energy available for burst pulses
+    uint32_t budget_t;          // last refill; 0 = never (starts full)
+    uint8_t  event;             // PressureEvent of the burst in progress
+    uint8_t  pulses;            // extra pulses run in it
+    uint8_t  stable;            // samples in a row within stable_ft
+    uint32_t next_pulse_s;      // next burst pulse, unit-clock second
+};
+
+inline void burst_refill(PressureWatch &w, const BurstParams &p, uint32_t t) {
+    if (!w.budget_t) {
+        w.budget_j = p.budget_j_day;
+    } else {
+        w.budget_j += p.budget_j_day * (float)(t - w.budget_t) / 86400.0f;
+        if (w.budget_j > p.budget_j_day) w.budget_j = p.budget_j_day;
+    }
+    w.budget_t = t;
+}
+
+inline bool burst_affordable(const PressureWatch &w, const BurstParams &p, float battery_v) {
+    return w.budget_j >= p.pulse_j && battery_v >= p.min_batt_v;
+}
+
+// Back to the sparse schedule; the level it settled at is the new baseline
+inline void burst_end(PressureWatch &w) {
+    w.event = PEV_NONE;
+    w.pulses = 0;
+    w.stable = 0;
+    w.base_ft = w.last_ft;
+}
+
+/*
+ * One level sample at unit-clock second t. Returns true when it starts a
+ * burst, whose first pulse is due at once. During a burst the event
+ * follows the direction of the latest large step, so a recovery after a
+ * drawdown is tagged as one.
+ */
+inline bool pressure_watch_sample(PressureWatch &w, const BurstParams &p, float level_ft,
+                                  uint32_t t, float battery_v) {
+    burst_refill(w, p, t);
+    if (!w.last_t) {
+        w.base_ft = w.last_ft = level_ft;
+        w.last_t = t;
+        return false;
+    }
+    float step = level_ft - w.last_ft;
+    float dt = (float)(t - w.last_t);
+    w.last_ft = level_ft;
+    w.last_t = t;
+
+    if (w.event) {
+        if (fabsf(step) > p.stable_ft) {
+            w.stable = 0;
+            w.event = step < 0 ? PEV_DRAWDOWN : PEV_RECOVERY;
+        } else if (++w.stable >= p.stable_samples) {
+            burst_end(w);
+        }
+        return false;
+    }
+
+    float dev = level_ft - w.base_ft;
+    if (fabsf(dev) < p.trigger_ft) {
+        w.base_ft += dev * (1.0f - expf(-dt / p.baseline_s));
+        return false;
+    }
+    // Without the energy for it the change is let go: the new level
+    // becomes the baseline and only a further change triggers
+    if (!burst_affordable(w, p, battery_v)) {
+        w.base_ft = level_ft;
+        return false;
+    }
+    w.event = dev < 0 ? PEV_DRAWDOWN : PEV_RECOVERY;
+    w.pulses = 0;
+    w.stable = 0;
+    w.next_pulse_s = t;
+    return true;
+}
+
+inline bool burst_pulse_due(const PressureWatch &w, uint32_t t) {
+    return w.event && (int32_t)(t - w.next_pulse_s) >= 0;
+}
+
+// After a pulse cycle during a burst; extra = not a scheduled cycle, so
+// it is paid from the budget
+inline void burst_pulse_done(PressureWatch &w, const BurstParams &p, uint32_t t, bool extra,
+                             float battery_v) {
+    if (!w.event) return;
+    if (extra) {
+        w.budget_j -= p.pulse_j;
+        w.pulses++;
+    }
+    if (w.pulses >= p.max_pulses || !burst_affordable(w, p, battery_v)) {
+        burst_end(w);
+    } else {
+        w.next_pulse_s = t + p.interval_s;
+    }
+}
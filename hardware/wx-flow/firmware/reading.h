@@ -0,0 +1,139 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "digital_sensors.h"
+#include "heat_pulse.h"
+#include "pressure_watch.h"
+#include "tx_policy.h"
+#include "battery_sag.h"
+
+/*
+ * WX-Flow reading: the sensor-to-payload logic that does not touch
+ * hardware directly — ADC code conversions, digital-sensor merging and the
+ * payload encoder generated from hardware/schema/. Shared by the firmware
+ * and the env:native build.
+ */
+
+struct FullReading {
+    FlowResult flow;
+    float conductivity_us;
+    float tds_ppm;
+    float water_temp_c;
+    float water_level_ft;
+    float pressure_psi;
+    float battery_v;
+    float solar_v;
+    uint32_t boot_count;
+    uint32_t campaign;         // synoptic campaign id, 0 = none
+    float campaign_dt_s;       // measured minus campaign instant, unit's estimate
+    float clock_err_s;         // bound on that estimate
+    uint8_t burst;             // PressureEvent of a burst pulse, 0 = scheduled
+    SagReport batt;            // battery sag since the last reading
+    TxDecision tx;             // how this reading is sent, reported with it
+};
+
+inline float mapf(float x, float in_min, float in_max, float out_min, float out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// ── ADC Code Conversions ────────────────────────────────────
+inline float pressure_psi_from_raw(int16_t raw) {
+    float voltage = raw * 0.000125f;
+    float psi = mapf(voltage, PRESSURE_V_MIN, PRESSURE_V_MAX,
+                     PRESSURE_PSI_MIN, PRESSURE_PSI_MAX);
+    if (psi < PRESSURE_PSI_MIN) return PRESSURE_PSI_MIN;
+    if (psi > PRESSURE_PSI_MAX) return PRESSURE_PSI_MAX;
+    return psi;
+}
+
+inline float conductivity_from_raw(int16_t raw) {
+    // Atlas EZO-EC or DFRobot outputs 0–3.0V proportional to conductivity
+    // 0V = 0 µS/cm, 3.0V = 100,000 µS/cm (adjustable via calibration)
+    float voltage = raw * 0.000125f;
+    return mapf(voltage, 0.0f, 3.0f, 0.0f, 100000.0f);
+}
+
+inline float pt1000_temp_from_raw(int16_t raw) {
+    // PT1000 in Wheatstone bridge with 1kΩ references
+    // Output voltage is proportional to resistance deviation
+    // PT1000: R = 1000 × (1 + 0.00385 × T)
+    // Bridge output ΔV → ΔR → T
+    float voltage = raw * 0.000125f;
+
+    // Approximate: bridge excitation 3.3V, all arms 1kΩ at 0°C
+    // ΔV ≈ Vexc/4 × ΔR/R0 → ΔR = ΔV × 4 × R0 / Vexc
+    float delta_r = voltage * 4.0f * 1000.0f / 3.3f;
+    float resistance = 1000.0f + delta_r;
+    float temp_c = (resistance / 1000.0f - 1.0f) / 0.00385f;
+
+    return temp_c;
+}
+
+// Pressure channel alone → level, for the sample wakes between cycles
+inline float read_level_ft(HalAdc &adc) {
+    float ft = pressure_psi_from_raw(adc.read_single_ended(CH_PRESSURE)) * PSI_TO_FT_WATER;
+    return ft < 0 ? 0 : ft;
+}
+
+// ADS1115 #1 block of a cycle: pressure → level, conductivity → TDS, PT1000
+inline void read_analog_sensors(FullReading &r, HalAdc &adc) {
+    r.pressure_psi   = pressure_psi_from_raw(adc.read_single_ended(CH_PRESSURE));
+    r.water_level_ft = r.pressure_psi * PSI_TO_FT_WATER;
+    if (r.water_level_ft < 0) r.water_level_ft = 0;
+
+    r.conductivity_us = conductivity_from_raw(adc.read_single_ended(CH_CONDUCTIVITY));
+    r.tds_ppm = r.conductivity_us * 0.55f;  // approximate conversion factor
+
+    r.water_temp_c = pt1000_temp_from_raw(adc.read_single_ended(CH_PT1000));
+}
+
+// ── Digital Sensors ─────────────────────────────────────────
+// Modbus and SDI-12 values override the analog measurement they duplicate.
+inline void apply_digital_values(FullReading &r, const DigitalValue *values, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const DigitalValue &v = values[i];
+        if (!v.ok) continue;
+        switch (v.quantity) {
+            case SQ_PRESSURE_PSI:
+                r.pressure_psi   = v.value;
+                r.water_level_ft = v.value * PSI_TO_FT_WATER;
+                if (r.water_level_ft < 0) r.water_level_ft = 0;
+                break;
+            case SQ_LEVEL_FT:
+                r.water_level_ft = v.value;
+                r.pressure_psi   = v.value / PSI_TO_FT_WATER;
+                break;
+            case SQ_TEMP_C:
+                r.water_temp_c = v.value;
+                break;
+            case SQ_EC_US:
+                r.conductivity_us = v.value;
+                r.tds_ppm         = v.value * 0.55f;
+                break;
+        }
+    }
+}
+
+// ── Transport Urgency ───────────────────────────────────────
+// Urgent on a step in conductivity or water level since the last reading
+// (nullptr on the first cycle)
+inline uint8_t reading_urgency(const FullReading &r, const FullReading *last) {
+    if (!last) return TX_ROUTINE;
+    if (fabsf(r.conductivity_us - last->conductivity_us) >= TX_URGENT_EC_STEP_US) return TX_URGENT;
+    if (fabsf(r.water_level_ft - last->water_level_ft) >= TX_URGENT_LEVEL_STEP_FT) return TX_URGENT;
+    return TX_ROUTINE;
+}
+
+// Transport policy parameters from config.h (see tx_policy.h)
+static const TxPolicyParams TX_POLICY = {
+    { { TX_LORA_ATTEMPT_J, TX_LORA_BYTE_J, 0.0f, TX_LORA_LATENCY_S, LORA_MAX_PAYLOAD },
+      { TX_CELL_ATTEMPT_J, TX_CELL_BYTE_J, TX_CELL_PRICE_J, TX_CELL_LATENCY_S, 0 } },
+    TX_ROUTINE_BUDGET_J, TX_QUEUE_MAX,
+    TX_BATT_OK_V, TX_BATT_LOW_V, TX_BATT_CRIT_V, TX_BATT_WEIGHT_MAX,
+    TX_STATS_DECAY, TX_STATS_RECOVER,
+};
+
+// ── Payload ─────────────────────────────────────────────────
+// build_json() is generated from hardware/schema/readings.py
+#include "reading_schema.h"
@@ -0,0 +1,140 @@
+// Generated by hardware/schema/gen_readings.py from readings.py. Do not edit.
+#pragma once
+#include "schema.h"
+
+// wx-flow payload, keys and precision as in hardware/schema/readings.py.
+// Serializes into buf (NUL-terminated); returns the payload length, 0 if
+// it did not fit.
+inline size_t build_json(const FullReading &r, char *buf, size_t cap) {
+    JsonOut out(buf, cap);
+    out.lit("{\"device_id\":");
+    out.str(DEVICE_ID);
+    out.lit(",\"device_type\":");
+    out.str(DEVICE_TYPE);
+    out.lit(",\"fw_version\":");
+    out.str(FIRMWARE_VERSION);
+    out.lit(",\"boot_count\":");
+    out.uint(r.boot_count);
+    out.lit(",\"flow\":{\"velocity_cm_day\":");
+    out.fixed<1>(r.flow.velocity_cm_day);
+    out.lit(",\"direction_deg\":");
+    out.fixed<0>(r.flow.direction_deg);
+    out.lit(",\"valid\":");
+    out.boolean(r.flow.valid);
+    out.lit(",\"peak_temps\":");
+    out.fixed_array<2>(r.flow.peak_temps, 4);
+    out.lit(",\"peak_times\":");
+    out.fixed_array<1>(r.flow.peak_times, 4);
+    out.lit("},\"conductivity_us\":");
+    out.fixed<0>(r.conductivity_us);
+    out.lit(",\"tds_ppm\":");
+    out.fixed<0>(r.tds_ppm);
+    out.lit(",\"water_temp_c\":");
+    out.fixed<1>(r.water_temp_c);
+    out.lit(",\"water_level_ft\":");
+    out.fixed<2>(r.water_level_ft);
+    out.lit(",\"pressure_psi\":");
+    out.fixed<3>(r.pressure_psi);
+    out.lit(",\"battery_v\":");
+    out.fixed<2>(r.battery_v);
+    out.lit(",\"solar_v\":");
+    out.fixed<2>(r.solar_v);
+    if (r.burst) {
+        out.lit(",\"burst\":");
+        out.str(pressure_event_name(r.burst));
+    }
+    if (r.batt.r_ohm > 0) {
+        out.lit(",\"batt_r_ohm\":");
+        out.fixed<3>(r.batt.r_ohm);
+    }
+    if (r.batt.min_v > 0) {
+        out.lit(",\"batt_min_v\":");
+        out.fixed<2>(r.batt.min_v);
+    }
+    if (r.campaign) {
+        out.lit(",\"campaign\":");
+        out.uint(r.campaign);
+        out.lit(",\"campaign_dt_s\":");
+        out.fixed<3>(r.campaign_dt_s);
+        out.lit(",\"clock_err_s\":");
+        out.fixed<3>(r.clock_err_s);
+    }
+    out.lit(",\"tx\":{\"route\":");
+    out.str(tx_route_name(r.tx.route));
+    out.lit(",\"reason\":");
+    out.str(tx_reason_name(r.tx.reason));
+    out.lit(",\"queued\":");
+    out.uint(r.tx.queued);
+    out.lit(",\"p_lora\":");
+    out.fixed<2>(r.tx.p[TX_LORA]);
+    out.lit(",\"p_cell\":");
+    out.fixed<2>(r.tx.p[TX_CELL]);
+    if (r.tx.route != TX_DEFER) {
+        out.lit(",\"cost_j\":");
+        out.fixed<1>(r.tx.cost_j[r.tx.route]);
+    }
+    out.lit("}}");
+    return out.finish();
+}
+
+// The same reading as a LoRa frame: short keys, arrays of objects as
+// value arrays, cellular-only fields left out (readings.py `air`).
+inline size_t build_air(const FullReading &r, char *buf, size_t cap) {
+    JsonOut out(buf, cap);
+    out.lit("{\"device_id\":");
+    out.str(DEVICE_ID);
+    out.lit(",\"device_type\":");
+    out.str(DEVICE_TYPE);
+    out.lit(",\"n\":");
+    out.uint(r.boot_count);
+    out.lit(",\"f\":{\"v\":");
+    out.fixed<1>(r.flow.velocity_cm_day);
+    out.lit(",\"d\":");
+    out.fixed<0>(r.flow.direction_deg);
+    out.lit(",\"ok\":");
+    out.boolean(r.flow.valid);
+    out.lit(",\"pt\":");
+    out.fixed_array<2>(r.flow.peak_temps, 4);
+    out.lit(",\"ps\":");
+    out.fixed_array<1>(r.flow.peak_times, 4);
+    out.lit("},\"ec\":");
+    out.fixed<0>(r.conductivity_us);
+    out.lit(",\"td\":");
+    out.fixed<0>(r.tds_ppm);
+    out.lit(",\"wt\":");
+    out.fixed<1>(r.water_temp_c);
+    out.lit(",\"wl\":");
+    out.fixed<2>(r.water_level_ft);
+    out.lit(",\"p\":");
+    out.fixed<3>(r.pressure_psi);
+    out.lit(",\"bv\":");
+    out.fixed<2>(r.battery_v);
+    out.lit(",\"sv\":");
+    out.fixed<2>(r.solar_v);
+    if (r.burst) {
+        out.lit(",\"bu\":");
+        out.str(pressure_event_name(r.burst));
+    }
+    if (r.batt.r_ohm > 0) {
+        out.lit(",\"br\":");
+        out.fixed<3>(r.batt.r_ohm);
+    }
+    if (r.batt.min_v > 0) {
+        out.lit(",\"bm\":");
+        out.fixed<2>(r.batt.min_v);
+    }
+    if (r.campaign) {
+        out.lit(",\"cp\":");
+        out.uint(r.campaign);
+        out.lit(",\"cd\":");
+        out.fixed<3>(r.campaign_dt_s);
+        out.lit(",\"ce\":");
+        out.fixed<3>(r.clock_err_s);
+    }
+    out.lit("}");
+    return out.finish();
+}
+
+// Longest frame build_air() writes: every conditional field present,
+// numbers and strings at their readings.py span / width.
+static constexpr size_t AIR_MAX_BYTES = 302 + (sizeof(DEVICE_ID) - 1) + (sizeof(DEVICE_TYPE) - 1);
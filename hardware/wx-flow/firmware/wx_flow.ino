@@ -6,55 +6,130 @@
  *   - Groundwater flow velocity & direction (heat pulse method)
  *   - Conductivity / TDS
  *   - Temperature (PT1000 RTD)
- *   - Water level (submersible pressure transducer)
+ *   - Water level (submersible pressure transducer), sampled between
+ *     cycles to run heat-pulse bursts around pumping events
+ *   - Optional digital sondes on RS-485 Modbus RTU and SDI-12
  * Transmits via LoRa (primary) + LTE Cat-M1 (fallback).
  */
 
+#include <time.h>
 #include <Wire.h>
 #include <SPI.h>
 #include <LoRa.h>
 #include <Adafruit_ADS1X15.h>
 #include <ArduinoJson.h>
+#include <sys/time.h>
+#include "modbus_rtu.h"
+#include "modbus_port_esp32.h"
+#include "sdi12.h"
+#include "sdi12_port_esp32.h"
+#include "sim7000.h"
 #include "config.h"
+#include "hal_arduino.h"
+#include "adc_trace.h"
+#include "adc_trace_store.h"
 #include "heat_pulse.h"
+#include "campaign.h"
+#include "reading.h"
 
 // ── Globals ─────────────────────────────────────────────────
 Adafruit_ADS1115 ads_sensors;  // pressure, conductivity, PT1000
 Adafruit_ADS1115 ads_therm;    // 4 thermistors
+Ads1115Adc       sensors_adc(ads_sensors);
+Ads1115Adc       therm_adc(ads_therm);
+ArduinoClock     hal_clock;
+ArduinoGpio      hal_gpio;
+LoRaRadio        lora_radio;
+Esp32SupplyStream supply_stream(PIN_BATTERY_ADC, PIN_SOLAR_ADC, SAG_DIVIDER);
+static bool      lora_started = false;   // sample wakes leave the radio asleep
 
 RTC_DATA_ATTR uint32_t boot_count = 0;
 RTC_DATA_ATTR uint32_t tx_fail_count = 0;
+RTC_DATA_ATTR uint32_t next_report_s = 0;    // unit clock; pressure sample wakes until then
+RTC_DATA_ATTR PressureWatch pressure_watch;  // level baseline and burst in progress
+#if HEAT_HISTORY
+RTC_DATA_ATTR ThermalHistory heat_history;   // residual of recent pulses
+#endif
+RTC_DATA_ATTR TxLinkStats tx_stats[2];       // delivery history, [TX_LORA], [TX_CELL]
+RTC_DATA_ATTR FullReading tx_queue[TX_QUEUE_MAX];   // deferred or unsent readings
+RTC_DATA_ATTR uint8_t     tx_queued = 0;
+RTC_DATA_ATTR FullReading last_reading;
+RTC_DATA_ATTR ClockSync   clock_sync;        // unit clock → UTC, from ingest replies
+RTC_DATA_ATTR Campaign    campaign;          // next synoptic campaign, id 0 = none
+RTC_DATA_ATTR BatteryHealth batt_health;     // internal resistance and sag under load
+
+static const BurstParams BURST = {
+    BURST_TRIGGER_FT, BURST_STABLE_FT, BURST_STABLE_SAMPLES, BURST_BASELINE_S,
+    BURST_INTERVAL_MS / 1000, BURST_MAX_PULSES, BURST_PULSE_J, BURST_BUDGET_J_DAY,
+    BURST_MIN_BATT_V,
+};
+
+static const ClockParams CLOCK = {
+    CLOCK_DRIFT_PPM, CLOCK_RESIDUAL_PPM, CLOCK_SKEW_MIN_S, CLOCK_SYNC_MAX_S,
+};
 
-struct FullReading {
-    FlowResult flow;
-    float conductivity_us;
-    float tds_ppm;
-    float water_temp_c;
-    float water_level_ft;
-    float pressure_psi;
-    float battery_v;
-    float solar_v;
+static const SagParams SAG = {
+    SAG_R_WEIGHT, SAG_SOLAR_STEADY_V, SAG_MIN_SAMPLES, SAG_BROWNOUT_V,
 };
 
+// Both converters are read through the trace recorder; it only logs once
+// adc_trace.begin() has been called (TRACE_RECORD)
+static AdcTraceSample trace_buf[TRACE_RECORD ? TRACE_MAX_SAMPLES : 1];
+AdcTrace     adc_trace(trace_buf, TRACE_RECORD ? TRACE_MAX_SAMPLES : 0);
+RecordingAdc sensors_rec(sensors_adc, adc_trace, TRACE_ADC_SENSORS);
+RecordingAdc therm_rec(therm_adc, adc_trace, TRACE_ADC_THERM);
+
+#if MODBUS_FIELD_COUNT > 0
+static const ModbusField MODBUS_FIELD_CFG[MODBUS_FIELD_COUNT] = MODBUS_FIELDS;
+#endif
+#if SDI12_FIELD_COUNT > 0
+static const Sdi12Field  SDI12_FIELD_CFG[SDI12_FIELD_COUNT] = SDI12_FIELDS;
+#endif
+
 // ── Forward Declarations ────────────────────────────────────
 FullReading read_all();
-float       read_pressure_psi();
-float       read_conductivity();
-float       read_pt1000_temp();
 float       read_battery_voltage();
 float       read_solar_voltage();
-float       mapf(float x, float in_min, float in_max, float out_min, float out_max);
+void        sag_start(SagCapture &sag);
+void        sag_finish(SagCapture &sag, float load_a);
+bool        cell_brownout(float battery_v);
+float       heater_loaded_v(float battery_v);
+void        read_modbus(FullReading &r);
+void        read_sdi12(FullReading &r);
+void        choose_transport(FullReading &r, bool lora_ok, bool sync);
 bool        send_lora(const FullReading &r);
 bool        send_cellular(const FullReading &r);
-String      build_json(const FullReading &r);
+void        queue_add(const FullReading &r);
+size_t      queue_bytes();
+bool        queue_post(Sim7000 &modem);
+bool        queue_flush();
+void        handle_server_reply(Sim7000 &modem, const char *reply, int64_t sent_ms,
+                                int64_t recv_ms);
 void        enter_deep_sleep();
 void        sim_power_on();
-void        sim_power_off();
 
 // ── Setup ───────────────────────────────────────────────────
 void setup() {
     Serial.begin(115200);
-    boot_count++;
+    // Scheduled cycles and burst pulses run the full cycle; the wakes
+    // between them only sample the pressure
+    uint32_t now_s = (uint32_t)time(nullptr);   // RTC clock, runs through deep sleep
+    bool report = boot_count == 0 || (int32_t)(now_s - next_report_s) >= 0 ||
+                  PRESSURE_SAMPLE_MS == 0;
+    bool burst = burst_pulse_due(pressure_watch, now_s);
+
+    // A campaign instant; one missed by more than its error budget is dropped
+    int64_t read_ms = unit_clock_ms();
+    bool snapshot = false;
+    if (campaign.id && clock_sync.synced_ms) {
+        int64_t late = read_ms - campaign_unit_ms(clock_sync, campaign);
+        if (late > (int64_t)campaign.max_err_ms) {
+            Serial.printf("Campaign %u missed by %.1f s\n", campaign.id, late / 1000.0);
+            campaign.id = 0;
+        } else {
+            snapshot = late >= -CAMPAIGN_EARLY_MS;
+        }
+    }
 
     Wire.begin(PIN_SDA, PIN_SCL);
 
@@ -64,6 +139,22 @@ void setup() {
     }
     ads_sensors.setGain(GAIN_ONE);
 
+    if (!report && !burst && !snapshot) {
+        float level_ft = read_level_ft(sensors_adc);
+        if (!pressure_watch_sample(pressure_watch, BURST, level_ft, now_s,
+                                   heater_loaded_v(read_battery_voltage()))) {
+            enter_deep_sleep();
+        }
+        Serial.printf("Level %.2f ft, %.2f ft from baseline: %s burst\n", level_ft,
+                      level_ft - pressure_watch.base_ft,
+                      pressure_event_name(pressure_watch.event));
+        burst = true;
+    }
+    // Bursts and snapshots are cycles out of schedule: the next scheduled
+    // one stays where it was
+    if (report) next_report_s = now_s + TX_INTERVAL_MS / 1000;
+    boot_count++;
+
     // ADS1115 #2 — thermistor channels
     if (!ads_therm.begin(ADS_ADDR_THERM)) {
         Serial.println("ADS #2 (thermistors) not found");
@@ -74,6 +165,7 @@ void setup() {
     LoRa.setPins(PIN_LORA_CS, PIN_LORA_RST, PIN_LORA_DIO0);
     SPI.begin(PIN_LORA_SCK, PIN_LORA_MISO, PIN_LORA_MOSI, PIN_LORA_CS);
     bool lora_ok = LoRa.begin(LORA_FREQ);
+    lora_started = true;
     if (lora_ok) {
         LoRa.setSpreadingFactor(LORA_SPREAD_FACTOR);
         LoRa.setSignalBandwidth(LORA_BANDWIDTH);
@@ -82,6 +174,26 @@ void setup() {
 
     // Read everything (including ~65s heat pulse cycle)
     FullReading reading = read_all();
+    if (burst && !report) reading.burst = pressure_watch.event;
+    if (burst || report) {
+        burst_pulse_done(pressure_watch, BURST, now_s, !report,
+                         heater_loaded_v(reading.battery_v));
+    }
+    if (snapshot) {
+        // The cycle's start is the measurement time, as for the heat pulse
+        reading.campaign = campaign.id;
+        campaign_offset(clock_sync, CLOCK, campaign, read_ms, reading.campaign_dt_s,
+                        reading.clock_err_s);
+        campaign.id = 0;
+    }
+
+#if TRACE_RECORD
+    Serial.printf("Trace: %u conversions (%u dropped)\n",
+                  adc_trace.header.count, adc_trace.header.dropped);
+    if (!trace_store_begin() || !trace_store_save(adc_trace, TRACE_KEEP)) {
+        Serial.println("Trace: save to flash failed");
+    }
+#endif
 
     Serial.printf("Boot #%u | Flow: %.1f cm/day @ %.0f° | EC: %.0f µS/cm | "
                   "T: %.1f°C | WL: %.2f ft | Batt: %.2fV\n",
@@ -90,13 +202,36 @@ void setup() {
                   reading.water_temp_c, reading.water_level_ft,
                   reading.battery_v);
 
-    // Transmit
+    // Transmit: the transport policy picks LoRa, cellular or the queue.
+    // Urgent readings fall back to the other link; routine ones that fail
+    // wait in the queue. send_cellular() takes the queue along. A clock too
+    // old or too loose for the next campaign sends the reading cellular,
+    // for the sync in the reply.
+    bool sync = clock_wants_sync(clock_sync, CLOCK, campaign, unit_clock_ms());
+    choose_transport(reading, lora_ok, sync);
+    uint8_t route = reading.tx.route;
     bool sent = false;
-    if (lora_ok) sent = send_lora(reading);
-    if (!sent) sent = send_cellular(reading);
+    if (route == TX_LORA) {
+        sent = send_lora(reading);
+        tx_record(TX_POLICY, tx_stats[TX_LORA], sent);
+    }
+    if (route == TX_CELL || (route == TX_LORA && !sent && reading.tx.reason == TX_WHY_URGENT)) {
+        sent = send_cellular(reading);
+        tx_record(TX_POLICY, tx_stats[TX_CELL], sent);
+    }
 
-    if (!sent) tx_fail_count++;
-    else tx_fail_count = 0;
+    if (!sent) {
+        if (route != TX_DEFER) tx_fail_count++;
+        queue_add(reading);
+    } else {
+        tx_fail_count = 0;
+        if (route == TX_LORA && tx_flush_queue(TX_POLICY, tx_stats, tx_queued,
+                                               queue_bytes(), reading.battery_v,
+                                               cell_brownout(reading.battery_v))) {
+            tx_record(TX_POLICY, tx_stats[TX_CELL], queue_flush());
+        }
+    }
+    last_reading = reading;
 
     enter_deep_sleep();
 }
@@ -105,67 +240,50 @@ void loop() {}
 
 // ── Full Reading ────────────────────────────────────────────
 FullReading read_all() {
-    FullReading r;
-
-    // Heat pulse flow measurement (~65 seconds)
+    FullReading r = {};
+    r.boot_count = boot_count;
+#if TRACE_RECORD
+    adc_trace.begin(hal_clock, DEVICE_TYPE, DEVICE_ID, boot_count);
+#endif
+
+    // Heat pulse flow measurement (~65 seconds; coded ~4 minutes). The
+    // supply is captured from before the heater comes on until it goes off.
     Serial.println("Starting heat pulse measurement...");
-    r.flow = run_heat_pulse(ads_therm);
+    SagCapture sag(supply_stream, hal_clock, SAG_SAMPLE_HZ, SAG_PREROLL_MS);
+    SagGpio    heater_gpio(hal_gpio, PIN_HEATER, sag);
+    if (SAG_CAPTURE) sag.begin();
+#if HEAT_MODE == HEAT_MODE_CODED
+    r.flow = run_coded_heat_pulse(therm_rec, hal_clock, heater_gpio);
+    sag_finish(sag, 0);                         // PWM keyed: no clean current step
+#elif HEAT_HISTORY
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);                 // RTC clock, runs through deep sleep
+    heat_history.sync((int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000, hal_clock.now_ms());
+    r.flow = run_heat_pulse(therm_rec, hal_clock, heater_gpio, HeatPulseParams(), &heat_history);
+    sag_finish(sag, SAG_HEATER_A);
+#else
+    r.flow = run_heat_pulse(therm_rec, hal_clock, heater_gpio);
+    sag_finish(sag, SAG_HEATER_A);
+#endif
     Serial.printf("Flow: %.1f cm/day, direction: %.0f°, valid: %d\n",
                   r.flow.velocity_cm_day, r.flow.direction_deg, r.flow.valid);
 
-    // Pressure → water level
-    r.pressure_psi  = read_pressure_psi();
-    r.water_level_ft = r.pressure_psi * PSI_TO_FT_WATER;
-    if (r.water_level_ft < 0) r.water_level_ft = 0;
+    // Pressure → water level, conductivity, PT1000 temperature
+    read_analog_sensors(r, sensors_rec);
 
-    // Conductivity
-    r.conductivity_us = read_conductivity();
-    r.tds_ppm = r.conductivity_us * 0.55f;  // approximate conversion factor
+    // Digital sondes override the analog values they duplicate
+    read_modbus(r);
+    read_sdi12(r);
 
-    // Temperature
-    r.water_temp_c = read_pt1000_temp();
-
-    // Power
+    // Power; sag under the loads since the last reading
     r.battery_v = read_battery_voltage();
     r.solar_v   = read_solar_voltage();
+    r.batt      = battery_report(batt_health);
 
     return r;
 }
 
-// ── Individual Sensor Reads ─────────────────────────────────
-float read_pressure_psi() {
-    int16_t raw = ads_sensors.readADC_SingleEnded(CH_PRESSURE);
-    float voltage = raw * 0.000125f;
-    float psi = mapf(voltage, PRESSURE_V_MIN, PRESSURE_V_MAX,
-                     PRESSURE_PSI_MIN, PRESSURE_PSI_MAX);
-    return constrain(psi, PRESSURE_PSI_MIN, PRESSURE_PSI_MAX);
-}
-
-float read_conductivity() {
-    // Atlas EZO-EC or DFRobot outputs 0–3.0V proportional to conductivity
-    // 0V = 0 µS/cm, 3.0V = 100,000 µS/cm (adjustable via calibration)
-    int16_t raw = ads_sensors.readADC_SingleEnded(CH_CONDUCTIVITY);
-    float voltage = raw * 0.000125f;
-    return mapf(voltage, 0.0f, 3.0f, 0.0f, 100000.0f);
-}
-
-float read_pt1000_temp() {
-    // PT1000 in Wheatstone bridge with 1kΩ references
-    // Output voltage is proportional to resistance deviation
-    // PT1000: R = 1000 × (1 + 0.00385 × T)
-    // Bridge output ΔV → ΔR → T
-    int16_t raw = ads_sensors.readADC_SingleEnded(CH_PT1000);
-    float voltage = raw * 0.000125f;
-
-    // Approximate: bridge excitation 3.3V, all arms 1kΩ at 0°C
-    // ΔV ≈ Vexc/4 × ΔR/R0 → ΔR = ΔV × 4 × R0 / Vexc
-    float delta_r = voltage * 4.0f * 1000.0f / 3.3f;
-    float resistance = 1000.0f + delta_r;
-    float temp_c = (resistance / 1000.0f - 1.0f) / 0.00385f;
-
-    return temp_c;
-}
-
+// ── Power Rails ─────────────────────────────────────────────
 float read_battery_voltage() {
     int raw = analogRead(PIN_BATTERY_ADC);
     return (raw / 4095.0f) * 3.3f * 2.0f;
@@ -176,113 +294,282 @@ float read_solar_voltage() {
     return (raw / 4095.0f) * 3.3f * 2.0f;
 }
 
-float mapf(float x, float in_min, float in_max, float out_min, float out_max) {
-    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+// ── Battery Sag ─────────────────────────────────────────────
+// A capture spans one heavy load: sag_start() before it is switched on
+// (or SagGpio marks the switch-on), sag_finish() once it is off. load_a 0 =
+// current step unknown, only the minimum counts.
+void sag_start(SagCapture &sag) {
+    if (SAG_CAPTURE && sag.begin()) sag.load_on();
+}
+
+void sag_finish(SagCapture &sag, float load_a) {
+    sag.load_off();
+    SagMeasurement m = sag_measure(sag.result(), load_a, SAG);
+    battery_health_update(batt_health, m, SAG);
+    if (m.min_v > 0) {
+        Serial.printf("Battery sag: %.3f V rest, %.3f V min | R %.0f mΩ (%u)\n",
+                      m.rest_v, m.min_v, batt_health.r_ohm * 1000.0f, batt_health.r_count);
+    }
+}
+
+// A cellular session from battery_v would sag the cell below brownout
+bool cell_brownout(float battery_v) {
+    return battery_brownout_risk(batt_health, SAG, battery_v, SAG_CELL_PEAK_A);
+}
+
+// What the battery is expected to hold under the heater
+float heater_loaded_v(float battery_v) {
+    return battery_loaded_v(batt_health, battery_v, SAG_HEATER_A);
+}
+
+// ── Digital Sensors ─────────────────────────────────────────
+void read_modbus(FullReading &r) {
+#if MODBUS_FIELD_COUNT > 0
+    Esp32ModbusPort port(MODBUS_UART, PIN_RS485_TX, PIN_RS485_RX, PIN_RS485_DE, MODBUS_BAUD);
+    if (!port.begin()) {
+        Serial.println("Modbus UART init failed");
+        return;
+    }
+    if (millis() < MODBUS_WARMUP_MS) delay(MODBUS_WARMUP_MS - millis());
+
+    ModbusBlock  blocks[MODBUS_FIELD_COUNT];
+    DigitalValue values[MODBUS_FIELD_COUNT];
+    size_t nb = modbus_plan_blocks(MODBUS_FIELD_CFG, MODBUS_FIELD_COUNT,
+                                   blocks, MODBUS_FIELD_COUNT);
+    ModbusMaster master(port, MODBUS_BAUD, MODBUS_TIMEOUT_MS);
+    size_t n_ok = master.poll(MODBUS_FIELD_CFG, blocks, nb, values);
+    port.end();
+
+    Serial.printf("Modbus: %u/%u fields in %u blocks (timeouts %u, CRC %u, exc %u)\n",
+                  n_ok, MODBUS_FIELD_COUNT, nb, master.stats.timeouts,
+                  master.stats.crc_errors, master.stats.exceptions);
+    apply_digital_values(r, values, MODBUS_FIELD_COUNT);
+#else
+    (void)r;
+#endif
+}
+
+void read_sdi12(FullReading &r) {
+#if SDI12_FIELD_COUNT > 0
+    Esp32Sdi12Port port(SDI12_UART, PIN_SDI12_TX, PIN_SDI12_RX, PIN_SDI12_DIR);
+    if (!port.begin()) {
+        Serial.println("SDI-12 UART init failed");
+        return;
+    }
+
+    DigitalValue values[SDI12_FIELD_COUNT];
+    Sdi12Master master(port);
+    size_t n_ok = master.measure(SDI12_FIELD_CFG, SDI12_FIELD_COUNT, values);
+    port.end();
+
+    Serial.printf("SDI-12: %u/%u values in %u ms (retries %u, no response %u)\n",
+                  n_ok, SDI12_FIELD_COUNT, master.elapsed_ms,
+                  master.stats.retries, master.stats.no_response);
+    apply_digital_values(r, values, SDI12_FIELD_COUNT);
+#else
+    (void)r;
+#endif
+}
+
+// ── Transport Policy ────────────────────────────────────────
+// Decides how this reading goes out and records the decision in it, so it
+// reaches the backend with the payload
+void choose_transport(FullReading &r, bool lora_ok, bool sync) {
+    tx_stats_tick(TX_POLICY, tx_stats);
+    r.tx = TxDecision();
+    char json[JSON_MAX_PAYLOAD];
+    TxRequest rq;
+    rq.bytes       = build_json(r, json, sizeof(json));
+    rq.air_bytes   = build_air(r, json, LORA_MAX_PAYLOAD + 1);
+    rq.queue_bytes = queue_bytes();
+    rq.queued      = tx_queued;
+    rq.urgency     = reading_urgency(r, r.boot_count > 1 ? &last_reading : nullptr);
+    rq.battery_v   = r.battery_v;
+    rq.lora_up     = lora_ok;
+    rq.cell_brownout = cell_brownout(r.battery_v);
+    r.tx = tx_decide(TX_POLICY, tx_stats, rq);
+    // A clock sync only comes back over cellular; not on a critical battery
+    if (sync && r.tx.route != TX_CELL && r.tx.reason != TX_WHY_LOW_BATT &&
+        r.tx.reason != TX_WHY_NO_LINK && !rq.cell_brownout) {
+        r.tx.route  = TX_CELL;
+        r.tx.reason = TX_WHY_SYNC;
+    }
+    Serial.printf("TX policy: %s (%s) | p LoRa %.2f cell %.2f | %.1f / %.1f J | %u queued\n",
+                  tx_route_name(r.tx.route), tx_reason_name(r.tx.reason),
+                  r.tx.p[TX_LORA], r.tx.p[TX_CELL],
+                  r.tx.cost_j[TX_LORA], r.tx.cost_j[TX_CELL], r.tx.queued);
 }
 
 // ── LoRa ────────────────────────────────────────────────────
 bool send_lora(const FullReading &r) {
-    String json = build_json(r);
-    LoRa.beginPacket();
-    LoRa.print(json);
-    bool ok = LoRa.endPacket();
+    // The compact frame (build_air); 0 when even that exceeds the FIFO
+    char frame[LORA_MAX_PAYLOAD + 1];
+    size_t len = build_air(r, frame, sizeof(frame));
+    if (!len) {
+        Serial.println("LoRa TX: frame exceeds LORA_MAX_PAYLOAD, skipping");
+        return false;
+    }
+    bool ok = lora_radio.send((const uint8_t *)frame, len);
     Serial.printf("LoRa TX: %s\n", ok ? "OK" : "FAIL");
     return ok;
 }
 
 // ── Cellular ────────────────────────────────────────────────
 bool send_cellular(const FullReading &r) {
+    SagCapture sag(supply_stream, hal_clock, SAG_SAMPLE_HZ, SAG_PREROLL_MS);
+    sag_start(sag);
     Serial1.begin(115200, SERIAL_8N1, PIN_SIM_RX, PIN_SIM_TX);
     sim_power_on();
-    delay(3000);
-
-    Serial1.println("AT");
-    delay(500);
-    Serial1.println("AT+CNACT=1,\"" APN "\"");
-    delay(3000);
-
-    String json = build_json(r);
-
-    Serial1.println("AT+SHCONF=\"URL\",\"https://" SERVER_HOST API_ENDPOINT "\"");
-    delay(500);
-    Serial1.println("AT+SHCONF=\"BODYLEN\",2048");
-    delay(500);
-    Serial1.println("AT+SHCONF=\"HEADERLEN\",350");
-    delay(500);
-    Serial1.println("AT+SHCONN");
-    delay(3000);
-    Serial1.println("AT+SHCHEAD");
-    delay(200);
-    Serial1.println("AT+SHAHEAD=\"Content-Type\",\"application/json\"");
-    delay(200);
-    Serial1.printf("AT+SHBOD=%d,10000\r\n", json.length());
-    delay(200);
-    Serial1.print(json);
-    delay(1000);
-    Serial1.println("AT+SHREQ=\"" API_ENDPOINT "\",3");
-    delay(5000);
 
-    String resp = "";
-    unsigned long start = millis();
-    while (millis() - start < 5000) {
-        if (Serial1.available()) resp += (char)Serial1.read();
+    ArduinoSerial sim_io(Serial1);
+    Sim7000 modem(sim_io, hal_clock);
+    bool ok = false;
+    if (modem.attach(APN) && modem.http_open("https://" SERVER_HOST)) {
+        char json[JSON_MAX_PAYLOAD];
+        size_t len = build_json(r, json, sizeof(json));
+        char reply[256];
+        int64_t sent_ms = unit_clock_ms();
+        int status = modem.http_post(API_ENDPOINT, "application/json",
+                                     (const uint8_t *)json, len, reply, sizeof(reply));
+        ok = status == 200;
+        if (ok) handle_server_reply(modem, reply, sent_ms, unit_clock_ms());
+        if (ok && tx_queued) queue_post(modem);
+        modem.http_close();
     }
+    modem.detach();
+    modem.power_off();
+    sag_finish(sag, 0);
 
-    Serial1.println("AT+SHDISC");
-    delay(500);
-    Serial1.println("AT+CNACT=0");
-    sim_power_off();
-
-    bool ok = resp.indexOf("200") >= 0;
     Serial.printf("Cell TX: %s\n", ok ? "OK" : "FAIL");
     return ok;
 }
 
-// ── JSON ────────────────────────────────────────────────────
-String build_json(const FullReading &r) {
+// The ingest reply carries the backend's clock ("utc_ms", sent_ms to
+// recv_ms being the exchange that fetched it), can carry a campaign
+// ("campaign") and ask for a stored ADC trace ("upload_trace": boot,
+// 0 = this cycle); the trace goes up on the connection that is already open
+void handle_server_reply(Sim7000 &modem, const char *reply, int64_t sent_ms, int64_t recv_ms) {
     JsonDocument doc;
-
-    doc["device_id"]   = DEVICE_ID;
-    doc["device_type"] = DEVICE_TYPE;
-    doc["fw_version"]  = FIRMWARE_VERSION;
-    doc["boot_count"]  = boot_count;
-
-    // Flow data
-    JsonObject flow = doc["flow"].to<JsonObject>();
-    flow["velocity_cm_day"] = roundf(r.flow.velocity_cm_day * 10) / 10.0f;
-    flow["direction_deg"]   = roundf(r.flow.direction_deg);
-    flow["valid"]           = r.flow.valid;
-    JsonArray peaks = flow["peak_temps"].to<JsonArray>();
-    JsonArray times = flow["peak_times"].to<JsonArray>();
-    for (int i = 0; i < 4; i++) {
-        peaks.add(roundf(r.flow.peak_temps[i] * 100) / 100.0f);
-        times.add(roundf(r.flow.peak_times[i] * 10) / 10.0f);
+    if (deserializeJson(doc, reply)) return;
+    if (doc["utc_ms"].is<int64_t>()) {
+        clock_sync_update(clock_sync, CLOCK, sent_ms, recv_ms, doc["utc_ms"].as<int64_t>());
+    }
+    JsonObjectConst c = doc["campaign"];
+    if (doc["campaign"].is<JsonObjectConst>() && c["id"].as<uint32_t>() != campaign.id) {
+        campaign.id = c["id"].as<uint32_t>();
+        campaign.at_utc_ms = c["at"].as<int64_t>() * 1000;
+        campaign.max_err_ms = c["max_err_ms"].as<uint32_t>();
+        Serial.printf("Campaign %u scheduled, clock error then %u ms\n", campaign.id,
+                      clock_error_ms(clock_sync, CLOCK, campaign_unit_ms(clock_sync, campaign)));
     }
+#if TRACE_RECORD
+    if (!doc["upload_trace"].is<uint32_t>()) return;
+    uint32_t boot = doc["upload_trace"].as<uint32_t>();
+    if (boot == 0) boot = boot_count;
+    bool ok = trace_store_upload(modem, boot, TRACE_KEEP, TRACE_PATH, TRACE_UPLOAD_CHUNK);
+    Serial.printf("Trace upload (boot %u): %s\n", boot, ok ? "OK" : "FAIL");
+#else
+    (void)modem;
+#endif
+}
 
-    // Water quality
-    doc["conductivity_us"] = roundf(r.conductivity_us);
-    doc["tds_ppm"]         = roundf(r.tds_ppm);
-    doc["water_temp_c"]    = roundf(r.water_temp_c * 10) / 10.0f;
+// ── Queue ───────────────────────────────────────────────────
+// Whole readings wait in RTC memory; when full the oldest is dropped
+void queue_add(const FullReading &r) {
+    if (tx_queued == TX_QUEUE_MAX) {
+        memmove(tx_queue, tx_queue + 1, (TX_QUEUE_MAX - 1) * sizeof(FullReading));
+        tx_queued--;
+        Serial.println("Queue full, oldest reading dropped");
+    }
+    tx_queue[tx_queued++] = r;
+    Serial.printf("Queue: %u readings\n", tx_queued);
+}
 
-    // Water level
-    doc["water_level_ft"]  = roundf(r.water_level_ft * 100) / 100.0f;
-    doc["pressure_psi"]    = roundf(r.pressure_psi * 1000) / 1000.0f;
+// Payload bytes the queue would add to a cellular session
+size_t queue_bytes() {
+    char json[JSON_MAX_PAYLOAD];
+    size_t n = 0;
+    for (int i = 0; i < tx_queued; i++) n += build_json(tx_queue[i], json, sizeof(json)) + 1;
+    return n;
+}
 
-    // Power
-    doc["battery_v"] = roundf(r.battery_v * 100) / 100.0f;
-    doc["solar_v"]   = roundf(r.solar_v * 100) / 100.0f;
+// Uploads the queue as one JSON array on an open HTTP session and, on
+// success, clears what it sent; readings left out stay queued
+bool queue_post(Sim7000 &modem) {
+    static char body[TX_QUEUE_MAX * JSON_MAX_PAYLOAD + 2];
+    bool sent[TX_QUEUE_MAX];
+    uint8_t n_sent = 0;
+    size_t len = 0;
+    body[len++] = '[';
+    for (int i = 0; i < tx_queued; i++) {
+        size_t start = len;
+        if (len > 1) body[len++] = ',';
+        size_t n = build_json(tx_queue[i], body + len, sizeof(body) - len - 1);
+        sent[i] = n > 0;
+        if (!n) {
+            len = start;                // did not fit: leave it out, comma and all
+            continue;
+        }
+        len += n;
+        n_sent++;
+    }
+    body[len++] = ']';
+    char reply[256];
+    int status = modem.http_post(API_BATCH_ENDPOINT, "application/json",
+                                 (const uint8_t *)body, len, reply, sizeof(reply));
+    Serial.printf("Queue TX: %u of %u readings, %u B → %d\n",
+                  n_sent, tx_queued, (unsigned)len, status);
+    if (status != 200) return false;
+    uint8_t kept = 0;
+    for (int i = 0; i < tx_queued; i++) {
+        if (!sent[i]) tx_queue[kept++] = tx_queue[i];
+    }
+    if (kept) Serial.printf("Queue: %u readings did not fit the batch, kept\n", kept);
+    tx_queued = kept;
+    return true;
+}
 
-    String out;
-    serializeJson(doc, out);
-    return out;
+// After a LoRa send: one cellular session just for the queue
+bool queue_flush() {
+    SagCapture sag(supply_stream, hal_clock, SAG_SAMPLE_HZ, SAG_PREROLL_MS);
+    sag_start(sag);
+    Serial1.begin(115200, SERIAL_8N1, PIN_SIM_RX, PIN_SIM_TX);
+    sim_power_on();
+    ArduinoSerial sim_io(Serial1);
+    Sim7000 modem(sim_io, hal_clock);
+    bool ok = false;
+    if (modem.attach(APN) && modem.http_open("https://" SERVER_HOST)) {
+        ok = queue_post(modem);
+        modem.http_close();
+    }
+    modem.detach();
+    modem.power_off();
+    sag_finish(sag, 0);
+    return ok;
 }
 
 // ── Power Management ────────────────────────────────────────
+// Until the next scheduled cycle, burst pulse or pressure sample, or to
+// the campaign instant, whichever comes first
 void enter_deep_sleep() {
-    LoRa.sleep();
-    Serial.printf("Sleeping for %lu ms\n", TX_INTERVAL_MS);
+    if (lora_started) lora_radio.sleep();
+    uint64_t sleep_us = DEEP_SLEEP_US;
+    if (PRESSURE_SAMPLE_MS > 0) {
+        uint32_t next_s = next_report_s;
+        if (pressure_watch.event && (int32_t)(pressure_watch.next_pulse_s - next_s) < 0) {
+            next_s = pressure_watch.next_pulse_s;
+        }
+        int32_t to_next = (int32_t)(next_s - (uint32_t)time(nullptr));
+        sleep_us = to_next > 0 ? to_next * 1000000ULL : 1000000ULL;
+        if (sleep_us > PRESSURE_SAMPLE_MS * 1000ULL) sleep_us = PRESSURE_SAMPLE_MS * 1000ULL;
+    }
+    if (campaign.id && clock_sync.synced_ms) {
+        int64_t to_ms = campaign_unit_ms(clock_sync, campaign) - unit_clock_ms();
+        if (to_ms > 0 && (uint64_t)to_ms * 1000ULL < sleep_us) sleep_us = (uint64_t)to_ms * 1000ULL;
+    }
+    Serial.printf("Sleeping for %lu ms\n", (unsigned long)(sleep_us / 1000));
     Serial.flush();
-    esp_sleep_enable_timer_wakeup(DEEP_SLEEP_US);
+    esp_sleep_enable_timer_wakeup(sleep_us);
     esp_deep_sleep_start();
 }
 
@@ -292,8 +579,3 @@ void sim_power_on() {
     delay(1000);
     digitalWrite(PIN_SIM_PWR, LOW);
 }
-
-void sim_power_off() {
-    Serial1.println("AT+CPOWD=1");
-    delay(2000);
-}
@@ -0,0 +1,157 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "http_client.h"
+
+/*
+ * Forwards tagged readings to POST /hardware/data/batch.
+ *
+ * Records wait in a bounded queue. `inflight` sender threads, each with
+ * its own keep-alive connection, take up to `batch_max` records at a time
+ * (waiting up to `linger_ms` for a batch to fill) so several batches are
+ * on the wire at once. A batch that fails on transport, 5xx or 429 is
+ * retried with exponential backoff while the queue absorbs new records;
+ * a 4xx other than 429 means the backend will never take it and it is
+ * dropped. When the queue is full the oldest records are dropped.
+ */
+
+struct SinkParams {
+    uint32_t batch_max    = 100;
+    uint32_t linger_ms    = 200;
+    uint32_t inflight     = 4;
+    size_t   queue_max    = 200000;
+    uint32_t backoff_ms   = 500;
+    uint32_t backoff_max_ms = 30000;
+    uint32_t timeout_ms   = 10000;
+};
+
+struct SinkStats {
+    std::atomic<uint64_t> queued{ 0 }, sent{ 0 }, batches{ 0 }, retries{ 0 };
+    std::atomic<uint64_t> rejected{ 0 }, dropped{ 0 };
+};
+
+class BackendSink {
+public:
+    BackendSink(const HttpUrl &url, const SinkParams &p) : url_(url), p_(p) {}
+    ~BackendSink() { stop(); }
+
+    void start() {
+        for (uint32_t i = 0; i < p_.inflight; i++) threads_.emplace_back([this] { sender(); });
+    }
+
+    // Drains what is queued (bounded by `drain_ms`), then stops the senders
+    void stop(uint32_t drain_ms = 0) {
+        if (threads_.empty()) return;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(drain_ms);
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            while (!q_.empty() && std::chrono::steady_clock::now() < deadline) {
+                lock.unlock();
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                lock.lock();
+            }
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread &t : threads_) t.join();
+        threads_.clear();
+    }
+
+    void push(std::string record) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (q_.size() >= p_.queue_max) {
+                q_.pop_front();
+                stats.dropped++;
+            }
+            q_.push_back(std::move(record));
+            stats.queued++;
+        }
+        cv_.notify_one();
+    }
+
+    size_t depth() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return q_.size();
+    }
+
+    SinkStats stats;
+
+private:
+    bool take_batch(std::vector<std::string> &batch) {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this] { return stopping_ || !q_.empty(); });
+        if (q_.empty()) return false;
+        // Linger briefly so a trickle still goes out in batches
+        if (q_.size() < p_.batch_max && !stopping_) {
+            cv_.wait_for(lock, std::chrono::milliseconds(p_.linger_ms),
+                         [this] { return stopping_ || q_.size() >= p_.batch_max; });
+        }
+        while (!q_.empty() && batch.size() < p_.batch_max) {
+            batch.push_back(std::move(q_.front()));
+            q_.pop_front();
+        }
+        return !batch.empty();
+    }
+
+    void sender() {
+        HttpConnection conn(url_);
+        conn.set_timeout_ms(p_.timeout_ms);
+        std::vector<std::string> batch;
+        std::string body;
+        while (take_batch(batch)) {
+            body.clear();
+            body += '[';
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (i) body += ',';
+                body += batch[i];
+            }
+            body += ']';
+
+            uint32_t backoff = p_.backoff_ms;
+            for (;;) {
+                int status = conn.request("POST", "/data/batch", body.data(), body.size());
+                if (status >= 200 && status < 300) {
+                    stats.sent += batch.size();
+                    stats.batches++;
+                    break;
+                }
+                if (status >= 400 && status < 500 && status != 429) {
+                    fprintf(stderr, "backend rejected batch of %zu (HTTP %d): %.200s\n",
+                            batch.size(), status, conn.body().c_str());
+                    stats.rejected += batch.size();
+                    break;
+                }
+                if (stopped()) {
+                    stats.dropped += batch.size();
+                    break;
+                }
+                stats.retries++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(backoff));
+                backoff = std::min(backoff * 2, p_.backoff_max_ms);
+            }
+            batch.clear();
+        }
+    }
+
+    bool stopped() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return stopping_;
+    }
+
+    HttpUrl    url_;
+    SinkParams p_;
+    std::mutex mu_;
+    std::condition_variable  cv_;
+    std::deque<std::string>  q_;
+    std::vector<std::thread> threads_;
+    bool stopping_ = false;
+};
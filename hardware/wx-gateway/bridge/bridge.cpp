@@ -0,0 +1,326 @@
+/*
+ * WX gateway bridge — the receiving side of send_lora().
+ *
+ * Listens for one or more Semtech UDP packet forwarders (the stock
+ * lora_gateway / sx1302_hal forwarder on each gateway, server_address
+ * pointed here), acknowledges their PUSH_DATA / PULL_DATA, decodes the WX
+ * readings in each rxpk, merges copies heard by several gateways and
+ * forwards each reading once, with the best gateway's RSSI / SNR, to
+ * POST /hardware/data/batch.
+ *
+ *   wx-bridge --listen 1700 --backend http://127.0.0.1:8000/hardware
+ *
+ * With --store DIR readings go to a local on-disk store first
+ * (ts_store.h) and are replayed to the backend from there. Readings
+ * survive backhaul outages and restarts, and the store answers local
+ * queries (wx-store). Without it a bounded RAM queue is used.
+ *
+ * With --sites units.csv the bridge also fits hydraulic gradients across
+ * neighbouring WX-Level wells as readings arrive (gradient.h) and
+ * forwards them as wx-gradient records:
+ *
+ *   wx-bridge --sites units.csv --wells ../../../backend/data/gsp_monitoring_sites.csv \
+ *       --wells ../../../data/monitoring/enterprise_wells.csv --radius-km 2
+ *
+ * With --wake the bridge also delivers on-demand reads: it polls the
+ * backend's pending read requests and sends each to its unit as a
+ * wake-on-radio command (wake.h). --wake-period-ms must match the units'
+ * WOR_CAD_PERIOD_MS:
+ *
+ *   wx-bridge --wake --wake-period-ms 2000 --wake-freq 915.0 --wake-datr SF7BW125
+ *
+ * Forwarder settings WX units need (global_conf.json):
+ *   "lorawan_public": false, "forward_crc_disabled": true, and a
+ *   channel at LORA_FREQ / LORA_SPREAD_FACTOR / LORA_BANDWIDTH.
+ *
+ * Test without radios: tools/fwdsim plays a fleet of simulated forwarders.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include "gradient.h"
+#include "store_sink.h"
+#include "uplink.h"
+#include "wake.h"
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_signal(int) {
+    stop_requested = 1;
+}
+
+static uint64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t wall_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+struct BridgeStats {
+    uint64_t datagrams = 0, push = 0, pull = 0, rxpk = 0;
+    uint64_t bad_crc = 0, foreign = 0, malformed = 0, duplicates = 0, readings = 0;
+    uint64_t wakes = 0, tx_ack = 0, tx_errors = 0;
+};
+
+/*
+ * wx-bridge [--listen PORT] [--backend URL] [--batch 100] [--linger-ms 200]
+ *           [--inflight 4] [--queue 200000] [--dedup-ms 1000]
+ *           [--dedup-memory-s 60] [--stats-s 10]
+ *           [--store DIR] [--store-mb 512] [--segment-mb 8] [--flush-s 60]
+ *           [--catchup-rate 200] [--sites CSV --wells CSV ...] [--radius-km 2]
+ *           [--align-s 3600] [--gradient-s 900] [--k-ft-day 17.8] [--porosity 0.2]
+ *           [--wake] [--wake-poll-s 5] [--wake-retry-s 20] [--wake-max 3]
+ *           [--wake-period-ms 2000] [--wake-freq 915.0] [--wake-datr SF7BW125]
+ *           [--wake-power 14]
+ */
+int main(int argc, char **argv) {
+    int port = 1700;
+    const char *backend = "http://127.0.0.1:8000/hardware";
+    StoreSinkParams ssp;
+    SinkParams &sp = ssp.sink;
+    StoreParams stp;
+    const char *store_dir = nullptr;
+    const char *sites_csv = nullptr;
+    std::vector<const char *> wells_csv;
+    GradientParams gp;
+    uint32_t dedup_ms = 1000, dedup_memory_s = 60, stats_s = 10;
+    bool wake = false;
+    WakeParams wp;
+
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        const char *a = argv[i];
+        if (!strcmp(a, "--listen") && more)               port = atoi(argv[++i]);
+        else if (!strcmp(a, "--backend") && more)         backend = argv[++i];
+        else if (!strcmp(a, "--batch") && more)           sp.batch_max = atoi(argv[++i]);
+        else if (!strcmp(a, "--linger-ms") && more)       sp.linger_ms = atoi(argv[++i]);
+        else if (!strcmp(a, "--inflight") && more)        sp.inflight = atoi(argv[++i]);
+        else if (!strcmp(a, "--queue") && more)           sp.queue_max = atol(argv[++i]);
+        else if (!strcmp(a, "--dedup-ms") && more)        dedup_ms = atoi(argv[++i]);
+        else if (!strcmp(a, "--dedup-memory-s") && more)  dedup_memory_s = atoi(argv[++i]);
+        else if (!strcmp(a, "--stats-s") && more)         stats_s = atoi(argv[++i]);
+        else if (!strcmp(a, "--store") && more)           store_dir = argv[++i];
+        else if (!strcmp(a, "--store-mb") && more)        stp.budget_bytes = (size_t)atol(argv[++i]) << 20;
+        else if (!strcmp(a, "--segment-mb") && more)      stp.segment_bytes = (size_t)atol(argv[++i]) << 20;
+        else if (!strcmp(a, "--flush-s") && more)         stp.flush_ms = atoi(argv[++i]) * 1000;
+        else if (!strcmp(a, "--catchup-rate") && more)    ssp.catchup_rate = atof(argv[++i]);
+        else if (!strcmp(a, "--sites") && more)           sites_csv = argv[++i];
+        else if (!strcmp(a, "--wells") && more)           wells_csv.push_back(argv[++i]);
+        else if (!strcmp(a, "--radius-km") && more)       gp.radius_km = atof(argv[++i]);
+        else if (!strcmp(a, "--align-s") && more)         gp.align_s = atof(argv[++i]);
+        else if (!strcmp(a, "--gradient-s") && more)      gp.emit_s = atof(argv[++i]);
+        else if (!strcmp(a, "--k-ft-day") && more)        gp.k_ft_day = atof(argv[++i]);
+        else if (!strcmp(a, "--porosity") && more)        gp.porosity = atof(argv[++i]);
+        else if (!strcmp(a, "--wake"))                    wake = true;
+        else if (!strcmp(a, "--wake-poll-s") && more)     wp.poll_ms = atoi(argv[++i]) * 1000;
+        else if (!strcmp(a, "--wake-retry-s") && more)    wp.retry_ms = atoi(argv[++i]) * 1000;
+        else if (!strcmp(a, "--wake-max") && more)        wp.max_sends = atoi(argv[++i]);
+        else if (!strcmp(a, "--wake-period-ms") && more)  wp.period_ms = atoi(argv[++i]);
+        else if (!strcmp(a, "--wake-freq") && more)       wp.freq_mhz = atof(argv[++i]);
+        else if (!strcmp(a, "--wake-datr") && more)       wp.datr = argv[++i];
+        else if (!strcmp(a, "--wake-power") && more)      wp.power_dbm = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return 2;
+        }
+    }
+    HttpUrl url;
+    if (!parse_http_url(backend, url)) {
+        fprintf(stderr, "need an http://host[:port][/prefix] backend URL\n");
+        return 2;
+    }
+    if (!sp.batch_max || !sp.inflight) {
+        fprintf(stderr, "--batch and --inflight must be at least 1\n");
+        return 2;
+    }
+    uint8_t sf;
+    uint32_t bw_hz;
+    if (wake && !wake_parse_datr(wp.datr, sf, bw_hz)) {
+        fprintf(stderr, "--wake-datr must look like SF7BW125\n");
+        return 2;
+    }
+
+    int fd = socket(AF_INET6, SOCK_DGRAM, 0);
+    int off = 0, rcvbuf = 4 << 20;
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));    // ride out bursts
+    timeval tv = { 0, 50000 };     // wake to close dedup windows even when idle
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    sockaddr_in6 addr = {};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+    if (fd < 0 || bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    std::vector<UnitSite> sites;
+    if (sites_csv) {
+        std::map<std::string, SiteInfo> catalog;
+        for (const char *w : wells_csv) {
+            if (!load_site_catalog(w, catalog)) fprintf(stderr, "cannot read %s\n", w);
+        }
+        if (!load_unit_sites(sites_csv, catalog, sites)) {
+            fprintf(stderr, "cannot read %s\n", sites_csv);
+            return 2;
+        }
+    }
+    GradientEngine gradients(gp, sites);
+    if (sites_csv) {
+        fprintf(stderr, "wx-bridge: %zu sited units, %zu gradient neighbourhoods\n", sites.size(),
+                gradients.neighbourhoods());
+    }
+
+    TsStore store;
+    if (store_dir) {
+        stp.dir = store_dir;
+        if (!store.open(stp)) return 1;
+        TsStore::Usage u = store.usage();
+        fprintf(stderr, "wx-bridge: store %s, %zu segments, %llu readings, %llu to replay\n",
+                store_dir, u.segments, (unsigned long long)u.records,
+                (unsigned long long)(u.head - u.cursor));
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    BackendSink sink(url, sp);
+    StoreSink store_sink(url, store, ssp);
+    store_dir ? store_sink.start() : sink.start();
+    SinkStats &ss = store_dir ? store_sink.stats : sink.stats;
+    auto send = [&](const std::string &device, int64_t received_ms, const std::string &record) {
+        if (store_dir) store_sink.push(device, received_ms, record);
+        else sink.push(record);
+    };
+    std::map<std::string, UnitLink> links;          // device_id → where it was last heard
+    auto forward = [&](const Uplink &u, uint32_t copies) {
+        send(u.device_id, u.received_ms, tag_uplink(u, copies));
+        if (wake) links[u.device_id] = UnitLink{ u.gateway_eui, u.freq_mhz, u.datr };
+        if (sites_csv) gradients.on_reading(u.payload.data(), u.payload.size(), u.received_ms, send);
+    };
+    auto depth = [&]() -> size_t { return store_dir ? store_sink.backlog() : sink.depth(); };
+    Deduplicator dedup(dedup_ms, dedup_memory_s * 1000);
+    BridgeStats st;
+    std::map<uint64_t, sockaddr_in6> gateways;      // EUI → downlink address (PULL_DATA source)
+    fprintf(stderr, "wx-bridge: udp/%d -> %s:%s%s/data/batch\n", port, url.host.c_str(),
+            url.port.c_str(), url.prefix.c_str());
+
+    WakePoller wake_poller(url, wp);
+    WakeScheduler wake_sched(wp);
+    std::vector<ReadRequest> wake_pending;
+    uint16_t wake_token = 0;
+    if (wake) wake_poller.start();
+    // A PULL_RESP to the gateway that last heard the unit, else to all of them
+    auto send_wake = [&](const ReadRequest &r) {
+        auto l = links.find(r.device_id);
+        const UnitLink *link = l != links.end() ? &l->second : nullptr;
+        uint8_t out[512];
+        size_t n = semtech_pull_resp(out, sizeof(out), ++wake_token, wake_txpk(r, link, wp));
+        auto gw = link ? gateways.find(link->gateway_eui) : gateways.end();
+        if (gw != gateways.end()) {
+            sendto(fd, out, n, 0, (sockaddr *)&gw->second, sizeof(gw->second));
+        } else {
+            for (auto &g : gateways) sendto(fd, out, n, 0, (sockaddr *)&g.second, sizeof(g.second));
+        }
+        st.wakes++;
+    };
+
+    uint8_t buf[65536], ack[4];
+    uint64_t next_stats = now_ms() + stats_s * 1000ULL;
+    while (!stop_requested) {
+        sockaddr_in6 from;
+        socklen_t from_len = sizeof(from);
+        ssize_t n = recvfrom(fd, buf, sizeof(buf), 0, (sockaddr *)&from, &from_len);
+        uint64_t now = now_ms();
+        if (n > 0) {
+            st.datagrams++;
+            SemtechHeader h;
+            const char *json;
+            size_t json_len;
+            if (semtech_parse(buf, (size_t)n, h, json, json_len)) {
+                if (h.id == SEMTECH_PUSH_DATA) {
+                    st.push++;
+                    // Ack first: the forwarder times out in ~100 ms and counts it against us
+                    sendto(fd, ack, semtech_ack(ack, h, SEMTECH_PUSH_ACK), 0, (sockaddr *)&from, from_len);
+                    JsonSpan rxpk;
+                    if (json_get(json_value(json, json_len), "rxpk", rxpk)) {
+                        json_each_element(rxpk, [&](JsonSpan pk) {
+                            st.rxpk++;
+                            Uplink u;
+                            u.received_ms = wall_ms();
+                            switch (decode_rxpk(pk, h.gateway_eui, u)) {
+                                case RXPK_OK:
+                                    if (dedup.add(u, now)) st.readings++;
+                                    else st.duplicates++;
+                                    break;
+                                case RXPK_BAD_CRC:   st.bad_crc++; break;
+                                case RXPK_FOREIGN:   st.foreign++; break;
+                                case RXPK_MALFORMED: st.malformed++; break;
+                            }
+                            return true;
+                        });
+                    }
+                } else if (h.id == SEMTECH_PULL_DATA) {
+                    st.pull++;
+                    gateways[h.gateway_eui] = from;
+                    sendto(fd, ack, semtech_ack(ack, h, SEMTECH_PULL_ACK), 0, (sockaddr *)&from, from_len);
+                } else if (h.id == SEMTECH_TX_ACK) {
+                    // Empty, or {"txpk_ack":{"error":"NONE"}} on success
+                    st.tx_ack++;
+                    JsonSpan ack_obj, err;
+                    if (json_get(json_value(json, json_len), "txpk_ack", ack_obj) &&
+                        json_get(ack_obj, "error", err) && json_string(err) != "NONE") {
+                        st.tx_errors++;
+                        fprintf(stderr, "wx-bridge: wake downlink refused: %s\n", json_string(err).c_str());
+                    }
+                }
+            }
+        }
+        dedup.release(now, forward);
+        if (store_dir) store.tick();
+        if (wake) {
+            if (wake_poller.take(wake_pending)) wake_sched.update(wake_pending);
+            if (!gateways.empty()) wake_sched.due(now, send_wake);   // none before a PULL_DATA
+        }
+
+        if (stats_s && now >= next_stats) {
+            next_stats = now + stats_s * 1000ULL;
+            // Quiet moments are the time to tidy replayed segments
+            if (store_dir && !store_sink.backlog()) store.compact();
+            fprintf(stderr, "gw=%zu push=%llu rxpk=%llu readings=%llu dup=%llu crc=%llu foreign=%llu "
+                    "| sent=%llu batches=%llu retries=%llu rejected=%llu dropped=%llu queue=%zu\n",
+                    gateways.size(), (unsigned long long)st.push, (unsigned long long)st.rxpk,
+                    (unsigned long long)st.readings, (unsigned long long)st.duplicates,
+                    (unsigned long long)st.bad_crc, (unsigned long long)st.foreign,
+                    (unsigned long long)ss.sent.load(), (unsigned long long)ss.batches.load(),
+                    (unsigned long long)ss.retries.load(), (unsigned long long)ss.rejected.load(),
+                    (unsigned long long)(ss.dropped.load() + (store_dir ? store.usage().dropped : 0)),
+                    depth());
+            if (wake) {
+                fprintf(stderr, "wake: sent=%llu tx_ack=%llu tx_err=%llu poll_err=%llu\n",
+                        (unsigned long long)st.wakes,
+                        (unsigned long long)st.tx_ack, (unsigned long long)st.tx_errors,
+                        (unsigned long long)wake_poller.errors());
+            }
+        }
+    }
+
+    // Flush open dedup windows, then give the backend a few seconds
+    dedup.release(UINT64_MAX, forward);
+    wake_poller.stop();
+    store_dir ? store_sink.stop(5000) : sink.stop(5000);
+    fprintf(stderr, "wx-bridge: stopped, %llu readings received, %llu forwarded, %zu unsent%s\n",
+            (unsigned long long)st.readings, (unsigned long long)ss.sent.load(), depth(),
+            store_dir ? " (kept in the store)" : "");
+    store.close();
+    close(fd);
+    return 0;
+}
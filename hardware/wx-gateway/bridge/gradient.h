@@ -0,0 +1,430 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "geo.h"
+#include "json_scan.h"
+
+/*
+ * Edge analytics: hydraulic gradient and Darcy flux from neighbouring
+ * WX-Level units, computed at the gateway as readings arrive instead of
+ * hours later in the cloud.
+ *
+ * A site map (units.csv) ties each unit's well to a monitoring-network
+ * well, which gives its position and reference-point elevation:
+ *
+ *   device_id,well_id,site,sensor_depth_ft,rp_elev_ft,aquifer
+ *   WXL-017,A,03S08W34F003S,120.5,,upper
+ *   WXL-018,A,333250N1163678W002,95,611.2,upper
+ *   WXF-002,,03S10W09G001S,,,upper
+ *
+ * `site` is a STATE_WELL_NUMBER or LOCAL_SITE_NAME from
+ * gsp_monitoring_sites.csv, a site_code / swn / well_name from
+ * enterprise_wells.csv, or "@lat;lon". rp_elev_ft overrides the
+ * catalogue's RP_ELEVATION, and is required for sites that have none.
+ * The head is rp_elev_ft - sensor_depth_ft + water_level_ft (the column
+ * above the transducer). Wells only pair with wells of the same
+ * `aquifer`. Leave it empty when every listed well taps one aquifer.
+ * Rows without a well_id are WX-Flow probes.
+ *
+ * Every level well is the centre of a neighbourhood: the wells of its
+ * aquifer within radius_km. Units report on their own schedules, so
+ * heads are time-aligned. Each well's head is carried as a line through
+ * its last two readings, h(t) = c + s*t, and is dropped once its last
+ * reading is older than align_s. A neighbourhood keeps the normal
+ * equations of the plane h = a + gx*x + gy*y as sums over its members.
+ * Every sum is linear or quadratic in t. A new reading swaps one
+ * member's (c, s) in O(1), and the plane at any common time t is a 3x3
+ * solve. No history is rescanned.
+ *
+ * At most every emit_s, each neighbourhood the reading touched emits a
+ * wx-gradient record upstream with:
+ *   - gradient magnitude and down-gradient azimuth
+ *   - Darcy flux q = K i and seepage velocity q / n_e
+ *   - fit RMSE
+ *   - a cross-check against the nearest WX-Flow probe's heat-pulse
+ *     direction, when one in the neighbourhood reported within align_s
+ */
+
+struct GradientParams {
+    double radius_km   = 2.0;
+    double align_s     = 3600;
+    double emit_s      = 900;
+    double k_ft_day    = 17.8;     // 40,000 gpd/ft over 300 ft (s4_well_impact DEFAULT_PARAMS)
+    double porosity    = 0.2;      // effective
+    double agree_deg   = 45;
+    size_t min_wells   = 3;
+};
+
+// ── Sites ────────────────────────────────────────────────────
+struct SiteInfo {
+    GeoPoint pos;
+    double   rp_elev_ft = NAN;
+};
+
+// Loads a monitoring-network CSV into `out`, keyed by every identifier
+// column it has. Either export is recognised by its header.
+inline bool load_site_catalog(const char *path, std::map<std::string, SiteInfo> &out) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[4096];
+    if (!fgets(line, sizeof(line), f)) {
+        fclose(f);
+        return false;
+    }
+    std::vector<std::string> head = csv_fields(line);
+    auto col = [&](const char *name) {
+        for (size_t i = 0; i < head.size(); i++) if (head[i] == name) return (int)i;
+        return -1;
+    };
+    int lat = col("LATITUDE"), lon = col("LONGITUDE"), rp = col("RP_ELEVATION");
+    std::vector<int> keys;
+    for (const char *k : { "STATE_WELL_NUMBER", "LOCAL_SITE_NAME", "site_code", "swn", "well_name" }) {
+        if (col(k) >= 0) keys.push_back(col(k));
+    }
+    int code = col("site_code");
+    while (fgets(line, sizeof(line), f)) {
+        std::vector<std::string> v = csv_fields(line);
+        SiteInfo s;
+        if (lat >= 0 && lon >= 0 && lat < (int)v.size() && lon < (int)v.size()) {
+            s.pos = { atof(v[lat].c_str()), atof(v[lon].c_str()) };
+            if (!s.pos.lat || !s.pos.lon) continue;
+        } else if (code < 0 || code >= (int)v.size() || !parse_site_code(v[code].c_str(), s.pos)) {
+            continue;
+        }
+        if (rp >= 0 && rp < (int)v.size() && !v[rp].empty()) s.rp_elev_ft = atof(v[rp].c_str());
+        for (int k : keys) {
+            if (k < (int)v.size() && !v[k].empty()) out.emplace(v[k], s);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+struct UnitSite {
+    std::string device, well, aquifer;
+    GeoPoint    pos;
+    double      sensor_elev_ft = NAN;   // rp elevation - sensor depth
+    bool        flow = false;
+};
+
+// Reads units.csv against the catalogue; unresolvable rows are reported
+// and skipped
+inline bool load_unit_sites(const char *path, const std::map<std::string, SiteInfo> &catalog,
+                            std::vector<UnitSite> &out) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[1024];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        std::vector<std::string> v = csv_fields(line);
+        if (v.size() < 3 || v[0].empty() || v[0][0] == '#' || v[0] == "device_id") continue;
+        v.resize(6);
+        UnitSite u;
+        u.device = v[0];
+        u.well = v[1];
+        u.aquifer = v[5];
+        u.flow = v[1].empty();
+        SiteInfo s;
+        if (v[2][0] == '@') {
+            if (sscanf(v[2].c_str() + 1, "%lf;%lf", &s.pos.lat, &s.pos.lon) != 2) {
+                fprintf(stderr, "%s:%d: bad position %s\n", path, lineno, v[2].c_str());
+                continue;
+            }
+        } else {
+            auto it = catalog.find(v[2]);
+            if (it == catalog.end()) {
+                fprintf(stderr, "%s:%d: site %s is in no monitoring CSV\n", path, lineno, v[2].c_str());
+                continue;
+            }
+            s = it->second;
+        }
+        u.pos = s.pos;
+        if (!v[4].empty()) s.rp_elev_ft = atof(v[4].c_str());
+        if (!u.flow) {
+            if (isnan(s.rp_elev_ft) || v[3].empty()) {
+                fprintf(stderr, "%s:%d: %s/%s needs rp_elev_ft and sensor_depth_ft\n", path, lineno,
+                        u.device.c_str(), u.well.c_str());
+                continue;
+            }
+            u.sensor_elev_ft = s.rp_elev_ft - atof(v[3].c_str());
+        }
+        out.push_back(u);
+    }
+    fclose(f);
+    return true;
+}
+
+// ── Engine ───────────────────────────────────────────────────
+class GradientEngine {
+public:
+    GradientEngine(const GradientParams &p, const std::vector<UnitSite> &sites) : p_(p) {
+        std::vector<GeoPoint> pts;
+        for (const UnitSite &u : sites) pts.push_back(u.pos);
+        proj_.center(pts);
+        for (const UnitSite &u : sites) {
+            if (u.flow) {
+                probes_[u.device] = { u, 0, 0, -1, false };
+                continue;
+            }
+            index_[u.device + '/' + u.well] = wells_.size();
+            wells_.push_back({ u, {} });
+        }
+        for (size_t c = 0; c < wells_.size(); c++) {
+            Hood h;
+            h.center = c;
+            for (size_t m = 0; m < wells_.size(); m++) {
+                const UnitSite &a = wells_[c].site, &b = wells_[m].site;
+                if (a.aquifer != b.aquifer || proj_.dist_km(a.pos, b.pos) > p_.radius_km) continue;
+                double e, n;
+                proj_.offset_km(a.pos, b.pos, e, n);
+                h.members.push_back({ m, e * FT_PER_KM, n * FT_PER_KM, false, 0, 0 });
+                wells_[m].hoods.push_back({ hoods_.size(), h.members.size() - 1 });
+            }
+            if (h.members.size() >= p_.min_wells) hoods_.push_back(h);
+            else for (const Member &m : h.members) wells_[m.well].hoods.pop_back();
+        }
+    }
+
+    size_t neighbourhoods() const { return hoods_.size(); }
+
+    // Feeds one forwarded reading (the unit's JSON) received at `t_ms`;
+    // emit(device_id, t_ms, json) is called for each derived record
+    template <typename F>
+    void on_reading(const char *json, size_t n, int64_t t_ms, F emit) {
+        JsonSpan doc = json_value(json, n), v;
+        if (!json_get(doc, "device_id", v)) return;
+        std::string device = json_string(v);
+        if (!t0_ms_) t0_ms_ = t_ms;
+        double t = (t_ms - t0_ms_) / 1000.0;
+
+        auto probe = probes_.find(device);
+        if (probe != probes_.end()) {
+            // Full payload or LoRa frame (build_air: "f" with short keys)
+            JsonSpan flow, f;
+            bool air = !json_get(doc, "flow", flow);
+            if (air && !json_get(doc, "f", flow)) return;
+            Probe &p = probe->second;
+            p.t = t;
+            p.valid = json_get(flow, air ? "ok" : "valid", f) && f.n == 4 && !memcmp(f.p, "true", 4);
+            p.velocity = json_get(flow, air ? "v" : "velocity_cm_day", f) ? json_number(f) : 0;
+            p.direction = json_get(flow, air ? "d" : "direction_deg", f) ? json_number(f) : -1;
+            return;
+        }
+
+        std::vector<size_t> touched;
+        auto level = [&](const std::string &well, JsonSpan lv) {
+            auto it = index_.find(device + '/' + well);
+            double ft = json_number(lv, NAN);
+            if (it == index_.end() || isnan(ft)) return;
+            update(it->second, t, ft, touched);
+        };
+        JsonSpan wells;
+        if (json_get(doc, "wells", wells)) {
+            json_each_element(wells, [&](JsonSpan w) {
+                JsonSpan id, lv;
+                if (json_get(w, "well_id", id) && json_get(w, "water_level_ft", lv)) level(json_string(id), lv);
+                return true;
+            });
+        } else if (json_get(doc, "w", wells)) {
+            // LoRa frame: each well is [well_id, water_level_ft, ...]
+            json_each_element(wells, [&](JsonSpan w) {
+                JsonSpan id, lv;
+                if (json_element(w, 0, id) && json_element(w, 1, lv)) level(json_string(id), lv);
+                return true;
+            });
+        } else if (json_get(doc, "water_level_ft", v)) {
+            level("", v);
+        }
+        for (size_t h : touched) {
+            Hood &hood = hoods_[h];
+            if (hood.emitted && t - hood.last_emit < p_.emit_s) continue;
+            std::string out;
+            if (!evaluate(hood, t, t_ms, out)) continue;
+            hood.emitted = true;
+            hood.last_emit = t;
+            emit(gradient_id(hood), t_ms, out);
+        }
+    }
+
+private:
+    static constexpr double FT_PER_KM = 3280.84;
+
+    struct Sums {
+        double n = 0, x = 0, y = 0, xx = 0, xy = 0, yy = 0;
+        double c = 0, xc = 0, yc = 0, s = 0, xs = 0, ys = 0;
+        double cc = 0, cs = 0, ss = 0;
+
+        void add(double px, double py, double pc, double psl, double sign) {
+            n += sign;
+            x += sign * px;
+            y += sign * py;
+            xx += sign * px * px;
+            xy += sign * px * py;
+            yy += sign * py * py;
+            c += sign * pc;
+            xc += sign * px * pc;
+            yc += sign * py * pc;
+            s += sign * psl;
+            xs += sign * px * psl;
+            ys += sign * py * psl;
+            cc += sign * pc * pc;
+            cs += sign * pc * psl;
+            ss += sign * psl * psl;
+        }
+    };
+    struct Member {
+        size_t well;
+        double x, y;            // ft east / north of the centre
+        bool   in;
+        double c, s;            // contribution currently in the sums
+    };
+    struct Hood {
+        size_t center;
+        std::vector<Member> members;
+        Sums   sums;
+        double last_emit = 0;
+        bool   emitted = false;
+    };
+    struct Well {
+        UnitSite site;
+        std::vector<std::pair<size_t, size_t>> hoods;   // (hood, member index)
+        double t1 = 0, h1 = 0, t0 = 0, h0 = 0;
+        bool   have = false, have_prev = false;
+    };
+    struct Probe {
+        UnitSite site;
+        double   t, velocity, direction;
+        bool     valid;
+    };
+
+    // New head for well `w`; swaps its line in every neighbourhood it is in
+    void update(size_t w, double t, double level_ft, std::vector<size_t> &touched) {
+        Well &well = wells_[w];
+        double head = well.site.sensor_elev_ft + level_ft;
+        well.have_prev = well.have && t - well.t1 > 0 && t - well.t1 <= p_.align_s;
+        well.t0 = well.t1;
+        well.h0 = well.h1;
+        well.t1 = t;
+        well.h1 = head;
+        well.have = true;
+        double slope = well.have_prev ? (well.h1 - well.h0) / (well.t1 - well.t0) : 0;
+        double c = head - slope * t;
+        for (auto &hm : well.hoods) {
+            Hood &hood = hoods_[hm.first];
+            Member &m = hood.members[hm.second];
+            if (m.in) hood.sums.add(m.x, m.y, m.c, m.s, -1);
+            m.in = true;
+            m.c = c;
+            m.s = slope;
+            hood.sums.add(m.x, m.y, c, slope, +1);
+            touched.push_back(hm.first);
+        }
+    }
+
+    // Fits the plane at time t; false while too few wells are current or
+    // they are near collinear
+    bool evaluate(Hood &hood, double t, int64_t t_ms, std::string &out) {
+        double oldest = 0;
+        for (Member &m : hood.members) {
+            if (!m.in) continue;
+            double age = t - wells_[m.well].t1;
+            if (age > p_.align_s) {
+                hood.sums.add(m.x, m.y, m.c, m.s, -1);
+                m.in = false;
+            } else {
+                oldest = std::max(oldest, age);
+            }
+        }
+        const Sums &S = hood.sums;
+        if (S.n + 0.5 < p_.min_wells) return false;
+        double cxx = S.xx - S.x * S.x / S.n, cyy = S.yy - S.y * S.y / S.n, cxy = S.xy - S.x * S.y / S.n;
+        double tr = cxx + cyy;
+        if (tr <= 0 || (cxx * cyy - cxy * cxy) < 0.01 * tr * tr / 4) return false;
+
+        // Normal equations at t: [n x y; x xx xy; y xy yy] [a gx gy]' = b
+        double b0 = S.c + t * S.s, b1 = S.xc + t * S.xs, b2 = S.yc + t * S.ys;
+        double m[3][4] = { { S.n, S.x, S.y, b0 }, { S.x, S.xx, S.xy, b1 }, { S.y, S.xy, S.yy, b2 } };
+        for (int i = 0; i < 3; i++) {
+            int piv = i;
+            for (int r = i + 1; r < 3; r++) if (fabs(m[r][i]) > fabs(m[piv][i])) piv = r;
+            for (int k = 0; k < 4; k++) std::swap(m[i][k], m[piv][k]);
+            if (fabs(m[i][i]) < 1e-12) return false;
+            for (int r = 0; r < 3; r++) {
+                if (r == i) continue;
+                double f = m[r][i] / m[i][i];
+                for (int k = i; k < 4; k++) m[r][k] -= f * m[i][k];
+            }
+        }
+        double a = m[0][3] / m[0][0], gx = m[1][3] / m[1][1], gy = m[2][3] / m[2][2];
+        double hh = S.cc + 2 * t * S.cs + t * t * S.ss;
+        double sse = std::max(0.0, hh - (a * b0 + gx * b1 + gy * b2));
+        int n = (int)(S.n + 0.5);
+        double rmse = n > 3 ? sqrt(sse / (n - 3)) : 0;
+
+        double grad = sqrt(gx * gx + gy * gy);
+        double azimuth = atan2(-gx, -gy) * 180.0 / M_PI;   // flow runs down-gradient
+        if (azimuth < 0) azimuth += 360;
+        double flux = p_.k_ft_day * grad;
+        double seepage_cm_day = flux / p_.porosity * 30.48;
+
+        const UnitSite &c = wells_[hood.center].site;
+        char at[32], buf[768];
+        time_t secs = (time_t)(t_ms / 1000);
+        tm utc;
+        gmtime_r(&secs, &utc);
+        strftime(at, sizeof(at), "%Y-%m-%dT%H:%M:%SZ", &utc);
+        int len = snprintf(buf, sizeof(buf),
+                           "{\"device_id\":\"%s\",\"device_type\":\"wx-gradient\","
+                           "\"center\":{\"device_id\":\"%s\",\"well_id\":\"%s\"},\"aquifer\":\"%s\","
+                           "\"wells\":%d,\"span_s\":%.0f,\"computed_at\":\"%s\",\"head_ft\":%.2f,"
+                           "\"gradient\":%.6f,\"azimuth_deg\":%.0f,\"rmse_ft\":%.3f,"
+                           "\"darcy_flux_ft_day\":%.4f,\"seepage_cm_day\":%.2f",
+                           gradient_id(hood).c_str(), c.device.c_str(), c.well.c_str(),
+                           c.aquifer.c_str(), n, oldest, at, a, grad, azimuth, rmse, flux,
+                           seepage_cm_day);
+        out.assign(buf, len);
+
+        // Nearest WX-Flow probe in the neighbourhood that reported a direction
+        const Probe *best = nullptr;
+        double best_km = 0;
+        for (const auto &pp : probes_) {
+            const Probe &p = pp.second;
+            double km = proj_.dist_km(c.pos, p.site.pos);
+            if (p.site.aquifer != c.aquifer || km > p_.radius_km || !p.valid || p.direction < 0 ||
+                t - p.t > p_.align_s || (best && km >= best_km)) continue;
+            best = &p;
+            best_km = km;
+        }
+        if (best) {
+            double diff = fabs(fmod(best->direction - azimuth + 540.0, 360.0) - 180.0);
+            len = snprintf(buf, sizeof(buf),
+                           ",\"flow_check\":{\"device_id\":\"%s\",\"distance_km\":%.2f,"
+                           "\"direction_deg\":%.0f,\"velocity_cm_day\":%.1f,"
+                           "\"angle_diff_deg\":%.0f,\"agree\":%s}",
+                           best->site.device.c_str(), best_km, best->direction, best->velocity, diff,
+                           diff <= p_.agree_deg ? "true" : "false");
+            out.append(buf, len);
+        }
+        out += '}';
+        return true;
+    }
+
+    std::string gradient_id(const Hood &h) const {
+        const UnitSite &c = wells_[h.center].site;
+        return "WXG-" + c.device + (c.well.empty() ? "" : "-" + c.well);
+    }
+
+    GradientParams p_;
+    Projection     proj_;
+    std::vector<Well> wells_;
+    std::vector<Hood> hoods_;
+    std::map<std::string, size_t> index_;       // "device/well" → wells_
+    std::map<std::string, Probe>  probes_;
+    int64_t t0_ms_ = 0;
+};
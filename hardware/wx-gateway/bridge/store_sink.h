@@ -0,0 +1,142 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "backend_sink.h"
+#include "ts_store.h"
+
+/*
+ * Forwarding through the gateway store (ts_store.h) instead of a RAM
+ * queue: every record is appended to disk first. One sender replays the
+ * store in seq order from the acknowledged cursor. Live traffic is only
+ * the tail of that replay, so a backhaul outage grows the backlog on
+ * disk, not in memory, and nothing is lost to a restart.
+ *
+ * After an outage the backlog drains at `catchup_rate` records/s
+ * (0 = as fast as the backend acks), so a gateway coming back does not
+ * swamp a thin uplink or the backend. Batches go out one at a time
+ * because the cursor has to advance in order. The batch size makes up
+ * for the lost pipelining.
+ */
+
+struct StoreSinkParams {
+    SinkParams sink;
+    double     catchup_rate = 200;      // records/s
+};
+
+class StoreSink {
+public:
+    StoreSink(const HttpUrl &url, TsStore &store, const StoreSinkParams &p)
+        : url_(url), store_(store), p_(p) {}
+    ~StoreSink() { stop(); }
+
+    void start() {
+        thread_ = std::thread([this] { sender(); });
+    }
+
+    // Waits up to `drain_ms` for the backlog to reach the backend
+    void stop(uint32_t drain_ms = 0) {
+        if (!thread_.joinable()) return;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(drain_ms);
+        while (backlog() && std::chrono::steady_clock::now() < deadline) {
+            wake_.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        stopping_ = true;
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    void push(const std::string &device, int64_t received_ms, const std::string &record) {
+        store_.append(device, received_ms, record.data(), record.size());
+        stats.queued++;
+        wake_.notify_one();
+    }
+
+    uint64_t backlog() { return store_.head() - store_.cursor(); }
+
+    SinkStats stats;
+
+private:
+    void sender() {
+        HttpConnection conn(url_);
+        conn.set_timeout_ms(p_.sink.timeout_ms);
+        std::vector<StoredRecord> batch;
+        std::string body;
+        double tokens = p_.sink.batch_max;
+        auto last = std::chrono::steady_clock::now();
+        while (!stopping_) {
+            if (!store_.read_after(store_.cursor(), p_.sink.batch_max, batch)) {
+                std::unique_lock<std::mutex> lock(mu_);
+                wake_.wait_for(lock, std::chrono::milliseconds(p_.sink.linger_ms));
+                continue;
+            }
+            // Linger briefly so a live trickle still goes out in batches
+            if (batch.size() < p_.sink.batch_max) {
+                std::unique_lock<std::mutex> lock(mu_);
+                wake_.wait_for(lock, std::chrono::milliseconds(p_.sink.linger_ms));
+                store_.read_after(store_.cursor(), p_.sink.batch_max, batch);
+            }
+            // Token bucket at catchup_rate, one batch deep
+            if (p_.catchup_rate > 0) {
+                auto now = std::chrono::steady_clock::now();
+                tokens = std::min<double>(p_.sink.batch_max,
+                                          tokens + p_.catchup_rate *
+                                              std::chrono::duration<double>(now - last).count());
+                last = now;
+                if (tokens < batch.size()) {
+                    double wait_s = (batch.size() - tokens) / p_.catchup_rate;
+                    std::this_thread::sleep_for(std::chrono::duration<double>(wait_s));
+                    tokens = batch.size();
+                    last = std::chrono::steady_clock::now();
+                }
+                tokens -= batch.size();
+            }
+
+            body.clear();
+            body += '[';
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (i) body += ',';
+                body += batch[i].payload;
+            }
+            body += ']';
+
+            uint32_t backoff = p_.sink.backoff_ms;
+            for (;;) {
+                int status = conn.request("POST", "/data/batch", body.data(), body.size());
+                if (status >= 200 && status < 300) {
+                    stats.sent += batch.size();
+                    stats.batches++;
+                    break;
+                }
+                if (status >= 400 && status < 500 && status != 429) {
+                    fprintf(stderr, "backend rejected batch of %zu (HTTP %d): %.200s\n",
+                            batch.size(), status, conn.body().c_str());
+                    stats.rejected += batch.size();
+                    break;
+                }
+                // Unsent records stay in the store for the next start
+                if (stopping_) return;
+                stats.retries++;
+                std::unique_lock<std::mutex> lock(mu_);
+                wake_.wait_for(lock, std::chrono::milliseconds(backoff), [this] { return stopping_.load(); });
+                backoff = std::min(backoff * 2, p_.sink.backoff_max_ms);
+            }
+            store_.ack(batch.back().seq);
+        }
+    }
+
+    HttpUrl   url_;
+    TsStore  &store_;
+    StoreSinkParams p_;
+    std::mutex mu_;
+    std::condition_variable wake_;
+    std::thread thread_;
+    std::atomic<bool> stopping_{ false };
+};
@@ -0,0 +1,124 @@
+/*
+ * wx-store — inspect and query the bridge's local store (ts_store.h) on
+ * the gateway, e.g. to pull a unit's readings from a site whose backhaul
+ * is down, or to check how far catch-up has got.
+ *
+ *   wx-store /var/lib/wx-bridge stats
+ *   wx-store /var/lib/wx-bridge query WXL-017 --from -6h
+ *   wx-store /var/lib/wx-bridge query WXF-002 --from 2026-10-01 --to 2026-10-02T12:00
+ *   wx-store /var/lib/wx-bridge compact         # bridge stopped
+ *
+ * query prints one tagged reading (JSON, as forwarded) per line. stats
+ * and query open the store read-only and work next to a running bridge.
+ * Readings the bridge has not flushed yet (--flush-s) are not visible.
+ */
+
+#include <time.h>
+#include <chrono>
+#include "ts_store.h"
+
+static int64_t wall_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Unix ms, a UTC date / date-time, or an offset back from now (-30m, -6h, -2d)
+static bool parse_time(const char *s, int64_t &out) {
+    char unit;
+    double n;
+    if (s[0] == '-' && sscanf(s + 1, "%lf%c", &n, &unit) == 2) {
+        double scale = unit == 's' ? 1e3 : unit == 'm' ? 60e3 : unit == 'h' ? 3600e3 : unit == 'd' ? 86400e3 : 0;
+        if (!scale) return false;
+        out = wall_ms() - (int64_t)(n * scale);
+        return true;
+    }
+    tm t = {};
+    const char *end = strptime(s, "%Y-%m-%d", &t);
+    if (end && *end == 'T') end = strptime(end + 1, strchr(end, ':') == strrchr(end, ':') ? "%H:%M" : "%H:%M:%S", &t);
+    if (end && !*end) {
+        out = (int64_t)timegm(&t) * 1000;
+        return true;
+    }
+    char *rest;
+    out = strtoll(s, &rest, 10);
+    return !*rest && rest != s;
+}
+
+static void print_time(int64_t ms, char *out, size_t cap) {
+    time_t secs = (time_t)(ms / 1000);
+    tm utc;
+    gmtime_r(&secs, &utc);
+    strftime(out, cap, "%Y-%m-%dT%H:%M:%SZ", &utc);
+}
+
+/*
+ * wx-store DIR stats
+ * wx-store DIR query DEVICE [--from T] [--to T]
+ * wx-store DIR compact
+ */
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: wx-store DIR stats | query DEVICE [--from T] [--to T] | compact\n");
+        return 2;
+    }
+    StoreParams p;
+    p.dir = argv[1];
+    const char *cmd = argv[2];
+    TsStore store;
+
+    if (!strcmp(cmd, "stats")) {
+        if (!store.open(p, true)) return 1;
+        TsStore::Usage u = store.usage();
+        printf("segments=%zu records=%llu head=%llu cursor=%llu backlog=%llu\n", u.segments,
+               (unsigned long long)u.records, (unsigned long long)u.head,
+               (unsigned long long)u.cursor, (unsigned long long)(u.head - u.cursor));
+        printf("segment,flags,bytes,records,seq_min,seq_max,first,last\n");
+        for (const SegmentInfo &s : store.segments()) {
+            char t0[32] = "", t1[32] = "";
+            if (s.records) {
+                print_time(s.t_min, t0, sizeof(t0));
+                print_time(s.t_max, t1, sizeof(t1));
+            }
+            printf("%u,%s,%llu,%llu,%llu,%llu,%s,%s\n", s.number,
+                   s.flags & SEG_COMPACTED ? "compacted" : s.flags & SEG_SEALED ? "sealed" : "active",
+                   (unsigned long long)s.used, (unsigned long long)s.records,
+                   (unsigned long long)s.seq_min, (unsigned long long)s.seq_max, t0, t1);
+        }
+        return 0;
+    }
+
+    if (!strcmp(cmd, "query") && argc >= 4) {
+        const char *device = argv[3];
+        int64_t from = 0, to = INT64_MAX;
+        for (int i = 4; i < argc; i++) {
+            bool more = i + 1 < argc;
+            const char *a = argv[i];
+            if (!strcmp(a, "--from") && more && parse_time(argv[i + 1], from))    i++;
+            else if (!strcmp(a, "--to") && more && parse_time(argv[i + 1], to))   i++;
+            else {
+                fprintf(stderr, "bad option: %s\n", a);
+                return 2;
+            }
+        }
+        if (!store.open(p, true)) return 1;
+        size_t n = 0;
+        store.query(device, from, to, [&](const StoredRecord &r) {
+            fwrite(r.payload.data(), 1, r.payload.size(), stdout);
+            putchar('\n');
+            n++;
+        });
+        fprintf(stderr, "%zu readings\n", n);
+        return 0;
+    }
+
+    if (!strcmp(cmd, "compact")) {
+        if (!store.open(p)) return 1;
+        int runs = 0;
+        while (store.compact()) runs++;
+        fprintf(stderr, "%d compaction runs, %zu segments\n", runs, store.segments().size());
+        return 0;
+    }
+
+    fprintf(stderr, "unknown command: %s\n", cmd);
+    return 2;
+}
@@ -0,0 +1,788 @@
+#pragma once
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Gateway-local time-series store: keeps every reading the bridge
+ * receives on disk so a backhaul outage costs latency, not data, and
+ * serves local range queries by device and time.
+ *
+ * Layout (all little-endian, in one directory):
+ *
+ *   seg-NNNNNNNN.wxs  Fixed-size segment files, preallocated and mmap'd.
+ *                     Page 0 is a header; after it come blocks. A block
+ *                     holds one device's records in columns:
+ *                     t_ms[] seq[] len[] then the payload bytes.
+ *   index.wxi         Segment list with seq / time ranges. Only ever
+ *                     replaced by write-temp + fsync + rename.
+ *   cursor            Highest seq the backend has acknowledged (same
+ *                     atomic replace, at most every cursor_sync_ms).
+ *
+ * Appends collect per device in RAM and go to disk together as one
+ * flush: every dirty device's block, back to back, padded to a 4 KiB
+ * boundary, then msync. A flush is one sequential write of whole pages,
+ * and no page is rewritten, which is what an SD card's FTL wants.
+ * Flushes happen when flush_bytes are buffered or the oldest buffered
+ * record is flush_ms old. A crash loses at most that window.
+ *
+ * Recovery trusts the index for sealed segments and rescans the active
+ * one, stopping at the first block whose magic or CRC is wrong (a torn
+ * flush). Delivery to the backend is at-least-once: after a crash,
+ * records past the last persisted cursor are sent again.
+ *
+ * Segments beyond budget_bytes are deleted oldest first, replayed or
+ * not. compact() rewrites runs of replayed segments into one segment
+ * (up to compact_bytes) with one contiguous block run per device, so
+ * device queries touch fewer pages and per-flush padding is reclaimed.
+ */
+
+#define WXS_PAGE            4096
+#define WXS_SEG_MAGIC       0x47535857u   // "WXSG"
+#define WXS_BLOCK_MAGIC     0x42535857u   // "WXSB"
+#define WXS_PAD_MAGIC       0x50535857u   // "WXSP"
+#define WXS_INDEX_MAGIC     0x49535857u   // "WXSI"
+#define WXS_VERSION         1
+
+struct StoreParams {
+    std::string dir;
+    size_t   segment_bytes  = 8u << 20;
+    size_t   budget_bytes   = 512u << 20;
+    size_t   flush_bytes    = 64u << 10;
+    uint32_t flush_ms       = 60000;
+    uint32_t cursor_sync_ms = 30000;
+    size_t   block_max      = 64u << 10;  // records per block are split above this
+    size_t   compact_bytes  = 32u << 20;  // largest compacted segment
+};
+
+struct StoredRecord {
+    uint64_t    seq;
+    int64_t     t_ms;           // gateway receive time (Unix ms)
+    std::string device;
+    std::string payload;
+};
+
+#pragma pack(push, 1)
+struct SegmentHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t number;
+    uint32_t reserved;
+    uint64_t capacity;
+    int64_t  created_ms;
+};
+
+struct BlockHeader {            // 48 bytes; blocks are 8-byte aligned
+    uint32_t magic;
+    uint32_t crc;               // CRC-32 of the block after this field
+    uint32_t length;            // whole block, header included
+    uint16_t count;
+    uint16_t id_len;
+    uint64_t seq_min, seq_max;
+    int64_t  t_min, t_max;
+};
+
+struct SegmentInfo {
+    uint32_t number;
+    uint32_t flags;             // SEG_SEALED | SEG_COMPACTED
+    uint64_t used;              // bytes up to the end of the last flush
+    uint64_t records;
+    uint64_t seq_min, seq_max;
+    int64_t  t_min, t_max;
+};
+#pragma pack(pop)
+
+enum { SEG_SEALED = 1, SEG_COMPACTED = 2 };
+
+inline uint32_t wxs_crc32(const uint8_t *p, size_t n) {
+    static uint32_t table[256];
+    static bool init = false;
+    if (!init) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        init = true;
+    }
+    uint32_t c = 0xFFFFFFFFu;
+    while (n--) c = table[(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+inline size_t wxs_align(size_t n, size_t a) {
+    return (n + a - 1) / a * a;
+}
+
+// Record i of a block, decoded from its columns
+struct BlockView {
+    const BlockHeader *h;
+    const uint8_t     *base;
+
+    std::string device() const { return std::string((const char *)base + sizeof(BlockHeader), h->id_len); }
+    size_t cols() const { return sizeof(BlockHeader) + wxs_align(h->id_len, 8); }
+    int64_t t_ms(size_t i) const {
+        int64_t v;
+        memcpy(&v, base + cols() + 8 * i, 8);
+        return v;
+    }
+    uint64_t seq(size_t i) const {
+        uint64_t v;
+        memcpy(&v, base + cols() + 8 * h->count + 8 * i, 8);
+        return v;
+    }
+    uint32_t len(size_t i) const {
+        uint32_t v;
+        memcpy(&v, base + cols() + 16 * h->count + 4 * i, 4);
+        return v;
+    }
+    const uint8_t *payloads() const { return base + cols() + 20 * h->count; }
+};
+
+class TsStore {
+public:
+    ~TsStore() { close(); }
+
+    // Opens or creates the store. read_only maps existing segments for
+    // queries next to a running writer and takes no lock.
+    bool open(const StoreParams &p, bool read_only = false) {
+        p_ = p;
+        ro_ = read_only;
+        mkdir(p_.dir.c_str(), 0755);
+        if (!ro_) {
+            lock_fd_ = ::open(path("LOCK").c_str(), O_RDWR | O_CREAT, 0644);
+            if (lock_fd_ < 0 || flock(lock_fd_, LOCK_EX | LOCK_NB) != 0) {
+                fprintf(stderr, "store %s is in use\n", p_.dir.c_str());
+                return false;
+            }
+        }
+        load_index();
+        load_cursor();
+        remove_strays();
+        for (SegmentInfo &s : segs_) {
+            if (!(s.flags & SEG_SEALED)) rescan(s);
+            next_seq_ = std::max(next_seq_, s.seq_max + 1);
+        }
+        if (ro_) return true;
+        if (segs_.empty() || (segs_.back().flags & SEG_SEALED)) {
+            if (!new_segment()) return false;
+        }
+        return map_active();
+    }
+
+    void close() {
+        if (!ro_ && active_) {
+            flush();
+            save_cursor();
+        }
+        for (auto &m : maps_) munmap(m.second.first, m.second.second);
+        maps_.clear();
+        active_ = nullptr;
+        if (lock_fd_ >= 0) ::close(lock_fd_);
+        lock_fd_ = -1;
+    }
+
+    // Returns the record's sequence number
+    uint64_t append(const std::string &device, int64_t t_ms, const char *payload, size_t len) {
+        std::lock_guard<std::mutex> lock(mu_);
+        Pending &d = pending_[device];
+        uint64_t seq = next_seq_++;
+        d.t.push_back(t_ms);
+        d.seq.push_back(seq);
+        d.len.push_back((uint32_t)len);
+        tail_.push_back({ seq, device, d.seq.size() - 1, d.bytes.size() });
+        d.bytes.append(payload, len);
+        pending_bytes_ += len + 20;
+        if (!oldest_pending_ms_) oldest_pending_ms_ = now_ms();
+        if (pending_bytes_ >= p_.flush_bytes) flush_locked();
+        return seq;
+    }
+
+    // Periodic work: age-based flush and cursor persistence
+    void tick() {
+        std::lock_guard<std::mutex> lock(mu_);
+        uint64_t now = now_ms();
+        if (oldest_pending_ms_ && now - oldest_pending_ms_ >= p_.flush_ms) flush_locked();
+        if (cursor_dirty_ && now - cursor_saved_ms_ >= p_.cursor_sync_ms) save_cursor();
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mu_);
+        flush_locked();
+    }
+
+    // Up to `max` records with seq > after, in seq order
+    size_t read_after(uint64_t after, size_t max, std::vector<StoredRecord> &out) {
+        std::lock_guard<std::mutex> lock(mu_);
+        out.clear();
+        for (const SegmentInfo &s : segs_) {
+            if (out.size() >= max) break;
+            if (!s.records || s.seq_max <= after) continue;
+            std::vector<StoredRecord> got;
+            scan_segment(s, [&](const BlockView &b) {
+                if (b.h->seq_max <= after) return;
+                size_t off = 0;
+                for (size_t i = 0; i < b.h->count; i++) {
+                    uint32_t n = b.len(i);
+                    if (b.seq(i) > after) {
+                        got.push_back({ b.seq(i), b.t_ms(i), b.device(),
+                                        std::string((const char *)b.payloads() + off, n) });
+                    }
+                    off += n;
+                }
+            });
+            std::sort(got.begin(), got.end(),
+                      [](const StoredRecord &a, const StoredRecord &b) { return a.seq < b.seq; });
+            for (StoredRecord &r : got) {
+                if (out.size() >= max) break;
+                out.push_back(std::move(r));
+            }
+        }
+        // Not yet flushed
+        for (const TailRef &t : tail_) {
+            if (out.size() >= max) break;
+            if (t.seq <= after) continue;
+            const Pending &d = pending_[t.device];
+            out.push_back({ t.seq, d.t[t.index], t.device, d.bytes.substr(t.offset, d.len[t.index]) });
+        }
+        return out.size();
+    }
+
+    // Everything up to `seq` reached the backend
+    void ack(uint64_t seq) {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (seq <= cursor_) return;
+        cursor_ = seq;
+        cursor_dirty_ = true;
+    }
+
+    uint64_t cursor() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return cursor_;
+    }
+    uint64_t head() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return next_seq_ - 1;
+    }
+
+    // fn(record) for one device's records with t_min <= t_ms < t_max, per
+    // segment in seq order (segments are visited oldest first)
+    template <typename F>
+    void query(const std::string &device, int64_t t_min, int64_t t_max, F fn) {
+        std::lock_guard<std::mutex> lock(mu_);
+        for (const SegmentInfo &s : segs_) {
+            if (!s.records || s.t_max < t_min || s.t_min >= t_max) continue;
+            std::vector<StoredRecord> got;
+            scan_segment(s, [&](const BlockView &b) {
+                if (b.h->t_max < t_min || b.h->t_min >= t_max) return;
+                if (b.h->id_len != device.size() ||
+                    memcmp(b.base + sizeof(BlockHeader), device.data(), device.size())) return;
+                size_t off = 0;
+                for (size_t i = 0; i < b.h->count; i++) {
+                    uint32_t n = b.len(i);
+                    int64_t t = b.t_ms(i);
+                    if (t >= t_min && t < t_max) {
+                        got.push_back({ b.seq(i), t, device,
+                                        std::string((const char *)b.payloads() + off, n) });
+                    }
+                    off += n;
+                }
+            });
+            std::sort(got.begin(), got.end(),
+                      [](const StoredRecord &a, const StoredRecord &b) { return a.seq < b.seq; });
+            for (const StoredRecord &r : got) fn(r);
+        }
+        auto it = pending_.find(device);
+        if (it == pending_.end()) return;
+        const Pending &d = it->second;
+        size_t off = 0;
+        for (size_t i = 0; i < d.seq.size(); i++) {
+            if (d.t[i] >= t_min && d.t[i] < t_max) {
+                fn(StoredRecord{ d.seq[i], d.t[i], device, d.bytes.substr(off, d.len[i]) });
+            }
+            off += d.len[i];
+        }
+    }
+
+    /*
+     * Rewrites the oldest run of sealed, fully replayed, not yet compacted
+     * segments that fits in one segment into a single compacted segment,
+     * grouped by device. Returns false when there was nothing to do.
+     */
+    bool compact() {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (ro_) return false;
+        size_t first = 0, n = 0, bytes = WXS_PAGE;
+        for (size_t i = 0; i < segs_.size(); i++) {
+            const SegmentInfo &s = segs_[i];
+            bool ok = (s.flags & SEG_SEALED) && !(s.flags & SEG_COMPACTED) && s.seq_max <= cursor_;
+            if (!ok || bytes + s.used > p_.compact_bytes) {
+                if (n >= 2) break;
+                n = 0;
+                bytes = WXS_PAGE;
+                if (!ok) continue;
+            }
+            if (!n) first = i;
+            n++;
+            bytes += s.used;
+        }
+        if (n < 2) return false;
+
+        // Gather per device, in seq order
+        std::map<std::string, std::vector<StoredRecord>> by_dev;
+        SegmentInfo out = {};
+        out.number = segs_[first].number;
+        out.flags = SEG_SEALED | SEG_COMPACTED;
+        out.seq_min = UINT64_MAX;
+        out.t_min = INT64_MAX;
+        out.t_max = INT64_MIN;
+        for (size_t i = first; i < first + n; i++) {
+            scan_segment(segs_[i], [&](const BlockView &b) {
+                size_t off = 0;
+                std::vector<StoredRecord> &v = by_dev[b.device()];
+                for (size_t k = 0; k < b.h->count; k++) {
+                    uint32_t len = b.len(k);
+                    v.push_back({ b.seq(k), b.t_ms(k), std::string(),
+                                  std::string((const char *)b.payloads() + off, len) });
+                    off += len;
+                }
+            });
+        }
+        std::string data;
+        for (auto &dv : by_dev) {
+            std::sort(dv.second.begin(), dv.second.end(),
+                      [](const StoredRecord &a, const StoredRecord &b) { return a.seq < b.seq; });
+            Pending d;
+            for (const StoredRecord &r : dv.second) {
+                d.t.push_back(r.t_ms);
+                d.seq.push_back(r.seq);
+                d.len.push_back((uint32_t)r.payload.size());
+                d.bytes += r.payload;
+            }
+            encode_blocks(dv.first, d, data, out);
+        }
+        pad_to_page(data);
+
+        // Write beside, then atomically replace the first segment of the run
+        std::string tmp = path("compact.tmp");
+        int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        std::string head(WXS_PAGE, '\0');
+        SegmentHeader sh = { WXS_SEG_MAGIC, WXS_VERSION, SEG_COMPACTED, out.number, 0,
+                             WXS_PAGE + data.size(), wall_ms() };
+        memcpy(&head[0], &sh, sizeof(sh));
+        bool ok = write_all(fd, head) && write_all(fd, data) && fsync(fd) == 0;
+        ::close(fd);
+        if (!ok) {
+            unlink(tmp.c_str());
+            return false;
+        }
+        out.used = WXS_PAGE + data.size();
+        for (size_t i = first; i < first + n; i++) unmap(segs_[i].number);
+        if (rename(tmp.c_str(), seg_path(out.number).c_str()) != 0) return false;
+
+        std::vector<uint32_t> gone;
+        for (size_t i = first + 1; i < first + n; i++) gone.push_back(segs_[i].number);
+        segs_.erase(segs_.begin() + first + 1, segs_.begin() + first + n);
+        segs_[first] = out;
+        save_index();
+        for (uint32_t g : gone) unlink(seg_path(g).c_str());
+        return true;
+    }
+
+    struct Usage {
+        size_t   segments, bytes;
+        uint64_t records, head, cursor;
+        uint64_t dropped;       // deleted by the budget before they were replayed
+    };
+    Usage usage() {
+        std::lock_guard<std::mutex> lock(mu_);
+        Usage u = { segs_.size(), 0, 0, next_seq_ - 1, cursor_, dropped_ };
+        for (const SegmentInfo &s : segs_) {
+            u.bytes += (s.flags & SEG_COMPACTED) ? s.used : p_.segment_bytes;
+            u.records += s.records;
+        }
+        for (const auto &d : pending_) u.records += d.second.seq.size();
+        return u;
+    }
+
+    const std::vector<SegmentInfo> &segments() const { return segs_; }
+
+private:
+    struct Pending {
+        std::vector<int64_t>  t;
+        std::vector<uint64_t> seq;
+        std::vector<uint32_t> len;
+        std::string           bytes;
+    };
+    struct TailRef {
+        uint64_t    seq;
+        std::string device;
+        size_t      index, offset;
+    };
+
+    static uint64_t now_ms() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+    }
+    static int64_t wall_ms() {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+    }
+    std::string path(const char *name) const { return p_.dir + "/" + name; }
+    std::string seg_path(uint32_t n) const {
+        char name[32];
+        snprintf(name, sizeof(name), "seg-%08u.wxs", n);
+        return path(name);
+    }
+    static bool write_all(int fd, const std::string &s) {
+        size_t done = 0;
+        while (done < s.size()) {
+            ssize_t w = ::write(fd, s.data() + done, s.size() - done);
+            if (w <= 0) return false;
+            done += (size_t)w;
+        }
+        return true;
+    }
+
+    // ── Encoding ──
+    // Appends `d` as one or more blocks (split at block_max) and folds
+    // their ranges into `info`
+    void encode_blocks(const std::string &device, const Pending &d, std::string &out, SegmentInfo &info) {
+        size_t i = 0, off = 0;
+        while (i < d.seq.size()) {
+            size_t n = 0, bytes = 0;
+            while (i + n < d.seq.size() && n < 0xFFFF &&
+                   (n == 0 || bytes + d.len[i + n] + 20 <= p_.block_max)) {
+                bytes += d.len[i + n] + 20;
+                n++;
+            }
+            size_t cols = sizeof(BlockHeader) + wxs_align(device.size(), 8);
+            size_t payload = 0;
+            for (size_t k = 0; k < n; k++) payload += d.len[i + k];
+            size_t length = wxs_align(cols + 20 * n + payload, 8);
+
+            size_t at = out.size();
+            out.resize(at + length, '\0');
+            uint8_t *b = (uint8_t *)&out[at];
+            BlockHeader h = { WXS_BLOCK_MAGIC, 0, (uint32_t)length, (uint16_t)n,
+                              (uint16_t)device.size(), d.seq[i], d.seq[i + n - 1],
+                              INT64_MAX, INT64_MIN };
+            for (size_t k = 0; k < n; k++) {
+                h.t_min = std::min(h.t_min, d.t[i + k]);
+                h.t_max = std::max(h.t_max, d.t[i + k]);
+            }
+            memcpy(b + sizeof(BlockHeader), device.data(), device.size());
+            memcpy(b + cols, &d.t[i], 8 * n);
+            memcpy(b + cols + 8 * n, &d.seq[i], 8 * n);
+            memcpy(b + cols + 16 * n, &d.len[i], 4 * n);
+            memcpy(b + cols + 20 * n, d.bytes.data() + off, payload);
+            memcpy(b, &h, sizeof(h));
+            h.crc = wxs_crc32(b + 8, length - 8);
+            memcpy(b, &h, sizeof(h));
+
+            info.records += n;
+            info.seq_min = std::min(info.seq_min, h.seq_min);
+            info.seq_max = std::max(info.seq_max, h.seq_max);
+            info.t_min = std::min(info.t_min, h.t_min);
+            info.t_max = std::max(info.t_max, h.t_max);
+            i += n;
+            off += payload;
+        }
+    }
+
+    static void pad_to_page(std::string &out) {
+        size_t end = wxs_align(out.size(), WXS_PAGE);
+        if (end == out.size()) return;
+        if (end - out.size() < sizeof(BlockHeader)) end += WXS_PAGE;
+        BlockHeader pad = { WXS_PAD_MAGIC, 0, (uint32_t)(end - out.size()), 0, 0, 0, 0, 0, 0 };
+        size_t at = out.size();
+        out.resize(end, '\0');
+        memcpy(&out[at], &pad, sizeof(pad));
+    }
+
+    void flush_locked() {
+        if (ro_ || pending_.empty()) return;
+        SegmentInfo &s = segs_.back();
+        std::string data;
+        SegmentInfo delta = s;
+        if (!s.records) {
+            delta.seq_min = UINT64_MAX;
+            delta.t_min = INT64_MAX;
+            delta.t_max = INT64_MIN;
+        }
+        for (const auto &d : pending_) encode_blocks(d.first, d.second, data, delta);
+        pad_to_page(data);
+
+        if (s.used + data.size() > p_.segment_bytes) {
+            if (!s.records) {
+                fprintf(stderr, "store: a %zu byte flush does not fit in a segment\n", data.size());
+                return;
+            }
+            seal_active();
+            if (!new_segment() || !map_active()) {
+                fprintf(stderr, "store: cannot open a new segment, keeping %zu bytes in RAM\n",
+                        data.size());
+                return;
+            }
+            flush_locked();
+            return;
+        }
+        memcpy(active_ + s.used, data.data(), data.size());
+        msync(active_ + s.used, data.size(), MS_SYNC);
+        uint64_t used = s.used + data.size();
+        s = delta;
+        s.used = used;
+
+        pending_.clear();
+        tail_.clear();
+        pending_bytes_ = 0;
+        oldest_pending_ms_ = 0;
+        enforce_budget();
+    }
+
+    // ── Segments ──
+    bool new_segment() {
+        uint32_t n = segs_.empty() ? 1 : segs_.back().number + 1;
+        int fd = ::open(seg_path(n).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        bool ok = ftruncate(fd, (off_t)p_.segment_bytes) == 0;
+        SegmentHeader h = { WXS_SEG_MAGIC, WXS_VERSION, 0, n, 0, p_.segment_bytes, wall_ms() };
+        ok = ok && pwrite(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && fsync(fd) == 0;
+        ::close(fd);
+        if (!ok) return false;
+        SegmentInfo s = {};
+        s.number = n;
+        s.used = WXS_PAGE;
+        segs_.push_back(s);
+        save_index();               // a segment exists once the index lists it
+        return true;
+    }
+
+    void seal_active() {
+        segs_.back().flags |= SEG_SEALED;
+        unmap(segs_.back().number);
+        active_ = nullptr;
+        save_index();
+    }
+
+    bool map_active() {
+        const uint8_t *m = map_segment(segs_.back().number, true);
+        active_ = (uint8_t *)m;
+        return active_ != nullptr;
+    }
+
+    const uint8_t *map_segment(uint32_t n, bool writable = false) {
+        auto it = maps_.find(n);
+        if (it != maps_.end()) return (const uint8_t *)it->second.first;
+        int fd = ::open(seg_path(n).c_str(), writable ? O_RDWR : O_RDONLY);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        fstat(fd, &st);
+        void *m = mmap(nullptr, st.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                       MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (m == MAP_FAILED) return nullptr;
+        maps_[n] = { m, (size_t)st.st_size };
+        return (const uint8_t *)m;
+    }
+
+    void unmap(uint32_t n) {
+        auto it = maps_.find(n);
+        if (it == maps_.end()) return;
+        munmap(it->second.first, it->second.second);
+        maps_.erase(it);
+    }
+
+    // Calls fn(BlockView) for each valid block; returns the end of valid data
+    template <typename F>
+    uint64_t scan_segment(const SegmentInfo &s, F fn) {
+        const uint8_t *m = map_segment(s.number);
+        if (!m) return WXS_PAGE;
+        size_t size = maps_[s.number].second;
+        uint64_t limit = std::min<uint64_t>(size, s.used);
+        uint64_t pos = WXS_PAGE;
+        while (pos + sizeof(BlockHeader) <= limit) {
+            BlockHeader h;
+            memcpy(&h, m + pos, sizeof(h));
+            if (h.length < sizeof(BlockHeader) || pos + h.length > limit) break;
+            if (h.magic == WXS_PAD_MAGIC) {
+                pos += h.length;
+                continue;
+            }
+            if (h.magic != WXS_BLOCK_MAGIC || wxs_crc32(m + pos + 8, h.length - 8) != h.crc) break;
+            fn(BlockView{ (const BlockHeader *)(m + pos), m + pos });
+            pos += h.length;
+        }
+        return pos;
+    }
+
+    // Active segment after a restart: find the end of the last good flush
+    void rescan(SegmentInfo &s) {
+        SegmentInfo fresh = {};
+        fresh.number = s.number;
+        fresh.seq_min = UINT64_MAX;
+        fresh.t_min = INT64_MAX;
+        fresh.t_max = INT64_MIN;
+        SegmentInfo probe = s;
+        probe.used = UINT64_MAX;       // scan to the end of the file
+        uint64_t end = scan_segment(probe, [&](const BlockView &b) {
+            fresh.records += b.h->count;
+            fresh.seq_min = std::min(fresh.seq_min, b.h->seq_min);
+            fresh.seq_max = std::max(fresh.seq_max, b.h->seq_max);
+            fresh.t_min = std::min(fresh.t_min, b.h->t_min);
+            fresh.t_max = std::max(fresh.t_max, b.h->t_max);
+        });
+        fresh.used = wxs_align(end, WXS_PAGE);
+        if (!fresh.records) fresh.seq_min = fresh.seq_max = 0;
+        fresh.flags = s.flags;
+        s = fresh;
+        unmap(s.number);
+    }
+
+    void enforce_budget() {
+        auto total = [&] {
+            size_t b = 0;
+            for (const SegmentInfo &s : segs_) b += (s.flags & SEG_COMPACTED) ? s.used : p_.segment_bytes;
+            return b;
+        };
+        bool changed = false;
+        while (segs_.size() > 1 && total() > p_.budget_bytes) {
+            const SegmentInfo &s = segs_.front();
+            if (s.seq_max > cursor_) {
+                uint64_t lost = s.seq_max - std::max(cursor_, s.seq_min - 1);
+                dropped_ += std::min<uint64_t>(lost, s.records);
+                fprintf(stderr, "store: over budget, dropping segment %u with %llu unsent records\n",
+                        s.number, (unsigned long long)std::min<uint64_t>(lost, s.records));
+            }
+            unmap(s.number);
+            unlink(seg_path(s.number).c_str());
+            segs_.erase(segs_.begin());
+            changed = true;
+        }
+        if (changed) save_index();
+    }
+
+    // ── Index / Cursor ──
+    bool replace_file(const char *name, const std::string &data) {
+        std::string tmp = path(name) + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        bool ok = write_all(fd, data) && fsync(fd) == 0;
+        ::close(fd);
+        if (!ok || rename(tmp.c_str(), path(name).c_str()) != 0) return false;
+        int dfd = ::open(p_.dir.c_str(), O_RDONLY);
+        if (dfd >= 0) {
+            fsync(dfd);
+            ::close(dfd);
+        }
+        return true;
+    }
+
+    void save_index() {
+        std::string d(12, '\0');
+        uint32_t head[3] = { WXS_INDEX_MAGIC, WXS_VERSION, (uint32_t)segs_.size() };
+        memcpy(&d[0], head, 12);
+        d.append((const char *)segs_.data(), segs_.size() * sizeof(SegmentInfo));
+        uint32_t crc = wxs_crc32((const uint8_t *)d.data(), d.size());
+        d.append((const char *)&crc, 4);
+        replace_file("index.wxi", d);
+    }
+
+    void load_index() {
+        segs_.clear();
+        FILE *f = fopen(path("index.wxi").c_str(), "rb");
+        if (!f) return;
+        std::string d;
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) d.append(buf, n);
+        fclose(f);
+        uint32_t head[3], crc;
+        if (d.size() < 16) return;
+        memcpy(head, d.data(), 12);
+        memcpy(&crc, d.data() + d.size() - 4, 4);
+        size_t expect = 12 + head[2] * sizeof(SegmentInfo) + 4;
+        if (head[0] != WXS_INDEX_MAGIC || d.size() != expect ||
+            wxs_crc32((const uint8_t *)d.data(), d.size() - 4) != crc) {
+            fprintf(stderr, "store: index damaged, starting empty\n");
+            return;
+        }
+        segs_.resize(head[2]);
+        memcpy(segs_.data(), d.data() + 12, head[2] * sizeof(SegmentInfo));
+        // A crash mid-compaction can leave segments whose records the
+        // compacted one already holds
+        for (size_t i = 1; i < segs_.size();) {
+            const SegmentInfo &c = segs_[i - 1];
+            if ((c.flags & SEG_COMPACTED) && segs_[i].seq_max <= c.seq_max && segs_[i].records) {
+                if (!ro_) unlink(seg_path(segs_[i].number).c_str());
+                segs_.erase(segs_.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+
+    // Segment files the index does not list were never committed
+    void remove_strays() {
+        if (ro_) return;
+        DIR *dir = opendir(p_.dir.c_str());
+        if (!dir) return;
+        while (dirent *e = readdir(dir)) {
+            unsigned n;
+            if (sscanf(e->d_name, "seg-%8u.wxs", &n) != 1) continue;
+            bool listed = false;
+            for (const SegmentInfo &s : segs_) listed |= s.number == n;
+            if (!listed) unlink(path(e->d_name).c_str());
+        }
+        closedir(dir);
+        unlink(path("compact.tmp").c_str());
+    }
+
+    void save_cursor() {
+        uint64_t v[2] = { cursor_, cursor_ ^ 0x5758435552534F52ULL };
+        if (replace_file("cursor", std::string((const char *)v, sizeof(v)))) {
+            cursor_dirty_ = false;
+            cursor_saved_ms_ = now_ms();
+        }
+    }
+
+    void load_cursor() {
+        FILE *f = fopen(path("cursor").c_str(), "rb");
+        if (!f) return;
+        uint64_t v[2];
+        if (fread(v, sizeof(v), 1, f) == 1 && (v[0] ^ 0x5758435552534F52ULL) == v[1]) cursor_ = v[0];
+        fclose(f);
+    }
+
+    StoreParams p_;
+    bool        ro_ = false;
+    int         lock_fd_ = -1;
+    std::mutex  mu_;
+    std::vector<SegmentInfo> segs_;     // oldest first; the last one is active
+    std::map<uint32_t, std::pair<void *, size_t>> maps_;
+    uint8_t    *active_ = nullptr;
+    std::map<std::string, Pending> pending_;
+    std::vector<TailRef> tail_;         // unflushed records in seq order
+    size_t      pending_bytes_ = 0;
+    uint64_t    oldest_pending_ms_ = 0;
+    uint64_t    next_seq_ = 1;
+    uint64_t    cursor_ = 0;
+    bool        cursor_dirty_ = false;
+    uint64_t    cursor_saved_ms_ = 0;
+    uint64_t    dropped_ = 0;
+};
@@ -0,0 +1,162 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "json_scan.h"
+#include "semtech_udp.h"
+
+/*
+ * Uplink path of the bridge: rxpk entries from a PUSH_DATA are decoded
+ * into WX readings, and copies of the same transmission heard by several
+ * gateways are merged into one before forwarding.
+ *
+ * WX units send their build_air() output as a raw LoRa frame (no
+ * LoRaWAN MAC, CRC off), so the forwarder must run with
+ * "forward_crc_disabled": true and a private sync word. Anything that is
+ * not a JSON object with device_id and device_type is someone else's
+ * traffic and is dropped.
+ */
+
+struct Uplink {
+    uint64_t    gateway_eui;
+    std::string payload;        // the unit's JSON, as received
+    std::string device_id;
+    int64_t     received_ms = 0;    // bridge wall clock, Unix ms
+    double      rssi = 0;
+    double      snr = 0;
+    double      freq_mhz = 0;
+    std::string datr;           // e.g. "SF7BW125"
+    uint32_t    tmst = 0;
+};
+
+enum RxpkResult { RXPK_OK, RXPK_BAD_CRC, RXPK_FOREIGN, RXPK_MALFORMED };
+
+inline RxpkResult decode_rxpk(JsonSpan rxpk, uint64_t gateway_eui, Uplink &out) {
+    JsonSpan v;
+    // stat: 1 CRC ok, -1 CRC bad, 0 no CRC (how WX units transmit)
+    if (json_get(rxpk, "stat", v) && json_number(v) < 0) return RXPK_BAD_CRC;
+    if (!json_get(rxpk, "data", v) || !v.is_string()) return RXPK_MALFORMED;
+
+    uint8_t raw[256];
+    size_t n = base64_decode(v.p + 1, v.n - 2, raw, sizeof(raw));
+    while (n && (raw[n - 1] == 0 || raw[n - 1] == '\n' || raw[n - 1] == ' ')) n--;
+    if (!n) return RXPK_MALFORMED;
+    JsonSpan body = json_value((const char *)raw, n);
+    if (!body.is_object() || body.n != n) return RXPK_FOREIGN;
+    JsonSpan id, type;
+    if (!json_get(body, "device_id", id) || !id.is_string() ||
+        !json_get(body, "device_type", type) || !type.is_string()) return RXPK_FOREIGN;
+
+    out.gateway_eui = gateway_eui;
+    out.payload.assign((const char *)raw, n);
+    out.device_id = json_string(id);
+    if (json_get(rxpk, "rssi", v))      out.rssi = json_number(v);
+    if (json_get(rxpk, "lsnr", v))      out.snr = json_number(v);
+    if (json_get(rxpk, "freq", v))      out.freq_mhz = json_number(v);
+    if (json_get(rxpk, "datr", v))      out.datr = json_string(v);
+    if (json_get(rxpk, "tmst", v))      out.tmst = (uint32_t)json_number(v);
+    // SX1302 forwarders may only report per-antenna figures
+    JsonSpan rsig;
+    if (!out.rssi && json_get(rxpk, "rsig", rsig)) {
+        json_each_element(rsig, [&](JsonSpan ant) {
+            JsonSpan f;
+            if (json_get(ant, "rssic", f)) out.rssi = json_number(f);
+            if (json_get(ant, "lsnr", f))  out.snr = json_number(f);
+            return false;
+        });
+    }
+    return RXPK_OK;
+}
+
+// The forwarded record: the unit's JSON with a "lora" object appended
+inline std::string tag_uplink(const Uplink &u, uint32_t copies) {
+    char eui[17], at[32], meta[240];
+    semtech_eui_str(u.gateway_eui, eui);
+    time_t secs = (time_t)(u.received_ms / 1000);
+    tm utc;
+    gmtime_r(&secs, &utc);
+    size_t n = strftime(at, sizeof(at), "%Y-%m-%dT%H:%M:%S", &utc);
+    snprintf(at + n, sizeof(at) - n, ".%03dZ", (int)(u.received_ms % 1000));
+    snprintf(meta, sizeof(meta),
+             ",\"lora\":{\"rssi\":%.1f,\"snr\":%.1f,\"gateway\":\"%s\",\"gateways\":%u,"
+             "\"freq_mhz\":%.3f,\"datr\":\"%s\",\"received_at\":\"%s\"}}",
+             u.rssi, u.snr, eui, copies, u.freq_mhz, u.datr.c_str(), at);
+    size_t close = u.payload.rfind('}');
+    std::string out = u.payload.substr(0, close);
+    // An empty object has nothing to separate from
+    out += out.find_last_not_of(" \t\r\n") == 0 ? meta + 1 : meta;
+    return out;
+}
+
+// ── Deduplication ───────────────────────────────────────────
+// A transmission is identified by its payload bytes (boot_count makes
+// every reading unique). The first copy opens a window; copies arriving
+// within it only improve the link figures. After release the key is
+// remembered for `memory_ms` so late copies are dropped too.
+class Deduplicator {
+public:
+    Deduplicator(uint32_t window_ms, uint32_t memory_ms)
+        : window_ms_(window_ms), memory_ms_(memory_ms) {}
+
+    // Returns false when the uplink is a duplicate
+    bool add(const Uplink &u, uint64_t now_ms) {
+        uint64_t key = fnv1a(u.payload);
+        auto it = seen_.find(key);
+        if (it != seen_.end()) {
+            Entry &e = it->second;
+            if (e.released) return false;
+            e.copies++;
+            if (u.rssi > e.best.rssi) e.best = u;   // strongest gateway's view
+            return false;
+        }
+        Entry &e = seen_[key];
+        e.best = u;
+        e.copies = 1;
+        e.first_ms = now_ms;
+        pending_.push_back(key);
+        return true;
+    }
+
+    // Releases every entry whose window has closed, oldest first, and
+    // forgets released keys past the memory horizon
+    template <typename F>
+    void release(uint64_t now_ms, F emit) {
+        while (!pending_.empty()) {
+            Entry &e = seen_[pending_.front()];
+            if (now_ms < e.first_ms + window_ms_) break;
+            emit(e.best, e.copies);
+            e.released = true;
+            std::string().swap(e.best.payload);
+            released_.push_back(pending_.front());
+            pending_.pop_front();
+        }
+        while (!released_.empty() && now_ms >= seen_[released_.front()].first_ms + memory_ms_) {
+            seen_.erase(released_.front());
+            released_.pop_front();
+        }
+    }
+
+    size_t pending() const { return pending_.size(); }
+
+    static uint64_t fnv1a(const std::string &s) {
+        uint64_t h = 1469598103934665603ULL;
+        for (unsigned char c : s) h = (h ^ c) * 1099511628211ULL;
+        return h;
+    }
+
+private:
+    struct Entry {
+        Uplink   best;
+        uint32_t copies = 0;
+        uint64_t first_ms = 0;
+        bool     released = false;
+    };
+    uint32_t window_ms_, memory_ms_;
+    std::unordered_map<uint64_t, Entry> seen_;
+    std::deque<uint64_t> pending_;      // open windows, by first_ms
+    std::deque<uint64_t> released_;     // remembered keys, by first_ms
+};
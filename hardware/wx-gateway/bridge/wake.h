@@ -0,0 +1,198 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "http_client.h"
+#include "json_scan.h"
+#include "semtech_udp.h"
+#include "wake_radio.h"
+
+/*
+ * Downlink path of the bridge: on-demand reads.
+ *
+ * The backend queues read requests (POST /hardware/devices/{id}/read). A
+ * poller thread fetches the pending ones; the bridge sends each as a
+ * wake-on-radio command (common/firmware/wake_radio.h) in a PULL_RESP to
+ * the gateway that last heard the unit, or to every gateway when it has
+ * not been heard yet. The preamble outlasts the unit's CAD period so a
+ * listening unit cannot miss it. A request is sent again every retry_ms
+ * until the reading arrives (the backend then drops it from the pending
+ * list) or max_sends is reached.
+ */
+
+struct WakeParams {
+    uint32_t    poll_ms   = 5000;
+    uint32_t    retry_ms  = 20000;
+    uint32_t    max_sends = 3;
+    uint32_t    period_ms = 2000;       // units' WOR_CAD_PERIOD_MS
+    double      freq_mhz  = 915.0;      // for units not heard yet: LORA_FREQ
+    std::string datr      = "SF7BW125"; // LORA_SPREAD_FACTOR / LORA_BANDWIDTH
+    int         power_dbm = 14;
+};
+
+struct ReadRequest {
+    uint32_t    id = 0;
+    std::string device_id;
+};
+
+// Where a unit was last heard: its best gateway and channel
+struct UnitLink {
+    uint64_t    gateway_eui = 0;
+    double      freq_mhz = 0;
+    std::string datr;
+};
+
+// "SF7BW125" → 7, 125000; false if it is not a LoRa data rate
+inline bool wake_parse_datr(const std::string &datr, uint8_t &sf, uint32_t &bw_hz) {
+    unsigned s = 0, bw = 0;
+    if (sscanf(datr.c_str(), "SF%uBW%u", &s, &bw) != 2 || s < 6 || s > 12 || !bw) return false;
+    sf = (uint8_t)s;
+    bw_hz = bw * 1000;
+    return true;
+}
+
+// {"txpk":{...}} for one read command, sent at once on the unit's channel
+inline std::string wake_txpk(const ReadRequest &r, const UnitLink *link, const WakeParams &p) {
+    double freq = link && link->freq_mhz ? link->freq_mhz : p.freq_mhz;
+    const std::string &datr = link && !link->datr.empty() ? link->datr : p.datr;
+    uint8_t sf = 7;
+    uint32_t bw_hz = 125000;
+    wake_parse_datr(datr, sf, bw_hz);
+
+    char frame[WOR_FRAME_MAX];
+    size_t n = wor_frame(frame, sizeof(frame), r.device_id.c_str(), r.id);
+    char out[320];
+    // WX framing, as the units send: no IQ inversion, no CRC
+    snprintf(out, sizeof(out),
+             "{\"txpk\":{\"imme\":true,\"freq\":%.4f,\"rfch\":0,\"powe\":%d,\"modu\":\"LORA\","
+             "\"datr\":\"%s\",\"codr\":\"4/5\",\"ipol\":false,\"prea\":%u,\"ncrc\":true,"
+             "\"size\":%zu,\"data\":\"%s\"}}",
+             freq, p.power_dbm, datr.c_str(), wor_preamble_symbols(p.period_ms, sf, bw_hz), n,
+             base64_encode((const uint8_t *)frame, n).c_str());
+    return out;
+}
+
+// Fetches GET {prefix}/read-requests?status=pending every poll_ms
+class WakePoller {
+public:
+    WakePoller(const HttpUrl &url, const WakeParams &p) : url_(url), p_(p) {}
+    ~WakePoller() { stop(); }
+
+    void start() { thread_ = std::thread([this] { run(); }); }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    // The latest pending list, once per poll; false when nothing new
+    bool take(std::vector<ReadRequest> &out) {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!fresh_) return false;
+        out.swap(pending_);
+        fresh_ = false;
+        return true;
+    }
+
+    uint64_t errors() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return errors_;
+    }
+
+private:
+    void run() {
+        HttpConnection conn(url_);
+        conn.set_timeout_ms(5000);
+        std::unique_lock<std::mutex> lock(mu_);
+        while (!stopping_) {
+            lock.unlock();
+            std::vector<ReadRequest> reqs;
+            int status = conn.request("GET", "/read-requests?status=pending");
+            bool ok = status == 200 && parse(conn.body(), reqs);
+            lock.lock();
+            if (ok) {
+                pending_.swap(reqs);
+                fresh_ = true;
+            } else {
+                errors_++;
+            }
+            cv_.wait_for(lock, std::chrono::milliseconds(p_.poll_ms), [this] { return stopping_; });
+        }
+    }
+
+    static bool parse(const std::string &body, std::vector<ReadRequest> &out) {
+        JsonSpan reqs;
+        if (!json_get(json_value(body.data(), body.size()), "requests", reqs)) return false;
+        json_each_element(reqs, [&](JsonSpan r) {
+            JsonSpan id, dev;
+            if (json_get(r, "id", id) && json_get(r, "device_id", dev) && dev.is_string()) {
+                ReadRequest q;
+                q.id = (uint32_t)json_number(id);
+                q.device_id = json_string(dev);
+                if (q.id) out.push_back(q);
+            }
+            return true;
+        });
+        return true;
+    }
+
+    HttpUrl    url_;
+    WakeParams p_;
+    std::thread thread_;
+    std::mutex  mu_;
+    std::condition_variable cv_;
+    std::vector<ReadRequest> pending_;
+    bool     fresh_ = false, stopping_ = false;
+    uint64_t errors_ = 0;
+};
+
+// Which pending requests to send now: new ones at once, then every
+// retry_ms up to max_sends. Requests gone from the pending list are
+// forgotten.
+class WakeScheduler {
+public:
+    explicit WakeScheduler(const WakeParams &p) : p_(p) {}
+
+    void update(const std::vector<ReadRequest> &pending) {
+        std::map<uint32_t, Entry> next;
+        for (const ReadRequest &r : pending) {
+            auto it = entries_.find(r.id);
+            Entry &e = next[r.id];
+            if (it != entries_.end()) e = it->second;
+            e.req = r;
+        }
+        entries_.swap(next);
+    }
+
+    template <typename F>
+    void due(uint64_t now_ms, F send) {
+        for (auto &kv : entries_) {
+            Entry &e = kv.second;
+            if (e.sends >= p_.max_sends || (e.sends && now_ms < e.last_ms + p_.retry_ms)) continue;
+            e.sends++;
+            e.last_ms = now_ms;
+            send(e.req);
+        }
+    }
+
+private:
+    struct Entry {
+        ReadRequest req;
+        uint32_t    sends = 0;
+        uint64_t    last_ms = 0;
+    };
+    WakeParams p_;
+    std::map<uint32_t, Entry> entries_;
+};
@@ -0,0 +1,110 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include "config.h"
+#include "reading.h"
+
+/*
+ * SGMA threshold alarms, checked on the unit at every sample.
+ *
+ * The backend converts each well's GSP minimum threshold and measurable
+ * objective into this unit's own level (ft of water over the transducer)
+ * and hands them over in an ingest reply; the firmware keeps them in NVS.
+ * A well is in breach below a threshold, or when its level moves faster
+ * than rate_ft_h, and clears ALARM_HYSTERESIS_FT back inside. A new
+ * breach is held as unsent until it has been delivered, so it is retried
+ * on every wake until it gets through.
+ */
+
+enum AlarmBit : uint8_t {
+    ALARM_MT   = 1,     // below the minimum threshold
+    ALARM_MO   = 2,     // below the measurable objective
+    ALARM_RATE = 4,     // level changing faster than the limit
+};
+
+// One well's limits; NaN disables a check
+struct WellThreshold {
+    float min_ft;
+    float warn_ft;
+    float rate_ft_h;
+};
+
+struct ThresholdSet {
+    uint32_t      version;          // backend's; 0 = none received
+    WellThreshold wells[WELL_COUNT];
+};
+
+// Breach state across wakes; plain data for RTC memory
+struct AlarmState {
+    uint32_t version;               // ThresholdSet the state belongs to
+    uint8_t  active[WELL_COUNT];    // AlarmBit mask in breach now
+    uint8_t  unsent[WELL_COUNT];    // raised since the last delivered reading
+    float    ref_ft[WELL_COUNT];    // rate reference sample
+    uint32_t ref_t[WELL_COUNT];     // … and its unit-clock second, 0 = none
+};
+
+inline void threshold_set_clear(ThresholdSet &s) {
+    s.version = 0;
+    for (int i = 0; i < WELL_COUNT; i++) s.wells[i] = { NAN, NAN, NAN };
+}
+
+inline const char *alarm_names(uint8_t mask) {
+    static const char *const NAMES[8] = {
+        "", "mt", "mo", "mt+mo", "rate", "mt+rate", "mo+rate", "mt+mo+rate",
+    };
+    return NAMES[mask & 7];
+}
+
+// Level below limit sets bit; back above limit + hysteresis clears it
+inline uint8_t alarm_level_bit(uint8_t active, uint8_t bit, float level, float limit) {
+    if (isnan(limit)) return 0;
+    if (level < limit) return bit;
+    if ((active & bit) && level < limit + ALARM_HYSTERESIS_FT) return bit;
+    return 0;
+}
+
+/*
+ * Checks reading r, taken at unit-clock second t, and stores each well's
+ * breach mask in r.wells[i].alarm. Returns true when a breach is waiting
+ * to be sent (new now, or raised earlier and not yet delivered).
+ */
+inline bool alarm_evaluate(const ThresholdSet &thr, AlarmState &st, SensorReading &r, uint32_t t) {
+    if (st.version != thr.version) {
+        memset(&st, 0, sizeof(st));
+        st.version = thr.version;
+    }
+    bool pending = false;
+    for (int i = 0; i < WELL_COUNT; i++) {
+        WellReading &w = r.wells[i];
+        const WellThreshold &lim = thr.wells[i];
+        uint8_t was = st.active[i], now = 0;
+        if (w.ok && thr.version) {
+            now |= alarm_level_bit(was, ALARM_MT, w.water_level_ft, lim.min_ft);
+            now |= alarm_level_bit(was, ALARM_MO, w.water_level_ft, lim.warn_ft);
+
+            // Rate over at least ALARM_RATE_MIN_S, so sensor noise does not trip it
+            now |= was & ALARM_RATE;
+            if (!st.ref_t[i]) {
+                st.ref_ft[i] = w.water_level_ft;
+                st.ref_t[i]  = t;
+            } else if (t - st.ref_t[i] >= ALARM_RATE_MIN_S) {
+                float rate = fabsf(w.water_level_ft - st.ref_ft[i]) * 3600.0f / (t - st.ref_t[i]);
+                now &= ~ALARM_RATE;
+                if (!isnan(lim.rate_ft_h) && rate >= lim.rate_ft_h) now |= ALARM_RATE;
+                st.ref_ft[i] = w.water_level_ft;
+                st.ref_t[i]  = t;
+            }
+        }
+        st.unsent[i] |= now & ~was;
+        st.active[i]  = now;
+        w.alarm = now;
+        if (st.unsent[i]) pending = true;
+    }
+    return pending;
+}
+
+// The reading carrying the breaches got through
+inline void alarm_delivered(AlarmState &st) {
+    memset(st.unsent, 0, sizeof(st.unsent));
+}
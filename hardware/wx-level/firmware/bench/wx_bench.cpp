@@ -0,0 +1,224 @@
+/*
+ * WX bench firmware (env:wx-bench) — on-target latency matrix.
+ *
+ * Runs once after reset on a bench board (WX-Level carrier: ADS1115,
+ * BME280, SX1276, SIM7000G) using the same drivers as the firmware, then
+ * idles. Every result is one CSV line prefixed "BENCH," so a serial log
+ * can be grepped into a file and compared across firmware versions:
+ *
+ *   pio run -e wx-bench -t upload && pio device monitor | grep ^BENCH, > bench.csv
+ *
+ * Columns: fw, group, case, n, min_us, med_us, max_us, ref_us, where
+ * ref_us is the datasheet or computed figure for the case (0 if none).
+ * Connect the LoRa port to a dummy load. The modem group is left out
+ * unless built with -DBENCH_MODEM=1 (needs a SIM and coverage).
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <Wire.h>
+#include <SPI.h>
+#include <LoRa.h>
+#include <Adafruit_ADS1X15.h>
+#include <Adafruit_BME280.h>
+#include "config.h"
+#include "hal_arduino.h"
+#include "lora_airtime.h"
+#include "reading.h"
+#include "sim7000.h"
+
+#ifndef BENCH_MODEM
+#define BENCH_MODEM 0
+#endif
+#define BENCH_REPS        32
+#define BENCH_LORA_REPS   3
+
+Adafruit_ADS1115 ads;
+Adafruit_BME280  bme;
+ArduinoClock     hal_clock;
+
+// ── Results ─────────────────────────────────────────────────
+static uint32_t samples[BENCH_REPS];
+
+static void report(const char *group, const char *name, uint32_t *s, int n, uint32_t ref_us = 0) {
+    std::sort(s, s + n);
+    Serial.printf("BENCH,%s,%s,%s,%d,%u,%u,%u,%u\n", FIRMWARE_VERSION, group, name, n,
+                  s[0], s[n / 2], s[n - 1], ref_us);
+}
+
+template <typename F>
+static void measure(const char *group, const char *name, int reps, F fn, uint32_t ref_us = 0) {
+    if (reps > BENCH_REPS) reps = BENCH_REPS;
+    for (int i = 0; i < reps; i++) {
+        uint32_t t0 = micros();
+        fn();
+        samples[i] = micros() - t0;
+    }
+    report(group, name, samples, reps, ref_us);
+}
+
+// ── ADS1115 / I2C ───────────────────────────────────────────
+static void bench_adc() {
+    static const struct { uint16_t rate; uint16_t sps; } RATES[] = {
+        { RATE_ADS1115_8SPS, 8 },     { RATE_ADS1115_16SPS, 16 },
+        { RATE_ADS1115_32SPS, 32 },   { RATE_ADS1115_64SPS, 64 },
+        { RATE_ADS1115_128SPS, 128 }, { RATE_ADS1115_250SPS, 250 },
+        { RATE_ADS1115_475SPS, 475 }, { RATE_ADS1115_860SPS, 860 },
+    };
+    static const uint32_t CLOCKS[] = { 100000, 400000 };
+    char name[32];
+
+    for (uint32_t hz : CLOCKS) {
+        Wire.setClock(hz);
+
+        // One register read (config register poll), the unit cost of any I2C access
+        snprintf(name, sizeof(name), "reg_read_%uk", hz / 1000);
+        measure("i2c", name, BENCH_REPS, [] { ads.conversionComplete(); });
+
+        for (const auto &r : RATES) {
+            ads.setDataRate(r.rate);
+            snprintf(name, sizeof(name), "convert_%usps_%uk", r.sps, hz / 1000);
+            int reps = r.sps < 64 ? 8 : BENCH_REPS;
+            measure("ads1115", name, reps, [] { ads.readADC_SingleEnded(0); },
+                    1000000UL / r.sps);
+        }
+    }
+    ads.setDataRate(RATE_ADS1115_128SPS);
+    Wire.setClock(100000);
+}
+
+// ── BME280 ──────────────────────────────────────────────────
+static void bench_bme() {
+    // Forced mode, x1 oversampling on all three channels as in the firmware
+    bme.setSampling(Adafruit_BME280::MODE_FORCED,
+                    Adafruit_BME280::SAMPLING_X1, Adafruit_BME280::SAMPLING_X1,
+                    Adafruit_BME280::SAMPLING_X1, Adafruit_BME280::FILTER_OFF);
+    measure("bme280", "forced_measurement", BENCH_REPS, [] { bme.takeForcedMeasurement(); }, 9300);
+    measure("bme280", "read_compensated", BENCH_REPS, [] {
+        volatile float p = bme.readPressure(), t = bme.readTemperature(), h = bme.readHumidity();
+        (void)p; (void)t; (void)h;
+    });
+}
+
+// ── Payload ─────────────────────────────────────────────────
+static void bench_json() {
+    SensorReading r = {};
+    r.boot_count = 1234;
+    r.baro_pressure_hpa = 1009.7f;
+    r.baro_temp_c = 24.3f;
+    r.humidity_pct = 41.8f;
+    r.water_temp_c = 24.3f;
+    r.battery_v = 3.92f;
+    r.solar_v = 5.61f;
+    float psi[WELL_CHANNEL_COUNT];
+    for (int i = 0; i < WELL_CHANNEL_COUNT; i++) psi[i] = 4.2f + i * 1.7f;
+    fill_well_levels(r, psi);
+
+    static char buf[1024];
+    size_t len = 0;
+    measure("cpu", "build_json", BENCH_REPS, [&] { len = build_json(r, buf, sizeof(buf)); });
+    Serial.printf("BENCHMETA,build_json_bytes,%u\n", (unsigned)len);
+}
+
+// ── LoRa ────────────────────────────────────────────────────
+static void bench_lora() {
+    LoRa.setPins(PIN_LORA_CS, PIN_LORA_RST, PIN_LORA_DIO0);
+    SPI.begin(PIN_LORA_SCK, PIN_LORA_MISO, PIN_LORA_MOSI, PIN_LORA_CS);
+    if (!LoRa.begin(LORA_FREQ)) {
+        Serial.println("BENCHMETA,lora,absent");
+        return;
+    }
+    LoRa.setSignalBandwidth(LORA_BANDWIDTH);
+    LoRa.setTxPower(2);     // bench: into a dummy load
+
+    static const uint16_t SIZES[] = { 16, 64, 128, LORA_MAX_PAYLOAD };
+    static uint8_t payload[LORA_MAX_PAYLOAD];
+    memset(payload, 0x55, sizeof(payload));
+    char name[32];
+
+    for (uint8_t sf = 7; sf <= 12; sf++) {
+        LoRa.setSpreadingFactor(sf);
+        for (uint16_t len : SIZES) {
+            snprintf(name, sizeof(name), "tx_sf%u_%uB", sf, len);
+            measure("lora", name, BENCH_LORA_REPS, [&] {
+                LoRa.beginPacket();
+                LoRa.write(payload, len);
+                LoRa.endPacket();
+            }, lora_airtime_us(sf, (uint32_t)LORA_BANDWIDTH, len));
+        }
+    }
+    LoRa.setSpreadingFactor(LORA_SPREAD_FACTOR);
+    LoRa.sleep();
+}
+
+// ── SIM7000G ────────────────────────────────────────────────
+#if BENCH_MODEM
+static void bench_modem() {
+    Serial1.begin(115200, SERIAL_8N1, PIN_SIM_RX, PIN_SIM_TX);
+    ArduinoSerial io(Serial1);
+    Sim7000 modem(io, hal_clock);
+
+    // One pass per step; repeated sessions are run by resetting the board
+    uint32_t t0 = micros();
+    pinMode(PIN_SIM_PWR, OUTPUT);
+    digitalWrite(PIN_SIM_PWR, HIGH);
+    delay(1000);
+    digitalWrite(PIN_SIM_PWR, LOW);
+    bool alive = false;
+    while (!alive && micros() - t0 < 30000000UL) alive = modem.command("AT", "OK", 500);
+    samples[0] = micros() - t0;
+    report("sim7000", alive ? "boot_to_at" : "boot_to_at_TIMEOUT", samples, 1);
+    if (!alive) return;
+
+    const char body[] = "{\"device_id\":\"" DEVICE_ID "\",\"device_type\":\"bench\"}";
+    bool ok = true;
+    auto step = [&](const char *name, auto fn) {
+        if (!ok) return;
+        uint32_t t = micros();
+        ok = fn();
+        samples[0] = micros() - t;
+        report("sim7000", ok ? name : "step_FAILED", samples, 1);
+        if (!ok) Serial.printf("BENCHMETA,sim7000_failed_step,%s,%s\n", name, modem.line());
+    };
+    step("attach", [&] { return modem.attach(APN); });
+    step("http_open", [&] { return modem.http_open("https://" SERVER_HOST); });
+    step("http_post", [&] {
+        return modem.http_post(API_ENDPOINT, "application/json",
+                               (const uint8_t *)body, sizeof(body) - 1) > 0;
+    });
+    step("http_close", [&] { modem.http_close(); return true; });
+    step("detach", [&] { modem.detach(); return true; });
+    step("power_off", [&] { modem.power_off(); return true; });
+}
+#endif
+
+// ── Main ────────────────────────────────────────────────────
+void setup() {
+    Serial.begin(115200);
+    delay(2000);    // let the monitor attach
+    Serial.println("BENCH,fw,group,case,n,min_us,med_us,max_us,ref_us");
+    Serial.printf("BENCHMETA,device,%s,cpu_mhz,%u\n", DEVICE_ID, getCpuFrequencyMhz());
+
+    Wire.begin(PIN_SDA, PIN_SCL);
+    bool ads_ok = ads.begin(ADS1115_ADDR);
+    bool bme_ok = bme.begin(BME280_ADDR);
+    if (ads_ok) {
+        ads.setGain(GAIN_ONE);
+        bench_adc();
+    } else {
+        Serial.println("BENCHMETA,ads1115,absent");
+    }
+    if (bme_ok) bench_bme();
+    else Serial.println("BENCHMETA,bme280,absent");
+
+    bench_json();
+    bench_lora();
+#if BENCH_MODEM
+    bench_modem();
+#endif
+    Serial.println("BENCHMETA,done");
+}
+
+void loop() {
+    delay(1000);
+}
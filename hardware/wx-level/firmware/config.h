@@ -12,8 +12,15 @@
 #define PIN_SIM_TX          17
 #define PIN_SIM_RX          18
 #define PIN_SIM_PWR         21
+#define PIN_SIM_RI          13   // modem ring indicator; RTC GPIO for ext0 wake
 #define PIN_BATTERY_ADC     4    // voltage divider to LiPo
 #define PIN_SOLAR_ADC       5    // voltage divider to solar panel
+#define PIN_RS485_TX        15
+#define PIN_RS485_RX        16
+#define PIN_RS485_DE        7    // transceiver DE/RE, driven by UART RTS
+#define PIN_SDI12_TX        1    // via tri-state buffer onto the SDI-12 line
+#define PIN_SDI12_RX        2
+#define PIN_SDI12_DIR       6    // buffer enable: HIGH = talk, LOW = listen
 
 // ── ADS1115 ─────────────────────────────────────────────────
 #define ADS1115_ADDR        0x48
@@ -32,6 +39,80 @@
 #define PRESSURE_PSI_MAX    10.0f
 #define PSI_TO_FT_WATER     2.31f
 
+// ── Well Channels ───────────────────────────────────────────
+// One transducer per ADS1115 single-ended input, so a single logger can
+// serve up to four wells or nested piezometers within cable reach.
+// Channel 0 keeps the calibration above; add entries only for populated
+// inputs, since every entry is read and reported. baro_comp = false for
+// vented (gauge) transducers, which already reference atmosphere.
+// baro_ref_hpa is the pressure the sensor was zeroed at.
+#define WELL_CHANNEL_COUNT  1
+// { ads_ch, v_min, v_max, psi_min, psi_max, ft_per_psi, baro_comp, baro_ref_hpa, well_id }
+#define WELL_CHANNELS { \
+    { ADS_CHANNEL_PRESSURE, PRESSURE_V_MIN, PRESSURE_V_MAX, \
+      PRESSURE_PSI_MIN, PRESSURE_PSI_MAX, PSI_TO_FT_WATER, true, 1013.25f, "A" }, \
+}
+/* Example — nested piezometers on inputs 1 (15 PSI, absolute) and
+   2 (30 PSI, vented) next to the channel-0 well:
+     #define WELL_CHANNEL_COUNT  3
+     #define WELL_CHANNELS { \
+         { ADS_CHANNEL_PRESSURE, PRESSURE_V_MIN, PRESSURE_V_MAX, \
+           PRESSURE_PSI_MIN, PRESSURE_PSI_MAX, PSI_TO_FT_WATER, true, 1013.25f, "A" }, \
+         { 1, 1.0f, 5.0f, 0.0f, 15.0f, 2.31f, true,  1013.25f, "B" }, \
+         { 2, 1.0f, 5.0f, 0.0f, 30.0f, 2.31f, false, 1013.25f, "C" }, \
+     }
+*/
+
+// ── Digital Wells ───────────────────────────────────────────
+// Wells read over Modbus or SDI-12, appended after the analog wells. A
+// pressure or level field on slot N fills digital well N; a temperature
+// replaces the BME280 water-temperature approximation.
+#define DIGITAL_WELL_COUNT  0
+// { well_id, bus, ft_per_psi, baro_comp, baro_ref_hpa }
+#define DIGITAL_WELLS       { }
+
+// ── Modbus RTU (RS-485) ─────────────────────────────────────
+// Fields of one slave are listed together so they are fetched in a single
+// block read.
+#define MODBUS_UART         UART_NUM_2
+#define MODBUS_BAUD         19200
+#define MODBUS_TIMEOUT_MS   200
+#define MODBUS_WARMUP_MS    1000  // sonde power-up, counted from boot
+#define MODBUS_FIELD_COUNT  0
+// { slave, func, reg, type, scale, offset, quantity, slot }
+#define MODBUS_FIELDS       { }
+/* Example — absolute level sonde at address 1, F32 pressure (PSI) at
+   register 0 and F32 temperature at register 2:
+     #define DIGITAL_WELL_COUNT  1
+     #define DIGITAL_WELLS       { { "D", "modbus", 2.31f, true, 1013.25f } }
+     #define MODBUS_FIELD_COUNT  2
+     #define MODBUS_FIELDS { \
+         { 1, MB_READ_HOLDING, 0, MB_F32, 1.0f, 0.0f, SQ_PRESSURE_PSI, 0 }, \
+         { 1, MB_READ_HOLDING, 2, MB_F32, 1.0f, 0.0f, SQ_TEMP_C,       0 }, \
+     }
+*/
+
+// ── SDI-12 ──────────────────────────────────────────────────
+// All sensors are started together with aC! and collected with aD0!…, so
+// the bus takes as long as the slowest sensor. Shares the UART with Modbus;
+// the two buses are read one after the other.
+#define SDI12_UART          UART_NUM_2
+#define SDI12_FIELD_COUNT   0
+// { addr, value_index, scale, offset, quantity, slot }
+#define SDI12_FIELDS        { }
+/* Example — two pressure/temperature probes at addresses 0 and 1, each
+   returning +pressure_psi+temp_c:
+     #define DIGITAL_WELL_COUNT  2
+     #define DIGITAL_WELLS { { "E", "sdi12", 2.31f, true, 1013.25f }, \
+                             { "F", "sdi12", 2.31f, true, 1013.25f } }
+     #define SDI12_FIELD_COUNT   3
+     #define SDI12_FIELDS { \
+         { '0', 0, 1.0f, 0.0f, SQ_PRESSURE_PSI, 0 }, \
+         { '0', 1, 1.0f, 0.0f, SQ_TEMP_C,       0 }, \
+         { '1', 0, 1.0f, 0.0f, SQ_PRESSURE_PSI, 1 }, \
+     }
+*/
+
 // ── Timing ──────────────────────────────────────────────────
 #define TX_INTERVAL_MS      (15UL * 60UL * 1000UL)  // 15 minutes
 #define DEEP_SLEEP_US       (TX_INTERVAL_MS * 1000ULL)
@@ -41,12 +122,115 @@
 #define LORA_BANDWIDTH      125E3
 #define LORA_SPREAD_FACTOR  7
 #define LORA_TX_POWER       17   // dBm
+#define LORA_MAX_PAYLOAD    255  // SX1276 FIFO; longer payloads go cellular
 
 // ── Cellular ────────────────────────────────────────────────
 #define APN                 "iot.1nce.net"   // change for your SIM
 #define SERVER_HOST         "api.waterxchange.io"
 #define SERVER_PORT         443
 #define API_ENDPOINT        "/hardware/data"
+#define JSON_MAX_PAYLOAD    1024     // build_json() buffer for one reading
+
+// ── Backlog ─────────────────────────────────────────────────
+// Readings the transport policy defers, or that fail to send, are kept in
+// RTC memory as a packed batch (ts_codec.h, ~6-10 bytes per reading once
+// a series settles) and uploaded on the next cellular session.
+#define BACKLOG_BYTES       2048
+#define API_PACKED_ENDPOINT "/hardware/data/packed"
+
+// ── Transport Policy ────────────────────────────────────────
+// Each reading goes over LoRa, cellular, or waits in the queue for a
+// cellular batch, by expected joules per delivered reading (see
+// common/firmware/tx_policy.h). Delivery rates are learned per link in
+// RTC memory; a LoRa send counts as delivered when the frame goes out.
+#define TX_LORA_ATTEMPT_J   0.02f    // wake + preamble at 17 dBm
+#define TX_LORA_BYTE_J      0.0009f  // ~1.5 ms airtime per byte at SF7/125 kHz
+#define TX_LORA_LATENCY_S   2.0f
+#define TX_CELL_ATTEMPT_J   17.0f    // ~30 s attach + TLS + POST at ~155 mA
+#define TX_CELL_BYTE_J      0.00005f
+#define TX_CELL_PRICE_J     0.0f     // data price per byte in joules; 0 for flat-rate SIMs
+#define TX_CELL_LATENCY_S   30.0f
+#define TX_ROUTINE_BUDGET_J 3.0f     // routine readings wait rather than cost more
+#define TX_QUEUE_MAX        16       // backlog readings; 4 h at 15 min
+#define TX_BATT_OK_V        3.8f     // energy weighs 1× at or above this…
+#define TX_BATT_LOW_V       3.5f     // …rising to TX_BATT_WEIGHT_MAX here
+#define TX_BATT_CRIT_V      3.4f     // below: only urgent readings are sent
+#define TX_BATT_WEIGHT_MAX  4.0f
+#define TX_STATS_DECAY      0.8f     // per attempt: ~5 attempts of memory
+#define TX_STATS_RECOVER    0.97f    // per cycle: an unused link drifts back to untried
+#define TX_URGENT_LEVEL_STEP_FT 1.0f  // any well, since the last reading
+
+// ── Battery Sag ─────────────────────────────────────────────
+// Around LoRa transmits and cellular sessions the on-chip ADC samples the
+// battery and solar dividers continuously (battery_sag.h). A transmit is
+// a known current step and gives the cell's internal resistance; every
+// capture gives its minimum. Routine readings stay off cellular when the
+// predicted sag of a session would reach SAG_BROWNOUT_V.
+#define SAG_CAPTURE         1
+#define SAG_SAMPLE_HZ       1000     // battery / solar pairs per second
+#define SAG_PREROLL_MS      50       // rest before the load
+#define SAG_DIVIDER         2.0f     // 100 kΩ / 100 kΩ on both inputs
+#define SAG_LORA_TX_A       0.12f    // SX1276 at LORA_TX_POWER, over idle
+#define SAG_CELL_PEAK_A     0.6f     // SIM7000G LTE-M transmit peak
+#define SAG_BROWNOUT_V      3.1f     // LDO dropout above the S3 brownout detector
+#define SAG_MIN_SAMPLES     32       // per phase, for a resistance estimate
+#define SAG_R_WEIGHT        0.2f     // of a new estimate in the tracked one
+#define SAG_SOLAR_STEADY_V  0.2f     // more solar swing voids the estimate
+
+// ── Threshold Alarms ────────────────────────────────────────
+// Per-well SGMA limits come from the backend in an ingest reply and are
+// kept in NVS (see alarm.h). Once a set is loaded, the unit wakes every
+// ALARM_SAMPLE_MS between reports to read the analog wells and check
+// them, so a breach goes out within one sample period rather than one TX
+// interval; it is sent as an urgent reading, up to ALARM_TX_ATTEMPTS
+// times per wake. Units without thresholds only wake to report.
+#define ALARM_SAMPLE_MS     (60UL * 1000UL)  // 0: check only at report time
+#define ALARM_HYSTERESIS_FT 0.2f
+#define ALARM_RATE_MIN_S    300     // shortest span for a rate-of-change estimate
+#define ALARM_TX_ATTEMPTS   3
+#define ALARM_RETRY_MS      5000
+#define ALARM_NVS_NAMESPACE "wx-alarm"
+
+// ── On-Demand Reads ─────────────────────────────────────────
+// Between reports the unit can listen for a read command from the gateway
+// bridge (wake_radio.h): a CAD every WOR_CAD_PERIOD_MS, from light sleep
+// (WOR_LIGHT) or from a short deep sleep (WOR_DEEP, slower to react but
+// cheaper between CADs). The bridge's --wake-period-ms must match.
+#define WOR_OFF             0
+#define WOR_LIGHT           1
+#define WOR_DEEP            2
+#define WOR_MODE            WOR_OFF
+#define WOR_CAD_PERIOD_MS   2000
+#define WOR_CAD_TIMEOUT_MS  20        // CAD takes ~2 symbols; 0.5 ms at SF7
+#define WOR_RX_TIMEOUT_MS   (WOR_CAD_PERIOD_MS + 500)  // rest of the long preamble
+// With SIM_RI_WAKE the modem is left registered after a session instead of
+// powered down, and an SMS pulls PIN_SIM_RI low to wake the unit. eDRX
+// rather than PSM: a module in PSM cannot be paged, so it would not see
+// the SMS until its next TAU.
+#define SIM_RI_WAKE         0
+#define SIM_EDRX_CYCLE      "0101"    // 81.92 s paging cycle (3GPP 27.007)
+
+// ── Synoptic Campaigns ──────────────────────────────────────
+// The backend announces campaign instants in the ingest reply and the unit
+// wakes to measure at them (common/firmware/campaign.h). Its clock comes
+// from the same replies: the internal RC RTC drifts ~1000 ppm until two
+// syncs CLOCK_SKEW_MIN_S apart give its skew. A 32 kHz crystal
+// (CONFIG_RTC_CLK_SRC_EXT_CRYS) brings both bounds to ~20 ppm.
+#define CLOCK_DRIFT_PPM     1000.0f
+#define CLOCK_RESIDUAL_PPM  200.0f
+#define CLOCK_SKEW_MIN_S    3600
+#define CLOCK_SYNC_MAX_S    (24UL * 3600UL)  // a cellular report at least daily; 0 = only for campaigns
+
+// ── ADC Trace Recording ─────────────────────────────────────
+// Every ADC conversion of a cycle is logged and the last TRACE_KEEP cycles
+// are kept in flash; the backend can ask for one to be uploaded, and
+// hardware/tools/replay runs it back through the firmware code.
+#define TRACE_RECORD        1
+#define TRACE_MAX_SAMPLES   1024      // 8 bytes each
+#define TRACE_KEEP          8
+#define TRACE_UPLOAD_CHUNK  2048
+#define TRACE_PATH          "/hardware/traces/" DEVICE_ID
+#define TRACE_ADC_LEVEL     0         // converter id in the trace
 
 // ── Device Identity ─────────────────────────────────────────
 #define DEVICE_TYPE         "wx-level"
@@ -0,0 +1,123 @@
+/*
+ * WX-Level host microbenchmarks (env:native).
+ *
+ * Runs the firmware's reading logic — ADC code conversion, pipelined
+ * channel sequencing, barometric compensation and JSON serialization —
+ * against hal_native.h backends and reports host ns/op. The pipelined
+ * sequence is also reported in virtual (on-device) milliseconds, which is
+ * what the awake-time budget actually cares about.
+ * It also checks that a default reading goes out as one LoRa frame and
+ * exits nonzero if not.
+ *
+ *   pio run -e native && .pio/build/native/program [name-filter]
+ */
+
+#include <stdio.h>
+#include "hal_native.h"
+#include "microbench.h"
+#include "reading.h"
+
+// Built against the shipped config.h: its wells must fit one LoRa frame.
+// Units configured with more wells send over cellular when they do not.
+static_assert(AIR_MAX_BYTES <= LORA_MAX_PAYLOAD,
+              "default WX-Level LoRa frame can exceed LORA_MAX_PAYLOAD");
+
+static SensorReading sample_reading() {
+    SensorReading r = {};
+    r.boot_count        = 1234;
+    r.baro_pressure_hpa = 1009.7f;
+    r.baro_temp_c       = 24.3f;
+    r.humidity_pct      = 41.8f;
+    r.water_temp_c      = 24.3f;
+    r.battery_v         = 3.92f;
+    r.solar_v           = 5.61f;
+    float psi[WELL_CHANNEL_COUNT];
+    for (int i = 0; i < WELL_CHANNEL_COUNT; i++) psi[i] = 4.2f + i * 1.7f;
+    fill_well_levels(r, psi);
+    r.pressure_psi   = r.wells[0].pressure_psi;
+    r.water_level_ft = r.wells[0].water_level_ft;
+    return r;
+}
+
+// A default reading must go out as one LoRa frame: build_air() within
+// LORA_MAX_PAYLOAD, and the transport policy routing it to LoRa
+static bool check_lora_feasible() {
+    SensorReading r = sample_reading();
+    char json[JSON_MAX_PAYLOAD], frame[LORA_MAX_PAYLOAD + 1];
+    TxRequest rq = {};
+    rq.bytes     = build_json(r, json, sizeof(json));
+    rq.air_bytes = build_air(r, frame, sizeof(frame));
+    rq.urgency   = TX_ROUTINE;
+    rq.battery_v = r.battery_v;
+    rq.lora_up   = true;
+    TxLinkStats stats[2] = {};
+    TxDecision d = tx_decide(TX_POLICY, stats, rq);
+    bool ok = rq.air_bytes && d.route == TX_LORA;
+    printf("CHECK %-32s %12s (%u B frame, route %s)\n", "level/lora_feasible",
+           ok ? "ok" : "FAIL", (unsigned)rq.air_bytes, tx_route_name(d.route));
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    bool checks_ok = check_lora_feasible();
+    VirtualClock clock;
+    ScriptedAdc adc(clock, [](uint8_t ch, uint64_t t_us) {
+        return (int16_t)(16000 + ch * 2500 + (int)(t_us / 1000) % 7);
+    });
+
+    if (bench_selected(argc, argv, "level/pressure_psi_from_raw")) {
+        int16_t code = 8000;
+        bench_run("level/pressure_psi_from_raw", [&] {
+            code = (int16_t)(8000 + (code + 7) % 32000);
+            bench_keep(pressure_psi_from_raw(WELL_CFG[0], code));
+        });
+    }
+
+    if (bench_selected(argc, argv, "level/fill_well_levels")) {
+        SensorReading r = sample_reading();
+        float psi[WELL_CHANNEL_COUNT];
+        for (int i = 0; i < WELL_CHANNEL_COUNT; i++) psi[i] = 3.0f + i;
+        bench_run("level/fill_well_levels", [&] {
+            r.baro_pressure_hpa += 0.01f;
+            fill_well_levels(r, psi);
+            bench_keep(r);
+        });
+    }
+
+    if (bench_selected(argc, argv, "level/well_conversions")) {
+        float psi[WELL_CHANNEL_COUNT];
+        uint64_t t0 = clock.time_us();
+        well_conversions_begin(adc);
+        well_conversions_finish(adc, clock, psi);
+        printf("SIM   %-32s %12.2f ms virtual\n", "level/well_conversions",
+               (clock.time_us() - t0) / 1000.0);
+        bench_run("level/well_conversions", [&] {
+            well_conversions_begin(adc);
+            well_conversions_finish(adc, clock, psi);
+            bench_keep(psi);
+        });
+    }
+
+    if (bench_selected(argc, argv, "level/build_json")) {
+        SensorReading r = sample_reading();
+        char buf[1024];
+        size_t len = build_json(r, buf, sizeof(buf));
+        printf("SIZE  %-32s %12zu bytes\n", "level/build_json", len);
+        bench_run("level/build_json", [&] {
+            r.boot_count++;
+            bench_keep(build_json(r, buf, sizeof(buf)));
+        });
+    }
+
+    if (bench_selected(argc, argv, "level/build_air")) {
+        SensorReading r = sample_reading();
+        char buf[LORA_MAX_PAYLOAD + 1];
+        size_t len = build_air(r, buf, sizeof(buf));
+        printf("SIZE  %-32s %12zu bytes\n", "level/build_air", len);
+        bench_run("level/build_air", [&] {
+            r.boot_count++;
+            bench_keep(build_air(r, buf, sizeof(buf)));
+        });
+    }
+    return checks_ok ? 0 : 1;
+}
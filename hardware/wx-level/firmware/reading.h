@@ -0,0 +1,218 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "config.h"
+#include "digital_sensors.h"
+#include "hal.h"
+#include "tx_policy.h"
+#include "battery_sag.h"
+
+/*
+ * WX-Level reading: the sensor-to-payload logic that does not touch
+ * hardware directly — per-channel calibration, pipelined ADC sequencing,
+ * barometric compensation, digital-sensor merging and the payload
+ * encoders generated from hardware/schema/.
+ * Shared by the firmware and the env:native build.
+ */
+
+struct WellChannel {
+    uint8_t     ads_channel;
+    float       v_min;
+    float       v_max;
+    float       psi_min;
+    float       psi_max;
+    float       ft_per_psi;
+    bool        baro_comp;     // false for vented (gauge) transducers
+    float       baro_ref_hpa;  // atmosphere at which the sensor was zeroed
+    const char *well_id;
+};
+
+static const WellChannel WELL_CFG[WELL_CHANNEL_COUNT] = WELL_CHANNELS;
+
+struct DigitalWell {
+    const char *well_id;
+    const char *bus;           // "modbus" or "sdi12"
+    float       ft_per_psi;
+    bool        baro_comp;
+    float       baro_ref_hpa;
+};
+
+#define WELL_COUNT (WELL_CHANNEL_COUNT + DIGITAL_WELL_COUNT)
+
+#if DIGITAL_WELL_COUNT > 0
+static const DigitalWell DIGITAL_WELL_CFG[DIGITAL_WELL_COUNT] = DIGITAL_WELLS;
+#endif
+
+struct WellReading {
+    float water_level_ft;
+    float pressure_psi;
+    bool  ok;
+    uint8_t alarm;             // AlarmBit mask (alarm.h)
+};
+
+struct SensorReading {
+    WellReading wells[WELL_COUNT];
+    float water_level_ft;      // channel 0, for single-well consumers
+    float pressure_psi;
+    float water_temp_c;
+    float baro_pressure_hpa;
+    float baro_temp_c;
+    float humidity_pct;
+    float battery_v;
+    float solar_v;
+    uint32_t boot_count;
+    uint32_t thr_version;      // threshold set the alarms were checked against
+    uint32_t read_req;         // on-demand read request answered, 0 = scheduled
+    uint32_t campaign;         // synoptic campaign id, 0 = none
+    float campaign_dt_s;       // measured minus campaign instant, unit's estimate
+    float clock_err_s;         // bound on that estimate
+    SagReport batt;            // battery sag since the last reading
+    TxDecision tx;             // how this reading is sent, reported with it
+};
+
+inline float mapf(float x, float in_min, float in_max, float out_min, float out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+inline const DigitalWell *digital_well(int i) {
+#if DIGITAL_WELL_COUNT > 0
+    if (i >= WELL_CHANNEL_COUNT) return &DIGITAL_WELL_CFG[i - WELL_CHANNEL_COUNT];
+#else
+    (void)i;
+#endif
+    return nullptr;
+}
+
+inline const char *well_id(int i) {
+    const DigitalWell *dw = digital_well(i);
+    return dw ? dw->well_id : WELL_CFG[i].well_id;
+}
+
+// ── Conversions ─────────────────────────────────────────────
+inline float pressure_psi_from_raw(const WellChannel &ch, int16_t raw) {
+    float voltage = raw * 0.000125f; // ADS1115 at GAIN_ONE: 0.125mV/bit
+    float psi = mapf(voltage, ch.v_min, ch.v_max, ch.psi_min, ch.psi_max);
+    if (psi < ch.psi_min) return ch.psi_min;
+    if (psi > ch.psi_max) return ch.psi_max;
+    return psi;
+}
+
+inline float compensate_level_ft(float psi, float ft_per_psi, bool baro_comp,
+                                 float baro_ref_hpa, float baro_hpa) {
+    // Absolute transducers also see the atmosphere above the water column.
+    // Barometric offset in PSI: (actual_hPa - zero_hPa) × 0.01450
+    if (baro_comp) {
+        psi -= (baro_hpa - baro_ref_hpa) * 0.01450f;
+    }
+    float level_ft = psi * ft_per_psi;
+    return level_ft < 0 ? 0 : level_ft;
+}
+
+/*
+ * Pipelined conversions across channels: each ADS1115 conversion takes
+ * ~8ms at 128 SPS, so the next channel is started before the previous
+ * result is scaled. The caller starts the first conversion with
+ * well_conversions_begin(), runs the BME280 forced measurement while it is
+ * in flight, then collects everything with well_conversions_finish().
+ * Total time ≈ N conversions instead of N conversions + BME280 +
+ * per-channel I2C/maths overhead.
+ */
+inline void well_conversions_begin(HalAdc &adc) {
+    adc.start_single_ended(WELL_CFG[0].ads_channel);
+}
+
+inline void well_conversions_finish(HalAdc &adc, HalClock &clock,
+                                    float out_psi[WELL_CHANNEL_COUNT]) {
+    for (int i = 0; i < WELL_CHANNEL_COUNT; i++) {
+        while (!adc.conversion_done()) {
+            clock.delay_us(200);
+        }
+        int16_t raw = adc.last_result();
+        if (i + 1 < WELL_CHANNEL_COUNT) {
+            adc.start_single_ended(WELL_CFG[i + 1].ads_channel);
+        }
+        out_psi[i] = pressure_psi_from_raw(WELL_CFG[i], raw);
+    }
+}
+
+// Convert pressure to water level (ft) with per-channel barometric
+// compensation — one BME280 reading serves every well on the logger.
+// Digital wells start out empty until their bus fills them.
+inline void fill_well_levels(SensorReading &r, const float psi[WELL_CHANNEL_COUNT]) {
+    for (int i = 0; i < WELL_CHANNEL_COUNT; i++) {
+        const WellChannel &ch = WELL_CFG[i];
+        r.wells[i].pressure_psi   = psi[i];
+        r.wells[i].water_level_ft = compensate_level_ft(psi[i], ch.ft_per_psi,
+                                                        ch.baro_comp, ch.baro_ref_hpa,
+                                                        r.baro_pressure_hpa);
+        r.wells[i].ok = true;
+        r.wells[i].alarm = 0;
+    }
+    for (int i = WELL_CHANNEL_COUNT; i < WELL_COUNT; i++) {
+        r.wells[i].water_level_ft = 0;
+        r.wells[i].pressure_psi   = 0;
+        r.wells[i].ok             = false;
+        r.wells[i].alarm          = 0;
+    }
+}
+
+// ── Digital Sensors ─────────────────────────────────────────
+// Modbus and SDI-12 values feed the same WellReading slots as the analog
+// path, so digital and analog wells are indistinguishable downstream apart
+// from their source.
+inline void apply_digital_values(SensorReading &r, const DigitalValue *values, size_t n) {
+#if DIGITAL_WELL_COUNT > 0
+    for (size_t i = 0; i < n; i++) {
+        const DigitalValue &v = values[i];
+        if (!v.ok) continue;
+        if (v.quantity == SQ_TEMP_C) {
+            r.water_temp_c = v.value;
+            continue;
+        }
+        if (v.slot >= DIGITAL_WELL_COUNT) continue;
+        const DigitalWell &dw = DIGITAL_WELL_CFG[v.slot];
+        WellReading &w = r.wells[WELL_CHANNEL_COUNT + v.slot];
+        if (v.quantity == SQ_PRESSURE_PSI) {
+            w.pressure_psi   = v.value;
+            w.water_level_ft = compensate_level_ft(v.value, dw.ft_per_psi, dw.baro_comp,
+                                                   dw.baro_ref_hpa, r.baro_pressure_hpa);
+            w.ok = true;
+        } else if (v.quantity == SQ_LEVEL_FT) {
+            w.water_level_ft = v.value;
+            w.pressure_psi   = v.value / dw.ft_per_psi;
+            w.ok = true;
+        }
+    }
+#else
+    (void)r; (void)values; (void)n;
+#endif
+}
+
+// ── Transport Urgency ───────────────────────────────────────
+// Urgent when any well moved TX_URGENT_LEVEL_STEP_FT since the last
+// reading (last_ft, per well; nullptr on the first cycle)
+inline uint8_t reading_urgency(const SensorReading &r, const float *last_ft) {
+    if (!last_ft) return TX_ROUTINE;
+    for (int i = 0; i < WELL_COUNT; i++) {
+        if (r.wells[i].ok && fabsf(r.wells[i].water_level_ft - last_ft[i]) >= TX_URGENT_LEVEL_STEP_FT) {
+            return TX_URGENT;
+        }
+    }
+    return TX_ROUTINE;
+}
+
+// Transport policy parameters from config.h (see tx_policy.h)
+static const TxPolicyParams TX_POLICY = {
+    { { TX_LORA_ATTEMPT_J, TX_LORA_BYTE_J, 0.0f, TX_LORA_LATENCY_S, LORA_MAX_PAYLOAD },
+      { TX_CELL_ATTEMPT_J, TX_CELL_BYTE_J, TX_CELL_PRICE_J, TX_CELL_LATENCY_S, 0 } },
+    TX_ROUTINE_BUDGET_J, TX_QUEUE_MAX,
+    TX_BATT_OK_V, TX_BATT_LOW_V, TX_BATT_CRIT_V, TX_BATT_WEIGHT_MAX,
+    TX_STATS_DECAY, TX_STATS_RECOVER,
+};
+
+// ── Payload ─────────────────────────────────────────────────
+// build_json() and the packed backlog record (pack_begin() / pack_add())
+// are generated from hardware/schema/readings.py. Readings that could
+// not be sent wait in RTC memory as a ts_codec batch and go up together.
+#include "reading_schema.h"
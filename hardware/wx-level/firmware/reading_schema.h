@@ -0,0 +1,224 @@
+// Generated by hardware/schema/gen_readings.py from readings.py. Do not edit.
+#pragma once
+#include <stdio.h>
+#include "schema.h"
+#include "ts_codec.h"
+
+// wx-level payload, keys and precision as in hardware/schema/readings.py.
+// Serializes into buf (NUL-terminated); returns the payload length, 0 if
+// it did not fit.
+inline size_t build_json(const SensorReading &r, char *buf, size_t cap) {
+    JsonOut out(buf, cap);
+    out.lit("{\"device_id\":");
+    out.str(DEVICE_ID);
+    out.lit(",\"device_type\":");
+    out.str(DEVICE_TYPE);
+    out.lit(",\"fw_version\":");
+    out.str(FIRMWARE_VERSION);
+    out.lit(",\"boot_count\":");
+    out.uint(r.boot_count);
+    out.lit(",\"water_level_ft\":");
+    out.fixed<2>(r.water_level_ft);
+    out.lit(",\"pressure_psi\":");
+    out.fixed<3>(r.pressure_psi);
+    out.lit(",\"water_temp_c\":");
+    out.fixed<1>(r.water_temp_c);
+    out.lit(",\"baro_pressure_hpa\":");
+    out.fixed<1>(r.baro_pressure_hpa);
+    out.lit(",\"baro_temp_c\":");
+    out.fixed<1>(r.baro_temp_c);
+    out.lit(",\"humidity_pct\":");
+    out.fixed<1>(r.humidity_pct);
+    out.lit(",\"battery_v\":");
+    out.fixed<2>(r.battery_v);
+    out.lit(",\"solar_v\":");
+    out.fixed<2>(r.solar_v);
+    out.lit(",\"wells\":[");
+    for (int i = 0; i < WELL_COUNT; i++) {
+        const WellReading &w = r.wells[i];
+        const DigitalWell *dw = digital_well(i);
+        if (i) out.lit(",");
+        out.lit("{\"well_id\":");
+        out.str(well_id(i));
+        if (!dw) {
+            out.lit(",\"channel\":");
+            out.uint(WELL_CFG[i].ads_channel);
+        }
+        if (dw) {
+            out.lit(",\"bus\":");
+            out.str(dw->bus);
+        }
+        if (w.ok) {
+            out.lit(",\"water_level_ft\":");
+            out.fixed<2>(w.water_level_ft);
+            out.lit(",\"pressure_psi\":");
+            out.fixed<3>(w.pressure_psi);
+        }
+        if (w.alarm) {
+            out.lit(",\"alarm\":");
+            out.uint(w.alarm);
+        }
+        out.lit("}");
+    }
+    out.lit("]");
+    if (r.thr_version) {
+        out.lit(",\"thr_version\":");
+        out.uint(r.thr_version);
+    }
+    if (r.read_req) {
+        out.lit(",\"read_req\":");
+        out.uint(r.read_req);
+    }
+    if (r.batt.r_ohm > 0) {
+        out.lit(",\"batt_r_ohm\":");
+        out.fixed<3>(r.batt.r_ohm);
+    }
+    if (r.batt.min_v > 0) {
+        out.lit(",\"batt_min_v\":");
+        out.fixed<2>(r.batt.min_v);
+    }
+    if (r.campaign) {
+        out.lit(",\"campaign\":");
+        out.uint(r.campaign);
+        out.lit(",\"campaign_dt_s\":");
+        out.fixed<3>(r.campaign_dt_s);
+        out.lit(",\"clock_err_s\":");
+        out.fixed<3>(r.clock_err_s);
+    }
+    out.lit(",\"tx\":{\"route\":");
+    out.str(tx_route_name(r.tx.route));
+    out.lit(",\"reason\":");
+    out.str(tx_reason_name(r.tx.reason));
+    out.lit(",\"queued\":");
+    out.uint(r.tx.queued);
+    out.lit(",\"p_lora\":");
+    out.fixed<2>(r.tx.p[TX_LORA]);
+    out.lit(",\"p_cell\":");
+    out.fixed<2>(r.tx.p[TX_CELL]);
+    if (r.tx.route != TX_DEFER) {
+        out.lit(",\"cost_j\":");
+        out.fixed<1>(r.tx.cost_j[r.tx.route]);
+    }
+    out.lit("}}");
+    return out.finish();
+}
+
+// The same reading as a LoRa frame: short keys, arrays of objects as
+// value arrays, cellular-only fields left out (readings.py `air`).
+inline size_t build_air(const SensorReading &r, char *buf, size_t cap) {
+    JsonOut out(buf, cap);
+    out.lit("{\"device_id\":");
+    out.str(DEVICE_ID);
+    out.lit(",\"device_type\":");
+    out.str(DEVICE_TYPE);
+    out.lit(",\"n\":");
+    out.uint(r.boot_count);
+    out.lit(",\"wt\":");
+    out.fixed<1>(r.water_temp_c);
+    out.lit(",\"bp\":");
+    out.fixed<1>(r.baro_pressure_hpa);
+    out.lit(",\"bt\":");
+    out.fixed<1>(r.baro_temp_c);
+    out.lit(",\"rh\":");
+    out.fixed<1>(r.humidity_pct);
+    out.lit(",\"bv\":");
+    out.fixed<2>(r.battery_v);
+    out.lit(",\"sv\":");
+    out.fixed<2>(r.solar_v);
+    out.lit(",\"w\":[");
+    for (int i = 0; i < WELL_COUNT; i++) {
+        const WellReading &w = r.wells[i];
+        if (i) out.lit(",");
+        out.lit("[");
+        out.str(well_id(i));
+        out.lit(",");
+        out.fixed<2>((w.ok) ? w.water_level_ft : NAN);
+        out.lit(",");
+        out.fixed<3>((w.ok) ? w.pressure_psi : NAN);
+        out.lit(",");
+        out.uint(w.alarm);
+        out.lit("]");
+    }
+    out.lit("]");
+    if (r.thr_version) {
+        out.lit(",\"tv\":");
+        out.uint(r.thr_version);
+    }
+    if (r.read_req) {
+        out.lit(",\"rr\":");
+        out.uint(r.read_req);
+    }
+    if (r.batt.r_ohm > 0) {
+        out.lit(",\"br\":");
+        out.fixed<3>(r.batt.r_ohm);
+    }
+    if (r.batt.min_v > 0) {
+        out.lit(",\"bm\":");
+        out.fixed<2>(r.batt.min_v);
+    }
+    if (r.campaign) {
+        out.lit(",\"cp\":");
+        out.uint(r.campaign);
+        out.lit(",\"cd\":");
+        out.fixed<3>(r.campaign_dt_s);
+        out.lit(",\"ce\":");
+        out.fixed<3>(r.clock_err_s);
+    }
+    out.lit("}");
+    return out.finish();
+}
+
+// Longest frame build_air() writes: every conditional field present,
+// numbers and strings at their readings.py span / width.
+static constexpr size_t AIR_MAX_BYTES = 203 + (sizeof(DEVICE_ID) - 1) + (sizeof(DEVICE_TYPE) - 1) + (WELL_COUNT) * (27);
+
+// Packed backlog columns: unit clock (s), then every packed field at its
+// payload precision; wells columns repeat per entry as "<well_id>.<key>".
+static constexpr TsField PACK_COLUMNS[] = {
+    { "t", TS_DOD, 0 },
+    { "boot_count", TS_DOD, 0 },
+    { "water_temp_c", TS_DELTA, 1 },
+    { "baro_pressure_hpa", TS_DELTA, 1 },
+    { "battery_v", TS_DELTA, 2 },
+    { "solar_v", TS_DELTA, 2 },
+};
+static constexpr TsField PACK_WELLS_COLUMNS[] = {
+    { "water_level_ft", TS_DELTA, 2 },
+    { "pressure_psi", TS_DELTA, 3 },
+};
+
+#define PACK_BASE_FIELDS    6
+#define PACK_FIELD_COUNT    (PACK_BASE_FIELDS + 2 * WELL_COUNT)
+static_assert(PACK_FIELD_COUNT <= TS_MAX_FIELDS, "too many columns for one packed record");
+
+// Starts a batch in buf
+inline bool pack_begin(TsEncoder &enc, uint8_t *buf, size_t cap) {
+    TsField f[PACK_FIELD_COUNT];
+    for (int k = 0; k < PACK_BASE_FIELDS; k++) f[k] = PACK_COLUMNS[k];
+    static char names[WELL_COUNT][2][32];
+    for (int i = 0; i < WELL_COUNT; i++) {
+        for (int k = 0; k < 2; k++) {
+            const TsField &c = PACK_WELLS_COLUMNS[k];
+            snprintf(names[i][k], sizeof(names[i][k]), "%s.%s", well_id(i), c.name);
+            f[PACK_BASE_FIELDS + 2 * i + k] = { names[i][k], c.kind, c.decimals };
+        }
+    }
+    return enc.begin(buf, cap, DEVICE_ID, DEVICE_TYPE, f, PACK_FIELD_COUNT);
+}
+
+// Appends r, taken at unit-clock second t; false when the batch is full
+inline bool pack_add(TsEncoder &enc, uint8_t *buf, const SensorReading &r, uint32_t t) {
+    double v[PACK_FIELD_COUNT];
+    v[0] = t;
+    v[1] = r.boot_count;
+    v[2] = r.water_temp_c;
+    v[3] = r.baro_pressure_hpa;
+    v[4] = r.battery_v;
+    v[5] = r.solar_v;
+    for (int i = 0; i < WELL_COUNT; i++) {
+        const WellReading &w = r.wells[i];
+        v[PACK_BASE_FIELDS + 2 * i] = w.ok ? w.water_level_ft : NAN;
+        v[PACK_BASE_FIELDS + 2 * i + 1] = w.ok ? w.pressure_psi : NAN;
+    }
+    return enc.add(buf, v);
+}
@@ -2,52 +2,175 @@
  * WX-Level — Smart Well Level Meter Firmware
  * ESP32-S3 + ADS1115 + BME280 + SX1276 LoRa + SIM7000G
  *
- * Reads submersible pressure transducer (4-20mA) to compute water level,
- * compensates for barometric pressure via BME280, and transmits readings
- * over LoRa (primary) and LTE Cat-M1 (fallback) to WaterXchange cloud.
+ * Reads up to four submersible pressure transducers (4-20mA), one per
+ * ADS1115 input, plus digital sondes over RS-485 Modbus RTU and SDI-12, to compute
+ * water level in each well, compensates for barometric pressure via BME280,
+ * and transmits readings over LoRa (primary) and LTE Cat-M1 (fallback) to
+ * WaterXchange cloud.
  */
 
+#include <time.h>
 #include <Wire.h>
 #include <SPI.h>
 #include <LoRa.h>
 #include <Adafruit_ADS1X15.h>
 #include <Adafruit_BME280.h>
 #include <ArduinoJson.h>
+#include <Preferences.h>
+#include "modbus_rtu.h"
+#include "modbus_port_esp32.h"
+#include "sdi12.h"
+#include "sdi12_port_esp32.h"
+#include "sim7000.h"
 #include "config.h"
+#include "hal_arduino.h"
+#include "adc_trace.h"
+#include "adc_trace_store.h"
+#include "reading.h"
+#include "alarm.h"
+#include "wake_radio.h"
+#include "campaign.h"
 
 // ── Globals ─────────────────────────────────────────────────
 Adafruit_ADS1115 ads;
 Adafruit_BME280  bme;
 RTC_DATA_ATTR uint32_t boot_count = 0;
 RTC_DATA_ATTR uint32_t tx_fail_count = 0;
+// Unsent readings, packed; header_len == 0 means no batch is open
+RTC_DATA_ATTR uint8_t   backlog_buf[BACKLOG_BYTES];
+RTC_DATA_ATTR TsEncoder backlog;
+RTC_DATA_ATTR TxLinkStats tx_stats[2];          // delivery history, [TX_LORA], [TX_CELL]
+RTC_DATA_ATTR float     last_level_ft[WELL_COUNT];
+RTC_DATA_ATTR uint32_t  next_report_s = 0;      // unit clock; alarm sample wakes until then
+RTC_DATA_ATTR uint32_t  next_sample_s = 0;      // next alarm sample; WOR_DEEP listens until then
+RTC_DATA_ATTR AlarmState alarm_state;
+RTC_DATA_ATTR bool      alarms_armed = false;   // a threshold set is loaded: sample wakes run
+// On-demand read to answer at the next wake: the request id from a radio
+// command, or READ_REQ_RING when the modem rang (the SMS carries no id)
+RTC_DATA_ATTR uint32_t  read_req = 0;
+RTC_DATA_ATTR bool      modem_idle = false;     // left registered in eDRX, RI armed
+RTC_DATA_ATTR ClockSync clock_sync;             // unit clock → UTC, from ingest replies
+RTC_DATA_ATTR Campaign  campaign;               // next synoptic campaign, id 0 = none
+RTC_DATA_ATTR BatteryHealth batt_health;        // internal resistance and sag under load
+#define READ_REQ_RING   0xFFFFFFFFUL
+ThresholdSet thresholds;                        // loaded from NVS every wake
+
+static const ClockParams CLOCK = {
+    CLOCK_DRIFT_PPM, CLOCK_RESIDUAL_PPM, CLOCK_SKEW_MIN_S, CLOCK_SYNC_MAX_S,
+};
 
-struct SensorReading {
-    float water_level_ft;
-    float pressure_psi;
-    float water_temp_c;
-    float baro_pressure_hpa;
-    float baro_temp_c;
-    float humidity_pct;
-    float battery_v;
-    float solar_v;
+static const SagParams SAG = {
+    SAG_R_WEIGHT, SAG_SOLAR_STEADY_V, SAG_MIN_SAMPLES, SAG_BROWNOUT_V,
 };
 
+Ads1115Adc   level_adc(ads);
+ArduinoClock hal_clock;
+LoRaRadio    lora_radio;
+Esp32SupplyStream supply_stream(PIN_BATTERY_ADC, PIN_SOLAR_ADC, SAG_DIVIDER);
+
+// Transducer conversions go through the trace recorder; it only logs once
+// adc_trace.begin() has been called (TRACE_RECORD)
+static AdcTraceSample trace_buf[TRACE_RECORD ? TRACE_MAX_SAMPLES : 1];
+AdcTrace     adc_trace(trace_buf, TRACE_RECORD ? TRACE_MAX_SAMPLES : 0);
+RecordingAdc level_rec(level_adc, adc_trace, TRACE_ADC_LEVEL);
+
+#if MODBUS_FIELD_COUNT > 0
+static const ModbusField MODBUS_FIELD_CFG[MODBUS_FIELD_COUNT] = MODBUS_FIELDS;
+#endif
+#if SDI12_FIELD_COUNT > 0
+static const Sdi12Field  SDI12_FIELD_CFG[SDI12_FIELD_COUNT] = SDI12_FIELDS;
+#endif
+
 // ── Forward Declarations ────────────────────────────────────
 SensorReading read_sensors();
-float         read_pressure_psi();
+void          read_wells(SensorReading &r);
+void          read_modbus(SensorReading &r);
+void          read_sdi12(SensorReading &r);
 float         read_battery_voltage();
 float         read_solar_voltage();
+void          sag_start(SagCapture &sag);
+void          sag_finish(SagCapture &sag, float load_a);
+bool          cell_brownout(float battery_v);
 bool          send_lora(const SensorReading &r);
 bool          send_cellular(const SensorReading &r);
-String        build_json(const SensorReading &r);
+void          handle_server_reply(Sim7000 &modem, const char *reply, int64_t sent_ms,
+                                  int64_t recv_ms);
+void          choose_transport(SensorReading &r, bool lora_ok, bool urgent, bool sync);
+bool          transmit(SensorReading &r, bool lora_ok, bool urgent, bool sync = false);
+void          send_alarm(SensorReading &r, bool lora_ok);
+void          thresholds_load();
+void          thresholds_apply(JsonObjectConst t);
+void          backlog_add(const SensorReading &r);
+bool          backlog_post(Sim7000 &modem);
+bool          backlog_flush();
 void          enter_deep_sleep();
+uint64_t      wor_light_listen(uint64_t sleep_us);
 void          sim_power_on();
-void          sim_power_off();
+void          sim_release(Sim7000 &modem);
 
 // ── Setup ───────────────────────────────────────────────────
 void setup() {
     Serial.begin(115200);
-    boot_count++;
+    // Report wakes run the full cycle; the wakes between them only check
+    // the alarm thresholds, or under WOR_DEEP only listen for a read command
+    uint32_t now_s = (uint32_t)time(nullptr);   // RTC clock, runs through deep sleep
+#if SIM_RI_WAKE
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0) read_req = READ_REQ_RING;
+#endif
+    bool sampling = ALARM_SAMPLE_MS > 0 && alarms_armed;
+    bool report = boot_count == 0 || (int32_t)(now_s - next_report_s) >= 0 ||
+                  (!sampling && WOR_MODE != WOR_DEEP);
+    // A campaign instant; one missed by more than its error budget is dropped
+    bool snapshot = false;
+    if (campaign.id && clock_sync.synced_ms) {
+        int64_t late = unit_clock_ms() - campaign_unit_ms(clock_sync, campaign);
+        if (late > (int64_t)campaign.max_err_ms) {
+            Serial.printf("Campaign %u missed by %.1f s\n", campaign.id, late / 1000.0);
+            campaign.id = 0;
+        } else {
+            snapshot = late >= -CAMPAIGN_EARLY_MS;
+        }
+    }
+    bool sample = !report && !snapshot && sampling &&
+                  (WOR_MODE != WOR_DEEP || (int32_t)(now_s - next_sample_s) >= 0);
+
+    // LoRa — SX1276; first, so a listen-only wake touches nothing else
+    LoRa.setPins(PIN_LORA_CS, PIN_LORA_RST, PIN_LORA_DIO0);
+    SPI.begin(PIN_LORA_SCK, PIN_LORA_MISO, PIN_LORA_MOSI, PIN_LORA_CS);
+    bool lora_ok = LoRa.begin(LORA_FREQ);
+    if (lora_ok) {
+        LoRa.setSpreadingFactor(LORA_SPREAD_FACTOR);
+        LoRa.setSignalBandwidth(LORA_BANDWIDTH);
+        LoRa.setTxPower(LORA_TX_POWER);
+    }
+#if WOR_MODE == WOR_DEEP
+    if (!report && !sample && !snapshot && !read_req) {
+        WorCommand cmd;
+        if (!lora_ok || !wor_listen_once(lora_radio, DEVICE_ID, WOR_CAD_TIMEOUT_MS,
+                                         WOR_RX_TIMEOUT_MS, cmd)) {
+            enter_deep_sleep();
+        }
+        read_req = cmd.req;
+    }
+#endif
+
+    // On-demand reads and campaign snapshots are reports out of schedule:
+    // the next scheduled one stays where it was
+    bool on_demand = read_req != 0;
+    if (report) {
+        next_report_s = now_s + TX_INTERVAL_MS / 1000;
+        tx_stats_tick(TX_POLICY, tx_stats);
+    }
+    if (report || sample) next_sample_s = now_s + ALARM_SAMPLE_MS / 1000;
+    if (on_demand) {
+        Serial.printf("On-demand read (%s)\n", read_req == READ_REQ_RING ? "modem ring" : "radio");
+        report = true;
+    }
+    if (snapshot) {
+        Serial.printf("Campaign %u snapshot\n", campaign.id);
+        report = true;
+    }
+    if (report) boot_count++;
 
     Wire.begin(PIN_SDA, PIN_SCL);
 
@@ -68,40 +191,83 @@ void setup() {
         Adafruit_BME280::SAMPLING_X1,
         Adafruit_BME280::FILTER_OFF
     );
-
-    // LoRa — SX1276
-    LoRa.setPins(PIN_LORA_CS, PIN_LORA_RST, PIN_LORA_DIO0);
-    SPI.begin(PIN_LORA_SCK, PIN_LORA_MISO, PIN_LORA_MOSI, PIN_LORA_CS);
-    bool lora_ok = LoRa.begin(LORA_FREQ);
-    if (lora_ok) {
-        LoRa.setSpreadingFactor(LORA_SPREAD_FACTOR);
-        LoRa.setSignalBandwidth(LORA_BANDWIDTH);
-        LoRa.setTxPower(LORA_TX_POWER);
+    thresholds_load();
+
+    if (!report) {
+        SensorReading sample = {};
+        sample.boot_count = boot_count;
+        read_wells(sample);
+        sample.battery_v = read_battery_voltage();
+        sample.solar_v   = read_solar_voltage();
+        if (alarm_evaluate(thresholds, alarm_state, sample, now_s)) send_alarm(sample, lora_ok);
+        enter_deep_sleep();
     }
 
     // Read all sensors
+    int64_t read_ms = unit_clock_ms();
     SensorReading reading = read_sensors();
+    bool alarm = alarm_evaluate(thresholds, alarm_state, reading, now_s);
+    if (on_demand) reading.read_req = read_req == READ_REQ_RING ? 0 : read_req;
+    if (snapshot) {
+        reading.campaign = campaign.id;
+        campaign_offset(clock_sync, CLOCK, campaign, read_ms, reading.campaign_dt_s,
+                        reading.clock_err_s);
+        campaign.id = 0;
+    }
 
-    // Print to serial for debugging
-    Serial.printf("Boot #%u | WL: %.2f ft | P: %.3f PSI | Baro: %.1f hPa | "
-                  "Batt: %.2fV | Solar: %.2fV\n",
-                  boot_count, reading.water_level_ft, reading.pressure_psi,
-                  reading.baro_pressure_hpa, reading.battery_v, reading.solar_v);
+#if TRACE_RECORD
+    Serial.printf("Trace: %u conversions (%u dropped)\n",
+                  adc_trace.header.count, adc_trace.header.dropped);
+    if (!trace_store_begin() || !trace_store_save(adc_trace, TRACE_KEEP)) {
+        Serial.println("Trace: save to flash failed");
+    }
+#endif
 
-    // Transmit: try LoRa first, cellular fallback
-    bool sent = false;
-    if (lora_ok) {
-        sent = send_lora(reading);
+    // Print to serial for debugging
+    Serial.printf("Boot #%u | Baro: %.1f hPa | Batt: %.2fV | Solar: %.2fV\n",
+                  boot_count, reading.baro_pressure_hpa,
+                  reading.battery_v, reading.solar_v);
+    for (int i = 0; i < WELL_COUNT; i++) {
+        Serial.printf("  Well %s | WL: %.2f ft | P: %.3f PSI%s%s%s\n",
+                      well_id(i), reading.wells[i].water_level_ft,
+                      reading.wells[i].pressure_psi,
+                      reading.wells[i].ok ? "" : " (no response)",
+                      reading.wells[i].alarm ? " | ALARM " : "",
+                      alarm_names(reading.wells[i].alarm));
     }
-    if (!sent) {
-        sent = send_cellular(reading);
+
+    // Transmit: the transport policy picks LoRa, cellular or the backlog.
+    // A threshold breach is urgent and retried; routine readings that fail
+    // wait in the backlog. send_cellular() takes the backlog along. An
+    // on-demand read is urgent too: someone is waiting for it. A clock too
+    // old or too loose for the next campaign sends the reading cellular,
+    // for the sync in the reply.
+    bool sync = clock_wants_sync(clock_sync, CLOCK, campaign, unit_clock_ms());
+    bool sent = transmit(reading, lora_ok, alarm || on_demand, sync);
+    read_req = 0;
+    for (int k = 1; !sent && alarm && k < ALARM_TX_ATTEMPTS; k++) {
+        delay(ALARM_RETRY_MS);
+        sent = transmit(reading, lora_ok, true, sync);
     }
+    uint8_t route = reading.tx.route;
 
     if (!sent) {
-        tx_fail_count++;
-        Serial.printf("TX failed (total failures: %u)\n", tx_fail_count);
+        if (route != TX_DEFER) {
+            tx_fail_count++;
+            Serial.printf("TX failed (total failures: %u)\n", tx_fail_count);
+        }
+        backlog_add(reading);
     } else {
         tx_fail_count = 0;
+        if (alarm) alarm_delivered(alarm_state);
+        if (route == TX_LORA && tx_flush_queue(TX_POLICY, tx_stats, backlog.count,
+                                               backlog.bytes(), reading.battery_v,
+                                               cell_brownout(reading.battery_v))) {
+            tx_record(TX_POLICY, tx_stats[TX_CELL], backlog_flush());
+        }
+    }
+    for (int i = 0; i < WELL_COUNT; i++) {
+        if (reading.wells[i].ok) last_level_ft[i] = reading.wells[i].water_level_ft;
     }
 
     enter_deep_sleep();
@@ -113,44 +279,102 @@ void loop() {
 
 // ── Sensor Reading ──────────────────────────────────────────
 SensorReading read_sensors() {
-    SensorReading r;
+    SensorReading r = {};
+    r.boot_count = boot_count;
+#if TRACE_RECORD
+    adc_trace.begin(hal_clock, DEVICE_TYPE, DEVICE_ID, boot_count);
+#endif
 
-    // Pressure transducer via ADS1115
-    r.pressure_psi = read_pressure_psi();
+    read_wells(r);
 
-    // BME280 barometric readings
+    // Digital sensors on RS-485 and SDI-12
+    read_modbus(r);
+    read_sdi12(r);
+
+    r.pressure_psi   = r.wells[0].pressure_psi;
+    r.water_level_ft = r.wells[0].water_level_ft;
+
+    // Battery and solar voltages; sag under the loads since the last reading
+    r.battery_v = read_battery_voltage();
+    r.solar_v   = read_solar_voltage();
+    r.batt      = battery_report(batt_health);
+
+    return r;
+}
+
+// Analog wells with barometric compensation: all an alarm sample reads
+void read_wells(SensorReading &r) {
+    // Pressure transducers via ADS1115, with the BME280 forced measurement
+    // running in the shadow of the first conversion
+    float psi[WELL_CHANNEL_COUNT];
+    well_conversions_begin(level_rec);
     bme.takeForcedMeasurement();
+    well_conversions_finish(level_rec, hal_clock, psi);
+
+    // BME280 barometric readings
     r.baro_pressure_hpa = bme.readPressure() / 100.0f;
     r.baro_temp_c       = bme.readTemperature();
     r.humidity_pct       = bme.readHumidity();
     r.water_temp_c       = r.baro_temp_c; // approximation; actual comes from transducer if available
 
-    // Convert pressure to water level (ft) with barometric compensation
-    // Standard atmosphere ≈ 14.696 PSI ≈ 1013.25 hPa
-    // Barometric offset in PSI: (actual_hPa - 1013.25) × 0.01450
-    float baro_offset_psi = (r.baro_pressure_hpa - 1013.25f) * 0.01450f;
-    float corrected_psi   = r.pressure_psi - baro_offset_psi;
-    r.water_level_ft      = corrected_psi * PSI_TO_FT_WATER;
-
-    if (r.water_level_ft < 0) r.water_level_ft = 0;
-
-    // Battery and solar voltages
-    r.battery_v = read_battery_voltage();
-    r.solar_v   = read_solar_voltage();
+    // Replay needs the compensation inputs as well as the ADC codes
+    adc_trace.header.aux[0] = r.baro_pressure_hpa;
+    adc_trace.header.aux[1] = r.baro_temp_c;
+    adc_trace.header.aux[2] = r.humidity_pct;
 
-    return r;
+    fill_well_levels(r, psi);
+    r.pressure_psi   = r.wells[0].pressure_psi;
+    r.water_level_ft = r.wells[0].water_level_ft;
+    r.thr_version    = thresholds.version;
 }
 
-float read_pressure_psi() {
-    int16_t raw = ads.readADC_SingleEnded(ADS_CHANNEL_PRESSURE);
-    float voltage = raw * 0.000125f; // ADS1115 at GAIN_ONE: 0.125mV/bit
-    float psi = mapf(voltage, PRESSURE_V_MIN, PRESSURE_V_MAX,
-                     PRESSURE_PSI_MIN, PRESSURE_PSI_MAX);
-    return constrain(psi, PRESSURE_PSI_MIN, PRESSURE_PSI_MAX);
+// ── Digital Sensors ─────────────────────────────────────────
+void read_modbus(SensorReading &r) {
+#if MODBUS_FIELD_COUNT > 0
+    Esp32ModbusPort port(MODBUS_UART, PIN_RS485_TX, PIN_RS485_RX, PIN_RS485_DE, MODBUS_BAUD);
+    if (!port.begin()) {
+        Serial.println("Modbus UART init failed");
+        return;
+    }
+    if (millis() < MODBUS_WARMUP_MS) delay(MODBUS_WARMUP_MS - millis());
+
+    ModbusBlock  blocks[MODBUS_FIELD_COUNT];
+    DigitalValue values[MODBUS_FIELD_COUNT];
+    size_t nb = modbus_plan_blocks(MODBUS_FIELD_CFG, MODBUS_FIELD_COUNT,
+                                   blocks, MODBUS_FIELD_COUNT);
+    ModbusMaster master(port, MODBUS_BAUD, MODBUS_TIMEOUT_MS);
+    size_t n_ok = master.poll(MODBUS_FIELD_CFG, blocks, nb, values);
+    port.end();
+
+    Serial.printf("Modbus: %u/%u fields in %u blocks (timeouts %u, CRC %u, exc %u)\n",
+                  n_ok, MODBUS_FIELD_COUNT, nb, master.stats.timeouts,
+                  master.stats.crc_errors, master.stats.exceptions);
+    apply_digital_values(r, values, MODBUS_FIELD_COUNT);
+#else
+    (void)r;
+#endif
 }
 
-float mapf(float x, float in_min, float in_max, float out_min, float out_max) {
-    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+void read_sdi12(SensorReading &r) {
+#if SDI12_FIELD_COUNT > 0
+    Esp32Sdi12Port port(SDI12_UART, PIN_SDI12_TX, PIN_SDI12_RX, PIN_SDI12_DIR);
+    if (!port.begin()) {
+        Serial.println("SDI-12 UART init failed");
+        return;
+    }
+
+    DigitalValue values[SDI12_FIELD_COUNT];
+    Sdi12Master master(port);
+    size_t n_ok = master.measure(SDI12_FIELD_CFG, SDI12_FIELD_COUNT, values);
+    port.end();
+
+    Serial.printf("SDI-12: %u/%u values in %u ms (retries %u, no response %u)\n",
+                  n_ok, SDI12_FIELD_COUNT, master.elapsed_ms,
+                  master.stats.retries, master.stats.no_response);
+    apply_digital_values(r, values, SDI12_FIELD_COUNT);
+#else
+    (void)r;
+#endif
 }
 
 float read_battery_voltage() {
@@ -164,113 +388,320 @@ float read_solar_voltage() {
     return (raw / 4095.0f) * 3.3f * 2.0f;
 }
 
+// ── Battery Sag ─────────────────────────────────────────────
+// A capture spans one heavy load: sag_start() before it is switched on,
+// sag_finish() once it is off. load_a 0 = current step unknown, only the
+// minimum counts.
+void sag_start(SagCapture &sag) {
+    if (SAG_CAPTURE && sag.begin()) sag.load_on();
+}
+
+void sag_finish(SagCapture &sag, float load_a) {
+    sag.load_off();
+    SagMeasurement m = sag_measure(sag.result(), load_a, SAG);
+    battery_health_update(batt_health, m, SAG);
+    if (m.min_v > 0) {
+        Serial.printf("Battery sag: %.3f V rest, %.3f V min | R %.0f mΩ (%u)\n",
+                      m.rest_v, m.min_v, batt_health.r_ohm * 1000.0f, batt_health.r_count);
+    }
+}
+
+// A cellular session from battery_v would sag the cell below brownout
+bool cell_brownout(float battery_v) {
+    return battery_brownout_risk(batt_health, SAG, battery_v, SAG_CELL_PEAK_A);
+}
+
 // ── LoRa Transmission ───────────────────────────────────────
 bool send_lora(const SensorReading &r) {
-    String json = build_json(r);
+    // The compact frame (build_air); 0 when even that exceeds the FIFO
+    char frame[LORA_MAX_PAYLOAD + 1];
+    size_t len = build_air(r, frame, sizeof(frame));
+    if (!len) {
+        Serial.println("LoRa TX: frame exceeds LORA_MAX_PAYLOAD, skipping");
+        return false;
+    }
 
-    LoRa.beginPacket();
-    LoRa.print(json);
-    bool ok = LoRa.endPacket();
+    // The transmit is a known current step: a resistance estimate
+    SagCapture sag(supply_stream, hal_clock, SAG_SAMPLE_HZ, SAG_PREROLL_MS);
+    sag_start(sag);
+    bool ok = lora_radio.send((const uint8_t *)frame, len);
+    sag_finish(sag, SAG_LORA_TX_A);
 
-    Serial.printf("LoRa TX: %s → %s\n", json.c_str(), ok ? "OK" : "FAIL");
+    Serial.printf("LoRa TX: %s → %s\n", frame, ok ? "OK" : "FAIL");
     return ok;
 }
 
 // ── Cellular Transmission ───────────────────────────────────
 bool send_cellular(const SensorReading &r) {
+    SagCapture sag(supply_stream, hal_clock, SAG_SAMPLE_HZ, SAG_PREROLL_MS);
+    sag_start(sag);
     Serial1.begin(115200, SERIAL_8N1, PIN_SIM_RX, PIN_SIM_TX);
     sim_power_on();
-    delay(3000);
-
-    // AT init sequence
-    Serial1.println("AT");
-    delay(500);
-    Serial1.println("AT+CNACT=1,\"" APN "\"");
-    delay(3000);
-
-    String json = build_json(r);
-
-    // HTTP POST
-    Serial1.println("AT+SHCONF=\"URL\",\"https://" SERVER_HOST API_ENDPOINT "\"");
-    delay(500);
-    Serial1.println("AT+SHCONF=\"BODYLEN\",1024");
-    delay(500);
-    Serial1.println("AT+SHCONF=\"HEADERLEN\",350");
-    delay(500);
-    Serial1.println("AT+SHCONN");
-    delay(3000);
-    Serial1.println("AT+SHCHEAD");
-    delay(200);
-    Serial1.println("AT+SHAHEAD=\"Content-Type\",\"application/json\"");
-    delay(200);
-    Serial1.printf("AT+SHBOD=%d,10000\r\n", json.length());
-    delay(200);
-    Serial1.print(json);
-    delay(1000);
-    Serial1.println("AT+SHREQ=\"" API_ENDPOINT "\",3");
-    delay(5000);
-
-    // Read response status
-    String resp = "";
-    unsigned long start = millis();
-    while (millis() - start < 5000) {
-        if (Serial1.available()) {
-            resp += (char)Serial1.read();
-        }
-    }
 
-    Serial1.println("AT+SHDISC");
-    delay(500);
-    Serial1.println("AT+CNACT=0");
-    sim_power_off();
+    ArduinoSerial sim_io(Serial1);
+    Sim7000 modem(sim_io, hal_clock);
+    bool ok = false;
+    if (modem.attach(APN) && modem.http_open("https://" SERVER_HOST)) {
+        char json[JSON_MAX_PAYLOAD];
+        size_t len = build_json(r, json, sizeof(json));
+        char reply[512];
+        int64_t sent_ms = unit_clock_ms();
+        int status = modem.http_post(API_ENDPOINT, "application/json",
+                                     (const uint8_t *)json, len, reply, sizeof(reply));
+        ok = status == 200;
+        if (ok) handle_server_reply(modem, reply, sent_ms, unit_clock_ms());
+        if (ok && backlog.count) backlog_post(modem);
+        modem.http_close();
+    }
+    sim_release(modem);
+    sag_finish(sag, 0);
 
-    bool ok = resp.indexOf("200") >= 0;
     Serial.printf("Cell TX: %s\n", ok ? "OK" : "FAIL");
     return ok;
 }
 
-// ── JSON Payload ────────────────────────────────────────────
-String build_json(const SensorReading &r) {
+// The ingest reply carries the backend's clock ("utc_ms", sent_ms to
+// recv_ms being the exchange that fetched it) and can carry a campaign
+// ("campaign"), new alarm thresholds ("thresholds") and ask for a stored
+// ADC trace ("upload_trace": boot, 0 = this cycle); the trace goes up on
+// the connection that is already open
+void handle_server_reply(Sim7000 &modem, const char *reply, int64_t sent_ms, int64_t recv_ms) {
     JsonDocument doc;
-    doc["device_id"]    = DEVICE_ID;
-    doc["device_type"]  = DEVICE_TYPE;
-    doc["fw_version"]   = FIRMWARE_VERSION;
-    doc["boot_count"]   = boot_count;
-    doc["water_level_ft"]      = round2(r.water_level_ft);
-    doc["pressure_psi"]        = round3(r.pressure_psi);
-    doc["water_temp_c"]        = round1(r.water_temp_c);
-    doc["baro_pressure_hpa"]   = round1(r.baro_pressure_hpa);
-    doc["baro_temp_c"]         = round1(r.baro_temp_c);
-    doc["humidity_pct"]        = round1(r.humidity_pct);
-    doc["battery_v"]           = round2(r.battery_v);
-    doc["solar_v"]             = round2(r.solar_v);
-
-    String out;
-    serializeJson(doc, out);
-    return out;
+    if (deserializeJson(doc, reply)) return;
+    if (doc["utc_ms"].is<int64_t>()) {
+        clock_sync_update(clock_sync, CLOCK, sent_ms, recv_ms, doc["utc_ms"].as<int64_t>());
+    }
+    JsonObjectConst c = doc["campaign"];
+    if (doc["campaign"].is<JsonObjectConst>() && c["id"].as<uint32_t>() != campaign.id) {
+        campaign.id = c["id"].as<uint32_t>();
+        campaign.at_utc_ms = c["at"].as<int64_t>() * 1000;
+        campaign.max_err_ms = c["max_err_ms"].as<uint32_t>();
+        Serial.printf("Campaign %u scheduled, clock error then %u ms\n", campaign.id,
+                      clock_error_ms(clock_sync, CLOCK, campaign_unit_ms(clock_sync, campaign)));
+    }
+    if (doc["thresholds"].is<JsonObjectConst>()) thresholds_apply(doc["thresholds"]);
+#if TRACE_RECORD
+    if (!doc["upload_trace"].is<uint32_t>()) return;
+    uint32_t boot = doc["upload_trace"].as<uint32_t>();
+    if (boot == 0) boot = boot_count;
+    bool ok = trace_store_upload(modem, boot, TRACE_KEEP, TRACE_PATH, TRACE_UPLOAD_CHUNK);
+    Serial.printf("Trace upload (boot %u): %s\n", boot, ok ? "OK" : "FAIL");
+#else
+    (void)modem;
+#endif
+}
+
+// ── Threshold Alarms ────────────────────────────────────────
+void thresholds_load() {
+    threshold_set_clear(thresholds);
+    Preferences prefs;
+    if (!prefs.begin(ALARM_NVS_NAMESPACE, true)) return;
+    ThresholdSet s;
+    if (prefs.getBytes("set", &s, sizeof(s)) == sizeof(s)) thresholds = s;
+    prefs.end();
+    alarms_armed = thresholds.version != 0;
+}
+
+// {"version": n, "wells": [[min_ft, warn_ft, rate_ft_h], ...]} in well
+// order, null for a check that is off
+void thresholds_apply(JsonObjectConst t) {
+    ThresholdSet s;
+    threshold_set_clear(s);
+    s.version = t["version"] | 0;
+    JsonArrayConst wells = t["wells"];
+    for (int i = 0; i < WELL_COUNT; i++) {
+        JsonArrayConst v = wells[i];
+        float *lim[3] = { &s.wells[i].min_ft, &s.wells[i].warn_ft, &s.wells[i].rate_ft_h };
+        for (int k = 0; k < 3; k++) {
+            if (v[k].is<float>()) *lim[k] = v[k].as<float>();
+        }
+    }
+    Preferences prefs;
+    if (!prefs.begin(ALARM_NVS_NAMESPACE, false)) return;
+    bool ok = prefs.putBytes("set", &s, sizeof(s)) == sizeof(s);
+    prefs.end();
+    if (ok) {
+        thresholds   = s;
+        alarms_armed = s.version != 0;
+    }
+    Serial.printf("Thresholds v%u: %s\n", s.version, ok ? "saved" : "NVS write failed");
+}
+
+// Sample wake with a breach waiting: urgent sends until one gets through.
+// A failed alarm is not backlogged; the next wake raises it again.
+void send_alarm(SensorReading &r, bool lora_ok) {
+    for (int k = 0; k < ALARM_TX_ATTEMPTS; k++) {
+        if (k) delay(ALARM_RETRY_MS);
+        if (transmit(r, lora_ok, true)) {
+            alarm_delivered(alarm_state);
+            return;
+        }
+    }
+    Serial.println("Alarm TX failed, retrying next wake");
+}
+
+// ── Transport Policy ────────────────────────────────────────
+// Decides how this reading goes out and records the decision in it, so it
+// reaches the backend with the payload
+void choose_transport(SensorReading &r, bool lora_ok, bool urgent, bool sync) {
+    r.tx = TxDecision();
+    char json[JSON_MAX_PAYLOAD];
+    TxRequest rq;
+    rq.bytes       = build_json(r, json, sizeof(json));
+    rq.air_bytes   = build_air(r, json, LORA_MAX_PAYLOAD + 1);
+    rq.queue_bytes = backlog.count ? backlog.bytes() : 0;
+    rq.queued      = backlog.count < 255 ? backlog.count : 255;
+    rq.urgency     = urgent ? TX_URGENT
+                   : reading_urgency(r, r.boot_count > 1 ? last_level_ft : nullptr);
+    rq.battery_v   = r.battery_v;
+    rq.lora_up     = lora_ok;
+    rq.cell_brownout = cell_brownout(r.battery_v);
+    r.tx = tx_decide(TX_POLICY, tx_stats, rq);
+    // A clock sync only comes back over cellular; not on a critical battery
+    if (sync && r.tx.route != TX_CELL && r.tx.reason != TX_WHY_LOW_BATT &&
+        r.tx.reason != TX_WHY_NO_LINK && !rq.cell_brownout) {
+        r.tx.route  = TX_CELL;
+        r.tx.reason = TX_WHY_SYNC;
+    }
+    Serial.printf("TX policy: %s (%s) | p LoRa %.2f cell %.2f | %.1f / %.1f J | %u queued\n",
+                  tx_route_name(r.tx.route), tx_reason_name(r.tx.reason),
+                  r.tx.p[TX_LORA], r.tx.p[TX_CELL],
+                  r.tx.cost_j[TX_LORA], r.tx.cost_j[TX_CELL], r.tx.queued);
+}
+
+// One decision and send. Urgent readings fall back to the other link;
+// the caller backlogs what did not go out.
+bool transmit(SensorReading &r, bool lora_ok, bool urgent, bool sync) {
+    choose_transport(r, lora_ok, urgent, sync);
+    bool sent = false;
+    if (r.tx.route == TX_LORA) {
+        sent = send_lora(r);
+        tx_record(TX_POLICY, tx_stats[TX_LORA], sent);
+    }
+    if (r.tx.route == TX_CELL || (r.tx.route == TX_LORA && !sent && r.tx.reason == TX_WHY_URGENT)) {
+        sent = send_cellular(r);
+        tx_record(TX_POLICY, tx_stats[TX_CELL], sent);
+    }
+    return sent;
 }
 
-float round1(float v) { return ((int)(v * 10 + 0.5f)) / 10.0f; }
-float round2(float v) { return ((int)(v * 100 + 0.5f)) / 100.0f; }
-float round3(float v) { return ((int)(v * 1000 + 0.5f)) / 1000.0f; }
+// ── Backlog ─────────────────────────────────────────────────
+void backlog_add(const SensorReading &r) {
+    if (!backlog.header_len && !pack_begin(backlog, backlog_buf, sizeof(backlog_buf))) return;
+    uint32_t t = (uint32_t)time(nullptr);     // RTC clock, runs through deep sleep
+    if (!pack_add(backlog, backlog_buf, r, t)) {
+        Serial.printf("Backlog full (%u readings), reading dropped\n", backlog.count);
+        return;
+    }
+    Serial.printf("Backlog: %u readings, %u B\n", backlog.count, (unsigned)backlog.bytes());
+}
+
+// Uploads the backlog on an open HTTP session and clears it on success
+bool backlog_post(Sim7000 &modem) {
+    size_t len = backlog.finish(backlog_buf, (uint32_t)time(nullptr));
+    char reply[256];
+    int status = modem.http_post(API_PACKED_ENDPOINT, "application/octet-stream",
+                                 backlog_buf, len, reply, sizeof(reply));
+    Serial.printf("Backlog TX: %u readings, %u B → %d\n", backlog.count, (unsigned)len, status);
+    if (status != 200) return false;
+    backlog.header_len = 0;
+    backlog.count = 0;
+    return true;
+}
+
+// After a LoRa send: one cellular session just for the backlog
+bool backlog_flush() {
+    SagCapture sag(supply_stream, hal_clock, SAG_SAMPLE_HZ, SAG_PREROLL_MS);
+    sag_start(sag);
+    Serial1.begin(115200, SERIAL_8N1, PIN_SIM_RX, PIN_SIM_TX);
+    sim_power_on();
+    ArduinoSerial sim_io(Serial1);
+    Sim7000 modem(sim_io, hal_clock);
+    bool ok = false;
+    if (modem.attach(APN) && modem.http_open("https://" SERVER_HOST)) {
+        ok = backlog_post(modem);
+        modem.http_close();
+    }
+    sim_release(modem);
+    sag_finish(sag, 0);
+    return ok;
+}
 
 // ── Power Management ────────────────────────────────────────
+// Until the next report, or the next alarm sample if that comes first
+// (only while a threshold set is loaded); with wake-on-radio, listening
+// on the way
 void enter_deep_sleep() {
-    LoRa.sleep();
-    Serial.printf("Sleeping for %lu ms\n", TX_INTERVAL_MS);
+    lora_radio.sleep();
+    uint64_t sleep_us = DEEP_SLEEP_US;
+    if (ALARM_SAMPLE_MS > 0 && alarms_armed) {
+        int32_t to_report = (int32_t)(next_report_s - (uint32_t)time(nullptr));
+        sleep_us = to_report > 0 ? to_report * 1000000ULL : 1000000ULL;
+        if (sleep_us > ALARM_SAMPLE_MS * 1000ULL) sleep_us = ALARM_SAMPLE_MS * 1000ULL;
+    }
+    if (campaign.id && clock_sync.synced_ms) {
+        int64_t to_ms = campaign_unit_ms(clock_sync, campaign) - unit_clock_ms();
+        if (to_ms > 0 && (uint64_t)to_ms * 1000ULL < sleep_us) sleep_us = (uint64_t)to_ms * 1000ULL;
+    }
+#if SIM_RI_WAKE
+    if (modem_idle) esp_sleep_enable_ext0_wakeup((gpio_num_t)PIN_SIM_RI, 0);
+#endif
+#if WOR_MODE == WOR_LIGHT
+    sleep_us = wor_light_listen(sleep_us);
+#elif WOR_MODE == WOR_DEEP
+    if (sleep_us > WOR_CAD_PERIOD_MS * 1000ULL) sleep_us = WOR_CAD_PERIOD_MS * 1000ULL;
+#endif
+    Serial.printf("Sleeping for %lu ms\n", (unsigned long)(sleep_us / 1000));
     Serial.flush();
-    esp_sleep_enable_timer_wakeup(DEEP_SLEEP_US);
+    esp_sleep_enable_timer_wakeup(sleep_us);
     esp_deep_sleep_start();
 }
 
+// WOR_LIGHT: light sleep one CAD period at a time until sleep_us is used
+// up, with a listen slot after each. Returns the deep sleep still to go;
+// 1 ms when a read command (or the modem's ring) came in, so the unit
+// wakes straight into a report. Timed against the RTC, so listening does
+// not push a campaign wake late.
+uint64_t wor_light_listen(uint64_t sleep_us) {
+    const int64_t period_ms = WOR_CAD_PERIOD_MS;
+    int64_t end_ms = unit_clock_ms() + (int64_t)(sleep_us / 1000);
+    Serial.flush();
+    for (;;) {
+        int64_t left_ms = end_ms - unit_clock_ms();
+        if (left_ms <= period_ms) return left_ms > 1 ? (uint64_t)left_ms * 1000ULL : 1000;
+        esp_sleep_enable_timer_wakeup(period_ms * 1000ULL);
+        esp_light_sleep_start();
+        if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0) {
+            read_req = READ_REQ_RING;
+            return 1000;
+        }
+        WorCommand cmd;
+        if (wor_listen_once(lora_radio, DEVICE_ID, WOR_CAD_TIMEOUT_MS, WOR_RX_TIMEOUT_MS, cmd)) {
+            read_req = cmd.req;
+            return 1000;
+        }
+        lora_radio.sleep();
+    }
+}
+
+// A modem left idle by sim_release() is still on: no PWRKEY pulse, which
+// would switch it off
 void sim_power_on() {
+    if (modem_idle) return;
     pinMode(PIN_SIM_PWR, OUTPUT);
     digitalWrite(PIN_SIM_PWR, HIGH);
     delay(1000);
     digitalWrite(PIN_SIM_PWR, LOW);
 }
 
-void sim_power_off() {
-    Serial1.println("AT+CPOWD=1");
-    delay(2000);
+// After a session: detach, then power down — or with SIM_RI_WAKE stay
+// registered in eDRX so an SMS can ring the unit awake
+void sim_release(Sim7000 &modem) {
+    modem.detach();
+#if SIM_RI_WAKE
+    modem_idle = modem.ring_on_sms(SIM_EDRX_CYCLE);
+    if (modem_idle) return;
+#endif
+    modem.power_off();
+    modem_idle = false;
 }